@@ -30,6 +30,9 @@ using namespace render;
 
 AppDelegate::AppDelegate()
 {
+    // The engine logs through cocos, so that its messages end up with those of the app
+    chessEngine::setLogHandler([] (const char * inMessage) { cocos2d::log("%s", inMessage); });
+
     _stateMachine   = new AppStateMachine();
 }
 
@@ -88,14 +91,14 @@ AppDelegate::applicationDidFinishLaunching()
         return false;
     }
 
-    LOG("Launching app");
+    chessEngine::log("Launching app");
     
     glView = GLViewImpl::createWithRect("Chess", Rect(0, 0, 1280, 720));
     dir->setOpenGLView(glView);
 
     _stateMachine->init(new ChessAppInitialState());
     
-    LOG("Done launching app");
+    chessEngine::log("Done launching app");
     
     return true;
 }
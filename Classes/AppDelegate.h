@@ -12,6 +12,8 @@
 
 #include "Chess.h"
 
+#include "cocos2d.h"
+
 namespace render
 {
     class AppStateMachine;
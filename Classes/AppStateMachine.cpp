@@ -40,7 +40,7 @@ AppStateMachine::init(AppState * inInitialState)
 void
 AppStateMachine::receiveEvent(AppEvent * inEvent)
 {
-    LOG("AppStateMachine::receiveEvent(%d)", inEvent->getID());
+    chessEngine::log("AppStateMachine::receiveEvent(%d)", inEvent->getID());
     
     AppState * newState = _currState->_react(inEvent);
     
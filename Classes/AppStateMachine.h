@@ -69,7 +69,8 @@ namespace render
 			@brief			Receive an event
 
 			@discussion		Performs a state change upon recieving an event. Calls
-			state functions as appropriate.
+			state functions as appropriate. The event is only used during the call and not
+			owned, so it can live on the stack of the caller.
 
 			@param			inEvent			received event
 		 */
@@ -13,6 +13,7 @@
 
 #include <inttypes.h>
 #include <limits>
+#include <string>
 
 using namespace chessEngine;
 
@@ -158,14 +159,91 @@ const Bitboard    BitboardLUT::kStartBlackKing     = BitboardLUT::kSquareMasks[5
 
 const Bitboard    BitboardLUT::kFull               = std::numeric_limits<BitboardMask>::max();
 
+Bitboard          BitboardLUT::kKnightAttacks[64];
+Bitboard          BitboardLUT::kKingAttacks[64];
+Bitboard          BitboardLUT::kPawnAttacks[2][64];
+Bitboard          BitboardLUT::kRays[8][64];
+
 Bitboard          BitboardLUT::kRowOccupiedMasks[8][256];
 Bitboard          BitboardLUT::kColOccupiedMasks[8][256];
 Bitboard          BitboardLUT::kDiagOccupiedMasks[8][256];
 Bitboard          BitboardLUT::kADiagOccupiedMasks[8][256];
 
+enum RayDirection : uint8_t
+{
+    kNorth, kNorthEast, kEast, kSouthEast, kSouth, kSouthWest, kWest, kNorthWest
+};
+
+static const int8_t kRayRowSteps[8] = { 1, 1, 0, -1, -1, -1,  0,  1 };
+static const int8_t kRayColSteps[8] = { 0, 1, 1,  1,  0, -1, -1, -1 };
+
+static Bitboard
+_getStepTargets(Square inSq, const int8_t (* inSteps)[2], uint8_t inNumSteps)
+{
+    Bitboard targets;
+    
+    for (auto i = 0; i < inNumSteps; i++)
+    {
+        int row = inSq.getRow() + inSteps[i][0];
+        int col = inSq.getCol() + inSteps[i][1];
+        
+        if ((row >= 0) && (row < 8) && (col >= 0) && (col < 8))
+        {
+            targets |= Bitboard::getForSquare(Square(row, col));
+        }
+    }
+    
+    return targets;
+}
+
+static void
+_initAttacks()
+{
+    static const int8_t kKnightSteps[8][2] = {
+        { 2, 1 }, { 1, 2 }, { -1, 2 }, { -2, 1 }, { -2, -1 }, { -1, -2 }, { 1, -2 }, { 2, -1 }
+    };
+    static const int8_t kKingSteps[8][2] = {
+        { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 }
+    };
+    static const int8_t kWhitePawnSteps[2][2] = { { 1, -1 }, { 1, 1 } };
+    static const int8_t kBlackPawnSteps[2][2] = { { -1, -1 }, { -1, 1 } };
+    
+    static constexpr uint8_t kBlack = static_cast<uint8_t>(attributes::ChessColor::kBlack);
+    static constexpr uint8_t kWhite = static_cast<uint8_t>(attributes::ChessColor::kWhite);
+    
+    for (uint8_t index = 0; index < 64; index++)
+    {
+        Square sq(index);
+        
+        BitboardLUT::kKnightAttacks[index]      = _getStepTargets(sq, kKnightSteps, 8);
+        BitboardLUT::kKingAttacks[index]        = _getStepTargets(sq, kKingSteps, 8);
+        BitboardLUT::kPawnAttacks[kWhite][index] = _getStepTargets(sq, kWhitePawnSteps, 2);
+        BitboardLUT::kPawnAttacks[kBlack][index] = _getStepTargets(sq, kBlackPawnSteps, 2);
+        
+        for (uint8_t dir = 0; dir < 8; dir++)
+        {
+            Bitboard ray;
+            int      row = sq.getRow() + kRayRowSteps[dir];
+            int      col = sq.getCol() + kRayColSteps[dir];
+            
+            while ((row >= 0) && (row < 8) && (col >= 0) && (col < 8))
+            {
+                ray |= Bitboard::getForSquare(Square(row, col));
+                
+                row += kRayRowSteps[dir];
+                col += kRayColSteps[dir];
+            }
+            
+            BitboardLUT::kRays[dir][index] = ray;
+        }
+    }
+}
+
 void
 BitboardLUT::init()
 {
+    _initAttacks();
+    
     for (auto i = 0; i < 8; i++)
     {
         for (auto others = 0; others < 256; others++)
@@ -240,34 +318,85 @@ BitboardLUT::init()
 #pragma mark Bitboard
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Directions in which the square index grows, i.e. the first blocker is the lowest bit
+static inline bool
+_isPositiveRay(uint8_t inDirection)
+{
+    return (inDirection == kNorth) || (inDirection == kNorthEast) ||
+           (inDirection == kEast)  || (inDirection == kNorthWest);
+}
+
+static inline Bitboard
+_getRayAttacks(uint8_t inDirection, Square inSq, Bitboard inBoard)
+{
+    auto ray      = BitboardLUT::kRays[inDirection][inSq.index];
+    auto blockers = (ray & inBoard).mask;
+    
+    if (blockers != 0)
+    {
+        uint8_t first = (_isPositiveRay(inDirection) ?
+                         __builtin_ctzll(blockers) : 63 - __builtin_clzll(blockers));
+        
+        ray ^= BitboardLUT::kRays[inDirection][first];
+    }
+    
+    return ray;
+}
+
 Bitboard
 Bitboard::getRowAttacks(Square inSq, Bitboard inBoard)
 {
-    
+    return _getRayAttacks(kEast, inSq, inBoard) | _getRayAttacks(kWest, inSq, inBoard);
 }
 
 Bitboard
 Bitboard::getRowAttacks(Bitboard inAttackers, Bitboard inBoard)
 {
+    Bitboard attacks;
+    
+    for (auto sq : inAttackers)
+    {
+        attacks |= getRowAttacks(sq, inBoard);
+    }
     
+    return attacks;
+}
+
+Bitboard
+Bitboard::getBishopAttacks(Square inSq, Bitboard inBoard)
+{
+    return (_getRayAttacks(kNorthEast, inSq, inBoard) | _getRayAttacks(kSouthEast, inSq, inBoard) |
+            _getRayAttacks(kSouthWest, inSq, inBoard) | _getRayAttacks(kNorthWest, inSq, inBoard));
+}
+
+Bitboard
+Bitboard::getRookAttacks(Square inSq, Bitboard inBoard)
+{
+    return (_getRayAttacks(kNorth, inSq, inBoard) | _getRayAttacks(kEast, inSq, inBoard) |
+            _getRayAttacks(kSouth, inSq, inBoard) | _getRayAttacks(kWest, inSq, inBoard));
+}
+
+Bitboard
+Bitboard::getQueenAttacks(Square inSq, Bitboard inBoard)
+{
+    return getBishopAttacks(inSq, inBoard) | getRookAttacks(inSq, inBoard);
 }
 
 void
 Bitboard::print() const
 {
-    LOG("0x%" PRIx64 "\n", mask);
+    // Logged as one message, as every message is a line of its own
+    std::string board;
     
     for (auto row = 7; row >= 0; row--)
     {
         for (auto col = 0; col < 8; col++)
         {
-            unsigned int val = (getForSquare(Square(row, col)).mask & mask) > 0;
-            
-            LOG("%d ", val);
+            board += ((getForSquare(Square(row, col)).mask & mask) > 0) ? "1 " : "0 ";
         }
         
-        LOG("\n");
+        board += "\n";
     }
     
-    LOG("\n");
+    chessEngine::log("0x%" PRIx64 "\n%s", mask, board.c_str());
 }
@@ -95,6 +95,18 @@ namespace chessEngine
         
         extern const Bitboard       kFull;
         
+        extern Bitboard             kKnightAttacks[64];
+        extern Bitboard             kKingAttacks[64];
+        extern Bitboard             kPawnAttacks[2][64];
+        
+        /**
+         @brief         Rays from a square to the edge of the board, excluding the square
+         
+         @discussion    Indexed by [direction][square], with the directions north, north east,
+         east, south east, south, south west, west and north west.
+         */
+        extern Bitboard             kRays[8][64];
+        
         extern Bitboard             kRowOccupiedMasks[8][256];
         extern Bitboard             kColOccupiedMasks[8][256];
         extern Bitboard             kDiagOccupiedMasks[8][256];
@@ -203,6 +215,34 @@ namespace chessEngine
         
         static Bitboard                 getRowAttacks(Square inSq, Bitboard inBoard);
         static Bitboard                 getRowAttacks(Bitboard inAttackers, Bitboard inBoard);
+        
+        static Bitboard                 getKnightAttacks(Square inSq)
+        { return BitboardLUT::kKnightAttacks[inSq.index]; }
+        
+        static Bitboard                 getKingAttacks(Square inSq)
+        { return BitboardLUT::kKingAttacks[inSq.index]; }
+        
+        /**
+         @brief          Squares a pawn of a color attacks
+         */
+        static Bitboard                 getPawnAttacks(attributes::ChessColor inColor,
+                                                       Square inSq)
+        { return BitboardLUT::kPawnAttacks[static_cast<uint8_t>(inColor)][inSq.index]; }
+        
+        /**
+         @brief          Squares a slider on inSq attacks, up to and including the first piece of
+         inBoard in every direction
+         */
+        static Bitboard                 getBishopAttacks(Square inSq, Bitboard inBoard);
+        static Bitboard                 getRookAttacks(Square inSq, Bitboard inBoard);
+        
+        static Bitboard                 getQueenAttacks(Square inSq, Bitboard inBoard);
+        
+        /**
+         @brief          Number of pieces on the bitboard
+         */
+        uint8_t                         count() const
+        { return static_cast<uint8_t>(__builtin_popcountll(mask)); }
     };
     
     static inline Bitboard              operator& (Bitboard inB1, Bitboard inB2)
@@ -11,15 +11,18 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <assert.h>
 #include <stdio.h>
 #include <ctype.h>
 
-#ifndef TARGET_TEST
-    #include "cocos2d.h"
-    #define LOG      cocos2d::log
+#include "Log.h"
+
+// Hint that an address is about to be read, so that the cache miss overlaps with other work
+#if defined(__GNUC__) || defined(__clang__)
+    #define PREFETCH(inAddress)     __builtin_prefetch(inAddress)
 #else
-    #define LOG      printf
+    #define PREFETCH(inAddress)     ((void) (inAddress))
 #endif
 
 namespace attributes
@@ -10,9 +10,39 @@
 
 #include "ChessEngine.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
 using namespace chessEngine;
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark PackedMove
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string
+PackedMove::toString() const
+{
+    static const char kPromotionChars[4] = { 'n', 'b', 'r', 'q' };
+    
+    std::string str;
+    
+    str += static_cast<char>('a' + getSrc().getCol());
+    str += static_cast<char>('1' + getSrc().getRow());
+    str += static_cast<char>('a' + getDest().getCol());
+    str += static_cast<char>('1' + getDest().getRow());
+    
+    if (isPromotion())
+    {
+        str += kPromotionChars[getFlags() & 0x3];
+    }
+    
+    return str;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
 #pragma mark ChessEngine::BitboardCollection
@@ -37,11 +67,95 @@ ChessEngine::BitboardCollection::getPieceAt(const Position & inPos,
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
-#pragma mark ChessboardScene
+#pragma mark ChessEngine
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool ChessEngine::_sIsInit = false;
 
+const char * const ChessEngine::kStartFen =
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Castling rights that survive a move from or to a square
+static const uint8_t kCastlingMasks[64] = {
+    0x0D, 0x0F, 0x0F, 0x0F, 0x0C, 0x0F, 0x0F, 0x0E,
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+    0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+    0x07, 0x0F, 0x0F, 0x0F, 0x03, 0x0F, 0x0F, 0x0B
+};
+
+static const char kPieceChars[6] = { 'p', 'n', 'b', 'r', 'q', 'k' };
+
+static inline uint64_t
+_readLittleEndian(const uint8_t * inData, int inNumBytes)
+{
+    uint64_t value = 0;
+    
+    for (auto i = inNumBytes - 1; i >= 0; i--)
+    {
+        value = (value << 8) | inData[i];
+    }
+    
+    return value;
+}
+
+static inline void
+_writeLittleEndian(uint64_t inValue, int inNumBytes, uint8_t * outData)
+{
+    for (auto i = 0; i < inNumBytes; i++)
+    {
+        outData[i] = static_cast<uint8_t>(inValue);
+        inValue >>= 8;
+    }
+}
+
+/**
+ @brief         CRC-32 of the zlib, PNG and Ethernet checksums, carried on from inCrc
+ */
+static uint32_t
+_crc32(const uint8_t * inData, size_t inSize, uint32_t inCrc = 0)
+{
+    uint32_t crc = ~inCrc;
+    
+    for (size_t i = 0; i < inSize; i++)
+    {
+        crc ^= inData[i];
+        
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    
+    return ~crc;
+}
+
+/**
+ @brief         Checksum of a snapshot, as if its own field were zero
+ */
+static uint32_t
+_getSnapshotChecksum(const uint8_t * inData, size_t inSize)
+{
+    static const uint8_t kZero[4] = { 0, 0, 0, 0 };
+    
+    auto offset = ChessEngine::kSnapshotChecksumOffset;
+    auto crc    = _crc32(inData, offset);
+    
+    crc = _crc32(kZero, sizeof(kZero), crc);
+    
+    return _crc32(inData + offset + sizeof(kZero), inSize - offset - sizeof(kZero), crc);
+}
+
+static inline attributes::ChessColor
+_opposite(attributes::ChessColor inColor)
+{
+    return ((inColor == attributes::ChessColor::kWhite) ?
+            attributes::ChessColor::kBlack : attributes::ChessColor::kWhite);
+}
+
 ChessEngine::ChessEngine() :
 _whitePieces(BitboardLUT::kStartWhitePawns, BitboardLUT::kStartWhiteKnights,
              BitboardLUT::kStartWhiteBishops, BitboardLUT::kStartWhiteRooks,
@@ -49,9 +163,34 @@ _whitePieces(BitboardLUT::kStartWhitePawns, BitboardLUT::kStartWhiteKnights,
 _blackPieces(BitboardLUT::kStartBlackPawns, BitboardLUT::kStartBlackKnights,
              BitboardLUT::kStartBlackBishops, BitboardLUT::kStartBlackRooks,
              BitboardLUT::kStartBlackQueen, BitboardLUT::kStartBlackKing),
-_currTurn(attributes::ChessColor::kWhite)
+_currTurn(attributes::ChessColor::kWhite),
+_castlingRights(kAllCastlingRights),
+_enPassant(),
+_halfMoveClock(0),
+_fullMoveNumber(1),
+_network(nullptr)
 {
+    assert(_sIsInit);
+    
+    _mailbox.fill(static_cast<uint8_t>(kNoPiece));
+    
+    for (auto color : { attributes::ChessColor::kBlack, attributes::ChessColor::kWhite })
+    {
+        for (uint8_t piece = 0; piece < BitboardCollection::kSize; piece++)
+        {
+            auto name = static_cast<attributes::ChessPieceName>(piece);
+            
+            for (auto sq : getPieces(color, name))
+            {
+                _mailbox[sq.index] = _toPieceCode(color, name);
+            }
+        }
+    }
+    
+    _hashKey = computeHashKey();
+    _pawnKey = computePawnKey();
     
+    _undoStack.reserve(kMaxGamePly);
 }
 
 void
@@ -60,6 +199,7 @@ ChessEngine::init()
     if (!_sIsInit)
     {
         BitboardLUT::init();
+        ZobristLUT::init();
         _sIsInit = true;
     }
 }
@@ -68,151 +208,1393 @@ bool
 ChessEngine::attemptMove(const Move & inMove, Move * outSideEffect,
                          bool * outPromotion)
 {
-    bool ret = false;
-    
-    attributes::ChessPieceName piece;
-    attributes::ChessColor color = getCurrMove();
+    PackedMove move;
     
     // Start with an invalid move
     *outSideEffect = Move::invalid();
+    *outPromotion  = false;
     
-    if (color == attributes::ChessColor::kWhite)
-    {
-        assert(_whitePieces.getPieceAt(inMove.src, &piece));
-    }
-    else if(color == attributes::ChessColor::kBlack)
+    if (!_toPackedMove(inMove, &move))
     {
-        assert(_blackPieces.getPieceAt(inMove.src, &piece));
+        return false;
     }
-    else
+    
+    return attemptMove(move, outSideEffect, outPromotion);
+}
+
+bool
+ChessEngine::attemptMove(PackedMove inMove, Move * outSideEffect, bool * outPromotion)
+{
+    MoveList legalMoves;
+    
+    *outSideEffect = Move::invalid();
+    *outPromotion  = false;
+    
+    generateLegalMoves(&legalMoves);
+    
+    if (!legalMoves.contains(inMove))
     {
-        assert(0);
+        return false;
     }
     
-    switch (piece)
+    auto src  = inMove.getSrc();
+    auto dest = inMove.getDest();
+    
+    switch (inMove.getFlags())
     {
-        case attributes::ChessPieceName::kPawn:
+        case PackedMove::kEnPassant:
         {
-            ret = _attemptPawnMove(color, inMove, outSideEffect, outPromotion);
+            Square captured(src.getRow(), dest.getCol());
+            
+            outSideEffect->src  = captured.getPosition();
+            outSideEffect->dest = Position::outside();
             break;
         }
-        case attributes::ChessPieceName::kKnight:
+        case PackedMove::kKingCastle:
         {
-            ret = _attemptKnightMove(color, inMove, outSideEffect);
+            outSideEffect->src  = Square(src.index + 3).getPosition();
+            outSideEffect->dest = Square(src.index + 1).getPosition();
             break;
         }
-        case attributes::ChessPieceName::kBishop:
+        case PackedMove::kQueenCastle:
         {
-            ret = _attemptBishopMove(color, inMove, outSideEffect);
+            outSideEffect->src  = Square(src.index - 4).getPosition();
+            outSideEffect->dest = Square(src.index - 1).getPosition();
             break;
         }
-        case attributes::ChessPieceName::kRook:
+        default:
         {
-            ret = _attemptRookMove(color, inMove, outSideEffect);
+            if (inMove.isCapture())
+            {
+                outSideEffect->src  = dest.getPosition();
+                outSideEffect->dest = Position::outside();
+            }
             break;
         }
-        case attributes::ChessPieceName::kQueen:
+    }
+    
+    *outPromotion = inMove.isPromotion();
+    
+    makeMove(inMove);
+    
+    return true;
+}
+
+void
+ChessEngine::generateMoves(MoveList * outMoves, bool inCapturesOnly) const
+{
+    using attributes::ChessPieceName;
+    
+    auto us         = _currTurn;
+    auto them       = _opposite(us);
+    auto own        = getAllPieces(us);
+    auto enemy      = getAllPieces(them);
+    auto occupied   = own | enemy;
+    auto targets    = inCapturesOnly ? enemy : ~own;
+    
+    bool    isWhite   = (us == attributes::ChessColor::kWhite);
+    int8_t  forward   = isWhite ? 8 : -8;
+    uint8_t startRow  = isWhite ? 1 : 6;
+    uint8_t lastRow   = isWhite ? 7 : 0;
+    
+    for (auto src : getPieces(us, ChessPieceName::kPawn))
+    {
+        Square push(src.index + forward);
+        
+        if ((occupied & Bitboard::getForSquare(push)) == 0)
+        {
+            if (push.getRow() == lastRow)
+            {
+                _addPromotions(outMoves, src, push, false, inCapturesOnly);
+            }
+            else if (!inCapturesOnly)
+            {
+                outMoves->add(PackedMove(src, push, PackedMove::kQuiet));
+                
+                Square doublePush(push.index + forward);
+                
+                if ((src.getRow() == startRow) &&
+                    ((occupied & Bitboard::getForSquare(doublePush)) == 0))
+                {
+                    outMoves->add(PackedMove(src, doublePush, PackedMove::kDoublePawnPush));
+                }
+            }
+        }
+        
+        auto attacks = Bitboard::getPawnAttacks(us, src);
+        
+        for (auto dest : attacks & enemy)
         {
-            ret = _attemptQueenMove(color, inMove, outSideEffect);
-            break;
+            if (dest.getRow() == lastRow)
+            {
+                _addPromotions(outMoves, src, dest, true, inCapturesOnly);
+            }
+            else
+            {
+                outMoves->add(PackedMove(src, dest, PackedMove::kCapture));
+            }
         }
-        case attributes::ChessPieceName::kKing:
+        
+        if (!_enPassant.isOutside() && ((attacks & Bitboard::getForSquare(_enPassant)) != 0))
         {
-            ret = _attemptKingMove(color, inMove, outSideEffect);
-            break;
+            outMoves->add(PackedMove(src, _enPassant, PackedMove::kEnPassant));
+        }
+    }
+    
+    for (uint8_t piece = static_cast<uint8_t>(ChessPieceName::kKnight);
+         piece <= static_cast<uint8_t>(ChessPieceName::kKing); piece++)
+    {
+        auto name = static_cast<ChessPieceName>(piece);
+        
+        for (auto src : getPieces(us, name))
+        {
+            Bitboard attacks;
+            
+            switch (name)
+            {
+                case ChessPieceName::kKnight: attacks = Bitboard::getKnightAttacks(src); break;
+                case ChessPieceName::kBishop:
+                    attacks = Bitboard::getBishopAttacks(src, occupied); break;
+                case ChessPieceName::kRook:   attacks = Bitboard::getRookAttacks(src, occupied); break;
+                case ChessPieceName::kQueen:
+                    attacks = Bitboard::getQueenAttacks(src, occupied); break;
+                default:                      attacks = Bitboard::getKingAttacks(src); break;
+            }
+            
+            for (auto dest : attacks & targets)
+            {
+                bool isCapture = ((enemy & Bitboard::getForSquare(dest)) != 0);
+                
+                outMoves->add(PackedMove(src, dest,
+                                         isCapture ? PackedMove::kCapture : PackedMove::kQuiet));
+            }
         }
     }
     
-    if (ret)
+    uint8_t kingSide  = isWhite ? kWhiteKingSide : kBlackKingSide;
+    uint8_t queenSide = isWhite ? kWhiteQueenSide : kBlackQueenSide;
+    
+    if (inCapturesOnly || ((_castlingRights & (kingSide | queenSide)) == 0))
+    {
+        return;
+    }
+    
+    // The rights imply that the king and the rooks are on their start squares
+    Square kingSq(isWhite ? 4 : 60);
+    
+    if (isSquareAttacked(kingSq, them))
+    {
+        return;
+    }
+    
+    if ((_castlingRights & kingSide) &&
+        ((occupied & Bitboard(0x60ULL << (kingSq.index - 4))) == 0) &&
+        !isSquareAttacked(Square(kingSq.index + 1), them) &&
+        !isSquareAttacked(Square(kingSq.index + 2), them))
     {
-        _currTurn = ((color == attributes::ChessColor::kWhite) ?
-                     attributes::ChessColor::kBlack :
-                     attributes::ChessColor::kWhite);
+        outMoves->add(PackedMove(kingSq, Square(kingSq.index + 2), PackedMove::kKingCastle));
     }
     
-    return ret;
+    if ((_castlingRights & queenSide) &&
+        ((occupied & Bitboard(0x0EULL << (kingSq.index - 4))) == 0) &&
+        !isSquareAttacked(Square(kingSq.index - 1), them) &&
+        !isSquareAttacked(Square(kingSq.index - 2), them))
+    {
+        outMoves->add(PackedMove(kingSq, Square(kingSq.index - 2), PackedMove::kQueenCastle));
+    }
 }
 
-bool
-ChessEngine::_attemptPawnMove(attributes::ChessColor inColor,
-                              const Move & inMove, Move * outSideEffect,
-                              bool * outPromotion)
+void
+ChessEngine::generateLegalMoves(MoveList * outMoves) const
 {
-    *outPromotion = false;
-    return _simpleMoveAndKill(attributes::ChessPieceName::kPawn, inColor,
-                              inMove, outSideEffect);
+    MoveList moves;
+    
+    generateMoves(&moves);
+    
+    for (auto move : moves)
+    {
+        if (isLegal(move))
+        {
+            outMoves->add(move);
+        }
+    }
 }
 
 bool
-ChessEngine::_attemptKnightMove(attributes::ChessColor inColor,
-                                const Move & inMove, Move * outSideEffect)
+ChessEngine::isLegal(PackedMove inMove) const
 {
-    return _simpleMoveAndKill(attributes::ChessPieceName::kKnight, inColor,
-                              inMove, outSideEffect);
+    auto us     = _currTurn;
+    auto them   = _opposite(us);
+    auto src    = inMove.getSrc();
+    auto dest   = inMove.getDest();
+    auto srcBB  = Bitboard::getForSquare(src);
+    auto destBB = Bitboard::getForSquare(dest);
+    auto king   = getPieces(us, attributes::ChessPieceName::kKing);
+    
+    if ((king & srcBB) != 0)
+    {
+        // Castling squares were checked when generating, only the destination is left
+        return _getAttackers(dest, them, getOccupied() ^ srcBB) == 0;
+    }
+    
+    auto occupied = (getOccupied() ^ srcBB) | destBB;
+    auto captured = destBB;
+    
+    if (inMove.getFlags() == PackedMove::kEnPassant)
+    {
+        captured  = Bitboard::getForSquare(Square(src.getRow(), dest.getCol()));
+        occupied ^= captured;
+    }
+    
+    return (_getAttackers(*king.begin(), them, occupied) & ~captured) == 0;
 }
 
 bool
-ChessEngine::_attemptBishopMove(attributes::ChessColor inColor,
-                                const Move & inMove, Move * outSideEffect)
+ChessEngine::isInCheck() const
 {
-    return _simpleMoveAndKill(attributes::ChessPieceName::kBishop, inColor,
-                              inMove, outSideEffect);
+    auto king = getPieces(_currTurn, attributes::ChessPieceName::kKing);
+    
+    return (king != 0) && isSquareAttacked(*king.begin(), _opposite(_currTurn));
 }
 
 bool
-ChessEngine::_attemptRookMove(attributes::ChessColor inColor,
-                              const Move & inMove, Move * outSideEffect)
+ChessEngine::isDraw() const
 {
-    return _simpleMoveAndKill(attributes::ChessPieceName::kRook, inColor,
-                              inMove, outSideEffect);
+    if (_halfMoveClock >= 100)
+    {
+        return true;
+    }
+    
+    // Positions before a pawn move or a capture cannot come back, neither can the ones before a
+    // null move, as the side to move differs
+    size_t numMoves = _undoStack.size();
+    size_t first    = (numMoves > _halfMoveClock) ? numMoves - _halfMoveClock : 0;
+    
+    for (size_t i = numMoves; i-- > first; )
+    {
+        if (_undoStack[i].move.isNull())
+        {
+            break;
+        }
+        
+        if ((((numMoves - i) & 1) == 0) && (_undoStack[i].hashKey == _hashKey))
+        {
+            return true;
+        }
+    }
+    
+    using attributes::ChessPieceName;
+    
+    auto majorsAndPawns = (getPieces(attributes::ChessColor::kWhite, ChessPieceName::kPawn) |
+                           getPieces(attributes::ChessColor::kBlack, ChessPieceName::kPawn) |
+                           getPieces(attributes::ChessColor::kWhite, ChessPieceName::kRook) |
+                           getPieces(attributes::ChessColor::kBlack, ChessPieceName::kRook) |
+                           getPieces(attributes::ChessColor::kWhite, ChessPieceName::kQueen) |
+                           getPieces(attributes::ChessColor::kBlack, ChessPieceName::kQueen));
+    
+    // A single minor piece cannot mate
+    return (majorsAndPawns == 0) && (getOccupied().count() <= 3);
 }
 
 bool
-ChessEngine::_attemptQueenMove(attributes::ChessColor inColor,
-                               const Move & inMove, Move * outSideEffect)
+ChessEngine::hasNonPawnMaterial(attributes::ChessColor inColor) const
 {
-    return _simpleMoveAndKill(attributes::ChessPieceName::kQueen, inColor,
-                              inMove, outSideEffect);
+    auto pieces = (getAllPieces(inColor) ^ getPieces(inColor, attributes::ChessPieceName::kPawn) ^
+                   getPieces(inColor, attributes::ChessPieceName::kKing));
+    
+    return pieces != 0;
 }
 
-bool
-ChessEngine::_attemptKingMove(attributes::ChessColor inColor,
-                              const Move & inMove, Move * outSideEffect)
+Bitboard
+ChessEngine::_getAttackers(Square inSq, attributes::ChessColor inByColor,
+                           Bitboard inOccupied) const
+{
+    using attributes::ChessPieceName;
+    
+    const BitboardCollection & pieces = _getCollection(inByColor);
+    
+    auto queens     = pieces.board(ChessPieceName::kQueen);
+    auto diagonals  = pieces.board(ChessPieceName::kBishop) | queens;
+    auto straights  = pieces.board(ChessPieceName::kRook) | queens;
+    
+    // A pawn of the color attacks inSq from the squares a pawn of the other color on inSq attacks
+    return ((Bitboard::getPawnAttacks(_opposite(inByColor), inSq) &
+             pieces.board(ChessPieceName::kPawn)) |
+            (Bitboard::getKnightAttacks(inSq) & pieces.board(ChessPieceName::kKnight)) |
+            (Bitboard::getKingAttacks(inSq) & pieces.board(ChessPieceName::kKing)) |
+            (Bitboard::getBishopAttacks(inSq, inOccupied) & diagonals) |
+            (Bitboard::getRookAttacks(inSq, inOccupied) & straights));
+}
+
+void
+ChessEngine::_addPromotions(MoveList * outMoves, Square inSrc, Square inDest,
+                            bool inIsCapture, bool inCapturesOnly) const
 {
-    return _simpleMoveAndKill(attributes::ChessPieceName::kKing, inColor,
-                              inMove, outSideEffect);
+    uint8_t captureFlag = inIsCapture ? PackedMove::kCapture : 0;
+    
+    outMoves->add(PackedMove(inSrc, inDest, PackedMove::kQueenPromotion | captureFlag));
+    
+    if (inCapturesOnly)
+    {
+        return;
+    }
+    
+    outMoves->add(PackedMove(inSrc, inDest, PackedMove::kRookPromotion | captureFlag));
+    outMoves->add(PackedMove(inSrc, inDest, PackedMove::kBishopPromotion | captureFlag));
+    outMoves->add(PackedMove(inSrc, inDest, PackedMove::kKnightPromotion | captureFlag));
 }
 
 bool
-ChessEngine::_simpleMoveAndKill(attributes::ChessPieceName inPiece,
-                                attributes::ChessColor inColor,
-                                const Move & inMove, Move * outSideEffect)
+ChessEngine::_toPackedMove(const Move & inMove, PackedMove * outMove) const
 {
-    bool isWhite     = (inColor == attributes::ChessColor::kWhite);
+    attributes::ChessColor     color, destColor;
+    attributes::ChessPieceName piece, destPiece;
+    
+    auto src  = inMove.src.getSquare();
+    auto dest = inMove.dest.getSquare();
+    
+    if (!getPieceAt(src, &color, &piece) || (color != _currTurn))
+    {
+        return false;
+    }
     
-    auto src         = inMove.src.getBitboard();
-    auto dest        = inMove.dest.getBitboard();
+    bool isCapture = getPieceAt(dest, &destColor, &destPiece);
     
-    auto & own       = isWhite ? _whitePieces : _blackPieces;
-    auto & others    = isWhite ? _blackPieces : _whitePieces;
+    if (isCapture && ((destColor == color) || (destPiece == attributes::ChessPieceName::kKing)))
+    {
+        return false;
+    }
     
-    attributes::ChessPieceName capturedPiece;
+    uint8_t flags = isCapture ? PackedMove::kCapture : PackedMove::kQuiet;
     
-    if (others.getPieceAt(inMove.dest, &capturedPiece))
+    if (piece == attributes::ChessPieceName::kPawn)
     {
-        if (capturedPiece == attributes::ChessPieceName::kKing)
+        uint8_t lastRow = (color == attributes::ChessColor::kWhite) ? 7 : 0;
+        
+        if (abs(dest.getRow() - src.getRow()) == 2)
         {
-            return false;
+            flags = PackedMove::kDoublePawnPush;
         }
+        else if (!isCapture && (dest.index == _enPassant.index) &&
+                 (dest.getCol() != src.getCol()))
+        {
+            flags = PackedMove::kEnPassant;
+        }
+        else if (dest.getRow() == lastRow)
+        {
+            flags = (isCapture ?
+                     PackedMove::kQueenPromotionCapture : PackedMove::kQueenPromotion);
+        }
+    }
+    else if ((piece == attributes::ChessPieceName::kKing) &&
+             (dest.getRow() == src.getRow()) && (abs(dest.getCol() - src.getCol()) == 2))
+    {
+        uint8_t rookIndex = (dest.getCol() > src.getCol()) ? src.index + 3 : src.index - 4;
         
-        own.board(capturedPiece) &= ~dest;
-        
-        outSideEffect->src  = (*dest.begin()).getPosition();
-        outSideEffect->dest = Position::outside();
+        if (_mailbox[rookIndex] == _toPieceCode(color, attributes::ChessPieceName::kRook))
+        {
+            flags = ((dest.getCol() > src.getCol()) ?
+                     PackedMove::kKingCastle : PackedMove::kQueenCastle);
+        }
+    }
+    
+    *outMove = PackedMove(src, dest, flags);
+    
+    return true;
+}
+
+void
+ChessEngine::makeMove(PackedMove inMove)
+{
+    UndoInfo undo;
+    
+    undo.move           = inMove;
+    undo.captured       = kNoPiece;
+    undo.castlingRights = _castlingRights;
+    undo.enPassant      = _enPassant;
+    undo.halfMoveClock  = _halfMoveClock;
+    undo.hashKey        = _hashKey;
+    undo.pawnKey        = _pawnKey;
+    
+    auto us     = _currTurn;
+    auto them   = _opposite(us);
+    auto src    = inMove.getSrc();
+    auto dest   = inMove.getDest();
+    auto flags  = inMove.getFlags();
+    auto code   = _mailbox[src.index];
+    
+    assert(code != kNoPiece);
+    assert(_getCodeColor(code) == us);
+    
+    auto piece  = _getCodePiece(code);
+    
+    if (!_enPassant.isOutside())
+    {
+        _hashKey  ^= ZobristLUT::kEnPassantFile[_enPassant.getCol()];
+        _enPassant = Square();
+    }
+    
+    _halfMoveClock++;
+    
+    if (flags == PackedMove::kEnPassant)
+    {
+        undo.captured = _toPieceCode(them, attributes::ChessPieceName::kPawn);
+        _removePiece(them, attributes::ChessPieceName::kPawn, Square(src.getRow(), dest.getCol()));
+    }
+    else if (inMove.isCapture())
+    {
+        undo.captured = _mailbox[dest.index];
+        _removePiece(them, _getCodePiece(undo.captured), dest);
+    }
+    
+    if ((undo.captured != kNoPiece) || (piece == attributes::ChessPieceName::kPawn))
+    {
+        _halfMoveClock = 0;
+    }
+    
+    _removePiece(us, piece, src);
+    _addPiece(us, inMove.isPromotion() ? inMove.getPromotion() : piece, dest);
+    
+    if (flags == PackedMove::kKingCastle)
+    {
+        _removePiece(us, attributes::ChessPieceName::kRook, Square(src.index + 3));
+        _addPiece(us, attributes::ChessPieceName::kRook, Square(src.index + 1));
+    }
+    else if (flags == PackedMove::kQueenCastle)
+    {
+        _removePiece(us, attributes::ChessPieceName::kRook, Square(src.index - 4));
+        _addPiece(us, attributes::ChessPieceName::kRook, Square(src.index - 1));
+    }
+    
+    uint8_t rights = _castlingRights & kCastlingMasks[src.index] & kCastlingMasks[dest.index];
+    
+    if (rights != _castlingRights)
+    {
+        _hashKey       ^= (ZobristLUT::getForCastling(_castlingRights) ^
+                           ZobristLUT::getForCastling(rights));
+        _castlingRights = rights;
+    }
+    
+    if (us == attributes::ChessColor::kBlack)
+    {
+        _fullMoveNumber++;
+    }
+    
+    _currTurn  = them;
+    _hashKey  ^= ZobristLUT::kBlackToMove;
+    
+    if (flags == PackedMove::kDoublePawnPush)
+    {
+        _setEnPassant(Square((src.index + dest.index) / 2));
+    }
+    
+    _undoStack.push_back(undo);
+}
+
+void
+ChessEngine::makeNullMove()
+{
+    UndoInfo undo;
+    
+    undo.move           = PackedMove();
+    undo.captured       = kNoPiece;
+    undo.castlingRights = _castlingRights;
+    undo.enPassant      = _enPassant;
+    undo.halfMoveClock  = _halfMoveClock;
+    undo.hashKey        = _hashKey;
+    undo.pawnKey        = _pawnKey;
+    
+    if (!_enPassant.isOutside())
+    {
+        _hashKey  ^= ZobristLUT::kEnPassantFile[_enPassant.getCol()];
+        _enPassant = Square();
+    }
+    
+    _halfMoveClock++;
+    
+    _currTurn  = _opposite(_currTurn);
+    _hashKey  ^= ZobristLUT::kBlackToMove;
+    
+    _undoStack.push_back(undo);
+}
+
+void
+ChessEngine::unmakeMove()
+{
+    assert(!_undoStack.empty());
+    
+    UndoInfo undo = _undoStack.back();
+    _undoStack.pop_back();
+    
+    if (undo.move.isNull())
+    {
+        _currTurn       = _opposite(_currTurn);
+        _enPassant      = undo.enPassant;
+        _halfMoveClock  = undo.halfMoveClock;
+        _hashKey        = undo.hashKey;
+        return;
+    }
+    
+    auto them   = _currTurn;
+    auto us     = _opposite(them);
+    auto src    = undo.move.getSrc();
+    auto dest   = undo.move.getDest();
+    auto flags  = undo.move.getFlags();
+    auto placed = _getCodePiece(_mailbox[dest.index]);
+    
+    if (flags == PackedMove::kKingCastle)
+    {
+        _removePiece(us, attributes::ChessPieceName::kRook, Square(src.index + 1));
+        _addPiece(us, attributes::ChessPieceName::kRook, Square(src.index + 3));
+    }
+    else if (flags == PackedMove::kQueenCastle)
+    {
+        _removePiece(us, attributes::ChessPieceName::kRook, Square(src.index - 1));
+        _addPiece(us, attributes::ChessPieceName::kRook, Square(src.index - 4));
+    }
+    
+    _removePiece(us, placed, dest);
+    _addPiece(us, undo.move.isPromotion() ? attributes::ChessPieceName::kPawn : placed, src);
+    
+    if (flags == PackedMove::kEnPassant)
+    {
+        _addPiece(them, attributes::ChessPieceName::kPawn, Square(src.getRow(), dest.getCol()));
+    }
+    else if (undo.captured != kNoPiece)
+    {
+        _addPiece(them, _getCodePiece(undo.captured), dest);
+    }
+    
+    if (us == attributes::ChessColor::kBlack)
+    {
+        _fullMoveNumber--;
+    }
+    
+    _currTurn       = us;
+    _castlingRights = undo.castlingRights;
+    _enPassant      = undo.enPassant;
+    _halfMoveClock  = undo.halfMoveClock;
+    _hashKey        = undo.hashKey;
+    _pawnKey        = undo.pawnKey;
+}
+
+bool
+ChessEngine::getPieceAt(Square inSq, attributes::ChessColor * outColor,
+                        attributes::ChessPieceName * outPiece) const
+{
+    auto code = _mailbox[inSq.index];
+    
+    if (code == kNoPiece)
+    {
+        return false;
     }
     
-    own.board(inPiece)  &= ~src;
-    own.board(inPiece)  |= dest;
+    *outColor = _getCodeColor(code);
+    *outPiece = _getCodePiece(code);
     
     return true;
 }
+
+bool
+ChessEngine::setFen(const std::string & inFen)
+{
+    std::istringstream stream(inFen);
+    std::string        board, turn, castling, enPassant;
+    int                halfMoveClock = 0, fullMoveNumber = 1;
+    
+    stream >> board >> turn >> castling >> enPassant;
+    
+    if (stream.fail())
+    {
+        return false;
+    }
+    
+    // The clocks are optional
+    stream >> halfMoveClock >> fullMoveNumber;
+    
+    std::array<uint8_t, 64> mailbox;
+    mailbox.fill(static_cast<uint8_t>(kNoPiece));
+    
+    int row = 7, col = 0;
+    
+    for (auto c : board)
+    {
+        if (c == '/')
+        {
+            if (col != 8)
+            {
+                return false;
+            }
+            
+            row--;
+            col = 0;
+        }
+        else if ((c >= '1') && (c <= '8'))
+        {
+            col += c - '0';
+        }
+        else
+        {
+            auto found = std::find(kPieceChars, kPieceChars + 6, tolower(c));
+            
+            if ((found == kPieceChars + 6) || (row < 0) || (col > 7))
+            {
+                return false;
+            }
+            
+            auto color = (isupper(c) ?
+                          attributes::ChessColor::kWhite : attributes::ChessColor::kBlack);
+            auto piece = static_cast<attributes::ChessPieceName>(found - kPieceChars);
+            
+            mailbox[Square(row, col).index] = _toPieceCode(color, piece);
+            col++;
+        }
+        
+        if (col > 8)
+        {
+            return false;
+        }
+    }
+    
+    if ((row != 0) || (col != 8) || ((turn != "w") && (turn != "b")))
+    {
+        return false;
+    }
+    
+    uint8_t rights = 0;
+    
+    for (auto c : castling)
+    {
+        switch (c)
+        {
+            case 'K': rights |= kWhiteKingSide;  break;
+            case 'Q': rights |= kWhiteQueenSide; break;
+            case 'k': rights |= kBlackKingSide;  break;
+            case 'q': rights |= kBlackQueenSide; break;
+            case '-': break;
+            default:  return false;
+        }
+    }
+    
+    Square epSquare;
+    
+    if (enPassant != "-")
+    {
+        if ((enPassant.size() != 2) || (enPassant[0] < 'a') || (enPassant[0] > 'h') ||
+            ((enPassant[1] != '3') && (enPassant[1] != '6')))
+        {
+            return false;
+        }
+        
+        epSquare = Square(enPassant[1] - '1', enPassant[0] - 'a');
+    }
+    
+    auto color = (turn == "w") ? attributes::ChessColor::kWhite : attributes::ChessColor::kBlack;
+    
+    _setPosition(mailbox, color, rights, epSquare,
+                 static_cast<uint8_t>(std::min(std::max(halfMoveClock, 0), 255)),
+                 static_cast<uint16_t>(std::max(fullMoveNumber, 1)));
+    
+    return true;
+}
+
+std::string
+ChessEngine::getFen() const
+{
+    std::string fen;
+    
+    for (int row = 7; row >= 0; row--)
+    {
+        int empty = 0;
+        
+        for (int col = 0; col < 8; col++)
+        {
+            auto code = _mailbox[Square(row, col).index];
+            
+            if (code == kNoPiece)
+            {
+                empty++;
+                continue;
+            }
+            
+            if (empty > 0)
+            {
+                fen += static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            
+            char c = kPieceChars[static_cast<uint8_t>(_getCodePiece(code))];
+            fen += ((_getCodeColor(code) == attributes::ChessColor::kWhite) ?
+                    static_cast<char>(toupper(c)) : c);
+        }
+        
+        if (empty > 0)
+        {
+            fen += static_cast<char>('0' + empty);
+        }
+        
+        if (row > 0)
+        {
+            fen += '/';
+        }
+    }
+    
+    fen += (_currTurn == attributes::ChessColor::kWhite) ? " w " : " b ";
+    
+    if (_castlingRights == 0)
+    {
+        fen += '-';
+    }
+    
+    if (_castlingRights & kWhiteKingSide)  fen += 'K';
+    if (_castlingRights & kWhiteQueenSide) fen += 'Q';
+    if (_castlingRights & kBlackKingSide)  fen += 'k';
+    if (_castlingRights & kBlackQueenSide) fen += 'q';
+    
+    fen += ' ';
+    
+    if (_enPassant.isOutside())
+    {
+        fen += '-';
+    }
+    else
+    {
+        fen += static_cast<char>('a' + _enPassant.getCol());
+        fen += static_cast<char>('1' + _enPassant.getRow());
+    }
+    
+    fen += ' ' + std::to_string(_halfMoveClock) + ' ' + std::to_string(_fullMoveNumber);
+    
+    return fen;
+}
+
+bool
+ChessEngine::getPackedPosition(PackedPosition * outPosition) const
+{
+    // Squares of the rooks of the castling rights, in the order of their bits
+    static constexpr uint8_t kCastlingRooks[4] = { 7, 0, 63, 56 };
+    
+    auto     occupied     = getOccupied();
+    auto &   data         = outPosition->data;
+    uint64_t castlingMask = 0;
+    
+    if (occupied.count() > 32)
+    {
+        return false;
+    }
+    
+    for (int i = 0; i < 4; i++)
+    {
+        auto color = (i < 2) ? attributes::ChessColor::kWhite : attributes::ChessColor::kBlack;
+        
+        if ((_castlingRights & (1 << i)) != 0)
+        {
+            if (_mailbox[kCastlingRooks[i]] !=
+                _toPieceCode(color, attributes::ChessPieceName::kRook))
+            {
+                return false;
+            }
+            
+            castlingMask |= 1ULL << kCastlingRooks[i];
+        }
+    }
+    
+    // The pawn that may be captured stands in front of the en passant square
+    auto   isWhiteToMove = (_currTurn == attributes::ChessColor::kWhite);
+    Square enPassantPawn;
+    
+    if (!_enPassant.isOutside())
+    {
+        enPassantPawn = Square(_enPassant.index + (isWhiteToMove ? -8 : 8));
+    }
+    
+    data.fill(0);
+    
+    for (int i = 0; i < 8; i++)
+    {
+        data[i] = static_cast<uint8_t>(occupied.mask >> (i * 8));
+    }
+    
+    size_t nibble = 0;
+    
+    for (auto sq : occupied)
+    {
+        auto code    = _mailbox[sq.index];
+        auto piece   = _getCodePiece(code);
+        auto isWhite = (_getCodeColor(code) == attributes::ChessColor::kWhite);
+        auto packed  = static_cast<uint8_t>(static_cast<uint8_t>(piece) + (isWhite ? 0 : 6));
+        
+        if (sq.index == enPassantPawn.index)
+        {
+            packed = 12;
+        }
+        else if ((castlingMask & (1ULL << sq.index)) != 0)
+        {
+            packed = isWhite ? 13 : 14;
+        }
+        else if ((piece == attributes::ChessPieceName::kKing) && !isWhite && !isWhiteToMove)
+        {
+            packed = 15;
+        }
+        
+        data[8 + (nibble / 2)] |= static_cast<uint8_t>(packed << ((nibble % 2) * 4));
+        nibble++;
+    }
+    
+    data[PackedPosition::kBoardSize]     = _halfMoveClock;
+    data[PackedPosition::kBoardSize + 1] = static_cast<uint8_t>(_fullMoveNumber);
+    data[PackedPosition::kBoardSize + 2] = static_cast<uint8_t>(_fullMoveNumber >> 8);
+    
+    return true;
+}
+
+bool
+ChessEngine::setPackedPosition(const PackedPosition & inPosition)
+{
+    auto &   data     = inPosition.data;
+    Bitboard occupied;
+    
+    for (int i = 0; i < 8; i++)
+    {
+        occupied.mask |= static_cast<BitboardMask>(data[i]) << (i * 8);
+    }
+    
+    size_t numPieces = occupied.count();
+    
+    if (numPieces > 32)
+    {
+        return false;
+    }
+    
+    // The side to move is only known once the black king is found
+    auto turn = attributes::ChessColor::kWhite;
+    
+    for (size_t nibble = 0; nibble < numPieces; nibble++)
+    {
+        if (((data[8 + (nibble / 2)] >> ((nibble % 2) * 4)) & 0xF) == 15)
+        {
+            turn = attributes::ChessColor::kBlack;
+        }
+    }
+    
+    std::array<uint8_t, 64> mailbox;
+    mailbox.fill(static_cast<uint8_t>(kNoPiece));
+    
+    uint8_t rights = 0;
+    size_t  nibble = 0;
+    Square  epSquare;
+    
+    for (auto sq : occupied)
+    {
+        auto packed = (data[8 + (nibble / 2)] >> ((nibble % 2) * 4)) & 0xF;
+        auto color  = (packed < 6) ? attributes::ChessColor::kWhite
+                                   : attributes::ChessColor::kBlack;
+        auto piece  = static_cast<attributes::ChessPieceName>(packed % 6);
+        
+        nibble++;
+        
+        switch (packed)
+        {
+            case 12:
+                // A pawn of the side not to move, just pushed two squares
+                color = _opposite(turn);
+                piece = attributes::ChessPieceName::kPawn;
+                
+                if (!epSquare.isOutside() ||
+                    (sq.getRow() != ((color == attributes::ChessColor::kWhite) ? 3 : 4)))
+                {
+                    return false;
+                }
+                
+                epSquare = Square(sq.index + ((color == attributes::ChessColor::kWhite) ? -8 : 8));
+                break;
+                
+            case 13:
+            case 14:
+            {
+                // A rook in its corner, with the castling right of that side
+                auto isWhite = (packed == 13);
+                auto row     = static_cast<uint8_t>(isWhite ? 0 : 7);
+                
+                color = isWhite ? attributes::ChessColor::kWhite : attributes::ChessColor::kBlack;
+                piece = attributes::ChessPieceName::kRook;
+                
+                if (sq.index == Square(row, 7).index)
+                {
+                    rights |= isWhite ? kWhiteKingSide : kBlackKingSide;
+                }
+                else if (sq.index == Square(row, 0).index)
+                {
+                    rights |= isWhite ? kWhiteQueenSide : kBlackQueenSide;
+                }
+                else
+                {
+                    return false;
+                }
+                break;
+            }
+                
+            case 15:
+                color = attributes::ChessColor::kBlack;
+                piece = attributes::ChessPieceName::kKing;
+                break;
+                
+            default:
+                break;
+        }
+        
+        mailbox[sq.index] = _toPieceCode(color, piece);
+    }
+    
+    int fullMoveNumber = data[PackedPosition::kBoardSize + 1] |
+                         (data[PackedPosition::kBoardSize + 2] << 8);
+    
+    _setPosition(mailbox, turn, rights, epSquare, data[PackedPosition::kBoardSize],
+                 static_cast<uint16_t>(std::max(fullMoveNumber, 1)));
+    
+    return true;
+}
+
+void
+ChessEngine::getSnapshot(std::vector<uint8_t> * outData) const
+{
+    assert(_undoStack.size() <= 0xFFFF);
+    
+    outData->resize(kSnapshotHeaderSize + (_undoStack.size() * kSnapshotMoveSize));
+    
+    uint8_t * data = outData->data();
+    
+    std::fill(data, data + kSnapshotHeaderSize, 0);
+    
+    _writeLittleEndian(kSnapshotMagic, 4, data);
+    _writeLittleEndian(kSnapshotVersion, 2, data + 4);
+    _writeLittleEndian(_undoStack.size(), 2, data + 6);
+    
+    for (uint8_t piece = 0; piece < BitboardCollection::kSize; piece++)
+    {
+        auto name = static_cast<attributes::ChessPieceName>(piece);
+        
+        _writeLittleEndian(_whitePieces.board(name).mask, 8, data + 8 + (piece * 8));
+        _writeLittleEndian(_blackPieces.board(name).mask, 8, data + 56 + (piece * 8));
+    }
+    
+    data[104] = static_cast<uint8_t>(_currTurn);
+    data[105] = _castlingRights;
+    data[106] = _enPassant.index;
+    data[107] = _halfMoveClock;
+    _writeLittleEndian(_fullMoveNumber, 2, data + 108);
+    _writeLittleEndian(_hashKey, 8, data + 112);
+    
+    data += kSnapshotHeaderSize;
+    
+    for (auto & undo : _undoStack)
+    {
+        _writeLittleEndian(undo.move.data, 2, data);
+        data[2] = undo.captured;
+        data[3] = undo.castlingRights;
+        data[4] = undo.enPassant.index;
+        data[5] = undo.halfMoveClock;
+        data[6] = 0;
+        data[7] = 0;
+        _writeLittleEndian(undo.hashKey, 8, data + 8);
+        _writeLittleEndian(undo.pawnKey, 8, data + 16);
+        data += kSnapshotMoveSize;
+    }
+    
+    _writeLittleEndian(_getSnapshotChecksum(outData->data(), outData->size()), 4,
+                       outData->data() + kSnapshotChecksumOffset);
+}
+
+bool
+ChessEngine::setSnapshot(const uint8_t * inData, size_t inSize)
+{
+    using attributes::ChessColor;
+    using attributes::ChessPieceName;
+    
+    if ((inSize < kSnapshotHeaderSize) || (_readLittleEndian(inData, 4) != kSnapshotMagic) ||
+        (_readLittleEndian(inData + 4, 2) != kSnapshotVersion))
+    {
+        return false;
+    }
+    
+    auto numMoves = static_cast<size_t>(_readLittleEndian(inData + 6, 2));
+    
+    if (inSize != kSnapshotHeaderSize + (numMoves * kSnapshotMoveSize))
+    {
+        return false;
+    }
+    
+    // The moves are unmade as they are, so a damaged byte anywhere must not get through
+    if (_readLittleEndian(inData + kSnapshotChecksumOffset, 4) !=
+        _getSnapshotChecksum(inData, inSize))
+    {
+        return false;
+    }
+    
+    // The state is read into another engine, which is only taken once it is found valid
+    ChessEngine snapshot;
+    Bitboard    occupied;
+    
+    snapshot._clearBoard();
+    
+    for (uint8_t piece = 0; piece < 2 * BitboardCollection::kSize; piece++)
+    {
+        auto color = (piece < BitboardCollection::kSize) ? ChessColor::kWhite : ChessColor::kBlack;
+        auto name  = static_cast<ChessPieceName>(piece % BitboardCollection::kSize);
+        auto board = Bitboard(_readLittleEndian(inData + 8 + (piece * 8), 8));
+        
+        if ((board & occupied) != 0)
+        {
+            return false;
+        }
+        
+        occupied |= board;
+        snapshot._getCollection(color).board(name) = board;
+        
+        for (auto sq : board)
+        {
+            snapshot._mailbox[sq.index] = _toPieceCode(color, name);
+        }
+    }
+    
+    snapshot._currTurn       = static_cast<ChessColor>(inData[104]);
+    snapshot._castlingRights = inData[105];
+    snapshot._enPassant      = Square(inData[106]);
+    snapshot._halfMoveClock  = inData[107];
+    snapshot._fullMoveNumber = static_cast<uint16_t>(_readLittleEndian(inData + 108, 2));
+    snapshot._hashKey        = _readLittleEndian(inData + 112, 8);
+    snapshot._pawnKey        = snapshot.computePawnKey();
+    
+    auto isWhiteToMove = (snapshot._currTurn == ChessColor::kWhite);
+    
+    if ((inData[104] > 1) || (snapshot._castlingRights > kAllCastlingRights))
+    {
+        return false;
+    }
+    
+    // An en passant square is behind a pawn that was just pushed two squares
+    if (!snapshot._enPassant.isOutside())
+    {
+        auto ep = snapshot._enPassant.index;
+        
+        if ((ep >= 64) || (snapshot._enPassant.getRow() != (isWhiteToMove ? 5 : 2)) ||
+            (snapshot._mailbox[ep] != kNoPiece) ||
+            (snapshot._mailbox[isWhiteToMove ? ep - 8 : ep + 8] !=
+             _toPieceCode(_opposite(snapshot._currTurn), ChessPieceName::kPawn)))
+        {
+            return false;
+        }
+    }
+    
+    // A key that is not that of the board tells of a snapshot of a build with other Zobrist
+    // numbers, whose keys of the moves would not match either
+    if (snapshot.computeHashKey() != snapshot._hashKey)
+    {
+        return false;
+    }
+    
+    // The moves cannot be checked without replaying them, only that their fields are in range
+    const uint8_t * data = inData + kSnapshotHeaderSize;
+    
+    snapshot._undoStack.resize(numMoves);
+    
+    for (auto & undo : snapshot._undoStack)
+    {
+        auto captured = data[2];
+        
+        undo.move.data      = static_cast<uint16_t>(_readLittleEndian(data, 2));
+        undo.captured       = captured;
+        undo.castlingRights = data[3];
+        undo.enPassant      = Square(data[4]);
+        undo.halfMoveClock  = data[5];
+        undo.hashKey        = _readLittleEndian(data + 8, 8);
+        undo.pawnKey        = _readLittleEndian(data + 16, 8);
+        data += kSnapshotMoveSize;
+        
+        if (((captured != kNoPiece) &&
+             (((captured & 0x7) >= BitboardCollection::kSize) || (captured > 0xF))) ||
+            (undo.castlingRights > kAllCastlingRights) ||
+            (!undo.enPassant.isOutside() && (undo.enPassant.index >= 64)))
+        {
+            return false;
+        }
+    }
+    
+    // The last move was made by the side not to move, and left one of its pieces where it went
+    if ((numMoves > 0) &&
+        (_getCodeColor(snapshot._mailbox[snapshot._undoStack.back().move.getDest().index]) !=
+         _opposite(snapshot._currTurn)))
+    {
+        return false;
+    }
+    
+    snapshot._network = _network;
+    
+    if (_network != nullptr)
+    {
+        _network->refresh(snapshot, &snapshot._accumulator);
+    }
+    
+    *this = std::move(snapshot);
+    
+    return true;
+}
+
+void
+ChessEngine::getKeysAfter(PackedMove inMove, ZobristKey * outHashKey,
+                          ZobristKey * outPawnKey) const
+{
+    auto us     = _currTurn;
+    auto them   = _opposite(us);
+    auto src    = inMove.getSrc();
+    auto dest   = inMove.getDest();
+    auto flags  = inMove.getFlags();
+    auto piece  = _getCodePiece(_mailbox[src.index]);
+    auto moved  = ZobristLUT::getForPiece(us, piece, src.index) ^
+                  ZobristLUT::getForPiece(us, inMove.isPromotion() ? inMove.getPromotion() : piece,
+                                          dest.index);
+    
+    ZobristKey hashKey  = _hashKey ^ moved ^ ZobristLUT::kBlackToMove;
+    ZobristKey pawnKey  = _pawnKey;
+    
+    if (piece == attributes::ChessPieceName::kPawn)
+    {
+        pawnKey ^= ZobristLUT::getForPiece(us, piece, src.index);
+        
+        if (!inMove.isPromotion())
+        {
+            pawnKey ^= ZobristLUT::getForPiece(us, piece, dest.index);
+        }
+    }
+    
+    if (flags == PackedMove::kEnPassant)
+    {
+        auto captured = ZobristLUT::getForPiece(them, attributes::ChessPieceName::kPawn,
+                                                Square(src.getRow(), dest.getCol()).index);
+        hashKey ^= captured;
+        pawnKey ^= captured;
+    }
+    else if (inMove.isCapture())
+    {
+        auto capturedPiece = _getCodePiece(_mailbox[dest.index]);
+        auto captured      = ZobristLUT::getForPiece(them, capturedPiece, dest.index);
+        
+        hashKey ^= captured;
+        
+        if (capturedPiece == attributes::ChessPieceName::kPawn)
+        {
+            pawnKey ^= captured;
+        }
+    }
+    else if (flags == PackedMove::kKingCastle)
+    {
+        hashKey ^= (ZobristLUT::getForPiece(us, attributes::ChessPieceName::kRook, src.index + 3) ^
+                    ZobristLUT::getForPiece(us, attributes::ChessPieceName::kRook, src.index + 1));
+    }
+    else if (flags == PackedMove::kQueenCastle)
+    {
+        hashKey ^= (ZobristLUT::getForPiece(us, attributes::ChessPieceName::kRook, src.index - 4) ^
+                    ZobristLUT::getForPiece(us, attributes::ChessPieceName::kRook, src.index - 1));
+    }
+    
+    if (!_enPassant.isOutside())
+    {
+        hashKey ^= ZobristLUT::kEnPassantFile[_enPassant.getCol()];
+    }
+    
+    uint8_t rights = _castlingRights & kCastlingMasks[src.index] & kCastlingMasks[dest.index];
+    
+    if (rights != _castlingRights)
+    {
+        hashKey ^= (ZobristLUT::getForCastling(_castlingRights) ^
+                    ZobristLUT::getForCastling(rights));
+    }
+    
+    *outHashKey = hashKey;
+    *outPawnKey = pawnKey;
+}
+
+ZobristKey
+ChessEngine::computeHashKey() const
+{
+    ZobristKey key = 0;
+    
+    for (auto color : { attributes::ChessColor::kBlack, attributes::ChessColor::kWhite })
+    {
+        for (uint8_t piece = 0; piece < BitboardCollection::kSize; piece++)
+        {
+            auto name = static_cast<attributes::ChessPieceName>(piece);
+            
+            for (auto sq : getPieces(color, name))
+            {
+                key ^= ZobristLUT::getForPiece(color, name, sq.index);
+            }
+        }
+    }
+    
+    key ^= ZobristLUT::getForCastling(_castlingRights);
+    
+    if (!_enPassant.isOutside())
+    {
+        key ^= ZobristLUT::kEnPassantFile[_enPassant.getCol()];
+    }
+    
+    if (_currTurn == attributes::ChessColor::kBlack)
+    {
+        key ^= ZobristLUT::kBlackToMove;
+    }
+    
+    return key;
+}
+
+ZobristKey
+ChessEngine::computePawnKey() const
+{
+    ZobristKey key = ZobristLUT::kNoPawns;
+    
+    for (auto color : { attributes::ChessColor::kBlack, attributes::ChessColor::kWhite })
+    {
+        for (auto sq : getPieces(color, attributes::ChessPieceName::kPawn))
+        {
+            key ^= ZobristLUT::getForPiece(color, attributes::ChessPieceName::kPawn, sq.index);
+        }
+    }
+    
+    return key;
+}
+
+void
+ChessEngine::setNetwork(const nnue::Network * inNetwork)
+{
+    _network = inNetwork;
+    
+    if (_network != nullptr)
+    {
+        _network->refresh(*this, &_accumulator);
+    }
+}
+
+void
+ChessEngine::_addPiece(attributes::ChessColor inColor,
+                       attributes::ChessPieceName inPiece, Square inSq)
+{
+    assert(_mailbox[inSq.index] == kNoPiece);
+    
+    auto key = ZobristLUT::getForPiece(inColor, inPiece, inSq.index);
+    
+    _getCollection(inColor).board(inPiece) |= Bitboard::getForSquare(inSq);
+    _mailbox[inSq.index] = _toPieceCode(inColor, inPiece);
+    
+    _hashKey ^= key;
+    
+    if (inPiece == attributes::ChessPieceName::kPawn)
+    {
+        _pawnKey ^= key;
+    }
+    
+    if (_network != nullptr)
+    {
+        _network->addPiece(&_accumulator, inColor, inPiece, inSq.index);
+    }
+}
+
+void
+ChessEngine::_removePiece(attributes::ChessColor inColor,
+                          attributes::ChessPieceName inPiece, Square inSq)
+{
+    assert(_mailbox[inSq.index] == _toPieceCode(inColor, inPiece));
+    
+    auto key = ZobristLUT::getForPiece(inColor, inPiece, inSq.index);
+    
+    _getCollection(inColor).board(inPiece) &= ~Bitboard::getForSquare(inSq);
+    _mailbox[inSq.index] = kNoPiece;
+    
+    _hashKey ^= key;
+    
+    if (inPiece == attributes::ChessPieceName::kPawn)
+    {
+        _pawnKey ^= key;
+    }
+    
+    if (_network != nullptr)
+    {
+        _network->removePiece(&_accumulator, inColor, inPiece, inSq.index);
+    }
+}
+
+void
+ChessEngine::_setEnPassant(Square inSq)
+{
+    // The pawn that was pushed past inSq stands one row further from its side
+    auto   capturer = _currTurn;
+    Square pushed(inSq.getRow() + ((capturer == attributes::ChessColor::kWhite) ? -1 : 1),
+                  inSq.getCol());
+    
+    static constexpr BitboardMask kNotFileA = ~0x0101010101010101ULL;
+    static constexpr BitboardMask kNotFileH = ~0x8080808080808080ULL;
+    
+    auto     pushedMask = Bitboard::getForSquare(pushed).mask;
+    Bitboard neighbours(((pushedMask << 1) & kNotFileA) | ((pushedMask >> 1) & kNotFileH));
+    
+    // Like Polyglot, only keep (and hash) the square if a capture is possible
+    if ((getPieces(capturer, attributes::ChessPieceName::kPawn) & neighbours) != 0)
+    {
+        _enPassant = inSq;
+        _hashKey  ^= ZobristLUT::kEnPassantFile[inSq.getCol()];
+    }
+}
+
+void
+ChessEngine::_clearBoard()
+{
+    for (uint8_t piece = 0; piece < BitboardCollection::kSize; piece++)
+    {
+        auto name = static_cast<attributes::ChessPieceName>(piece);
+        
+        _whitePieces.board(name) = Bitboard();
+        _blackPieces.board(name) = Bitboard();
+    }
+    
+    _mailbox.fill(static_cast<uint8_t>(kNoPiece));
+}
+
+void
+ChessEngine::_setPosition(const std::array<uint8_t, 64> & inMailbox, attributes::ChessColor inTurn,
+                          uint8_t inCastlingRights, Square inEnPassant, uint8_t inHalfMoveClock,
+                          uint16_t inFullMoveNumber)
+{
+    _clearBoard();
+    
+    for (uint8_t index = 0; index < 64; index++)
+    {
+        auto code = inMailbox[index];
+        
+        if (code != kNoPiece)
+        {
+            _getCollection(_getCodeColor(code)).board(_getCodePiece(code)) |=
+                Bitboard::getForSquare(Square(index));
+            _mailbox[index] = code;
+        }
+    }
+    
+    _currTurn       = inTurn;
+    _castlingRights = inCastlingRights;
+    _enPassant      = Square();
+    _halfMoveClock  = inHalfMoveClock;
+    _fullMoveNumber = inFullMoveNumber;
+    
+    _undoStack.clear();
+    
+    _hashKey = computeHashKey();
+    _pawnKey = computePawnKey();
+    
+    if (!inEnPassant.isOutside())
+    {
+        _setEnPassant(inEnPassant);
+    }
+    
+    if (_network != nullptr)
+    {
+        _network->refresh(*this, &_accumulator);
+    }
+}
@@ -12,8 +12,13 @@
 
 #include "Chess.h"
 #include "Bitboard.h"
+#include "Zobrist.h"
+#include "Nnue.h"
 
+#include <algorithm>
 #include <array>
+#include <string>
+#include <vector>
 
 namespace chessEngine
 {
@@ -93,6 +98,148 @@ namespace chessEngine
         { return src.isOutside() && dest.isOutside(); }
     };
     
+    /**
+     @class          PackedMove
+     
+     @brief          A move as used by the engine, packed into 16 bits
+     
+     @discussion     Bits 0-5 hold the source square, bits 6-11 the destination square and bits
+     12-15 the flags. The zero move (a1 to a1) is used as the null move.
+     */
+    struct PackedMove
+    {
+        enum Flags : uint8_t
+        {
+            kQuiet                  = 0,
+            kDoublePawnPush         = 1,
+            kKingCastle             = 2,
+            kQueenCastle            = 3,
+            kCapture                = 4,
+            kEnPassant              = 5,
+            kKnightPromotion        = 8,
+            kBishopPromotion        = 9,
+            kRookPromotion          = 10,
+            kQueenPromotion         = 11,
+            kKnightPromotionCapture = 12,
+            kBishopPromotionCapture = 13,
+            kRookPromotionCapture   = 14,
+            kQueenPromotionCapture  = 15
+        };
+        
+        uint16_t                    data;
+        
+        PackedMove() :
+        data(0)
+        { }
+        
+        PackedMove(Square inSrc, Square inDest, uint8_t inFlags) :
+        data(static_cast<uint16_t>(inSrc.index | (inDest.index << 6) | (inFlags << 12)))
+        { }
+        
+        Square                      getSrc() const { return Square(data & 0x3F); }
+        
+        Square                      getDest() const { return Square((data >> 6) & 0x3F); }
+        
+        uint8_t                     getFlags() const { return data >> 12; }
+        
+        bool                        isNull() const { return data == 0; }
+        
+        bool                        isCapture() const { return (getFlags() & kCapture) != 0; }
+        
+        bool                        isPromotion() const
+        { return (getFlags() & kKnightPromotion) != 0; }
+        
+        bool                        isCastle() const
+        { return (getFlags() == kKingCastle) || (getFlags() == kQueenCastle); }
+        
+        /**
+         @brief         Piece a pawn promotes to, only valid if isPromotion()
+         */
+        attributes::ChessPieceName  getPromotion() const
+        { return static_cast<attributes::ChessPieceName>((getFlags() & 0x3) + 1); }
+        
+        bool                        operator== (PackedMove inOther) const
+        { return data == inOther.data; }
+        
+        bool                        operator!= (PackedMove inOther) const
+        { return data != inOther.data; }
+        
+        /**
+         @brief         Move in long algebraic notation, e.g. e2e4 or e7e8q
+         */
+        std::string                 toString() const;
+    };
+    
+    /**
+     @class          MoveList
+     
+     @brief          A fixed capacity list of moves, so that generating moves never allocates
+     */
+    struct MoveList
+    {
+        static constexpr size_t     kMaxMoves = 256;
+        
+        PackedMove                  moves[kMaxMoves];
+        size_t                      size;
+        
+        MoveList() :
+        size(0)
+        { }
+        
+        void                        add(PackedMove inMove)
+        { assert(size < kMaxMoves); moves[size++] = inMove; }
+        
+        void                        clear() { size = 0; }
+        
+        bool                        isEmpty() const { return size == 0; }
+        
+        bool                        contains(PackedMove inMove) const
+        { return std::find(begin(), end(), inMove) != end(); }
+        
+        PackedMove                  operator[] (size_t inIndex) const { return moves[inIndex]; }
+        
+        PackedMove *                begin() { return moves; }
+        PackedMove *                end() { return moves + size; }
+        
+        const PackedMove *          begin() const { return moves; }
+        const PackedMove *          end() const { return moves + size; }
+    };
+    
+    /**
+     @class          PackedPosition
+     
+     @brief          A position in 32 bytes, for storing and sending many of them
+     
+     @discussion     The first 8 bytes are the occupied squares, little endian. A 4 bit code for
+     the piece on every occupied square follows, in the order of the squares, two to a byte with
+     the lower square in the low nibble: 0 to 5 for the white pieces and 6 to 11 for the black
+     ones, in the order of ChessPieceName. The rest of the state is folded into the codes:
+     
+     - 12, the pawn that may be captured en passant
+     - 13, a white rook that may still castle, 14 a black one
+     - 15, the black king, with Black to move
+     
+     So the 24 bytes of the board are the same for equal positions, and compare and hash as they
+     are. The half move clock and the full move number follow, in 1 and 2 bytes, and the rest is
+     zero.
+     */
+    struct PackedPosition
+    {
+        static constexpr size_t     kSize      = 32;
+        static constexpr size_t     kBoardSize = 24;
+        
+        std::array<uint8_t, kSize>  data;
+        
+        PackedPosition()
+        { data.fill(0); }
+        
+        bool                        operator== (const PackedPosition & inOther) const
+        { return data == inOther.data; }
+        
+        bool                        operator!= (const PackedPosition & inOther) const
+        { return data != inOther.data; }
+    };
+    
     /**
      @class          ChessEngine
      
@@ -129,27 +276,59 @@ namespace chessEngine
             Bitboard &              board(attributes::ChessPieceName inPiece)
             { return _pos[static_cast<uint8_t>(inPiece)]; }
             
+            Bitboard                board(attributes::ChessPieceName inPiece) const
+            { return _pos[static_cast<uint8_t>(inPiece)]; }
+            
             BitboardCollection(Bitboard inPawnsPos, Bitboard inKnightsPos,
                                Bitboard inBishopsPos, Bitboard inRooksPos,
                                Bitboard inQueensPos, Bitboard inKingPos) :
             _pos({ inPawnsPos, inKnightsPos, inBishopsPos, inRooksPos, inQueensPos, inKingPos })
             { }
             
-            Bitboard                getAll()
-            { Bitboard b; for (auto i : _pos) b &= i; return b; }
+            Bitboard                getAll() const
+            { Bitboard b; for (auto i : _pos) b |= i; return b; }
             
             bool                    getPieceAt(const Position & inPos,
                                                attributes::ChessPieceName * outPiece);
         };
         
-        BitboardCollection          _whitePieces;
-        BitboardCollection          _blackPieces;
+        /**
+         @class          UndoInfo
+         
+         @brief          State that a move destroys, kept to unmake it
+         */
+        struct UndoInfo
+        {
+            PackedMove              move;
+            uint8_t                 captured;
+            uint8_t                 castlingRights;
+            Square                  enPassant;
+            uint8_t                 halfMoveClock;
+            ZobristKey              hashKey;
+            ZobristKey              pawnKey;
+        };
         
-        attributes::ChessColor      _currTurn;
+    public:
+        enum CastlingRights : uint8_t
+        {
+            kWhiteKingSide          = 1 << 0,
+            kWhiteQueenSide         = 1 << 1,
+            kBlackKingSide          = 1 << 2,
+            kBlackQueenSide         = 1 << 3,
+            kAllCastlingRights      = 0x0F
+        };
         
-        static bool                 _sIsInit;
+        static constexpr uint8_t    kNoPiece = 0xFF;
+        static constexpr size_t     kMaxGamePly = 1024;
+        
+        static constexpr uint32_t   kSnapshotMagic          = 0x534E4543;  // "CENS"
+        static constexpr uint16_t   kSnapshotVersion        = 2;
+        static constexpr size_t     kSnapshotHeaderSize     = 128;
+        static constexpr size_t     kSnapshotMoveSize       = 24;
+        static constexpr size_t     kSnapshotChecksumOffset = 120;
+        
+        static const char * const   kStartFen;
         
-    public:
         ChessEngine();
         
         /**
@@ -162,27 +341,330 @@ namespace chessEngine
         bool                        attemptMove(const Move & inMove, Move * outSideEffect,
                                                 bool * outPromotion);
         
+        /**
+         @brief         Attempt an engine move
+         
+         @discussion    Same as the other variant, for moves coming from a search. The move has to
+         be legal in the current position.
+         */
+        bool                        attemptMove(PackedMove inMove, Move * outSideEffect,
+                                                bool * outPromotion);
+        
+        /**
+         @brief         Generate the pseudo legal moves of the side to move
+         
+         @discussion    Moves may leave the own king in check, which isLegal filters. Castling
+         moves are only generated if the king does not pass an attacked square.
+         
+         @param     outMoves        list the moves are appended to
+         @param     inCapturesOnly  only generate captures and queen promotions
+         */
+        void                        generateMoves(MoveList * outMoves,
+                                                  bool inCapturesOnly = false) const;
+        
+        /**
+         @brief         Generate the legal moves of the side to move
+         */
+        void                        generateLegalMoves(MoveList * outMoves) const;
+        
+        /**
+         @brief         Check if a pseudo legal move leaves the own king safe
+         */
+        bool                        isLegal(PackedMove inMove) const;
+        
+        /**
+         @brief         Check if the side to move is in check
+         */
+        bool                        isInCheck() const;
+        
+        /**
+         @brief         Check if a square is attacked by the pieces of a color
+         */
+        bool                        isSquareAttacked(Square inSq,
+                                                     attributes::ChessColor inByColor) const
+        { return _getAttackers(inSq, inByColor, getOccupied()) != 0; }
+        
+        /**
+         @brief         Check for a draw by the fifty move rule, repetition or insufficient
+         material
+         
+         @discussion    A single repetition of a position is enough, as searches treat it as a
+         draw. Checkmate on the hundredth half move is not considered.
+         */
+        bool                        isDraw() const;
+        
+        /**
+         @brief         Check if a color has a piece other than pawns and the king
+         */
+        bool                        hasNonPawnMaterial(attributes::ChessColor inColor) const;
+        
+        /**
+         @brief         Make a move
+         
+         @discussion    The move is expected to be at least pseudo legal. The bitboards, keys and
+         the network accumulator are all updated incrementally.
+         */
+        void                        makeMove(PackedMove inMove);
+        
+        /**
+         @brief         Unmake the last move made with makeMove
+         */
+        void                        unmakeMove();
+        
+        /**
+         @brief         Pass the turn without moving, as used by null move pruning
+         
+         @discussion    Unmade with unmakeMove. Must not be used when in check.
+         */
+        void                        makeNullMove();
+        
+        /**
+         @brief         Set up a position from a FEN string
+         
+         @return        false if the FEN could not be parsed, in which case the position is
+         unchanged
+         */
+        bool                        setFen(const std::string & inFen);
+        
+        /**
+         @brief         Get the FEN string of the position
+         */
+        std::string                 getFen() const;
+        
+        /**
+         @brief         Pack the position
+         
+         @return        false if it has more than 32 pieces, or a castling right without its rook
+         */
+        bool                        getPackedPosition(PackedPosition * outPosition) const;
+        
+        /**
+         @brief         Set up a packed position
+         
+         @return        false if the data is not a packed position, in which case the position is
+         unchanged
+         */
+        bool                        setPackedPosition(const PackedPosition & inPosition);
+        
+        /**
+         @brief         Write the full state of the engine, to park a game and pick it up later
+         
+         @discussion    A header of kSnapshotHeaderSize bytes holds the magic number and the
+         version in 4 and 2 bytes, the number of moves made in 2, the 12 bitboards of the pieces,
+         the white ones first, in 8 each, the side to move, the castling rights, the en passant
+         square and the half move clock in a byte each, the full move number in 2, the hash key
+         in 8 from byte 112, and at kSnapshotChecksumOffset the CRC-32 of the whole snapshot, taken
+         with these 4 bytes as zero. Every move that can be unmade follows in kSnapshotMoveSize
+         bytes, with the state it destroyed and the keys before it, so that repetitions are still
+         found. Everything is little endian.
+         */
+        void                        getSnapshot(std::vector<uint8_t> * outData) const;
+        
+        /**
+         @brief         Restore a snapshot written by getSnapshot, without replaying its moves
+         
+         @discussion    The network is not part of the snapshot. The one set is kept, and its
+         accumulator refreshed.
+         
+         @return        false if the data is not a valid snapshot of this version, or its
+         checksum does not match, in which case the engine is unchanged
+         */
+        bool                        setSnapshot(const uint8_t * inData, size_t inSize);
+        
         attributes::ChessColor      getCurrMove() const { return _currTurn; }
         
+        /**
+         @brief         Get the bitboard of a piece type of a color
+         */
+        Bitboard                    getPieces(attributes::ChessColor inColor,
+                                              attributes::ChessPieceName inPiece) const
+        { return _getCollection(inColor).board(inPiece); }
+        
+        /**
+         @brief         Get the bitboard of all the pieces of a color
+         */
+        Bitboard                    getAllPieces(attributes::ChessColor inColor) const
+        { return _getCollection(inColor).getAll(); }
+        
+        /**
+         @brief         Get the bitboard of all the pieces on the board
+         */
+        Bitboard                    getOccupied() const
+        { return _whitePieces.getAll() | _blackPieces.getAll(); }
+        
+        /**
+         @brief         Get the piece on a square
+         
+         @return        false if the square is empty
+         */
+        bool                        getPieceAt(Square inSq, attributes::ChessColor * outColor,
+                                               attributes::ChessPieceName * outPiece) const;
+        
+        uint8_t                     getCastlingRights() const { return _castlingRights; }
+        
+        /**
+         @brief         En passant target square, outside if there is no capture possible
+         */
+        Square                      getEnPassantSquare() const { return _enPassant; }
+        
+        uint8_t                     getHalfMoveClock() const { return _halfMoveClock; }
+        
+        uint16_t                    getFullMoveNumber() const { return _fullMoveNumber; }
+        
+        /**
+         @brief         Last move made, null if there is none
+         */
+        PackedMove                  getLastMove() const
+        { return _undoStack.empty() ? PackedMove() : _undoStack.back().move; }
+        
+        /**
+         @brief         Number of moves that can be unmade
+         */
+        size_t                      getNumMovesMade() const { return _undoStack.size(); }
+        
+        /**
+         @brief         Make room for this many more moves, so that making them never allocates
+         
+         @discussion    kMaxGamePly moves are reserved from the start, only longer games need this.
+         */
+        void                        reserveMoves(size_t inNumMoves)
+        { _undoStack.reserve(_undoStack.size() + inNumMoves); }
+        
+        /**
+         @brief         Zobrist key of the position, maintained incrementally
+         */
+        ZobristKey                  getHashKey() const { return _hashKey; }
+        
+        /**
+         @brief         Zobrist key of the pawns alone, maintained incrementally
+         
+         @discussion    Keys the pawn hash table. Only changes on pawn moves, captures of pawns
+         and promotions.
+         */
+        ZobristKey                  getPawnKey() const { return _pawnKey; }
+        
+        /**
+         @brief         Keys of the position after a move, without making it
+
+         @discussion    Meant for prefetching the entries of the child before the move is made.
+         The en passant square that a double push may set is left out, so the hash key is off for
+         those moves.
+         */
+        void                        getKeysAfter(PackedMove inMove, ZobristKey * outHashKey,
+                                                 ZobristKey * outPawnKey) const;
+        
+        /**
+         @brief         Compute the position key from scratch
+         */
+        ZobristKey                  computeHashKey() const;
+        
+        /**
+         @brief         Compute the pawn key from scratch
+         */
+        ZobristKey                  computePawnKey() const;
+        
+        /**
+         @brief         Use a network for evaluation
+         
+         @discussion    The network is not owned and has to outlive the engine. Pass nullptr to
+         go back to the handcrafted evaluation.
+         */
+        void                        setNetwork(const nnue::Network * inNetwork);
+        
+        const nnue::Network *       getNetwork() const { return _network; }
+        
+        /**
+         @brief         Accumulator of the network, only valid if a network is set
+         */
+        const nnue::Accumulator &   getAccumulator() const { return _accumulator; }
+        
         static void                 init();
         
     private:
-        bool                        _attemptPawnMove(attributes::ChessColor inColor,
-                                                     const Move & inMove, Move * outSideEffect,
-                                                     bool * outPromotion);
-        bool                        _attemptKnightMove(attributes::ChessColor inColor,
-                                                       const Move & inMove, Move * outSideEffect);
-        bool                        _attemptBishopMove(attributes::ChessColor inColor,
-                                                       const Move & inMove, Move * outSideEffect);
-        bool                        _attemptRookMove(attributes::ChessColor inColor,
-                                                     const Move & inMove, Move * outSideEffect);
-        bool                        _attemptQueenMove(attributes::ChessColor inColor,
-                                                      const Move & inMove, Move * outSideEffect);
-        bool                        _attemptKingMove(attributes::ChessColor inColor,
-                                                     const Move & inMove, Move * outSideEffect);
-        
-        bool                        _simpleMoveAndKill(attributes::ChessPieceName inPiece,
-                                                       attributes::ChessColor inColor,
-                                                       const Move & inMove, Move * outSideEffect);
+        BitboardCollection &        _getCollection(attributes::ChessColor inColor)
+        { return (inColor == attributes::ChessColor::kWhite) ? _whitePieces : _blackPieces; }
+        
+        const BitboardCollection &  _getCollection(attributes::ChessColor inColor) const
+        { return (inColor == attributes::ChessColor::kWhite) ? _whitePieces : _blackPieces; }
+        
+        /**
+         @brief         Convert a move of the board into an engine move
+         
+         @return        false if there is no own piece on the source square or the destination
+         holds an own piece
+         */
+        bool                        _toPackedMove(const Move & inMove, PackedMove * outMove) const;
+        
+        /**
+         @brief         Get the pieces of a color attacking a square, with sliders seeing through
+         everything not in inOccupied
+         */
+        Bitboard                    _getAttackers(Square inSq, attributes::ChessColor inByColor,
+                                                  Bitboard inOccupied) const;
+        
+        void                        _addPromotions(MoveList * outMoves, Square inSrc,
+                                                   Square inDest, bool inIsCapture,
+                                                   bool inCapturesOnly) const;
+        
+        /**
+         @brief         Put a piece on an empty square, updating the keys and the accumulator
+         */
+        void                        _addPiece(attributes::ChessColor inColor,
+                                              attributes::ChessPieceName inPiece, Square inSq);
+        
+        /**
+         @brief         Remove a piece from a square, updating the keys and the accumulator
+         */
+        void                        _removePiece(attributes::ChessColor inColor,
+                                                 attributes::ChessPieceName inPiece, Square inSq);
+        
+        /**
+         @brief         Set the en passant square if a pawn of the side to move can capture
+         */
+        void                        _setEnPassant(Square inSq);
+        
+        void                        _clearBoard();
+        
+        /**
+         @brief         Set up a position from the piece code of every square, or kNoPiece
+         */
+        void                        _setPosition(const std::array<uint8_t, 64> & inMailbox,
+                                                 attributes::ChessColor inTurn,
+                                                 uint8_t inCastlingRights, Square inEnPassant,
+                                                 uint8_t inHalfMoveClock,
+                                                 uint16_t inFullMoveNumber);
+        
+        static uint8_t              _toPieceCode(attributes::ChessColor inColor,
+                                                 attributes::ChessPieceName inPiece)
+        { return static_cast<uint8_t>((static_cast<uint8_t>(inColor) << 3) |
+                                      static_cast<uint8_t>(inPiece)); }
+        
+        static attributes::ChessColor       _getCodeColor(uint8_t inCode)
+        { return static_cast<attributes::ChessColor>(inCode >> 3); }
+        
+        static attributes::ChessPieceName   _getCodePiece(uint8_t inCode)
+        { return static_cast<attributes::ChessPieceName>(inCode & 0x7); }
+        
+        BitboardCollection          _whitePieces;
+        BitboardCollection          _blackPieces;
+        
+        std::array<uint8_t, 64>     _mailbox;
+        
+        attributes::ChessColor      _currTurn;
+        
+        uint8_t                     _castlingRights;
+        Square                      _enPassant;
+        uint8_t                     _halfMoveClock;
+        uint16_t                    _fullMoveNumber;
+        
+        ZobristKey                  _hashKey;
+        ZobristKey                  _pawnKey;
+        
+        std::vector<UndoInfo>       _undoStack;
+        
+        const nnue::Network *       _network;
+        nnue::Accumulator           _accumulator;
+        
+        static bool                 _sIsInit;
     };
 }
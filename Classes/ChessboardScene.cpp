@@ -10,6 +10,11 @@
 
 #include "ChessboardScene.h"
 #include "ChessEngine.h"
+#include "EngineService.h"
+#include "OpeningBook.h"
+
+#include <cstdlib>
+#include <sstream>
 
 
 using namespace cocos2d;
@@ -479,13 +484,30 @@ Chessboard::movePiece(const chessEngine::Position & inSrc,
     }
 }
 
+void
+Chessboard::promotePiece(const chessEngine::Position & inPos,
+                         attributes::ChessColor        inColor,
+                         attributes::ChessPieceName    inPiece,
+                         cocos2d::Node *               inNode)
+{
+    movePiece(inPos, Position::outside());
+    
+    auto piece = chessTiles[inPos.row][inPos.col]->createChessPieceOnTile(inColor, inPiece);
+    piece->addAsChildTo(inNode, 1);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
 #pragma mark ChessboardScene
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+const char * const ChessboardScene::kOpeningBookFile = "OpeningBook.bin";
+
 ChessboardScene::~ChessboardScene()
 {
+    // First, so that no search outlives the engine or calls back into the scene
+    delete engineService;
+    delete openingBook;
     delete background;
     delete board;
     delete engine;
@@ -538,6 +560,17 @@ ChessboardScene::init()
     
     board->addAsChildrenTo(this);
     
+    analysisLabel = Label::createWithSystemFont("", "Arial", boxLen * 0.3f);
+    analysisLabel->setPosition(Point(this->getBoundingBox().getMidX(),
+                                     bottomLeft.y + (boxLen * 8.75f)));
+    analysisLabel->setTextColor(Color4B::WHITE);
+    this->addChild(analysisLabel, 2);
+    
+    engineService = new EngineService();
+    openingBook   = new OpeningBook();
+    computerColor = attributes::ChessColor::kBlack;
+    isPondering   = false;
+    
     auto touchEventListener = EventListenerTouchOneByOne::create();
     touchEventListener->onTouchBegan = [] (Touch * touch, Event * event) -> bool {
         auto scene = dynamic_cast<ChessboardScene *>(event->getCurrentTarget());
@@ -547,9 +580,64 @@ ChessboardScene::init()
     
     this->_eventDispatcher->addEventListenerWithSceneGraphPriority(touchEventListener, this);
     
+    // The book is optional, and has to be a plain file to be mapped
+    auto bookPath = FileUtils::getInstance()->fullPathForFilename(kOpeningBookFile);
+    
+    if (!bookPath.empty())
+    {
+        openingBook->open(bookPath);
+    }
+    
+    _startEngine();
+    
     return true;
 }
 
+void
+ChessboardScene::showMove(const chessEngine::Move & inMove,
+                          const chessEngine::Move & inSideEffect,
+                          bool inIsPromotion)
+{
+    if (!inSideEffect.src.isOutside())
+    {
+        board->movePiece(inSideEffect.src, inSideEffect.dest);
+    }
+    
+    board->movePiece(inMove.src, inMove.dest);
+    
+    if (inIsPromotion)
+    {
+        attributes::ChessColor     color;
+        attributes::ChessPieceName piece;
+        
+        engine->getPieceAt(inMove.dest.getSquare(), &color, &piece);
+        board->promotePiece(inMove.dest, color, piece, this);
+    }
+}
+
+void
+ChessboardScene::onMoveCommitted()
+{
+    bool isPonderHit = (isPondering && (engine->getLastMove() == ponderMove));
+    
+    ponderMove  = PackedMove();
+    isPondering = false;
+    
+    // On a hit the running search already is the computer's reply
+    if (isPonderHit && engineService->ponderHit())
+    {
+        return;
+    }
+    
+    _startEngine();
+}
+
+bool
+ChessboardScene::isPlayerTurn() const
+{
+    return engine->getCurrMove() != computerColor;
+}
+
 void
 ChessboardScene::_touchReact(cocos2d::Point inTouchLocation)
 {
@@ -557,17 +645,154 @@ ChessboardScene::_touchReact(cocos2d::Point inTouchLocation)
     
     if (board->getPointBoardLocation(inTouchLocation, &row, &col))
     {
-        auto event = new ChessboardTouchEvent(row, col);
-        stateMachine->receiveEvent(event);
+        ChessboardTouchEvent event(row, col);
+        stateMachine->receiveEvent(&event);
     }
     else
     {
-        auto event = new AppEvent(ChessAppEvents::kChessboardClickedInEmptySpace);
-        stateMachine->receiveEvent(event);
+        AppEvent event(ChessAppEvents::kChessboardClickedInEmptySpace);
+        stateMachine->receiveEvent(&event);
     }
 }
 
 
+void
+ChessboardScene::_startEngine()
+{
+    MoveList legalMoves;
+    engine->generateLegalMoves(&legalMoves);
+    
+    if (legalMoves.isEmpty())
+    {
+        engineService->cancel();
+        analysisLabel->setString(engine->isInCheck() ? "Checkmate" : "Stalemate");
+        return;
+    }
+    
+    auto onResult = [this] (const SearchResult & inResult) { _onEngineResult(inResult); };
+    
+    SearchLimits limits;
+    limits.moveTimeMs = kComputerMoveTimeMs;
+    
+    if (!isPlayerTurn())
+    {
+        SearchResult bookResult;
+        
+        if (openingBook->isOpen())
+        {
+            auto random = static_cast<uint32_t>(cocos2d::random());
+            bookResult.bestMove = openingBook->pickMove(*engine, random);
+        }
+        
+        // A book move is played at once, with no search to wait for
+        if (!bookResult.bestMove.isNull())
+        {
+            engineService->cancel();
+            analysisLabel->setString("Book");
+            _onEngineResult(bookResult);
+            return;
+        }
+        
+        auto sideToMove = engine->getCurrMove();
+        
+        engineService->startSearch(*engine, limits, [this, sideToMove] (const SearchInfo & inInfo) {
+            _onEngineProgress(inInfo, sideToMove);
+        }, onResult);
+        return;
+    }
+    
+    if (!ponderMove.isNull() && legalMoves.contains(ponderMove))
+    {
+        ChessEngine ponderPosition(*engine);
+        ponderPosition.makeMove(ponderMove);
+        
+        MoveList answers;
+        ponderPosition.generateLegalMoves(&answers);
+        
+        // Search the answer to the expected reply while the player thinks, unless it ends the game
+        if (!answers.isEmpty())
+        {
+            auto sideToMove = ponderPosition.getCurrMove();
+            
+            limits.ponder = true;
+            isPondering   = true;
+            
+            engineService->startSearch(ponderPosition, limits,
+                                       [this, sideToMove] (const SearchInfo & inInfo) {
+                _onEngineProgress(inInfo, sideToMove);
+            }, onResult);
+            return;
+        }
+    }
+    
+    auto sideToMove = engine->getCurrMove();
+    
+    // Analyse the player's position until the move is committed
+    engineService->startSearch(*engine, SearchLimits(), [this, sideToMove] (const SearchInfo & inInfo) {
+        _onEngineProgress(inInfo, sideToMove);
+    }, nullptr);
+}
+
+void
+ChessboardScene::_onEngineProgress(const chessEngine::SearchInfo & inInfo,
+                                   attributes::ChessColor inSideToMove)
+{
+    static constexpr size_t kMaxPvMoves = 6;
+    
+    // Scores are shown from white's point of view
+    bool isWhite = (inSideToMove == attributes::ChessColor::kWhite);
+    int  score   = isWhite ? inInfo.score : -inInfo.score;
+    char buffer[32];
+    
+    if (inInfo.isMate())
+    {
+        int mateIn = inInfo.getMateInMoves();
+        snprintf(buffer, sizeof(buffer), "#%d", (score > 0) ? abs(mateIn) : -abs(mateIn));
+    }
+    else
+    {
+        snprintf(buffer, sizeof(buffer), "%+.2f", score / 100.0);
+    }
+    
+    std::ostringstream text;
+    
+    if (isPondering)
+    {
+        text << "after " << ponderMove.toString() << ":  ";
+    }
+    
+    text << "depth " << inInfo.depth << "   " << buffer << "  ";
+    
+    for (size_t i = 0; (i < inInfo.pv.size()) && (i < kMaxPvMoves); i++)
+    {
+        text << " " << inInfo.pv[i].toString();
+    }
+    
+    analysisLabel->setString(text.str());
+}
+
+void
+ChessboardScene::_onEngineResult(const chessEngine::SearchResult & inResult)
+{
+    Move sideEffect;
+    bool isPromotion;
+    
+    auto bestMove = inResult.bestMove;
+    Move move(bestMove.getSrc().getPosition(), bestMove.getDest().getPosition());
+    
+    if (bestMove.isNull() || !engine->attemptMove(bestMove, &sideEffect, &isPromotion))
+    {
+        chessEngine::log("Engine returned no move to play\n");
+        return;
+    }
+    
+    showMove(move, sideEffect, isPromotion);
+    
+    ponderMove = inResult.ponderMove;
+    _startEngine();
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark -
 #pragma mark ChessboardSceneStaticState
@@ -605,9 +830,9 @@ ChessboardSceneStaticState::_react(AppEvent * inEvent)
             auto clickEvent = dynamic_cast<ChessboardTouchEvent *>(inEvent);
             auto tile       = _scene->board->chessTiles[clickEvent->rowIndex][clickEvent->colIndex];
             
-            LOG("Touch on %d, %d\n\n", clickEvent->rowIndex, clickEvent->colIndex);
+            chessEngine::log("Touch on %d, %d\n\n", clickEvent->rowIndex, clickEvent->colIndex);
             
-            if ((tile->hasPiece()) &&
+            if ((tile->hasPiece()) && _scene->isPlayerTurn() &&
                  (_scene->engine->getCurrMove() == tile->getPiece()->getColor()))
             {
                 return new ChessboardScenePieceClickedState(_scene, clickEvent->rowIndex,
@@ -679,7 +904,7 @@ ChessboardScenePieceClickedState::_react(AppEvent * inEvent)
             auto newTile    = tiles[clickEvent->rowIndex][clickEvent->colIndex];
             auto tile       = tiles[_rowIndex][_colIndex];
             
-            LOG("Touch on %d, %d\n\n", clickEvent->rowIndex, clickEvent->colIndex);
+            chessEngine::log("Touch on %d, %d\n\n", clickEvent->rowIndex, clickEvent->colIndex);
             
             // If the same tile is clicked, then stay in this state
             if ((clickEvent->rowIndex == _rowIndex) && (clickEvent->colIndex == _colIndex))
@@ -707,12 +932,8 @@ ChessboardScenePieceClickedState::_react(AppEvent * inEvent)
             
             if (_scene->engine->attemptMove(move, &sideEffect, &isPromotion))
             {
-                if (!sideEffect.src.isOutside())
-                {
-                    _movePiece(sideEffect);
-                }
-                
-                _movePiece(move);
+                _scene->showMove(move, sideEffect, isPromotion);
+                _scene->onMoveCommitted();
             }
             
             return new ChessboardSceneStaticState(_scene);
@@ -728,8 +949,3 @@ ChessboardScenePieceClickedState::_react(AppEvent * inEvent)
     }
 }
 
-void
-ChessboardScenePieceClickedState::_movePiece(const chessEngine::Move & inMove)
-{
-    _scene->board->movePiece(inMove.src, inMove.dest);
-}
@@ -15,13 +15,17 @@
 
 #include "Chess.h"
 #include "ChessAppStateMachine.h"
+#include "ChessEngine.h"
+
+#include "cocos2d.h"
 
 
 namespace chessEngine
 {
-    class ChessEngine;
-    struct Position;
-    struct Move;
+    class EngineService;
+    class OpeningBook;
+    struct SearchInfo;
+    struct SearchResult;
 }
 
 namespace render
@@ -336,6 +340,19 @@ namespace render
         void                        movePiece(const chessEngine::Position & inSrc,
                                               const chessEngine::Position & inDst);
         
+        /**
+         @brief          Replace a promoted pawn with its new piece
+         
+         @param     inPos       the square of the pawn
+         @param     inColor     color of the pawn
+         @param     inPiece     the piece it promoted to
+         @param     inNode      the parent node of the pieces
+         */
+        void                        promotePiece(const chessEngine::Position & inPos,
+                                                 attributes::ChessColor        inColor,
+                                                 attributes::ChessPieceName    inPiece,
+                                                 cocos2d::Node *               inNode);
+        
 		ChessTileGrid				chessTiles;
         ChessPieceObjectVector *    chessPieces;
 	};
@@ -363,19 +380,71 @@ namespace render
 	    
         CREATE_FUNC(ChessboardScene);
         
+        /**
+         @brief          Show a move that the engine has made on the board
+         
+         @param     inMove          the move
+         @param     inSideEffect    side effect of the move as reported by the engine
+         @param     inIsPromotion   indicate that the move was a promotion
+         */
+        void                        showMove(const chessEngine::Move & inMove,
+                                             const chessEngine::Move & inSideEffect,
+                                             bool inIsPromotion);
+        
+        /**
+         @brief          Let the engine react to a move that was committed
+         
+         @discussion     If the computer was pondering the move that was played, its search goes
+         on. Otherwise the running search is cancelled and the next one started, either the reply
+         of the computer, or while the player thinks, its answer to the expected reply or an
+         analysis of the player's position.
+         */
+        void                        onMoveCommitted();
+        
+        /**
+         @brief          Check if the player may move pieces now
+         */
+        bool                        isPlayerTurn() const;
+        
 	private:
         void                        _setStateMachine(AppStateMachine * inStateMachine)
         { stateMachine = inStateMachine; }
         
         void                        _touchReact(cocos2d::Point inTouchLocation);
         
+        void                        _startEngine();
+        
+        void                        _onEngineProgress(const chessEngine::SearchInfo & inInfo,
+                                                      attributes::ChessColor inSideToMove);
+        
+        void                        _onEngineResult(const chessEngine::SearchResult & inResult);
+        
     public:
+        static constexpr int64_t    kComputerMoveTimeMs = 3000;
+        static const char * const   kOpeningBookFile;
+        
         AppStateMachine *           stateMachine;
         
         Chessboard *                board;
         ChessObjectWithColor *      background;
+        cocos2d::Label *            analysisLabel;
         
         chessEngine::ChessEngine *  engine;
+        chessEngine::EngineService * engineService;
+        
+        /**
+         @brief          Book the computer plays from without searching, closed if the app has none
+         */
+        chessEngine::OpeningBook *  openingBook;
+        
+        attributes::ChessColor      computerColor;
+        
+        /**
+         @brief          Reply of the player that the computer expects, and whether it is searching
+         its answer to it
+         */
+        chessEngine::PackedMove     ponderMove;
+        bool                        isPondering;
 	};
     
     
@@ -444,8 +513,6 @@ namespace render
         virtual void                _exit() override;
         virtual AppState *          _react(AppEvent * inEvent) override;
         
-        void                        _movePiece(const chessEngine::Move & inMove);
-        
         ChessboardScene *           _scene;
         
         const uint8_t               _rowIndex;
@@ -0,0 +1,180 @@
+/***************************************************************************************************
+ *
+ *  @file       EngineService.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Runs searches off the cocos thread
+ *
+ **************************************************************************************************/
+
+#include "EngineService.h"
+
+#include "cocos2d.h"
+
+using namespace chessEngine;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark EngineService
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+EngineService::EngineService(size_t inHashSizeMb) :
+_table(inHashSizeMb),
+_search(&_table),
+_isRunning(false),
+_isPondering(false),
+_quit(false),
+_latestId(std::make_shared<std::atomic<uint32_t>>(0))
+{
+    // Started last, once everything it uses is constructed
+    _worker = std::thread(&EngineService::_run, this);
+}
+
+EngineService::~EngineService()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _quit = true;
+        _pending.reset();
+        _latestId->fetch_add(1);
+        _search.stop();
+    }
+
+    _condition.notify_one();
+    _worker.join();
+}
+
+void
+EngineService::startSearch(const ChessEngine & inPosition, const SearchLimits & inLimits,
+                           const ProgressCallback & inOnProgress,
+                           const ResultCallback & inOnResult)
+{
+    std::unique_ptr<Request> request(new Request{ inPosition, inLimits, inOnProgress, inOnResult, 0 });
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        request->id = _latestId->fetch_add(1) + 1;
+        _pending    = std::move(request);
+
+        // The worker picks the new request up as soon as the running search returns
+        _search.stop();
+    }
+
+    _condition.notify_one();
+}
+
+void
+EngineService::cancel()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _pending.reset();
+    _latestId->fetch_add(1);
+
+    if (_isRunning)
+    {
+        _search.stop();
+    }
+}
+
+bool
+EngineService::ponderHit()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if ((_pending != nullptr) && _pending->limits.ponder)
+    {
+        _pending->limits.ponder = false;
+        return true;
+    }
+
+    if ((_pending == nullptr) && _isRunning && _isPondering)
+    {
+        _isPondering = false;
+        _search.ponderHit();
+        return true;
+    }
+
+    return false;
+}
+
+bool
+EngineService::isSearching() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _isRunning || (_pending != nullptr);
+}
+
+void
+EngineService::_run()
+{
+    while (true)
+    {
+        std::unique_ptr<Request> request;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            _isRunning   = false;
+            _isPondering = false;
+            _condition.wait(lock, [this] { return _quit || (_pending != nullptr); });
+
+            if (_quit)
+            {
+                return;
+            }
+
+            request      = std::move(_pending);
+            _isRunning   = true;
+            _isPondering = request->limits.ponder;
+
+            // Stops and hits meant for an earlier request must not affect this one. Any later one
+            // is taken under the lock, so it cannot be lost.
+            _search.resetStop();
+            _search.resetPonderHit();
+        }
+
+        auto id         = request->id;
+        auto onProgress = request->onProgress;
+        auto onResult   = request->onResult;
+
+        auto result = _search.run(request->position, request->limits,
+                                  [this, id, onProgress] (const SearchInfo & inInfo) {
+            if (onProgress)
+            {
+                _post(id, std::bind(onProgress, inInfo));
+            }
+        });
+
+        if (onResult)
+        {
+            _post(id, std::bind(onResult, result));
+        }
+    }
+}
+
+void
+EngineService::_post(uint32_t inRequestId, const std::function<void()> & inFunc)
+{
+    auto latestId = _latestId;
+
+    if (latestId->load() != inRequestId)
+    {
+        return;
+    }
+
+    auto scheduler = cocos2d::Director::getInstance()->getScheduler();
+
+    scheduler->performFunctionInCocosThread([latestId, inRequestId, inFunc] {
+        // The request may have been cancelled while the function was queued
+        if (latestId->load() == inRequestId)
+        {
+            inFunc();
+        }
+    });
+}
@@ -0,0 +1,127 @@
+/***************************************************************************************************
+ *
+ *  @file       EngineService.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Runs searches off the cocos thread
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace chessEngine
+{
+    /**
+     @class          EngineService
+
+     @brief          Runs searches on a worker thread and reports back on the cocos thread
+
+     @discussion     The cocos thread only ever copies the position and posts a request, so it is
+     never blocked by a search. Progress and results are delivered through
+     Scheduler::performFunctionInCocosThread. Starting a search cancels the running one, and the
+     callbacks of a cancelled search are never called, even if they were already posted.
+
+     The table and the search, with its history and last principal variation, are kept from one
+     search to the next, so that the searches of a game build on each other.
+     */
+    class EngineService
+    {
+    public:
+        using ProgressCallback = std::function<void(const SearchInfo &)>;
+        using ResultCallback   = std::function<void(const SearchResult &)>;
+
+        EngineService(size_t inHashSizeMb = TranspositionTable::kDefaultSizeMb);
+
+        /**
+         @brief         Stops the running search and waits for the worker thread to finish
+         */
+        ~EngineService();
+
+        EngineService(const EngineService &) = delete;
+        EngineService & operator= (const EngineService &) = delete;
+
+        /**
+         @brief         Search a position, cancelling the running search
+
+         @param     inPosition      the position, copied before returning
+         @param     inLimits        limits of the search, no limits to analyse until cancelled
+         @param     inOnProgress    called on the cocos thread after every iteration, may be null
+         @param     inOnResult      called on the cocos thread when the search ends, unless it
+         was cancelled
+         */
+        void                        startSearch(const ChessEngine & inPosition,
+                                                const SearchLimits & inLimits,
+                                                const ProgressCallback & inOnProgress,
+                                                const ResultCallback & inOnResult);
+
+        /**
+         @brief         Cancel the running search, if any, without waiting for it
+         */
+        void                        cancel();
+
+        /**
+         @brief         The expected reply was played, let the ponder search go on as a normal
+         search instead of starting over
+
+         @discussion    The search keeps its tree and the table, and its result is delivered to
+         the callback given when it started.
+
+         @return        false if no ponder search is pending or running, in which case the caller
+         should start a new search
+         */
+        bool                        ponderHit();
+
+        /**
+         @brief         Check if a search is pending or running
+         */
+        bool                        isSearching() const;
+
+    private:
+        struct Request
+        {
+            ChessEngine             position;
+            SearchLimits            limits;
+            ProgressCallback        onProgress;
+            ResultCallback          onResult;
+            uint32_t                id;
+        };
+
+        void                        _run();
+
+        /**
+         @brief         Run a function on the cocos thread, unless the request is stale by then
+         */
+        void                        _post(uint32_t inRequestId, const std::function<void()> & inFunc);
+
+        TranspositionTable          _table;
+        Search                      _search;
+
+        mutable std::mutex          _mutex;
+        std::condition_variable     _condition;
+        std::unique_ptr<Request>    _pending;
+        bool                        _isRunning;
+        bool                        _isPondering;
+        bool                        _quit;
+
+        /**
+         @brief         Id of the latest request, shared with the posted callbacks so that they
+         can check it even after the service is gone
+         */
+        std::shared_ptr<std::atomic<uint32_t>> _latestId;
+
+        std::thread                 _worker;
+    };
+}
@@ -0,0 +1,476 @@
+/***************************************************************************************************
+ *
+ *  @file       EpdSuite.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Test suites of positions with the moves to find or avoid
+ *
+ **************************************************************************************************/
+
+#include "EpdSuite.h"
+
+#include "PgnReader.h"
+#include "PgnWriter.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace chessEngine;
+
+/**
+ @brief         Opcode of an operation and its operands
+ */
+using EpdOperation = std::pair<std::string, std::vector<std::string>>;
+
+/**
+ @brief         Check if a field of a line is a number, as the clocks are
+ */
+static bool
+_isNumber(const std::string & inField)
+{
+    return !inField.empty() &&
+           (inField.find_first_not_of("0123456789") == std::string::npos);
+}
+
+/**
+ @brief         Read the operations after the position, each an opcode and its operands up to a
+ semicolon, an operand in quotes taken as it is
+ */
+static bool
+_parseOperations(const std::string & inText, std::vector<EpdOperation> * outOperations)
+{
+    size_t index = 0;
+
+    while (true)
+    {
+        index = inText.find_first_not_of(" \t\r", index);
+
+        if (index == std::string::npos)
+        {
+            return true;
+        }
+
+        EpdOperation operation;
+        size_t       end = inText.find_first_of(" \t\r;", index);
+
+        operation.first = inText.substr(index, end - index);
+        index           = end;
+
+        while (true)
+        {
+            index = inText.find_first_not_of(" \t\r", index);
+
+            if (index == std::string::npos)
+            {
+                // Every operation ends with a semicolon
+                return false;
+            }
+
+            if (inText[index] == ';')
+            {
+                index++;
+                break;
+            }
+
+            if (inText[index] == '"')
+            {
+                end = inText.find('"', index + 1);
+
+                if (end == std::string::npos)
+                {
+                    return false;
+                }
+
+                operation.second.push_back(inText.substr(index + 1, end - index - 1));
+                index = end + 1;
+            }
+            else
+            {
+                end = inText.find_first_of(" \t\r;", index);
+                operation.second.push_back(inText.substr(index, end - index));
+                index = end;
+            }
+        }
+
+        outOperations->push_back(operation);
+    }
+}
+
+static bool
+_parseMoves(const ChessEngine & inPosition, const std::vector<std::string> & inOperands,
+            std::vector<PackedMove> * outMoves)
+{
+    for (auto & operand : inOperands)
+    {
+        auto move = PgnParser::parseSan(inPosition, StringView(operand.data(), operand.size()));
+
+        if (move.isNull())
+        {
+            return false;
+        }
+
+        outMoves->push_back(move);
+    }
+
+    return !inOperands.empty();
+}
+
+static EpdResult
+_searchPosition(const EpdPosition & inPosition, const EpdOptions & inOptions,
+                TranspositionTable * inOutTable, Search * inOutSearch)
+{
+    ChessEngine position;
+    EpdResult   result;
+    bool        isKept = false;
+
+    position.setFen(inPosition.fen);
+
+    // Every position is searched from scratch, so that the results do not depend on the order
+    inOutTable->clear();
+    inOutSearch->clearHistory();
+
+    auto start  = std::chrono::steady_clock::now();
+    auto search = inOutSearch->run(position, inOptions.limits, [&] (const SearchInfo & inInfo) {
+        if ((inInfo.multiPv != 1) || inInfo.pv.empty())
+        {
+            return;
+        }
+
+        if (!inPosition.isSolution(inInfo.pv[0]))
+        {
+            isKept = false;
+        }
+        else if (!isKept)
+        {
+            isKept                = true;
+            result.solutionNodes  = inInfo.nodes;
+            result.solutionTimeMs = inInfo.timeMs;
+        }
+    });
+
+    result.move     = search.bestMove;
+    result.score    = search.score;
+    result.depth    = search.depth;
+    result.nodes    = search.stats.nodes;
+    result.timeMs   = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    result.isSolved = !result.move.isNull() && inPosition.isSolution(result.move);
+
+    // The move of a search stopped before its first iteration was never reported
+    if (result.isSolved && !isKept)
+    {
+        result.solutionNodes  = result.nodes;
+        result.solutionTimeMs = result.timeMs;
+    }
+
+    return result;
+}
+
+static std::string
+_toJsonString(const std::string & inText)
+{
+    std::string json = "\"";
+
+    for (char c : inText)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            json += '\\';
+            json += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            json += escape;
+        }
+        else
+        {
+            json += c;
+        }
+    }
+
+    return json + "\"";
+}
+
+static std::string
+_toJsonMoves(const ChessEngine & inPosition, const std::vector<PackedMove> & inMoves)
+{
+    ChessEngine position = inPosition;
+    std::string json     = "[";
+
+    for (size_t i = 0; i < inMoves.size(); i++)
+    {
+        json += ((i == 0) ? "" : ",") + _toJsonString(PgnWriter::toSan(&position, inMoves[i]));
+    }
+
+    return json + "]";
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark EpdPosition
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+EpdPosition::isSolution(PackedMove inMove) const
+{
+    if (!bestMoves.empty())
+    {
+        return std::find(bestMoves.begin(), bestMoves.end(), inMove) != bestMoves.end();
+    }
+
+    return std::find(avoidMoves.begin(), avoidMoves.end(), inMove) == avoidMoves.end();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark EpdSuite
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+EpdSuite::parseLine(const std::string & inLine, EpdPosition * outPosition)
+{
+    std::istringstream stream(inLine);
+    std::string        fields[4];
+    std::string        clocks[2] = { "0", "1" };
+    std::string        field;
+
+    for (auto & positionField : fields)
+    {
+        if (!(stream >> positionField))
+        {
+            return false;
+        }
+    }
+
+    // The clocks are numbers, where an opcode starts with a letter
+    for (auto & clock : clocks)
+    {
+        auto mark = stream.tellg();
+
+        if (!(stream >> field) || !_isNumber(field))
+        {
+            stream.clear();
+            stream.seekg(mark);
+            break;
+        }
+
+        clock = field;
+    }
+
+    std::vector<EpdOperation> operations;
+    std::string               rest;
+
+    std::getline(stream, rest);
+
+    if (!_parseOperations(rest, &operations))
+    {
+        return false;
+    }
+
+    ChessEngine position;
+
+    if (!position.setFen(fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3] + " " +
+                         clocks[0] + " " + clocks[1]))
+    {
+        return false;
+    }
+
+    EpdPosition epd;
+
+    epd.fen = position.getFen();
+
+    for (auto & operation : operations)
+    {
+        if ((operation.first == "bm") && !_parseMoves(position, operation.second, &epd.bestMoves))
+        {
+            return false;
+        }
+
+        if ((operation.first == "am") && !_parseMoves(position, operation.second, &epd.avoidMoves))
+        {
+            return false;
+        }
+
+        if ((operation.first == "id") && !operation.second.empty())
+        {
+            epd.id = operation.second[0];
+        }
+    }
+
+    if (epd.bestMoves.empty() && epd.avoidMoves.empty())
+    {
+        return false;
+    }
+
+    *outPosition = epd;
+
+    return true;
+}
+
+bool
+EpdSuite::load(const std::string & inPath, std::vector<EpdPosition> * outPositions,
+               int * outErrorLine)
+{
+    std::ifstream file(inPath);
+    std::string   line;
+    int           lineNumber = 0;
+
+    if (outErrorLine != nullptr)
+    {
+        *outErrorLine = 0;
+    }
+
+    if (!file)
+    {
+        return false;
+    }
+
+    while (std::getline(file, line))
+    {
+        auto        start = line.find_first_not_of(" \t\r");
+        EpdPosition position;
+
+        lineNumber++;
+
+        if ((start == std::string::npos) || (line[start] == '#'))
+        {
+            continue;
+        }
+
+        if (!parseLine(line, &position))
+        {
+            if (outErrorLine != nullptr)
+            {
+                *outErrorLine = lineNumber;
+            }
+
+            return false;
+        }
+
+        outPositions->push_back(position);
+    }
+
+    return true;
+}
+
+std::vector<EpdResult>
+EpdSuite::run(const std::vector<EpdPosition> & inPositions, const EpdOptions & inOptions,
+              const ProgressCallback & inOnProgress)
+{
+    std::vector<EpdResult> results(inPositions.size());
+    std::atomic<size_t>    nextPosition(0);
+    std::mutex             progressMutex;
+
+    auto work = [&] {
+        TranspositionTable table(inOptions.hashSizeMb);
+        Search             search(&table);
+
+        for (auto index = nextPosition++; index < inPositions.size(); index = nextPosition++)
+        {
+            results[index] = _searchPosition(inPositions[index], inOptions, &table, &search);
+
+            if (inOnProgress)
+            {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                inOnProgress(index, results[index]);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    auto numThreads = std::min(std::max(inOptions.numThreads, 1),
+                               static_cast<int>(std::max<size_t>(inPositions.size(), 1)));
+
+    for (int i = 1; i < numThreads; i++)
+    {
+        threads.emplace_back(work);
+    }
+
+    work();
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    return results;
+}
+
+std::string
+EpdSuite::toJson(const std::vector<EpdPosition> & inPositions,
+                 const std::vector<EpdResult> & inResults, const EpdOptions & inOptions)
+{
+    std::ostringstream positions;
+    uint64_t           numSolved = 0, nodes = 0, solutionNodes = 0;
+    int64_t            timeMs = 0, solutionTimeMs = 0;
+
+    for (size_t i = 0; i < std::min(inPositions.size(), inResults.size()); i++)
+    {
+        auto &      epd    = inPositions[i];
+        auto &      result = inResults[i];
+        ChessEngine position;
+
+        position.setFen(epd.fen);
+
+        numSolved += result.isSolved ? 1 : 0;
+        nodes     += result.nodes;
+        timeMs    += result.timeMs;
+
+        if (result.isSolved)
+        {
+            solutionNodes  += result.solutionNodes;
+            solutionTimeMs += result.solutionTimeMs;
+        }
+
+        positions << ((i == 0) ? "" : ",")
+                  << "{\"id\":" << _toJsonString(epd.id)
+                  << ",\"fen\":" << _toJsonString(epd.fen)
+                  << ",\"bestMoves\":" << _toJsonMoves(position, epd.bestMoves)
+                  << ",\"avoidMoves\":" << _toJsonMoves(position, epd.avoidMoves)
+                  << ",\"move\":" << (result.move.isNull() ? std::string("null") :
+                                      _toJsonString(PgnWriter::toSan(&position, result.move)))
+                  << ",\"solved\":" << (result.isSolved ? "true" : "false")
+                  << ",\"score\":" << result.score
+                  << ",\"depth\":" << result.depth
+                  << ",\"nodes\":" << result.nodes
+                  << ",\"timeMs\":" << result.timeMs;
+
+        if (result.isSolved)
+        {
+            positions << ",\"solutionNodes\":" << result.solutionNodes
+                      << ",\"solutionTimeMs\":" << result.solutionTimeMs;
+        }
+
+        positions << "}";
+    }
+
+    std::ostringstream json;
+
+    json << "{\"limits\":{\"depth\":" << inOptions.limits.depth
+         << ",\"nodes\":" << inOptions.limits.nodes
+         << ",\"moveTimeMs\":" << inOptions.limits.moveTimeMs << "}"
+         << ",\"threads\":" << inOptions.numThreads
+         << ",\"hashSizeMb\":" << inOptions.hashSizeMb
+         << ",\"positions\":" << inResults.size()
+         << ",\"solved\":" << numSolved
+         << ",\"nodes\":" << nodes
+         << ",\"timeMs\":" << timeMs
+         << ",\"solutionNodes\":" << solutionNodes
+         << ",\"solutionTimeMs\":" << solutionTimeMs
+         << ",\"results\":[" << positions.str() << "]}";
+
+    return json.str();
+}
@@ -0,0 +1,164 @@
+/***************************************************************************************************
+ *
+ *  @file       EpdSuite.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Test suites of positions with the moves to find or avoid
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "TimeManager.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @class          EpdPosition
+
+     @brief          A position of a suite, with its bm and am operations
+     */
+    struct EpdPosition
+    {
+        /**
+         @brief         FEN of the position, with the clocks of the line or the default ones
+         */
+        std::string                 fen;
+
+        /**
+         @brief         Operand of the id operation, empty if there is none
+         */
+        std::string                 id;
+
+        std::vector<PackedMove>     bestMoves;
+        std::vector<PackedMove>     avoidMoves;
+
+        /**
+         @brief         Check if a move is one of the best moves, or if there are none, not one of
+         the moves to avoid
+         */
+        bool                        isSolution(PackedMove inMove) const;
+    };
+
+    /**
+     @class          EpdOptions
+
+     @brief          How the positions of a suite are searched
+     */
+    struct EpdOptions
+    {
+        /**
+         @brief         Limits of the search of every position, usually a move time or a number
+         of nodes
+         */
+        SearchLimits                limits;
+
+        /**
+         @brief         Positions searched at once, each by a search on one thread
+         */
+        int                         numThreads;
+
+        /**
+         @brief         Size of the table of every thread, cleared before every position
+         */
+        size_t                      hashSizeMb;
+
+        EpdOptions() :
+        numThreads(1), hashSizeMb(16)
+        {
+            limits.moveTimeMs = 1000;
+        }
+    };
+
+    /**
+     @class          EpdResult
+
+     @brief          Outcome of the search of a position
+     */
+    struct EpdResult
+    {
+        PackedMove                  move;
+        int                         score;
+        int                         depth;
+        uint64_t                    nodes;
+        int64_t                     timeMs;
+
+        bool                        isSolved;
+
+        /**
+         @brief         Nodes and time of the first iteration from which the search kept to a
+         solution, only valid if isSolved
+         */
+        uint64_t                    solutionNodes;
+        int64_t                     solutionTimeMs;
+
+        EpdResult() :
+        score(0), depth(0), nodes(0), timeMs(0), isSolved(false), solutionNodes(0),
+        solutionTimeMs(0)
+        { }
+    };
+
+    /**
+     @class          EpdSuite
+
+     @brief          Reads the positions of EPD files and searches them on all the threads
+     */
+    class EpdSuite
+    {
+    public:
+        /**
+         @brief         Called after every position, one call at a time
+
+         @param     inIndex         index of the position, which come in any order
+         */
+        using ProgressCallback = std::function<void(size_t inIndex, const EpdResult &)>;
+
+        /**
+         @brief         Read a line of an EPD file
+
+         @discussion    The moves of the bm and am operations are in standard algebraic notation,
+         the other operations are left out. A line may carry the clocks after the four fields of
+         the position, as a FEN does.
+
+         @return        false if the position or one of its moves is not valid, or if there is
+         neither a bm nor an am operation
+         */
+        static bool                 parseLine(const std::string & inLine,
+                                              EpdPosition * outPosition);
+
+        /**
+         @brief         Add the positions of an EPD file, skipping empty lines and comments
+         starting with #
+
+         @param     outErrorLine    number of the line that is not valid, from 1, may be null
+
+         @return        false if the file could not be read or a line is not valid
+         */
+        static bool                 load(const std::string & inPath,
+                                         std::vector<EpdPosition> * outPositions,
+                                         int * outErrorLine = nullptr);
+
+        /**
+         @brief         Search every position
+
+         @return        results in the order of the positions
+         */
+        static std::vector<EpdResult> run(const std::vector<EpdPosition> & inPositions,
+                                          const EpdOptions & inOptions,
+                                          const ProgressCallback & inOnProgress = nullptr);
+
+        /**
+         @brief         Report of a run as a JSON object, with the totals and every position
+         */
+        static std::string          toJson(const std::vector<EpdPosition> & inPositions,
+                                           const std::vector<EpdResult> & inResults,
+                                           const EpdOptions & inOptions);
+    };
+}
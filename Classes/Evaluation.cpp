@@ -0,0 +1,341 @@
+/***************************************************************************************************
+ *
+ *  @file       Evaluation.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Static evaluation of a position
+ *
+ **************************************************************************************************/
+
+#include "Evaluation.h"
+#include "ChessEngine.h"
+
+using namespace chessEngine;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Weights
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static constexpr int kPieceValues[6]     = { 100, 320, 330, 500, 900, 0 };
+
+static constexpr int kDoubledPenalty     = 12;
+static constexpr int kIsolatedPenalty    = 10;
+static constexpr int kBackwardPenalty    = 8;
+
+// Indexed by the row relative to the side of the pawn
+static constexpr int kPassedBonus[8]     = { 0, 5, 10, 20, 35, 60, 100, 0 };
+
+static constexpr int kShieldNearBonus    = 10;
+static constexpr int kShieldFarBonus     = 5;
+static constexpr int kShieldMissing      = 12;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Masks
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static constexpr uint8_t kBlack = static_cast<uint8_t>(attributes::ChessColor::kBlack);
+static constexpr uint8_t kWhite = static_cast<uint8_t>(attributes::ChessColor::kWhite);
+
+// File of square index (r, c) is the column c, i.e. bit c of every row
+static Bitboard  _sFileMasks[8];
+static Bitboard  _sAdjacentFileMasks[8];
+
+// Squares in front of a pawn on its own and the adjacent files
+static Bitboard  _sPassedMasks[2][64];
+
+// Squares on the adjacent files on the same row or behind a pawn
+static Bitboard  _sSupportMasks[2][64];
+
+// Squares from which an enemy pawn attacks the stop square of a pawn
+static Bitboard  _sStopAttackerMasks[2][64];
+
+static inline uint8_t
+_relativeRow(uint8_t inColor, uint8_t inRow)
+{
+    return (inColor == kWhite) ? inRow : 7 - inRow;
+}
+
+static Bitboard
+_rowsAbove(uint8_t inRow)
+{
+    return (inRow >= 7) ? Bitboard() : Bitboard(BitboardLUT::kFull.mask << (8 * (inRow + 1)));
+}
+
+static Bitboard
+_rowsBelow(uint8_t inRow)
+{
+    return (inRow == 0) ? Bitboard() : Bitboard(BitboardLUT::kFull.mask >> (8 * (8 - inRow)));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark PawnHashTable
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PawnHashTable::PawnHashTable(size_t inNumEntries)
+{
+    size_t numEntries = 1;
+
+    while ((numEntries << 1) <= inNumEntries)
+    {
+        numEntries <<= 1;
+    }
+
+    _entries.resize(numEntries);
+    _mask = numEntries - 1;
+
+    clear();
+}
+
+void
+PawnHashTable::clear()
+{
+    // A zero key never matches, since pawn keys start from ZobristLUT::kNoPawns
+    for (auto & entry : _entries)
+    {
+        entry = PawnHashEntry();
+        entry.key = 0;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Evaluator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool Evaluator::_sIsInit = false;
+
+Evaluator::Evaluator(size_t inNumPawnEntries) :
+_pawnTable(inNumPawnEntries)
+{
+    init();
+}
+
+void
+Evaluator::init()
+{
+    if (_sIsInit)
+    {
+        return;
+    }
+
+    for (uint8_t col = 0; col < 8; col++)
+    {
+        _sFileMasks[col] = Bitboard(0x0101010101010101ULL << col);
+    }
+
+    for (uint8_t col = 0; col < 8; col++)
+    {
+        _sAdjacentFileMasks[col] = Bitboard();
+
+        if (col > 0)
+        {
+            _sAdjacentFileMasks[col] |= _sFileMasks[col - 1];
+        }
+
+        if (col < 7)
+        {
+            _sAdjacentFileMasks[col] |= _sFileMasks[col + 1];
+        }
+    }
+
+    for (uint8_t index = 0; index < 64; index++)
+    {
+        Square sq(index);
+
+        auto row        = sq.getRow();
+        auto col        = sq.getCol();
+        auto span       = _sFileMasks[col] | _sAdjacentFileMasks[col];
+
+        _sPassedMasks[kWhite][index]  = span & _rowsAbove(row);
+        _sPassedMasks[kBlack][index]  = span & _rowsBelow(row);
+
+        _sSupportMasks[kWhite][index] = _sAdjacentFileMasks[col] & ~_rowsAbove(row);
+        _sSupportMasks[kBlack][index] = _sAdjacentFileMasks[col] & ~_rowsBelow(row);
+
+        // A white pawn on row r is stopped on r + 1, which black pawns on r + 2 attack
+        _sStopAttackerMasks[kWhite][index] = Bitboard();
+        _sStopAttackerMasks[kBlack][index] = Bitboard();
+
+        if (row + 2 <= 7)
+        {
+            _sStopAttackerMasks[kWhite][index] = (_sAdjacentFileMasks[col] &
+                                                  BitboardLUT::kRowMasks[row + 2]);
+        }
+
+        if (row >= 2)
+        {
+            _sStopAttackerMasks[kBlack][index] = (_sAdjacentFileMasks[col] &
+                                                  BitboardLUT::kRowMasks[row - 2]);
+        }
+    }
+
+    _sIsInit = true;
+}
+
+int
+Evaluator::evaluate(const ChessEngine & inEngine)
+{
+    _stats.evaluations++;
+
+    auto network = inEngine.getNetwork();
+
+    if (network != nullptr)
+    {
+        return network->evaluate(inEngine.getAccumulator(), inEngine.getCurrMove());
+    }
+
+    int score = 0;
+
+    for (uint8_t piece = 0; piece < 6; piece++)
+    {
+        auto name   = static_cast<attributes::ChessPieceName>(piece);
+        auto white  = inEngine.getPieces(attributes::ChessColor::kWhite, name);
+        auto black  = inEngine.getPieces(attributes::ChessColor::kBlack, name);
+
+        score += kPieceValues[piece] * (__builtin_popcountll(white.mask) -
+                                        __builtin_popcountll(black.mask));
+    }
+
+    const PawnHashEntry & pawns = _probePawns(inEngine);
+
+    score += pawns.structure;
+
+    for (auto color : { attributes::ChessColor::kBlack, attributes::ChessColor::kWhite })
+    {
+        auto c      = static_cast<uint8_t>(color);
+        auto king   = inEngine.getPieces(color, attributes::ChessPieceName::kKing);
+
+        if (king == 0)
+        {
+            continue;
+        }
+
+        Square kingSq = *king.begin();
+
+        if (_relativeRow(c, kingSq.getRow()) <= 1)
+        {
+            int shield = pawns.shield[c][kingSq.getCol()];
+            score += (c == kWhite) ? shield : -shield;
+        }
+    }
+
+    return (inEngine.getCurrMove() == attributes::ChessColor::kWhite) ? score : -score;
+}
+
+const PawnHashEntry &
+Evaluator::_probePawns(const ChessEngine & inEngine)
+{
+    auto key    = inEngine.getPawnKey();
+    auto entry  = _pawnTable.getEntry(key);
+
+    _stats.pawnProbes++;
+
+    if (entry->key == key)
+    {
+        _stats.pawnHits++;
+    }
+    else
+    {
+        computePawnEntry(inEngine, entry);
+    }
+
+    return *entry;
+}
+
+void
+Evaluator::computePawnEntry(const ChessEngine & inEngine, PawnHashEntry * outEntry)
+{
+    init();
+
+    Bitboard pawns[2] = {
+        inEngine.getPieces(attributes::ChessColor::kBlack, attributes::ChessPieceName::kPawn),
+        inEngine.getPieces(attributes::ChessColor::kWhite, attributes::ChessPieceName::kPawn)
+    };
+
+    int structure[2] = { 0, 0 };
+
+    for (uint8_t c = 0; c < 2; c++)
+    {
+        auto own    = pawns[c];
+        auto enemy  = pawns[c ^ 1];
+
+        outEntry->passed[c] = Bitboard();
+
+        for (uint8_t col = 0; col < 8; col++)
+        {
+            auto count = __builtin_popcountll((own & _sFileMasks[col]).mask);
+
+            if (count > 1)
+            {
+                structure[c] -= kDoubledPenalty * (count - 1);
+            }
+        }
+
+        for (auto sq : own)
+        {
+            auto col        = sq.getCol();
+            auto isIsolated = ((own & _sAdjacentFileMasks[col]) == 0);
+
+            if (isIsolated)
+            {
+                structure[c] -= kIsolatedPenalty;
+            }
+            else if (((own & _sSupportMasks[c][sq.index]) == 0) &&
+                     ((enemy & _sStopAttackerMasks[c][sq.index]) != 0))
+            {
+                structure[c] -= kBackwardPenalty;
+            }
+
+            if ((enemy & _sPassedMasks[c][sq.index]) == 0)
+            {
+                outEntry->passed[c] |= Bitboard::getForSquare(sq);
+                structure[c] += kPassedBonus[_relativeRow(c, sq.getRow())];
+            }
+        }
+
+        // Shield in front of a king castled on its first row, for every king file
+        uint8_t nearRow = (c == kWhite) ? 1 : 6;
+        uint8_t farRow  = (c == kWhite) ? 2 : 5;
+
+        for (uint8_t kingCol = 0; kingCol < 8; kingCol++)
+        {
+            int shield = 0;
+
+            for (int col = kingCol - 1; col <= kingCol + 1; col++)
+            {
+                if ((col < 0) || (col > 7))
+                {
+                    continue;
+                }
+
+                auto filePawns = own & _sFileMasks[col];
+
+                if ((filePawns & BitboardLUT::kRowMasks[nearRow]) != 0)
+                {
+                    shield += kShieldNearBonus;
+                }
+                else if ((filePawns & BitboardLUT::kRowMasks[farRow]) != 0)
+                {
+                    shield += kShieldFarBonus;
+                }
+                else
+                {
+                    shield -= kShieldMissing;
+                }
+            }
+
+            outEntry->shield[c][kingCol] = static_cast<int16_t>(shield);
+        }
+    }
+
+    outEntry->key       = inEngine.getPawnKey();
+    outEntry->structure = static_cast<int16_t>(structure[kWhite] - structure[kBlack]);
+}
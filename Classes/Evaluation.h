@@ -0,0 +1,157 @@
+/***************************************************************************************************
+ *
+ *  @file       Evaluation.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Static evaluation of a position
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "Bitboard.h"
+#include "Zobrist.h"
+
+#include <vector>
+
+namespace chessEngine
+{
+    class ChessEngine;
+
+    /**
+     @class          PawnHashEntry
+
+     @brief          Pawn structure terms of a position, keyed by the pawn key
+
+     @discussion     Everything is from white's point of view. The king shield depends on the king
+     file, which is not a part of the pawn key, so it is stored for every file and picked when the
+     entry is used.
+     */
+    struct PawnHashEntry
+    {
+        ZobristKey                  key;
+
+        int16_t                     structure;
+        int16_t                     shield[2][8];
+
+        Bitboard                    passed[2];
+    };
+
+    /**
+     @class          PawnHashTable
+
+     @brief          A direct mapped cache of pawn structure terms
+
+     @discussion     Each search thread owns its own table, so there is no locking.
+     */
+    class PawnHashTable
+    {
+    public:
+        static constexpr size_t     kDefaultNumEntries = 1 << 14;
+
+        /**
+         @param     inNumEntries    number of entries, rounded down to a power of 2
+         */
+        PawnHashTable(size_t inNumEntries = kDefaultNumEntries);
+
+        /**
+         @brief         Get the slot for a key
+
+         @discussion    The slot may hold another key. The caller checks entry->key and refills it
+         on a miss.
+         */
+        PawnHashEntry *             getEntry(ZobristKey inKey)
+        { return &_entries[inKey & _mask]; }
+
+        /**
+         @brief         Start loading the slot of a key into the cache, ahead of getEntry
+         */
+        void                        prefetch(ZobristKey inKey) const
+        { PREFETCH(&_entries[inKey & _mask]); }
+
+        void                        clear();
+
+        size_t                      getNumEntries() const { return _entries.size(); }
+
+    private:
+        std::vector<PawnHashEntry>  _entries;
+        ZobristKey                  _mask;
+    };
+
+    /**
+     @class          EvalStats
+
+     @brief          Counters of an evaluator, summed up into the search statistics
+     */
+    struct EvalStats
+    {
+        uint64_t                    evaluations;
+        uint64_t                    pawnProbes;
+        uint64_t                    pawnHits;
+
+        EvalStats() :
+        evaluations(0), pawnProbes(0), pawnHits(0)
+        { }
+
+        void                        operator+= (const EvalStats & inOther)
+        {
+            evaluations += inOther.evaluations;
+            pawnProbes  += inOther.pawnProbes;
+            pawnHits    += inOther.pawnHits;
+        }
+
+        /**
+         @brief         Fraction of pawn hash probes that hit, between 0 and 1
+         */
+        double                      getPawnHitRate() const
+        { return (pawnProbes == 0) ? 0.0 : static_cast<double>(pawnHits) / pawnProbes; }
+    };
+
+    /**
+     @class          Evaluator
+
+     @brief          Handcrafted evaluation: material, pawn structure and king shield
+
+     @discussion     Not thread safe. Every search thread is expected to own an evaluator. If the
+     engine has a network set, the network is used instead of the handcrafted terms.
+     */
+    class Evaluator
+    {
+    public:
+        Evaluator(size_t inNumPawnEntries = PawnHashTable::kDefaultNumEntries);
+
+        /**
+         @brief         Evaluate a position
+
+         @return        score in centipawns from the point of view of the side to move
+         */
+        int                         evaluate(const ChessEngine & inEngine);
+
+        /**
+         @brief         Compute the pawn structure terms of a position without the cache
+
+         @param     inEngine        the position
+         @param     outEntry        the entry to fill, including the key
+         */
+        static void                 computePawnEntry(const ChessEngine & inEngine,
+                                                     PawnHashEntry * outEntry);
+
+        const EvalStats &           getStats() const { return _stats; }
+
+        void                        resetStats() { _stats = EvalStats(); }
+
+        PawnHashTable &             getPawnTable() { return _pawnTable; }
+
+        static void                 init();
+
+    private:
+        const PawnHashEntry &       _probePawns(const ChessEngine & inEngine);
+
+        PawnHashTable               _pawnTable;
+        EvalStats                   _stats;
+
+        static bool                 _sIsInit;
+    };
+}
@@ -0,0 +1,502 @@
+/***************************************************************************************************
+ *
+ *  @file       GameDatabase.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Compact binary file of games
+ *
+ **************************************************************************************************/
+
+#include "GameDatabase.h"
+#include "PgnWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace chessEngine;
+
+static constexpr size_t     kRecordHeaderSize = 7;
+static constexpr size_t     kMaxMoves         = 0xFFFF;
+
+// Result tokens by GameResult
+static const char * const   kResults[] = { "", "1-0", "0-1", "1/2-1/2", "*" };
+
+static inline uint64_t
+_readLittleEndian(const uint8_t * inData, int inNumBytes)
+{
+    uint64_t value = 0;
+
+    for (auto i = inNumBytes - 1; i >= 0; i--)
+    {
+        value = (value << 8) | inData[i];
+    }
+
+    return value;
+}
+
+static inline void
+_writeLittleEndian(uint64_t inValue, int inNumBytes, uint8_t * outData)
+{
+    for (auto i = 0; i < inNumBytes; i++)
+    {
+        outData[i] = static_cast<uint8_t>(inValue);
+        inValue  >>= 8;
+    }
+}
+
+/**
+ @brief         Legal moves of a position, in an order that does not depend on the generator
+ */
+static void
+_getSortedMoves(const ChessEngine & inPosition, MoveList * outMoves)
+{
+    outMoves->clear();
+    inPosition.generateLegalMoves(outMoves);
+
+    std::sort(outMoves->begin(), outMoves->end(), [] (PackedMove inA, PackedMove inB) {
+        return inA.data < inB.data;
+    });
+}
+
+/**
+ @brief         Number of bits an index into a number of moves is stored in
+ */
+static int
+_getNumBits(size_t inNumMoves)
+{
+    int numBits = 0;
+
+    while ((static_cast<size_t>(1) << numBits) < inNumMoves)
+    {
+        numBits++;
+    }
+
+    return numBits;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark GameDatabase
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GameDatabase::GameDatabase() :
+_file(), _numGames(0), _index(nullptr)
+{ }
+
+bool
+GameDatabase::open(const std::string & inPath)
+{
+    close();
+
+    // Games are read by their index, read ahead would only waste the page cache
+    if (!_file.open(inPath, true))
+    {
+        return false;
+    }
+
+    auto data = _file.getData();
+    auto size = _file.getSize();
+
+    if ((size < kHeaderSize) || (_readLittleEndian(data, 4) != kMagic) ||
+        (_readLittleEndian(data + 4, 4) != kVersion))
+    {
+        close();
+        return false;
+    }
+
+    uint64_t numGames    = _readLittleEndian(data + 8, 8);
+    uint64_t indexOffset = _readLittleEndian(data + 16, 8);
+
+    if ((indexOffset < kHeaderSize) || (indexOffset > size) ||
+        (numGames > (size - indexOffset) / 8))
+    {
+        close();
+        return false;
+    }
+
+    _numGames = static_cast<size_t>(numGames);
+    _index    = data + indexOffset;
+
+    return true;
+}
+
+void
+GameDatabase::close()
+{
+    _file.close();
+    _numGames = 0;
+    _index    = nullptr;
+}
+
+bool
+GameDatabase::readTags(size_t inIndex, std::vector<PgnTag> * outTags, GameResult * outResult) const
+{
+    size_t     numMoves;
+    GameResult result;
+
+    if (_readRecord(inIndex, outTags, &numMoves, &result) == nullptr)
+    {
+        return false;
+    }
+
+    if (outResult != nullptr)
+    {
+        *outResult = result;
+    }
+
+    return true;
+}
+
+bool
+GameDatabase::readGame(size_t inIndex, PgnGame * outGame) const
+{
+    size_t     numMoves;
+    GameResult result;
+
+    outGame->moves.clear();
+    outGame->text  = StringView();
+    outGame->error = StringView();
+
+    auto bits = _readRecord(inIndex, &outGame->tags, &numMoves, &result);
+
+    if (bits == nullptr)
+    {
+        return false;
+    }
+
+    outGame->result = getResultToken(result);
+
+    auto fen = outGame->getTag("FEN");
+
+    outGame->position = _startPosition;
+
+    if (!fen.isEmpty() && !outGame->position.setFen(fen.toString()))
+    {
+        outGame->error = fen;
+        return false;
+    }
+
+    size_t   bitPos  = 0;
+    size_t   maxBits = static_cast<size_t>(_index - bits) * 8;
+    MoveList moves;
+
+    for (size_t i = 0; i < numMoves; i++)
+    {
+        _getSortedMoves(outGame->position, &moves);
+
+        int    numBits   = _getNumBits(moves.size);
+        size_t moveIndex = 0;
+
+        if (bitPos + numBits > maxBits)
+        {
+            return false;
+        }
+
+        for (int bit = 0; bit < numBits; bit++, bitPos++)
+        {
+            moveIndex |= static_cast<size_t>((bits[bitPos / 8] >> (bitPos % 8)) & 1) << bit;
+        }
+
+        if (moveIndex >= moves.size)
+        {
+            return false;
+        }
+
+        outGame->position.makeMove(moves[moveIndex]);
+        outGame->moves.push_back(moves[moveIndex]);
+    }
+
+    return true;
+}
+
+bool
+GameDatabase::importPgn(const std::string & inPgnPath, const std::string & inPath,
+                        size_t * outNumSkipped)
+{
+    PgnReader          reader;
+    GameDatabaseWriter writer;
+    size_t             numSkipped = 0;
+    bool               isWritten  = true;
+
+    if (!reader.open(inPgnPath) || !writer.open(inPath))
+    {
+        return false;
+    }
+
+    reader.read([&] (const PgnGame & inGame) {
+        if (!inGame.isValid())
+        {
+            numSkipped++;
+            return true;
+        }
+
+        isWritten = writer.addGame(inGame);
+        return isWritten;
+    });
+
+    if (outNumSkipped != nullptr)
+    {
+        *outNumSkipped = numSkipped;
+    }
+
+    return writer.close() && isWritten;
+}
+
+bool
+GameDatabase::exportPgn(const std::string & inPath, const std::string & inPgnPath)
+{
+    GameDatabase database;
+
+    if (!database.open(inPath))
+    {
+        return false;
+    }
+
+    std::ofstream out(inPgnPath, std::ios::binary);
+    PgnGame       game;
+
+    for (size_t i = 0; (i < database.getNumGames()) && out; i++)
+    {
+        if (!database.readGame(i, &game))
+        {
+            return false;
+        }
+
+        PgnWriter::write(out, game);
+    }
+
+    out.close();
+
+    return !out.fail();
+}
+
+const uint8_t *
+GameDatabase::_readRecord(size_t inIndex, std::vector<PgnTag> * outTags, size_t * outNumMoves,
+                          GameResult * outResult) const
+{
+    if (inIndex >= _numGames)
+    {
+        return nullptr;
+    }
+
+    auto     data   = _file.getData();
+    auto     end    = _index;
+    uint64_t offset = _readLittleEndian(_index + (inIndex * 8), 8);
+
+    if ((offset < kHeaderSize) || (offset + kRecordHeaderSize > static_cast<uint64_t>(end - data)))
+    {
+        return nullptr;
+    }
+
+    auto   record   = data + offset;
+    size_t result   = record[2];
+    size_t tagsSize = static_cast<size_t>(_readLittleEndian(record + 3, 4));
+    auto   tags     = record + kRecordHeaderSize;
+
+    if ((result >= sizeof(kResults) / sizeof(kResults[0])) ||
+        (tagsSize > static_cast<size_t>(end - tags)))
+    {
+        return nullptr;
+    }
+
+    outTags->clear();
+
+    auto cursor  = reinterpret_cast<const char *>(tags);
+    auto tagsEnd = cursor + tagsSize;
+
+    while (cursor < tagsEnd)
+    {
+        auto nameEnd  = static_cast<const char *>(memchr(cursor, 0, tagsEnd - cursor));
+        auto valueEnd = (nameEnd == nullptr) ? nullptr
+                      : static_cast<const char *>(memchr(nameEnd + 1, 0, tagsEnd - nameEnd - 1));
+
+        if (valueEnd == nullptr)
+        {
+            return nullptr;
+        }
+
+        PgnTag tag;
+        tag.name  = StringView(cursor, static_cast<size_t>(nameEnd - cursor));
+        tag.value = StringView(nameEnd + 1, static_cast<size_t>(valueEnd - nameEnd - 1));
+        outTags->push_back(tag);
+
+        cursor = valueEnd + 1;
+    }
+
+    *outNumMoves = static_cast<size_t>(_readLittleEndian(record, 2));
+    *outResult   = static_cast<GameResult>(result);
+
+    return tags + tagsSize;
+}
+
+GameResult
+GameDatabase::getResult(StringView inResult)
+{
+    for (size_t i = 1; i < sizeof(kResults) / sizeof(kResults[0]); i++)
+    {
+        if (inResult == kResults[i])
+        {
+            return static_cast<GameResult>(i);
+        }
+    }
+
+    return GameResult::kNone;
+}
+
+StringView
+GameDatabase::getResultToken(GameResult inResult)
+{
+    return kResults[static_cast<size_t>(inResult)];
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark GameDatabaseWriter
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GameDatabaseWriter::GameDatabaseWriter() :
+_file(nullptr), _offset(0), _isWritten(false)
+{ }
+
+GameDatabaseWriter::~GameDatabaseWriter()
+{
+    close();
+}
+
+bool
+GameDatabaseWriter::open(const std::string & inPath)
+{
+    close();
+
+    _file = fopen(inPath.c_str(), "wb");
+
+    if (_file == nullptr)
+    {
+        return false;
+    }
+
+    // The header is written again once the number of games and the index are known
+    uint8_t header[GameDatabase::kHeaderSize] = { };
+
+    _offset    = 0;
+    _isWritten = true;
+    _offsets.clear();
+
+    return _write(header, sizeof(header));
+}
+
+bool
+GameDatabaseWriter::addGame(const PgnGame & inGame)
+{
+    if ((_file == nullptr) || (inGame.moves.size() > kMaxMoves))
+    {
+        return false;
+    }
+
+    _record.assign(kRecordHeaderSize, 0);
+
+    for (auto & tag : inGame.tags)
+    {
+        _record.insert(_record.end(), tag.name.begin(), tag.name.end());
+        _record.push_back(0);
+        _record.insert(_record.end(), tag.value.begin(), tag.value.end());
+        _record.push_back(0);
+    }
+
+    _writeLittleEndian(inGame.moves.size(), 2, _record.data());
+    _record[2] = static_cast<uint8_t>(GameDatabase::getResult(inGame.result));
+    _writeLittleEndian(_record.size() - kRecordHeaderSize, 4, _record.data() + 3);
+
+    // The moves were made on the position of the game, unmaking them gives the one it started from
+    ChessEngine position = inGame.position;
+
+    for (size_t i = 0; i < inGame.moves.size(); i++)
+    {
+        position.unmakeMove();
+    }
+
+    size_t   bitsBegin = _record.size();
+    size_t   bitPos    = 0;
+    MoveList moves;
+
+    for (auto move : inGame.moves)
+    {
+        _getSortedMoves(position, &moves);
+
+        auto moveIndex = static_cast<size_t>(std::find(moves.begin(), moves.end(), move) -
+                                             moves.begin());
+
+        if (moveIndex == moves.size)
+        {
+            return false;
+        }
+
+        int numBits = _getNumBits(moves.size);
+
+        for (int bit = 0; bit < numBits; bit++, bitPos++)
+        {
+            if ((bitPos % 8) == 0)
+            {
+                _record.push_back(0);
+            }
+
+            _record[bitsBegin + (bitPos / 8)] |= static_cast<uint8_t>(((moveIndex >> bit) & 1)
+                                                                      << (bitPos % 8));
+        }
+
+        position.makeMove(move);
+    }
+
+    _offsets.push_back(_offset);
+
+    return _write(_record.data(), _record.size());
+}
+
+bool
+GameDatabaseWriter::close()
+{
+    if (_file == nullptr)
+    {
+        return false;
+    }
+
+    uint8_t header[GameDatabase::kHeaderSize];
+    uint8_t offset[8];
+
+    _writeLittleEndian(GameDatabase::kMagic, 4, header);
+    _writeLittleEndian(GameDatabase::kVersion, 4, header + 4);
+    _writeLittleEndian(_offsets.size(), 8, header + 8);
+    _writeLittleEndian(_offset, 8, header + 16);
+
+    for (auto recordOffset : _offsets)
+    {
+        _writeLittleEndian(recordOffset, 8, offset);
+        _write(offset, sizeof(offset));
+    }
+
+    if (fseek(_file, 0, SEEK_SET) != 0)
+    {
+        _isWritten = false;
+    }
+
+    _write(header, sizeof(header));
+
+    bool isWritten = (fclose(_file) == 0) && _isWritten;
+
+    _file = nullptr;
+
+    return isWritten;
+}
+
+bool
+GameDatabaseWriter::_write(const uint8_t * inData, size_t inSize)
+{
+    _isWritten = _isWritten && (fwrite(inData, 1, inSize, _file) == inSize);
+    _offset   += inSize;
+
+    return _isWritten;
+}
@@ -0,0 +1,197 @@
+/***************************************************************************************************
+ *
+ *  @file       GameDatabase.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Compact binary file of games
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "MappedFile.h"
+#include "PgnReader.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @brief          Result of a game, as stored in a database
+     */
+    enum class GameResult : uint8_t
+    {
+        kNone      = 0,
+        kWhiteWins = 1,
+        kBlackWins = 2,
+        kDraw      = 3,
+        kUnknown   = 4
+    };
+
+    /**
+     @class          GameDatabase
+
+     @brief          Games read from a database file, each of them directly by its index
+
+     @discussion     The file starts with a header of the magic, the version, the number of games
+     and the offset of the index, all little endian. The games follow one after the other, each
+     as a record of:
+
+     - the number of moves, 2 bytes
+     - the result, 1 byte: none, 1-0, 0-1, 1/2-1/2 or *
+     - the size of the tags, 4 bytes
+     - the tags, as the name and the value of each, both null terminated
+     - the moves, bit packed
+
+     A move is stored as its index in the sorted legal moves of its position, in just as many
+     bits as that number of moves needs: about five for most moves, and none for a forced move.
+     The index at the end holds the offset of every record, 8 bytes each.
+
+     A game starts from the position of its FEN tag, or the initial position. Reading a game
+     replays its moves, without parsing any text; its tags view the mapped file. The file is not
+     changed after open(), so any number of threads may read games at once.
+     */
+    class GameDatabase
+    {
+    public:
+        static constexpr uint32_t   kMagic      = 0x42444743;   // CGDB
+        static constexpr uint32_t   kVersion    = 1;
+        static constexpr size_t     kHeaderSize = 24;
+
+        GameDatabase();
+
+        /**
+         @brief         Map a database file, closing the one mapped before
+
+         @return        false if the file could not be mapped, or its header or index are not
+         valid
+         */
+        bool                        open(const std::string & inPath);
+
+        void                        close();
+
+        bool                        isOpen() const { return _file.isOpen(); }
+
+        size_t                      getNumGames() const { return _numGames; }
+
+        /**
+         @brief         Read a game
+
+         @param     outGame         filled as PgnParser fills it, with the moves made on its
+         position, but no text
+
+         @return        false if the record is damaged, or a move or its FEN is not valid
+         */
+        bool                        readGame(size_t inIndex, PgnGame * outGame) const;
+
+        /**
+         @brief         Read the tags and the result of a game, without replaying its moves
+
+         @param     outTags         filled with the tags, which view the mapped file
+
+         @return        false if the record is damaged
+         */
+        bool                        readTags(size_t inIndex, std::vector<PgnTag> * outTags,
+                                             GameResult * outResult = nullptr) const;
+
+        /**
+         @brief         Convert a PGN file into a database file
+
+         @discussion    Games with a move that cannot be resolved are left out.
+
+         @param     outNumSkipped   number of games left out, may be null
+
+         @return        false if a file could not be read or written
+         */
+        static bool                 importPgn(const std::string & inPgnPath,
+                                              const std::string & inPath,
+                                              size_t * outNumSkipped = nullptr);
+
+        /**
+         @brief         Convert the games of a database file into a PGN file
+
+         @return        false if a file could not be read or written, or a game is damaged
+         */
+        static bool                 exportPgn(const std::string & inPath,
+                                              const std::string & inPgnPath);
+
+        /**
+         @brief         Result of a result token, kNone if it is empty or not one
+         */
+        static GameResult           getResult(StringView inResult);
+
+        /**
+         @brief         Result token of a result, empty for kNone
+         */
+        static StringView           getResultToken(GameResult inResult);
+
+    private:
+        /**
+         @brief         Read the record of a game up to its moves
+
+         @return        the moves, null if the record is damaged
+         */
+        const uint8_t *             _readRecord(size_t inIndex, std::vector<PgnTag> * outTags,
+                                                size_t * outNumMoves,
+                                                GameResult * outResult) const;
+
+        MappedFile                  _file;
+        size_t                      _numGames;
+        const uint8_t *             _index;
+        ChessEngine                 _startPosition;
+    };
+
+    /**
+     @class          GameDatabaseWriter
+
+     @brief          Writes a database file one game after the other
+
+     @discussion     The records are written as the games are added, the index and the header once
+     the writer is closed. A file that was not closed is not valid.
+     */
+    class GameDatabaseWriter
+    {
+    public:
+        GameDatabaseWriter();
+
+        /**
+         @brief         Closes the file if it is open
+         */
+        ~GameDatabaseWriter();
+
+        GameDatabaseWriter(const GameDatabaseWriter &) = delete;
+        GameDatabaseWriter & operator= (const GameDatabaseWriter &) = delete;
+
+        bool                        open(const std::string & inPath);
+
+        /**
+         @brief         Add a game, with the moves made on its position as PgnParser leaves them
+
+         @return        false if the game could not be written or has too many moves
+         */
+        bool                        addGame(const PgnGame & inGame);
+
+        /**
+         @brief         Write the index and the header, and close the file
+
+         @return        false if anything since open() could not be written
+         */
+        bool                        close();
+
+        size_t                      getNumGames() const { return _offsets.size(); }
+
+    private:
+        bool                        _write(const uint8_t * inData, size_t inSize);
+
+        FILE *                      _file;
+        uint64_t                    _offset;
+        bool                        _isWritten;
+        std::vector<uint64_t>       _offsets;
+        std::vector<uint8_t>        _record;
+    };
+}
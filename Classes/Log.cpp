@@ -0,0 +1,58 @@
+/***************************************************************************************************
+ *
+ *  @file       Log.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Logging of the engine, routed to whoever embeds it
+ *
+ **************************************************************************************************/
+
+#include "Log.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+using namespace chessEngine;
+
+static constexpr size_t         kMaxMessageLength = 1024;
+
+static std::atomic<LogHandler>  sHandler(nullptr);
+
+void
+chessEngine::setLogHandler(LogHandler inHandler)
+{
+    sHandler.store(inHandler, std::memory_order_release);
+}
+
+void
+chessEngine::log(const char * inFormat, ...)
+{
+    char    message[kMaxMessageLength];
+    va_list args;
+
+    va_start(args, inFormat);
+    vsnprintf(message, sizeof(message), inFormat, args);
+    va_end(args);
+
+    // Handlers end the line themselves
+    size_t length = strlen(message);
+
+    while ((length > 0) && (message[length - 1] == '\n'))
+    {
+        message[--length] = '\0';
+    }
+
+    auto handler = sHandler.load(std::memory_order_acquire);
+
+    if (handler != nullptr)
+    {
+        handler(message);
+    }
+    else
+    {
+        fprintf(stderr, "%s\n", message);
+    }
+}
@@ -0,0 +1,37 @@
+/***************************************************************************************************
+ *
+ *  @file       Log.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Logging of the engine, routed to whoever embeds it
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+namespace chessEngine
+{
+    /**
+     @brief         Receives every logged message, formatted and without a trailing line break
+     */
+    using LogHandler = void (*)(const char * inMessage);
+
+    /**
+     @brief         Route the log to a handler, or to the standard error if null, which is the
+     default
+
+     @discussion    Callable from any thread. Messages may be logged from search threads, so the
+     handler has to be thread safe.
+     */
+    void                            setLogHandler(LogHandler inHandler);
+
+    /**
+     @brief         Log a message formatted as by printf
+     */
+    void                            log(const char * inFormat, ...)
+#if defined(__GNUC__) || defined(__clang__)
+                                    __attribute__((format(printf, 1, 2)))
+#endif
+                                    ;
+}
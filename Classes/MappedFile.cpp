@@ -0,0 +1,212 @@
+/***************************************************************************************************
+ *
+ *  @file       MappedFile.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Read only memory mapped file
+ *
+ **************************************************************************************************/
+
+#include "MappedFile.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace chessEngine;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark MappedFile
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile() :
+_data(nullptr), _size(0), _file(nullptr), _mapping(nullptr)
+{ }
+
+MappedFile::MappedFile(MappedFile && inOther) :
+_data(inOther._data), _size(inOther._size), _file(inOther._file), _mapping(inOther._mapping)
+{
+    inOther._data    = nullptr;
+    inOther._size    = 0;
+    inOther._file    = nullptr;
+    inOther._mapping = nullptr;
+}
+
+MappedFile &
+MappedFile::operator= (MappedFile && inOther)
+{
+    if (this != &inOther)
+    {
+        close();
+
+        std::swap(_data, inOther._data);
+        std::swap(_size, inOther._size);
+        std::swap(_file, inOther._file);
+        std::swap(_mapping, inOther._mapping);
+    }
+
+    return *this;
+}
+
+bool
+MappedFile::open(const std::string & inPath, bool inIsRandom)
+{
+    close();
+
+    DWORD flags = inIsRandom ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL;
+    HANDLE file = CreateFileA(inPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, flags, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file, &size) || (size.QuadPart == 0))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void * data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (data == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    _data    = static_cast<const uint8_t *>(data);
+    _size    = static_cast<size_t>(size.QuadPart);
+    _file    = file;
+    _mapping = mapping;
+
+    return true;
+}
+
+void
+MappedFile::close()
+{
+    if (_data != nullptr)
+    {
+        UnmapViewOfFile(_data);
+        CloseHandle(_mapping);
+        CloseHandle(_file);
+    }
+
+    _data    = nullptr;
+    _size    = 0;
+    _file    = nullptr;
+    _mapping = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile() :
+_data(nullptr), _size(0)
+{ }
+
+MappedFile::MappedFile(MappedFile && inOther) :
+_data(inOther._data), _size(inOther._size)
+{
+    inOther._data = nullptr;
+    inOther._size = 0;
+}
+
+MappedFile &
+MappedFile::operator= (MappedFile && inOther)
+{
+    if (this != &inOther)
+    {
+        close();
+
+        std::swap(_data, inOther._data);
+        std::swap(_size, inOther._size);
+    }
+
+    return *this;
+}
+
+bool
+MappedFile::open(const std::string & inPath, bool inIsRandom)
+{
+    close();
+
+    int fd = ::open(inPath.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+
+    if ((fstat(fd, &info) != 0) || (info.st_size == 0))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void * data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping keeps the file alive
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    if (inIsRandom)
+    {
+        madvise(data, static_cast<size_t>(info.st_size), MADV_RANDOM);
+    }
+
+    _data = static_cast<const uint8_t *>(data);
+    _size = static_cast<size_t>(info.st_size);
+
+    return true;
+}
+
+void
+MappedFile::close()
+{
+    if (_data != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(_data), _size);
+    }
+
+    _data = nullptr;
+    _size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
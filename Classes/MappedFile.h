@@ -0,0 +1,67 @@
+/***************************************************************************************************
+ *
+ *  @file       MappedFile.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Read only memory mapped file
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+
+#include <string>
+
+namespace chessEngine
+{
+    /**
+     @class          MappedFile
+
+     @brief          A file mapped read only into memory
+
+     @discussion     The mapping is shared, so every thread and process mapping the same file reads
+     the same pages of the page cache. Pages are only read from disk when they are first touched.
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile();
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator= (const MappedFile &) = delete;
+
+        MappedFile(MappedFile && inOther);
+        MappedFile & operator= (MappedFile && inOther);
+
+        /**
+         @brief         Map a file, closing the one mapped before
+
+         @param     inPath          path of the file
+         @param     inIsRandom      the file is read at random places, do not read ahead
+
+         @return        false if the file could not be opened or is empty
+         */
+        bool                        open(const std::string & inPath, bool inIsRandom = false);
+
+        void                        close();
+
+        bool                        isOpen() const { return _data != nullptr; }
+
+        const uint8_t *             getData() const { return _data; }
+
+        size_t                      getSize() const { return _size; }
+
+    private:
+        const uint8_t *             _data;
+        size_t                      _size;
+
+#if defined(_WIN32)
+        void *                      _file;
+        void *                      _mapping;
+#endif
+    };
+}
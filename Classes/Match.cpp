@@ -0,0 +1,425 @@
+/***************************************************************************************************
+ *
+ *  @file       Match.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Games between two engines, to tell which is stronger
+ *
+ **************************************************************************************************/
+
+#include "Match.h"
+
+#include "ChessEngine.h"
+#include "UciConnection.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace chessEngine;
+
+static constexpr int64_t    kStartTimeoutMs = 10000;
+static constexpr int64_t    kStopTimeoutMs  = 1000;
+
+/**
+ @brief         Time a move searched to a number of nodes may take before the engine is given up
+ */
+static constexpr int64_t    kNodesTimeoutMs = 60000;
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ @brief         Legal move of a position in long algebraic notation, null if there is none
+ */
+static PackedMove
+_parseMove(const ChessEngine & inPosition, const std::string & inMove)
+{
+    MoveList moves;
+    inPosition.generateLegalMoves(&moves);
+
+    for (auto move : moves)
+    {
+        if (move.toString() == inMove)
+        {
+            return move;
+        }
+    }
+
+    return PackedMove();
+}
+
+/**
+ @brief         An engine of a match, as one thread plays it
+ */
+class MatchPlayer
+{
+public:
+    MatchPlayer(const MatchEngine & inEngine) :
+    _engine(inEngine)
+    { }
+
+    /**
+     @brief         Start the engine, again if it was started before, and set its options
+
+     @return        false if it did not answer
+     */
+    bool                        start()
+    {
+        if (_engine.command.empty())
+        {
+            _connection.reset(new UciLocalConnection());
+        }
+        else
+        {
+            auto process = new UciProcess();
+
+            _connection.reset(process);
+
+            if (!process->start(_engine.command))
+            {
+                return false;
+            }
+        }
+
+        if (!_connection->send("uci") || !_waitFor("uciok", kStartTimeoutMs, nullptr))
+        {
+            return false;
+        }
+
+        for (auto & option : _engine.options)
+        {
+            if (!_connection->send("setoption name " + option.first + " value " + option.second))
+            {
+                return false;
+            }
+        }
+
+        return _isReady();
+    }
+
+    bool                        newGame()
+    {
+        return _connection->send("ucinewgame") && _isReady();
+    }
+
+    /**
+     @brief         Have the engine pick a move
+
+     @return        false if it did not within the timeout, in which case it is stopped, or
+                    started again if it does not stop either
+     */
+    bool                        play(const std::string & inPosition, const std::string & inGo,
+                                     int64_t inTimeoutMs, std::string * outMove)
+    {
+        std::string line;
+
+        if (!_connection->send(inPosition) || !_connection->send(inGo))
+        {
+            start();
+            return false;
+        }
+
+        if (!_waitFor("bestmove", inTimeoutMs, &line))
+        {
+            // The move comes too late to count, but is waited for so that it does not answer the
+            // next search
+            if (!_connection->send("stop") || !_waitFor("bestmove", kStopTimeoutMs, nullptr))
+            {
+                start();
+            }
+
+            return false;
+        }
+
+        std::istringstream args(line);
+        args >> line >> *outMove;
+
+        return true;
+    }
+
+private:
+    bool                        _isReady()
+    {
+        return _connection->send("isready") && _waitFor("readyok", kStartTimeoutMs, nullptr);
+    }
+
+    /**
+     @brief         Wait for the line starting with a token, skipping the others
+     */
+    bool                        _waitFor(const std::string & inToken, int64_t inTimeoutMs,
+                                         std::string * outLine)
+    {
+        auto        deadline = Clock::now() + std::chrono::milliseconds(inTimeoutMs);
+        std::string line;
+
+        while (true)
+        {
+            auto remainingMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - Clock::now()).count();
+
+            if ((remainingMs <= 0) || !_connection->receive(remainingMs, &line))
+            {
+                return false;
+            }
+
+            if ((line.compare(0, inToken.size(), inToken) == 0) &&
+                ((line.size() == inToken.size()) || (line[inToken.size()] == ' ')))
+            {
+                if (outLine != nullptr)
+                {
+                    *outLine = line;
+                }
+
+                return true;
+            }
+        }
+    }
+
+    const MatchEngine &             _engine;
+    std::unique_ptr<UciConnection>  _connection;
+};
+
+/**
+ @brief         Outcome of a game
+ */
+struct GameOutcome
+{
+    /**
+     @brief         1 if White won, 0 for a draw and -1 if Black won
+     */
+    int                         whiteResult;
+
+    /**
+     @brief         The loser ran out of time, played an illegal move or stopped answering
+     */
+    bool                        isForfeit;
+};
+
+static GameOutcome
+_playGame(const std::string & inFen, const MatchOptions & inOptions, double inTimeScale,
+          MatchPlayer * inOutWhite, MatchPlayer * inOutBlack)
+{
+    ChessEngine position;
+    std::string moves;
+    int64_t     clocksMs[2]  = { };
+    auto        incrementMs  = static_cast<int64_t>(inOptions.incrementMs * inTimeScale);
+    MatchPlayer * players[2] = { inOutBlack, inOutWhite };
+
+    position.setFen(inFen);
+
+    for (auto & clockMs : clocksMs)
+    {
+        clockMs = static_cast<int64_t>(inOptions.timeMs * inTimeScale);
+    }
+
+    for (auto player : players)
+    {
+        if (!player->newGame())
+        {
+            player->start();
+            return { (player == inOutWhite) ? -1 : 1, true };
+        }
+    }
+
+    for (int ply = 0; ; ply++)
+    {
+        auto     side   = static_cast<int>(position.getCurrMove());
+        auto     lost   = (side == static_cast<int>(attributes::ChessColor::kWhite)) ? -1 : 1;
+        auto &   clock  = clocksMs[side];
+        MoveList legalMoves;
+
+        position.generateLegalMoves(&legalMoves);
+
+        if (legalMoves.isEmpty())
+        {
+            return { position.isInCheck() ? lost : 0, false };
+        }
+
+        if (position.isDraw() || (ply >= inOptions.maxPlies))
+        {
+            return { 0, false };
+        }
+
+        // The moves are sent rather than the position, so that repetitions are known to the
+        // engines
+        std::string go = "go nodes " + std::to_string(inOptions.nodes);
+        int64_t     timeoutMs = kNodesTimeoutMs;
+
+        if (inOptions.nodes == 0)
+        {
+            go = "go wtime " + std::to_string(std::max<int64_t>(clocksMs[1], 1)) +
+                 " btime " + std::to_string(std::max<int64_t>(clocksMs[0], 1)) +
+                 " winc " + std::to_string(incrementMs) + " binc " + std::to_string(incrementMs);
+            timeoutMs = clock + inOptions.timeMarginMs;
+        }
+
+        auto        start = Clock::now();
+        std::string moveText;
+
+        if (!players[side]->play("position fen " + inFen + (moves.empty() ? "" : " moves" + moves),
+                                 go, timeoutMs, &moveText))
+        {
+            return { lost, true };
+        }
+
+        auto usedMs = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                                           start).count();
+        auto move   = _parseMove(position, moveText);
+
+        if ((inOptions.nodes == 0) && (usedMs > clock + inOptions.timeMarginMs))
+        {
+            return { lost, true };
+        }
+
+        if (move.isNull())
+        {
+            return { lost, true };
+        }
+
+        clock += incrementMs - usedMs;
+        position.makeMove(move);
+        moves += " " + moveText;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Match
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+Match::run(const MatchEngine & inFirst, const MatchEngine & inSecond,
+           const MatchOptions & inOptions, MatchStats * outStats,
+           const ProgressCallback & inOnProgress)
+{
+    static const std::vector<std::string> kStartOpenings = { ChessEngine::kStartFen };
+
+    auto &   openings    = inOptions.openings.empty() ? kStartOpenings : inOptions.openings;
+    auto     numPairs    = (inOptions.numGames + 1) / 2;
+    auto     timeScale   = getTimeScale(inOptions.concurrency);
+    int      numThreads  = std::max(inOptions.concurrency, 1);
+
+    std::atomic<uint64_t> nextPair(0);
+    std::atomic<bool>     isStopped(false);
+    std::atomic<bool>     isFailed(false);
+    std::mutex            statsMutex;
+    MatchStats            stats;
+
+    stats.sprt = inOptions.sprt;
+
+    auto work = [&] {
+        MatchPlayer first(inFirst);
+        MatchPlayer second(inSecond);
+
+        if (!first.start() || !second.start())
+        {
+            isFailed  = true;
+            isStopped = true;
+            return;
+        }
+
+        for (auto pair = nextPair++; (pair < numPairs) && !isStopped; pair = nextPair++)
+        {
+            auto & fen = openings[pair % openings.size()];
+
+            // The results of both games are for the first engine
+            auto firstWhite  = _playGame(fen, inOptions, timeScale, &first, &second);
+            auto firstBlack  = _playGame(fen, inOptions, timeScale, &second, &first);
+            int  results[2]  = { firstWhite.whiteResult, -firstBlack.whiteResult };
+            int  halfPoints  = 0;
+
+            std::lock_guard<std::mutex> lock(statsMutex);
+
+            for (auto result : results)
+            {
+                stats.numGames++;
+                stats.numWins   += (result > 0) ? 1 : 0;
+                stats.numDraws  += (result == 0) ? 1 : 0;
+                stats.numLosses += (result < 0) ? 1 : 0;
+                halfPoints      += result + 1;
+            }
+
+            stats.numForfeits += (firstWhite.isForfeit ? 1 : 0) + (firstBlack.isForfeit ? 1 : 0);
+            stats.sprt.addPair(halfPoints);
+
+            if (inOptions.isSprt && (stats.sprt.getStatus() != Sprt::Status::kContinue))
+            {
+                isStopped = true;
+            }
+
+            if (inOnProgress)
+            {
+                inOnProgress(stats);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int i = 1; i < numThreads; i++)
+    {
+        threads.emplace_back(work);
+    }
+
+    work();
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    if (outStats != nullptr)
+    {
+        *outStats = stats;
+    }
+
+    return !isFailed;
+}
+
+double
+Match::getTimeScale(int inConcurrency)
+{
+    auto numCores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    return std::max(static_cast<double>(inConcurrency) / numCores, 1.0);
+}
+
+bool
+Match::loadOpenings(const std::string & inPath, std::vector<std::string> * outOpenings)
+{
+    std::ifstream file(inPath);
+    std::string   line;
+    ChessEngine   position;
+
+    if (!file)
+    {
+        return false;
+    }
+
+    outOpenings->clear();
+
+    while (std::getline(file, line))
+    {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+        {
+            continue;
+        }
+
+        // The operations of an EPD line are left out, the position gets the default clocks
+        if (!position.setFen(line))
+        {
+            return false;
+        }
+
+        outOpenings->push_back(position.getFen());
+    }
+
+    return !outOpenings->empty();
+}
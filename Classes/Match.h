@@ -0,0 +1,177 @@
+/***************************************************************************************************
+ *
+ *  @file       Match.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Games between two engines, to tell which is stronger
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "Sprt.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @class          MatchEngine
+
+     @brief          An engine of a match, and how it is set up
+     */
+    struct MatchEngine
+    {
+        std::string                 name;
+
+        /**
+         @brief         Command starting the engine as a process, empty for this build run in the
+         match process
+         */
+        std::string                 command;
+
+        /**
+         @brief         Names and values of the UCI options set before the first game
+         */
+        std::vector<std::pair<std::string, std::string>> options;
+    };
+
+    /**
+     @class          MatchOptions
+
+     @brief          How the games of a match are played
+     */
+    struct MatchOptions
+    {
+        /**
+         @brief         Games played at most, rounded up to whole pairs
+         */
+        uint64_t                    numGames;
+
+        /**
+         @brief         Games played at once
+         */
+        int                         concurrency;
+
+        /**
+         @brief         Clock of each side, before it is scaled by getTimeScale()
+         */
+        int64_t                     timeMs;
+        int64_t                     incrementMs;
+
+        /**
+         @brief         Time a move may take beyond the clock before it is lost on time
+         */
+        int64_t                     timeMarginMs;
+
+        /**
+         @brief         Nodes of every move instead of a clock if not 0, for quick and repeatable
+         matches
+         */
+        uint64_t                    nodes;
+
+        /**
+         @brief         Games still going after this many plies are scored as draws
+         */
+        int                         maxPlies;
+
+        /**
+         @brief         FEN of the start positions, the initial position if there are none
+         */
+        std::vector<std::string>    openings;
+
+        /**
+         @brief         Stop the match once the test is decided
+         */
+        bool                        isSprt;
+        Sprt                        sprt;
+
+        MatchOptions() :
+        numGames(1000), concurrency(1), timeMs(10000), incrementMs(100), timeMarginMs(100),
+        nodes(0), maxPlies(400), isSprt(false)
+        { }
+    };
+
+    /**
+     @class          MatchStats
+
+     @brief          Results of the games played so far, for the first engine
+     */
+    struct MatchStats
+    {
+        uint64_t                    numGames;
+        uint64_t                    numWins;
+        uint64_t                    numDraws;
+        uint64_t                    numLosses;
+
+        /**
+         @brief         Games lost on time, by an illegal move, or by an engine that stopped
+         answering
+         */
+        uint64_t                    numForfeits;
+
+        /**
+         @brief         The pairs of games, counted whether or not the test stops the match
+         */
+        Sprt                        sprt;
+
+        MatchStats() :
+        numGames(0), numWins(0), numDraws(0), numLosses(0), numForfeits(0)
+        { }
+    };
+
+    /**
+     @class          Match
+
+     @brief          Plays two engines against each other
+
+     @discussion     Every thread plays games with an instance of each engine of its own, speaking
+     UCI to both, so that an engine may be another build as well as this one with other options.
+     Games are played in pairs from the same opening with the colors swapped, the openings taken
+     in turn. A game ends in mate, stalemate, a draw by ChessEngine::isDraw(), as a draw once it
+     reaches the maximum number of plies, or as a loss for an engine that runs out of time, plays
+     an illegal move or stops answering. Such an engine is started again for the next game.
+
+     On a clock, the time is scaled by getTimeScale(), so that with more games than cores every
+     engine still gets about the same search as with a core to itself.
+     */
+    class Match
+    {
+    public:
+        /**
+         @brief         Called after every pair of games, one call at a time
+         */
+        using ProgressCallback = std::function<void(const MatchStats &)>;
+
+        /**
+         @brief         Play the match
+
+         @param     outStats        results, may be null
+
+         @return        false if an engine could not be started or set up
+         */
+        static bool                 run(const MatchEngine & inFirst, const MatchEngine & inSecond,
+                                        const MatchOptions & inOptions,
+                                        MatchStats * outStats = nullptr,
+                                        const ProgressCallback & inOnProgress = nullptr);
+
+        /**
+         @brief         Factor the clocks are scaled by, 1 unless there are more games at once
+         than cores
+         */
+        static double               getTimeScale(int inConcurrency);
+
+        /**
+         @brief         Read the openings of an EPD or FEN file, one position per line
+
+         @return        false if the file could not be read or a line is not a position
+         */
+        static bool                 loadOpenings(const std::string & inPath,
+                                                 std::vector<std::string> * outOpenings);
+    };
+}
@@ -0,0 +1,355 @@
+/***************************************************************************************************
+ *
+ *  @file       MateSearch.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Search that only proves or disproves a forced mate
+ *
+ **************************************************************************************************/
+
+#include "MateSearch.h"
+
+#include <algorithm>
+
+using namespace chessEngine;
+
+/**
+ @brief         Move the best scored move from inIndex onwards to inIndex
+ */
+static void
+_pickMove(MoveList * inOutMoves, int * inOutScores, size_t inIndex)
+{
+    size_t best = inIndex;
+
+    for (size_t i = inIndex + 1; i < inOutMoves->size; i++)
+    {
+        if (inOutScores[i] > inOutScores[best])
+        {
+            best = i;
+        }
+    }
+
+    if (best != inIndex)
+    {
+        std::swap(inOutMoves->moves[inIndex], inOutMoves->moves[best]);
+        std::swap(inOutScores[inIndex], inOutScores[best]);
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark MateSearch
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+MateSearch::MateSearch(size_t inSizeMb) :
+_nodes(0), _isOutOfNodes(false), _stop(false), _numEntries(1), _frames(new Frame[kMaxPly])
+{
+    size_t maxEntries = (std::max<size_t>(inSizeMb, 1) << 20) / sizeof(Entry);
+
+    while ((_numEntries << 1) <= maxEntries)
+    {
+        _numEntries <<= 1;
+    }
+
+    _entries.reset(new Entry[_numEntries]);
+    clear();
+}
+
+MateResult
+MateSearch::run(const ChessEngine & inPosition, const MateLimits & inLimits)
+{
+    _engine       = inPosition;
+    _limits       = inLimits;
+    _nodes        = 0;
+    _isOutOfNodes = false;
+
+    MateResult result;
+    int        maxMoves = std::min(_limits.maxMoves, static_cast<int>(kMaxMoves));
+
+    if (maxMoves <= 0)
+    {
+        maxMoves = kMaxMoves;
+    }
+
+    for (int moves = 1; moves <= maxMoves; moves++)
+    {
+        if (_attack(moves, 0))
+        {
+            result.mateInMoves = moves;
+            break;
+        }
+
+        if (_isStopped())
+        {
+            break;
+        }
+    }
+
+    result.isComplete = !_isStopped();
+
+    if (result.mateInMoves != 0)
+    {
+        // The proofs are all in the table, the line costs few nodes more, even if the limit was
+        // reached on the node that proved the mate
+        _limits.nodes = 0;
+        _isOutOfNodes = false;
+        _buildPv(result.mateInMoves, &result.pv);
+    }
+
+    result.nodes = _nodes;
+
+    return result;
+}
+
+void
+MateSearch::clear()
+{
+    std::fill(_entries.get(), _entries.get() + _numEntries, Entry());
+}
+
+bool
+MateSearch::_attack(int inMoves, int inPly)
+{
+    if (_isStopped())
+    {
+        return false;
+    }
+
+    _countNode();
+
+    ZobristKey key   = _engine.getHashKey();
+    Entry *    entry = _getEntry(key);
+
+    if (entry->key == key)
+    {
+        if ((entry->provenMoves != 0) && (entry->provenMoves <= inMoves))
+        {
+            _mateMoves[inPly] = entry->move;
+            return true;
+        }
+
+        if (entry->disprovenMoves >= inMoves)
+        {
+            return false;
+        }
+    }
+
+    Frame &  frame = _frames[inPly];
+    MoveList moves;
+    MoveList replies;
+
+    _engine.generateLegalMoves(&moves);
+    frame.moves.clear();
+
+    bool isChecksOnly = (inMoves == 1) || _limits.isChecksOnly;
+
+    for (auto move : moves)
+    {
+        _engine.makeMove(move);
+
+        bool isCheck = _engine.isInCheck();
+
+        if (!isCheck && isChecksOnly)
+        {
+            _engine.unmakeMove();
+            continue;
+        }
+
+        replies.clear();
+        _engine.generateLegalMoves(&replies);
+        _engine.unmakeMove();
+
+        if (replies.isEmpty())
+        {
+            // Mate, unless it is stalemate
+            if (isCheck)
+            {
+                _store(key, move, 1);
+                _mateMoves[inPly] = move;
+
+                return true;
+            }
+
+            continue;
+        }
+
+        // A single move can only mate with check
+        if (inMoves == 1)
+        {
+            continue;
+        }
+
+        // Like the proof number of the reply, a move is cheaper to prove the fewer replies it
+        // leaves
+        frame.scores[frame.moves.size] = ((isCheck ? MoveList::kMaxMoves * 2 : 0) +
+                                          (move.isCapture() ? 1 : 0) -
+                                          static_cast<int>(replies.size) * 2);
+        frame.moves.add(move);
+    }
+
+    for (size_t i = 0; i < frame.moves.size; i++)
+    {
+        _pickMove(&frame.moves, frame.scores, i);
+
+        PackedMove move = frame.moves[i];
+
+        _engine.makeMove(move);
+        bool isMate = _defend(inMoves - 1, inPly + 1);
+        _engine.unmakeMove();
+
+        if (_isStopped())
+        {
+            return false;
+        }
+
+        if (isMate)
+        {
+            _store(key, move, inMoves);
+            _mateMoves[inPly] = move;
+
+            return true;
+        }
+    }
+
+    // Without its quiet moves a node is not disproven, except on the last move, where only
+    // checks can mate anyway
+    if (!isChecksOnly || (inMoves == 1))
+    {
+        _store(key, PackedMove(), inMoves);
+    }
+
+    return false;
+}
+
+bool
+MateSearch::_defend(int inMoves, int inPly)
+{
+    if (_isStopped())
+    {
+        return false;
+    }
+
+    _countNode();
+
+    Frame & frame = _frames[inPly];
+
+    frame.moves.clear();
+    _engine.generateLegalMoves(&frame.moves);
+
+    if (frame.moves.isEmpty())
+    {
+        return _engine.isInCheck();
+    }
+
+    Bitboard kings = _engine.getPieces(_engine.getCurrMove(), attributes::ChessPieceName::kKing);
+
+    for (size_t i = 0; i < frame.moves.size; i++)
+    {
+        PackedMove move = frame.moves[i];
+
+        frame.scores[i] = ((move.isCapture() ? 2 : 0) +
+                           (((kings & Bitboard::getForSquare(move.getSrc())) != 0) ? 1 : 0));
+    }
+
+    for (size_t i = 0; i < frame.moves.size; i++)
+    {
+        _pickMove(&frame.moves, frame.scores, i);
+
+        _engine.makeMove(frame.moves[i]);
+        bool isMated = _attack(inMoves, inPly + 1);
+        _engine.unmakeMove();
+
+        if (!isMated)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+MateSearch::_store(ZobristKey inKey, PackedMove inMove, int inMoves)
+{
+    // Children may have taken the entry since it was probed
+    Entry * entry = _getEntry(inKey);
+
+    if (entry->key != inKey)
+    {
+        *entry     = Entry();
+        entry->key = inKey;
+    }
+
+    if (inMove.isNull())
+    {
+        entry->disprovenMoves = static_cast<uint8_t>(std::max<int>(entry->disprovenMoves,
+                                                                   inMoves));
+    }
+    else
+    {
+        entry->move        = inMove;
+        entry->provenMoves = static_cast<uint8_t>(inMoves);
+    }
+}
+
+void
+MateSearch::_buildPv(int inMoves, std::vector<PackedMove> * outPv)
+{
+    int ply = 0;
+
+    for (int moves = inMoves; moves > 0; )
+    {
+        if (!_attack(moves, ply))
+        {
+            break;
+        }
+
+        outPv->push_back(_mateMoves[ply]);
+        _engine.makeMove(_mateMoves[ply++]);
+
+        MoveList replies;
+        _engine.generateLegalMoves(&replies);
+
+        // The reply the mate takes longest after, which is at most one move shorter
+        PackedMove longestReply;
+        int        longestMoves = 0;
+
+        for (auto reply : replies)
+        {
+            _engine.makeMove(reply);
+
+            int replyMoves = 1;
+
+            while ((replyMoves < moves - 1) && !_attack(replyMoves, ply + 1) && !_isStopped())
+            {
+                replyMoves++;
+            }
+
+            _engine.unmakeMove();
+
+            if (replyMoves > longestMoves)
+            {
+                longestReply = reply;
+                longestMoves = replyMoves;
+            }
+        }
+
+        if (longestReply.isNull() || _isStopped())
+        {
+            break;
+        }
+
+        outPv->push_back(longestReply);
+        _engine.makeMove(longestReply);
+        ply++;
+
+        moves = longestMoves;
+    }
+
+    for (size_t i = 0; i < outPv->size(); i++)
+    {
+        _engine.unmakeMove();
+    }
+}
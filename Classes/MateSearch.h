@@ -0,0 +1,209 @@
+/***************************************************************************************************
+ *
+ *  @file       MateSearch.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Search that only proves or disproves a forced mate
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "Zobrist.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @class          MateLimits
+
+     @brief          How far a mate is looked for. A zero limit is no limit.
+     */
+    struct MateLimits
+    {
+        /**
+         @brief         Longest mate looked for, in moves of the side to move
+         */
+        int                         maxMoves;
+        uint64_t                    nodes;
+
+        /**
+         @brief         Only try checks for the side to move, which misses mates with a quiet
+         move but proves the others much faster
+         */
+        bool                        isChecksOnly;
+
+        MateLimits() :
+        maxMoves(3), nodes(0), isChecksOnly(false)
+        { }
+    };
+
+    /**
+     @class          MateResult
+
+     @brief          Outcome of a mate search
+     */
+    struct MateResult
+    {
+        /**
+         @brief         Moves of the shortest mate, 0 if none was found
+         */
+        int                         mateInMoves;
+
+        /**
+         @brief         The search was neither stopped nor ran out of nodes, so without a mate
+         there is none within the limits
+         */
+        bool                        isComplete;
+
+        /**
+         @brief         The mate, with the longest defence at every move of the mated side
+         */
+        std::vector<PackedMove>     pv;
+
+        uint64_t                    nodes;
+
+        MateResult() :
+        mateInMoves(0), isComplete(false), nodes(0)
+        { }
+    };
+
+    /**
+     @class          MateSearch
+
+     @brief          Depth first search for the shortest forced mate of the side to move
+
+     @discussion     Looks for a mate in 1, 2 and so on, so the first one found is the shortest.
+     Nothing is evaluated: a node of the mating side is proven by one move that mates, a node of
+     the defending side by all its moves being mated.
+
+     The moves of the mating side are tried as in proof number search: checks first, then by the
+     number of replies they leave, fewest first. On its last move only checks are tried, and a
+     mate in one is looked for before anything else is searched. The defending side tries
+     captures and king moves first, as they refute most often.
+
+     Proofs and disproofs are kept in a table of their own. As the fifty move rule and repetitions
+     are ignored, they only depend on the position, and the table is kept from one search to the
+     next. A search of checks only stores no disproof of more than one move, so that a full search
+     after it on the same table still finds the mates with a quiet move.
+     */
+    class MateSearch
+    {
+    public:
+        static constexpr size_t     kDefaultSizeMb = 4;
+        static constexpr int        kMaxMoves      = 32;
+
+        /**
+         @param     inSizeMb        size of the table in megabytes, rounded down to a power of 2
+         entries
+         */
+        MateSearch(size_t inSizeMb = kDefaultSizeMb);
+
+        /**
+         @brief         Look for the shortest mate of the side to move within the limits
+         */
+        MateResult                  run(const ChessEngine & inPosition,
+                                        const MateLimits & inLimits);
+
+        /**
+         @brief         Stop the running search as soon as possible, callable from any thread
+
+         @discussion    As with Search, a stop requested while no search is running applies to
+         the next one, unless resetStop() is called in between.
+         */
+        void                        stop() { _stop.store(true, std::memory_order_relaxed); }
+
+        void                        resetStop() { _stop.store(false, std::memory_order_relaxed); }
+
+        /**
+         @brief         Forget the proofs and disproofs
+         */
+        void                        clear();
+
+    private:
+        static constexpr int        kMaxPly = 2 * kMaxMoves;
+
+        struct Entry
+        {
+            ZobristKey              key;
+            PackedMove              move;
+
+            /**
+             @brief         Mate proven within this many moves, 0 if none is
+             */
+            uint8_t                 provenMoves;
+
+            /**
+             @brief         No mate within this many moves
+             */
+            uint8_t                 disprovenMoves;
+        };
+
+        /**
+         @class          Frame
+
+         @brief          Moves of the node at a ply and their ordering scores
+         */
+        struct Frame
+        {
+            MoveList                moves;
+            int                     scores[MoveList::kMaxMoves];
+        };
+
+        /**
+         @brief         Check if the side to move mates within inMoves, leaving the mating move in
+         _mateMoves
+         */
+        bool                        _attack(int inMoves, int inPly);
+
+        /**
+         @brief         Check if the side to move gets mated within inMoves of the other side, for
+         every move it has
+         */
+        bool                        _defend(int inMoves, int inPly);
+
+        /**
+         @brief         Record a mate within inMoves by inMove, or no mate within inMoves if inMove
+         is null
+         */
+        void                        _store(ZobristKey inKey, PackedMove inMove, int inMoves);
+
+        /**
+         @brief         Collect the mate proven from the root, defending as long as possible
+         */
+        void                        _buildPv(int inMoves, std::vector<PackedMove> * outPv);
+
+        void                        _countNode()
+        {
+            if ((++_nodes >= _limits.nodes) && (_limits.nodes != 0))
+            {
+                _isOutOfNodes = true;
+            }
+        }
+
+        bool                        _isStopped() const
+        { return _isOutOfNodes || _stop.load(std::memory_order_relaxed); }
+
+        Entry *                     _getEntry(ZobristKey inKey) const
+        { return &_entries[inKey & (_numEntries - 1)]; }
+
+        ChessEngine                 _engine;
+        MateLimits                  _limits;
+        uint64_t                    _nodes;
+        bool                        _isOutOfNodes;
+
+        std::atomic<bool>           _stop;
+
+        std::unique_ptr<Entry[]>    _entries;
+        size_t                      _numEntries;
+
+        std::unique_ptr<Frame[]>    _frames;
+        PackedMove                  _mateMoves[kMaxPly];
+    };
+}
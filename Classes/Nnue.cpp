@@ -0,0 +1,530 @@
+/***************************************************************************************************
+ *
+ *  @file       Nnue.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Efficiently updatable neural network evaluation
+ *
+ **************************************************************************************************/
+
+#include "Nnue.h"
+#include "ChessEngine.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE4_1__)
+    #include <smmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+using namespace chessEngine;
+using namespace chessEngine::nnue;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Kernels
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t
+_featureIndex(attributes::ChessColor inPerspective, attributes::ChessColor inColor,
+              attributes::ChessPieceName inPiece, uint8_t inSquareIndex)
+{
+    uint32_t relColor = (inColor == inPerspective) ? 0 : 1;
+    uint32_t sq       = ((inPerspective == attributes::ChessColor::kWhite) ?
+                         inSquareIndex : (inSquareIndex ^ 56));
+
+    return (relColor * 6 + static_cast<uint32_t>(inPiece)) * 64 + sq;
+}
+
+static inline void
+_addScalar(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    for (uint32_t i = 0; i < kL1Size; i++)
+    {
+        inOutAcc[i] = static_cast<int16_t>(inOutAcc[i] + inWeights[i]);
+    }
+}
+
+static inline void
+_subScalar(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    for (uint32_t i = 0; i < kL1Size; i++)
+    {
+        inOutAcc[i] = static_cast<int16_t>(inOutAcc[i] - inWeights[i]);
+    }
+}
+
+static inline void
+_clipScalar(const int16_t * inValues, uint8_t * outValues, uint32_t inSize)
+{
+    for (uint32_t i = 0; i < inSize; i++)
+    {
+        int32_t v    = std::min<int32_t>(std::max<int32_t>(inValues[i], 0), kActivationMax);
+        outValues[i] = static_cast<uint8_t>(v);
+    }
+}
+
+static inline int32_t
+_dotScalar(const uint8_t * inValues, const int8_t * inWeights, uint32_t inSize)
+{
+    int32_t sum = 0;
+
+    for (uint32_t i = 0; i < inSize; i++)
+    {
+        sum += static_cast<int32_t>(inValues[i]) * inWeights[i];
+    }
+
+    return sum;
+}
+
+#if defined(__AVX2__)
+
+static const char * const kKernelName = "avx2";
+
+static inline void
+_add(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    for (uint32_t i = 0; i < kL1Size; i += 16)
+    {
+        auto acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inOutAcc + i));
+        auto w   = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inWeights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(inOutAcc + i), _mm256_add_epi16(acc, w));
+    }
+}
+
+static inline void
+_sub(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    for (uint32_t i = 0; i < kL1Size; i += 16)
+    {
+        auto acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inOutAcc + i));
+        auto w   = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inWeights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(inOutAcc + i), _mm256_sub_epi16(acc, w));
+    }
+}
+
+static inline void
+_clip(const int16_t * inValues, uint8_t * outValues, uint32_t inSize)
+{
+    const auto zero = _mm256_setzero_si256();
+    const auto max  = _mm256_set1_epi8(kActivationMax);
+
+    for (uint32_t i = 0; i < inSize; i += 32)
+    {
+        auto lo     = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inValues + i));
+        auto hi     = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inValues + i + 16));
+
+        // packs works on 128 bit lanes, so restore the order of the 64 bit quarters
+        auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(lo, hi), 0xD8);
+        packed      = _mm256_min_epi8(_mm256_max_epi8(packed, zero), max);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outValues + i), packed);
+    }
+}
+
+static inline int32_t
+_dot(const uint8_t * inValues, const int8_t * inWeights, uint32_t inSize)
+{
+    const auto ones = _mm256_set1_epi16(1);
+    auto sum        = _mm256_setzero_si256();
+
+    for (uint32_t i = 0; i < inSize; i += 32)
+    {
+        auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inValues + i));
+        auto w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inWeights + i));
+
+        // Inputs are at most kActivationMax, so the pairwise 16 bit sums cannot saturate
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(v, w), ones));
+    }
+
+    auto sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum128      = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+    sum128      = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+
+    return _mm_cvtsi128_si32(sum128);
+}
+
+#elif defined(__SSE4_1__)
+
+static const char * const kKernelName = "sse4.1";
+
+static inline void
+_add(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    for (uint32_t i = 0; i < kL1Size; i += 8)
+    {
+        auto acc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inOutAcc + i));
+        auto w   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inWeights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(inOutAcc + i), _mm_add_epi16(acc, w));
+    }
+}
+
+static inline void
+_sub(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    for (uint32_t i = 0; i < kL1Size; i += 8)
+    {
+        auto acc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inOutAcc + i));
+        auto w   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inWeights + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(inOutAcc + i), _mm_sub_epi16(acc, w));
+    }
+}
+
+static inline void
+_clip(const int16_t * inValues, uint8_t * outValues, uint32_t inSize)
+{
+    const auto zero = _mm_setzero_si128();
+    const auto max  = _mm_set1_epi8(kActivationMax);
+
+    for (uint32_t i = 0; i < inSize; i += 16)
+    {
+        auto lo     = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inValues + i));
+        auto hi     = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inValues + i + 8));
+        auto packed = _mm_min_epi8(_mm_max_epi8(_mm_packs_epi16(lo, hi), zero), max);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(outValues + i), packed);
+    }
+}
+
+static inline int32_t
+_dot(const uint8_t * inValues, const int8_t * inWeights, uint32_t inSize)
+{
+    const auto ones = _mm_set1_epi16(1);
+    auto sum        = _mm_setzero_si128();
+
+    for (uint32_t i = 0; i < inSize; i += 16)
+    {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inValues + i));
+        auto w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inWeights + i));
+
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(v, w), ones));
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+
+    return _mm_cvtsi128_si32(sum);
+}
+
+#elif defined(__ARM_NEON)
+
+static const char * const kKernelName = "neon";
+
+static inline void
+_add(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    for (uint32_t i = 0; i < kL1Size; i += 8)
+    {
+        vst1q_s16(inOutAcc + i, vaddq_s16(vld1q_s16(inOutAcc + i), vld1q_s16(inWeights + i)));
+    }
+}
+
+static inline void
+_sub(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    for (uint32_t i = 0; i < kL1Size; i += 8)
+    {
+        vst1q_s16(inOutAcc + i, vsubq_s16(vld1q_s16(inOutAcc + i), vld1q_s16(inWeights + i)));
+    }
+}
+
+static inline void
+_clip(const int16_t * inValues, uint8_t * outValues, uint32_t inSize)
+{
+    const auto zero = vdup_n_s8(0);
+    const auto max  = vdup_n_s8(kActivationMax);
+
+    for (uint32_t i = 0; i < inSize; i += 8)
+    {
+        auto packed = vqmovn_s16(vld1q_s16(inValues + i));
+        packed      = vmin_s8(vmax_s8(packed, zero), max);
+
+        vst1_u8(outValues + i, vreinterpret_u8_s8(packed));
+    }
+}
+
+static inline int32_t
+_dot(const uint8_t * inValues, const int8_t * inWeights, uint32_t inSize)
+{
+    auto sum = vdupq_n_s32(0);
+
+    for (uint32_t i = 0; i < inSize; i += 16)
+    {
+        // Inputs are at most kActivationMax, so they are valid signed bytes
+        auto v   = vreinterpretq_s8_u8(vld1q_u8(inValues + i));
+        auto w   = vld1q_s8(inWeights + i);
+
+        auto lo  = vmull_s8(vget_low_s8(v), vget_low_s8(w));
+        auto hi  = vmull_s8(vget_high_s8(v), vget_high_s8(w));
+
+        sum      = vpadalq_s16(sum, lo);
+        sum      = vpadalq_s16(sum, hi);
+    }
+
+    return vgetq_lane_s32(sum, 0) + vgetq_lane_s32(sum, 1) +
+           vgetq_lane_s32(sum, 2) + vgetq_lane_s32(sum, 3);
+}
+
+#else
+
+static const char * const kKernelName = "scalar";
+
+static inline void
+_add(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    _addScalar(inOutAcc, inWeights);
+}
+
+static inline void
+_sub(int16_t * inOutAcc, const int16_t * inWeights)
+{
+    _subScalar(inOutAcc, inWeights);
+}
+
+static inline void
+_clip(const int16_t * inValues, uint8_t * outValues, uint32_t inSize)
+{
+    _clipScalar(inValues, outValues, inSize);
+}
+
+static inline int32_t
+_dot(const uint8_t * inValues, const int8_t * inWeights, uint32_t inSize)
+{
+    return _dotScalar(inValues, inWeights, inSize);
+}
+
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark File byte order
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline bool
+_isBigEndian()
+{
+    const uint16_t value = 1;
+
+    return (*reinterpret_cast<const uint8_t *>(&value) == 0);
+}
+
+/**
+ @brief         Reverse the bytes of every value of an array, between the little endian file and
+ a big endian host
+ */
+template <typename T>
+static void
+_swapBytes(T * inOutValues, size_t inNumValues)
+{
+    auto bytes = reinterpret_cast<uint8_t *>(inOutValues);
+
+    for (size_t i = 0; i < inNumValues; i++, bytes += sizeof(T))
+    {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+}
+
+static void
+_swapBytes(Network * inOutNetwork)
+{
+    _swapBytes(&inOutNetwork->l1Weights[0][0], kNumInputs * kL1Size);
+    _swapBytes(inOutNetwork->l1Biases, kL1Size);
+    _swapBytes(inOutNetwork->l2Biases, kL2Size);
+    _swapBytes(&inOutNetwork->outBias, 1);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Network
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+Network::load(const char * inPath)
+{
+    FILE * file = fopen(inPath, "rb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    // Read into a network of its own, so that a bad file leaves these weights as they were
+    std::unique_ptr<Network> network(new Network());
+    uint32_t                 header[5];
+    bool                     ret = (fread(header, sizeof(header), 1, file) == 1);
+
+    if (_isBigEndian())
+    {
+        _swapBytes(header, 5);
+    }
+
+    ret = ret && (header[0] == kFileMagic) && (header[1] == kFileVersion);
+    ret = ret && (header[2] == kNumInputs) && (header[3] == kL1Size) && (header[4] == kL2Size);
+
+    ret = ret && (fread(network->l1Weights, sizeof(l1Weights), 1, file) == 1);
+    ret = ret && (fread(network->l1Biases, sizeof(l1Biases), 1, file) == 1);
+    ret = ret && (fread(network->l2Weights, sizeof(l2Weights), 1, file) == 1);
+    ret = ret && (fread(network->l2Biases, sizeof(l2Biases), 1, file) == 1);
+    ret = ret && (fread(network->outWeights, sizeof(outWeights), 1, file) == 1);
+    ret = ret && (fread(&network->outBias, sizeof(outBias), 1, file) == 1);
+
+    // A longer file is of another network, even with the same header
+    ret = ret && (fgetc(file) == EOF) && (feof(file) != 0);
+
+    fclose(file);
+
+    if (!ret)
+    {
+        chessEngine::log("Network::load(%s) failed\n", inPath);
+        return false;
+    }
+
+    if (_isBigEndian())
+    {
+        _swapBytes(network.get());
+    }
+
+    *this = *network;
+
+    return true;
+}
+
+bool
+Network::save(const char * inPath) const
+{
+    FILE * file = fopen(inPath, "wb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    // The file is little endian whatever the host
+    std::unique_ptr<Network> swapped;
+    const Network *          network = this;
+    uint32_t                 header[5] = { kFileMagic, kFileVersion, kNumInputs, kL1Size, kL2Size };
+
+    if (_isBigEndian())
+    {
+        swapped.reset(new Network(*this));
+        _swapBytes(swapped.get());
+        _swapBytes(header, 5);
+        network = swapped.get();
+    }
+
+    bool ret = (fwrite(header, sizeof(header), 1, file) == 1);
+
+    ret = ret && (fwrite(network->l1Weights, sizeof(l1Weights), 1, file) == 1);
+    ret = ret && (fwrite(network->l1Biases, sizeof(l1Biases), 1, file) == 1);
+    ret = ret && (fwrite(network->l2Weights, sizeof(l2Weights), 1, file) == 1);
+    ret = ret && (fwrite(network->l2Biases, sizeof(l2Biases), 1, file) == 1);
+    ret = ret && (fwrite(network->outWeights, sizeof(outWeights), 1, file) == 1);
+    ret = ret && (fwrite(&network->outBias, sizeof(outBias), 1, file) == 1);
+
+    return (fclose(file) == 0) && ret;
+}
+
+void
+Network::refresh(const ChessEngine & inEngine, Accumulator * outAccumulator) const
+{
+    for (auto c = 0; c < 2; c++)
+    {
+        std::copy(l1Biases, l1Biases + kL1Size, outAccumulator->values[c]);
+    }
+
+    for (auto color : { attributes::ChessColor::kBlack, attributes::ChessColor::kWhite })
+    {
+        for (uint8_t piece = 0; piece < 6; piece++)
+        {
+            auto name = static_cast<attributes::ChessPieceName>(piece);
+
+            for (auto sq : inEngine.getPieces(color, name))
+            {
+                addPiece(outAccumulator, color, name, sq.index);
+            }
+        }
+    }
+}
+
+void
+Network::addPiece(Accumulator * inOutAccumulator, attributes::ChessColor inColor,
+                  attributes::ChessPieceName inPiece, uint8_t inSquareIndex) const
+{
+    for (auto persp : { attributes::ChessColor::kBlack, attributes::ChessColor::kWhite })
+    {
+        auto index = _featureIndex(persp, inColor, inPiece, inSquareIndex);
+        _add(inOutAccumulator->values[static_cast<uint8_t>(persp)], l1Weights[index]);
+    }
+}
+
+void
+Network::removePiece(Accumulator * inOutAccumulator, attributes::ChessColor inColor,
+                     attributes::ChessPieceName inPiece, uint8_t inSquareIndex) const
+{
+    for (auto persp : { attributes::ChessColor::kBlack, attributes::ChessColor::kWhite })
+    {
+        auto index = _featureIndex(persp, inColor, inPiece, inSquareIndex);
+        _sub(inOutAccumulator->values[static_cast<uint8_t>(persp)], l1Weights[index]);
+    }
+}
+
+int
+Network::evaluate(const Accumulator & inAccumulator, attributes::ChessColor inSideToMove) const
+{
+    auto us   = static_cast<uint8_t>(inSideToMove);
+    auto them = us ^ 1;
+
+    uint8_t input[2 * kL1Size];
+    uint8_t hidden[kL2Size];
+
+    _clip(inAccumulator.values[us], input, kL1Size);
+    _clip(inAccumulator.values[them], input + kL1Size, kL1Size);
+
+    for (uint32_t i = 0; i < kL2Size; i++)
+    {
+        int32_t sum = (_dot(input, l2Weights[i], 2 * kL1Size) + l2Biases[i]) >> kWeightShift;
+        hidden[i]   = static_cast<uint8_t>(std::min<int32_t>(std::max<int32_t>(sum, 0),
+                                                             kActivationMax));
+    }
+
+    return (_dot(hidden, outWeights, kL2Size) + outBias) / kOutputScale;
+}
+
+int
+Network::evaluateScalar(const Accumulator & inAccumulator,
+                        attributes::ChessColor inSideToMove) const
+{
+    auto us   = static_cast<uint8_t>(inSideToMove);
+    auto them = us ^ 1;
+
+    uint8_t input[2 * kL1Size];
+    uint8_t hidden[kL2Size];
+
+    _clipScalar(inAccumulator.values[us], input, kL1Size);
+    _clipScalar(inAccumulator.values[them], input + kL1Size, kL1Size);
+
+    for (uint32_t i = 0; i < kL2Size; i++)
+    {
+        int32_t sum = ((_dotScalar(input, l2Weights[i], 2 * kL1Size) + l2Biases[i]) >>
+                       kWeightShift);
+        hidden[i]   = static_cast<uint8_t>(std::min<int32_t>(std::max<int32_t>(sum, 0),
+                                                             kActivationMax));
+    }
+
+    return (_dotScalar(hidden, outWeights, kL2Size) + outBias) / kOutputScale;
+}
+
+const char *
+Network::getKernelName()
+{
+    return kKernelName;
+}
@@ -0,0 +1,140 @@
+/***************************************************************************************************
+ *
+ *  @file       Nnue.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Efficiently updatable neural network evaluation
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include "Chess.h"
+
+namespace chessEngine
+{
+    class ChessEngine;
+
+    namespace nnue
+    {
+        /**
+         @brief         Network dimensions
+
+         @discussion    768 inputs per perspective (own/their x 6 pieces x 64 squares, flipped
+         vertically for black), a 128 wide accumulator per perspective, one hidden layer of 32 and
+         a single output.
+         */
+        static constexpr uint32_t   kNumInputs      = 2 * 6 * 64;
+        static constexpr uint32_t   kL1Size         = 128;
+        static constexpr uint32_t   kL2Size         = 32;
+
+        /**
+         @brief         Quantisation of the network file
+
+         @discussion    The accumulator is clipped to [0, kActivationMax] before feeding the
+         hidden layer. Hidden sums are shifted right by kWeightShift before being clipped the same
+         way. The output is divided by kOutputScale to get centipawns.
+         */
+        static constexpr int32_t    kActivationMax  = 127;
+        static constexpr int32_t    kWeightShift    = 6;
+        static constexpr int32_t    kOutputScale    = 16;
+
+        static constexpr uint32_t   kFileMagic      = 0x4E4E4343;   // "CCNN"
+        static constexpr uint32_t   kFileVersion    = 1;
+
+        /**
+         @class          Accumulator
+
+         @brief          First layer output of both perspectives, indexed by ChessColor
+         */
+        struct Accumulator
+        {
+            int16_t                 values[2][kL1Size];
+        };
+
+        /**
+         @class          Network
+
+         @brief          Weights of the network
+
+         @discussion     Read only once loaded, so one network can be shared by every engine and
+         search thread.
+
+         File layout, all little endian: magic, version, kNumInputs, kL1Size, kL2Size as uint32,
+         then the L1 weights as int16 [kNumInputs][kL1Size], the L1 biases as int16 [kL1Size], the
+         L2 weights as int8 [kL2Size][2 * kL1Size], the L2 biases as int32 [kL2Size], the output
+         weights as int8 [kL2Size] and the output bias as int32.
+         */
+        class Network
+        {
+        public:
+            /**
+             @brief         Load the weights from a file
+
+             @discussion    The file is read into a network of its own and only copied over
+             these weights once it is complete, so a failed load leaves them as they were. The
+             file is little endian, and converted on big endian hosts.
+
+             @return        false if the file is missing, truncated, longer than the network or of
+             another architecture
+             */
+            bool                    load(const char * inPath);
+
+            /**
+             @brief         Save the weights to a file, little endian whatever the host
+             */
+            bool                    save(const char * inPath) const;
+
+            /**
+             @brief         Compute the accumulator of a position from scratch
+             */
+            void                    refresh(const ChessEngine & inEngine,
+                                            Accumulator * outAccumulator) const;
+
+            /**
+             @brief         Add a piece to both perspectives of an accumulator
+             */
+            void                    addPiece(Accumulator * inOutAccumulator,
+                                             attributes::ChessColor inColor,
+                                             attributes::ChessPieceName inPiece,
+                                             uint8_t inSquareIndex) const;
+
+            /**
+             @brief         Remove a piece from both perspectives of an accumulator
+             */
+            void                    removePiece(Accumulator * inOutAccumulator,
+                                                attributes::ChessColor inColor,
+                                                attributes::ChessPieceName inPiece,
+                                                uint8_t inSquareIndex) const;
+
+            /**
+             @brief         Run the dense layers
+
+             @return        score in centipawns from the point of view of inSideToMove
+             */
+            int                     evaluate(const Accumulator & inAccumulator,
+                                             attributes::ChessColor inSideToMove) const;
+
+            /**
+             @brief         Same as evaluate, but always with the scalar kernels
+             */
+            int                     evaluateScalar(const Accumulator & inAccumulator,
+                                                   attributes::ChessColor inSideToMove) const;
+
+            /**
+             @brief         Name of the kernels evaluate uses in this build
+             */
+            static const char *     getKernelName();
+
+            int16_t                 l1Weights[kNumInputs][kL1Size];
+            int16_t                 l1Biases[kL1Size];
+            int8_t                  l2Weights[kL2Size][2 * kL1Size];
+            int32_t                 l2Biases[kL2Size];
+            int8_t                  outWeights[kL2Size];
+            int32_t                 outBias;
+        };
+    }
+}
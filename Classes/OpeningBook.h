@@ -0,0 +1,171 @@
+/***************************************************************************************************
+ *
+ *  @file       OpeningBook.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Opening book in the Polyglot layout
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "MappedFile.h"
+#include "Zobrist.h"
+
+#include <string>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @class          BookEntry
+
+     @brief          A move of a book position and how often it should be played
+     */
+    struct BookEntry
+    {
+        ZobristKey                  key;
+        PackedMove                  move;
+        uint16_t                    weight;
+        uint32_t                    learn;
+
+        BookEntry() :
+        key(0), move(), weight(0), learn(0)
+        { }
+
+        BookEntry(ZobristKey inKey, PackedMove inMove, uint16_t inWeight) :
+        key(inKey), move(inMove), weight(inWeight), learn(0)
+        { }
+    };
+
+    /**
+     @class          OpeningBook
+
+     @brief          Moves to play from a book file, without searching
+
+     @discussion     The file has the Polyglot layout: 16 byte big endian entries of the key, the
+     move, the weight and a learn field, sorted by key. The key is the Polyglot one,
+     getPolyglotKey(), so books made by Polyglot and other tools can be used as they are. Books
+     written with write() from the position keys of the engine, ChessEngine::getHashKey(), save
+     hashing every position again, and are opened with kEngineKeys.
+
+     The file is mapped read only, so books opened by several games share the page cache, and a
+     lookup is a binary search over the mapped entries that does not allocate. The book is not
+     changed after open(), so any number of threads may look up moves at once.
+     */
+    class OpeningBook
+    {
+    public:
+        /**
+         @brief         How the positions of a file are keyed
+         */
+        enum KeyType
+        {
+            kPolyglotKeys,
+            kEngineKeys
+        };
+
+        static constexpr size_t     kEntrySize          = 16;
+        static constexpr size_t     kNumPolyglotRandoms = 781;
+
+        /**
+         @brief         Random64 table of the Polyglot format
+         */
+        static const ZobristKey     kPolyglotRandoms[kNumPolyglotRandoms];
+
+        OpeningBook();
+
+        /**
+         @brief         Map a book file, closing the one mapped before
+
+         @param     inKeyType       kEngineKeys only for books written with the keys of the engine
+
+         @return        false if the file could not be mapped or is not a whole number of entries
+         */
+        bool                        open(const std::string & inPath,
+                                         KeyType inKeyType = kPolyglotKeys);
+
+        void                        close();
+
+        bool                        isOpen() const { return _file.isOpen(); }
+
+        size_t                      getNumEntries() const { return _numEntries; }
+
+        /**
+         @brief         Look up the moves of a position
+
+         @discussion    Entries are returned in the order of the file, the highest weight first
+         for books written by write(). Moves that are not legal in the position, which may be
+         left by a key collision, are skipped.
+
+         @param     outEntries      filled with the entries, at most inMaxEntries of them
+
+         @return        number of entries found
+         */
+        size_t                      probe(const ChessEngine & inPosition, BookEntry * outEntries,
+                                          size_t inMaxEntries) const;
+
+        /**
+         @brief         Pick a move of a position at random, in proportion to the weights
+
+         @param     inRandom        a uniform random number, so that the caller owns the generator
+         and picks can be repeated
+
+         @return        the null move if the position is not in the book
+         */
+        PackedMove                  pickMove(const ChessEngine & inPosition,
+                                             uint32_t inRandom) const;
+
+        /**
+         @brief         Write a book file
+
+         @discussion    Entries keep the keys they are given, getPolyglotKey() ones for a book that
+         any Polyglot reader can use. Entries of the same key and move are merged by adding their
+         weights, which saturate at the largest weight. The entries of a key are sorted by weight.
+
+         @return        false if the file could not be written
+         */
+        static bool                 write(const std::string & inPath,
+                                          std::vector<BookEntry> inEntries);
+
+        /**
+         @brief         Move as encoded in the file
+
+         @discussion    Bits 0-5 hold the destination square, bits 6-11 the source square and bits
+         12-14 the promotion piece. Castling is encoded as the king taking its own rook.
+         */
+        static uint16_t             encodeMove(PackedMove inMove);
+
+        /**
+         @brief         Key of a position in the Polyglot format
+
+         @discussion    Every piece is hashed with the number at 64 * kind + square, the kinds
+         going from the black pawn, the white pawn and the black knight up to the white king. Then
+         come the castling rights from 768, the en passant file from 772 when a pawn of the side to
+         move stands next to the pushed pawn, whether the capture is legal or not, and 780 when
+         white is to move, all in kPolyglotRandoms.
+         */
+        static ZobristKey           getPolyglotKey(const ChessEngine & inPosition);
+
+    private:
+        ZobristKey                  _getKey(size_t inIndex) const;
+
+        /**
+         @brief         Key of a position as in the file
+         */
+        ZobristKey                  _getPositionKey(const ChessEngine & inPosition) const;
+
+        /**
+         @brief         Read the entry of an index, with the move still encoded
+         */
+        void                        _getEntry(size_t inIndex, BookEntry * outEntry,
+                                              uint16_t * outMove) const;
+
+        MappedFile                  _file;
+        size_t                      _numEntries;
+        KeyType                     _keyType;
+    };
+}
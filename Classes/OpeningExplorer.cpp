@@ -0,0 +1,404 @@
+/***************************************************************************************************
+ *
+ *  @file       OpeningExplorer.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Statistics of the opening positions of a game database
+ *
+ **************************************************************************************************/
+
+#include "OpeningExplorer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace chessEngine;
+
+static constexpr size_t     kPositionEntrySize = 16;
+static constexpr size_t     kMoveEntrySize     = 20;
+
+/**
+ @brief         Statistics of a move while the explorer is built
+ */
+struct BuildMove
+{
+    PackedMove                  move;
+    uint32_t                    numGames;
+    uint32_t                    numResults[4];
+    uint32_t                    numRated;
+    uint64_t                    ratingSum;
+
+    /**
+     @brief         Last game counted, as a game repeating a position may play the move again
+     */
+    uint32_t                    game;
+};
+
+static inline uint64_t
+_readLittleEndian(const uint8_t * inData, int inNumBytes)
+{
+    uint64_t value = 0;
+
+    for (auto i = inNumBytes - 1; i >= 0; i--)
+    {
+        value = (value << 8) | inData[i];
+    }
+
+    return value;
+}
+
+static inline void
+_appendLittleEndian(uint64_t inValue, int inNumBytes, std::vector<uint8_t> * outData)
+{
+    for (auto i = 0; i < inNumBytes; i++)
+    {
+        outData->push_back(static_cast<uint8_t>(inValue));
+        inValue >>= 8;
+    }
+}
+
+/**
+ @return        rating of a rating tag, 0 if it is not a number or out of range
+ */
+static uint16_t
+_parseRating(StringView inValue)
+{
+    uint32_t rating = 0;
+
+    if (inValue.isEmpty() || (inValue.size > 4))
+    {
+        return 0;
+    }
+
+    for (auto c : inValue)
+    {
+        if ((c < '0') || (c > '9'))
+        {
+            return 0;
+        }
+
+        rating = (rating * 10) + static_cast<uint32_t>(c - '0');
+    }
+
+    return static_cast<uint16_t>(rating);
+}
+
+/**
+ @brief         Average rating of the players of every game, 0 for a game without one
+
+ @return        false if a record is damaged
+ */
+static bool
+_readRatings(const GameDatabase & inDatabase, std::vector<uint16_t> * outRatings)
+{
+    std::vector<PgnTag> tags;
+
+    outRatings->assign(inDatabase.getNumGames(), 0);
+
+    for (size_t i = 0; i < outRatings->size(); i++)
+    {
+        if (!inDatabase.readTags(i, &tags))
+        {
+            return false;
+        }
+
+        uint32_t sum        = 0;
+        uint32_t numPlayers = 0;
+
+        for (auto & tag : tags)
+        {
+            if ((tag.name == "WhiteElo") || (tag.name == "BlackElo"))
+            {
+                auto rating = _parseRating(tag.value);
+
+                sum        += rating;
+                numPlayers += (rating > 0) ? 1 : 0;
+            }
+        }
+
+        (*outRatings)[i] = (numPlayers == 0) ? 0 : static_cast<uint16_t>(sum / numPlayers);
+    }
+
+    return true;
+}
+
+static ExplorerMove
+_readMoveEntry(const uint8_t * inEntry)
+{
+    ExplorerMove move;
+
+    move.move.data     = static_cast<uint16_t>(_readLittleEndian(inEntry, 2));
+    move.averageRating = static_cast<uint16_t>(_readLittleEndian(inEntry + 2, 2));
+    move.numGames      = static_cast<uint32_t>(_readLittleEndian(inEntry + 4, 4));
+    move.numWhiteWins  = static_cast<uint32_t>(_readLittleEndian(inEntry + 8, 4));
+    move.numDraws      = static_cast<uint32_t>(_readLittleEndian(inEntry + 12, 4));
+    move.numBlackWins  = static_cast<uint32_t>(_readLittleEndian(inEntry + 16, 4));
+
+    return move;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark OpeningExplorer
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+OpeningExplorer::OpeningExplorer() :
+_file(), _numPositions(0), _numMoves(0), _maxPlies(0), _positions(nullptr), _moves(nullptr)
+{ }
+
+bool
+OpeningExplorer::open(const std::string & inPath)
+{
+    close();
+
+    // Probes jump around the file, read ahead would only waste the page cache
+    if (!_file.open(inPath, true))
+    {
+        return false;
+    }
+
+    auto data = _file.getData();
+    auto size = _file.getSize();
+
+    if ((size < kHeaderSize) || (_readLittleEndian(data, 4) != kMagic) ||
+        (_readLittleEndian(data + 4, 4) != kVersion))
+    {
+        close();
+        return false;
+    }
+
+    uint64_t numPositions = _readLittleEndian(data + 8, 8);
+    uint64_t numMoves     = _readLittleEndian(data + 16, 8);
+    uint64_t maxPlies     = _readLittleEndian(data + 24, 4);
+
+    if ((numPositions > (size - kHeaderSize) / kPositionEntrySize) ||
+        (numMoves != (size - kHeaderSize - (numPositions * kPositionEntrySize)) / kMoveEntrySize))
+    {
+        close();
+        return false;
+    }
+
+    _numPositions = static_cast<size_t>(numPositions);
+    _numMoves     = static_cast<size_t>(numMoves);
+    _maxPlies     = static_cast<size_t>(maxPlies);
+    _positions    = data + kHeaderSize;
+    _moves        = _positions + (_numPositions * kPositionEntrySize);
+
+    return true;
+}
+
+void
+OpeningExplorer::close()
+{
+    _file.close();
+    _numPositions = 0;
+    _numMoves     = 0;
+    _maxPlies     = 0;
+    _positions    = nullptr;
+    _moves        = nullptr;
+}
+
+size_t
+OpeningExplorer::probe(const ChessEngine & inPosition, std::vector<ExplorerMove> * outMoves) const
+{
+    auto   key  = inPosition.getHashKey();
+    size_t low  = 0;
+    size_t high = _numPositions;
+
+    outMoves->clear();
+
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+
+        if (_readLittleEndian(_positions + (mid * kPositionEntrySize), 8) < key)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    auto entry = _positions + (low * kPositionEntrySize);
+
+    if ((low == _numPositions) || (_readLittleEndian(entry, 8) != key))
+    {
+        return 0;
+    }
+
+    // The moves of a position end where those of the next one start
+    size_t   numGames  = static_cast<size_t>(_readLittleEndian(entry + 8, 4));
+    size_t   firstMove = static_cast<size_t>(_readLittleEndian(entry + 12, 4));
+    size_t   endMove   = (low + 1 < _numPositions)
+                       ? static_cast<size_t>(_readLittleEndian(entry + kPositionEntrySize + 12, 4))
+                       : _numMoves;
+    MoveList legalMoves;
+
+    inPosition.generateLegalMoves(&legalMoves);
+
+    for (size_t i = firstMove; (i < endMove) && (i < _numMoves); i++)
+    {
+        auto move = _readMoveEntry(_moves + (i * kMoveEntrySize));
+
+        if (legalMoves.contains(move.move))
+        {
+            outMoves->push_back(move);
+        }
+    }
+
+    return numGames;
+}
+
+bool
+OpeningExplorer::build(const GameDatabase & inDatabase, const PositionIndex & inIndex,
+                       const std::string & inPath, size_t inMaxPlies, size_t inMinGames)
+{
+    std::vector<uint16_t> ratings;
+
+    if (!_readRatings(inDatabase, &ratings))
+    {
+        return false;
+    }
+
+    std::vector<uint8_t>   positions;
+    std::vector<uint8_t>   moves;
+    std::vector<BuildMove> keyMoves;
+    ZobristKey             key         = 0;
+    uint32_t               numKeyGames = 0;
+    uint32_t               keyGame     = 0;
+    uint64_t               numMoves    = 0;
+    size_t                 minGames    = std::max<size_t>(inMinGames, 1);
+
+    auto flushKey = [&] {
+        if (numKeyGames >= minGames)
+        {
+            std::stable_sort(keyMoves.begin(), keyMoves.end(),
+                             [] (const BuildMove & inA, const BuildMove & inB) {
+                return inA.numGames > inB.numGames;
+            });
+
+            _appendLittleEndian(key, 8, &positions);
+            _appendLittleEndian(numKeyGames, 4, &positions);
+            _appendLittleEndian(numMoves, 4, &positions);
+
+            for (auto & move : keyMoves)
+            {
+                if (move.numGames < minGames)
+                {
+                    continue;
+                }
+
+                auto averageRating = (move.numRated == 0) ? 0 : move.ratingSum / move.numRated;
+
+                _appendLittleEndian(move.move.data, 2, &moves);
+                _appendLittleEndian(averageRating, 2, &moves);
+                _appendLittleEndian(move.numGames, 4, &moves);
+                _appendLittleEndian(move.numResults[static_cast<int>(GameResult::kWhiteWins)], 4,
+                                    &moves);
+                _appendLittleEndian(move.numResults[static_cast<int>(GameResult::kDraw)], 4,
+                                    &moves);
+                _appendLittleEndian(move.numResults[static_cast<int>(GameResult::kBlackWins)], 4,
+                                    &moves);
+                numMoves++;
+            }
+        }
+
+        keyMoves.clear();
+        numKeyGames = 0;
+    };
+
+    // The postings come sorted by key, so every position is complete once the key changes
+    bool isScanned = inIndex.scan([&] (ZobristKey inKey, const PositionPosting & inPosting) {
+        if (inPosting.game >= ratings.size())
+        {
+            return false;
+        }
+
+        if (inPosting.ply >= inMaxPlies)
+        {
+            return true;
+        }
+
+        if (inKey != key)
+        {
+            flushKey();
+            key = inKey;
+        }
+
+        // The postings of a key are sorted by game, so a game repeating the position counts once
+        if ((numKeyGames == 0) || (inPosting.game != keyGame))
+        {
+            keyGame = inPosting.game;
+            numKeyGames++;
+        }
+
+        if (inPosting.move.isNull())
+        {
+            return true;
+        }
+
+        auto move = std::find_if(keyMoves.begin(), keyMoves.end(),
+                                 [&] (const BuildMove & inMove) {
+            return inMove.move == inPosting.move;
+        });
+
+        if (move == keyMoves.end())
+        {
+            keyMoves.push_back({ inPosting.move, 0, { }, 0, 0, 0 });
+            move = keyMoves.end() - 1;
+        }
+        else if (move->game == inPosting.game)
+        {
+            return true;
+        }
+
+        auto rating = ratings[inPosting.game];
+        auto result = static_cast<size_t>(inPosting.result);
+
+        // A damaged or unknown result counts for the move, but for none of the outcomes
+        if (result < 4)
+        {
+            move->numResults[result]++;
+        }
+
+        move->game = inPosting.game;
+        move->numGames++;
+        move->numRated  += (rating > 0) ? 1 : 0;
+        move->ratingSum += rating;
+
+        return true;
+    });
+
+    flushKey();
+
+    if (!isScanned || (numMoves > UINT32_MAX))
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> header;
+
+    _appendLittleEndian(kMagic, 4, &header);
+    _appendLittleEndian(kVersion, 4, &header);
+    _appendLittleEndian(positions.size() / kPositionEntrySize, 8, &header);
+    _appendLittleEndian(numMoves, 8, &header);
+    _appendLittleEndian(inMaxPlies, 4, &header);
+    header.resize(kHeaderSize, 0);
+
+    FILE * file = fopen(inPath.c_str(), "wb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    bool isWritten = (fwrite(header.data(), 1, header.size(), file) == header.size()) &&
+                     (fwrite(positions.data(), 1, positions.size(), file) == positions.size()) &&
+                     (fwrite(moves.data(), 1, moves.size(), file) == moves.size());
+
+    return (fclose(file) == 0) && isWritten;
+}
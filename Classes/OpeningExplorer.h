@@ -0,0 +1,132 @@
+/***************************************************************************************************
+ *
+ *  @file       OpeningExplorer.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Statistics of the opening positions of a game database
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "GameDatabase.h"
+#include "MappedFile.h"
+#include "PositionIndex.h"
+#include "Zobrist.h"
+
+#include <string>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @class          ExplorerMove
+
+     @brief          How often a move was played in an opening position, and how the games ended
+     */
+    struct ExplorerMove
+    {
+        PackedMove                  move;
+        uint32_t                    numGames;
+        uint32_t                    numWhiteWins;
+        uint32_t                    numDraws;
+        uint32_t                    numBlackWins;
+
+        /**
+         @brief         Average of the ratings of the players of the games, 0 if none was rated
+         */
+        uint16_t                    averageRating;
+
+        /**
+         @brief         Score of White in the games, in percent
+         */
+        double                      getWhiteScore() const
+        {
+            return (numGames == 0) ? 0.0
+                 : (numWhiteWins + (numDraws * 0.5)) * 100.0 / numGames;
+        }
+    };
+
+    /**
+     @class          OpeningExplorer
+
+     @brief          Moves played in the opening positions of a database, precomputed
+
+     @discussion     Unlike PositionIndex::getMoveStats(), which decodes every posting of a
+     position, a probe here reads a few entries of a table, so that an opening tree can be shown
+     as fast as it is clicked through.
+
+     The file starts with a header of the magic, the version, the number of positions, the number
+     of moves and the number of plies the table was built for, all little endian. A table of the
+     positions sorted by key follows, 16 bytes each: the key, the number of games reaching the
+     position and the index of its first move. The moves of every position follow in a table of
+     their own, the most played first, 20 bytes each: the move, the average rating, and the number
+     of games, of wins for White, of draws and of wins for Black.
+
+     As with PositionIndex, moves that are not legal in the probed position, which can only come
+     from a key collision, are left out.
+     */
+    class OpeningExplorer
+    {
+    public:
+        static constexpr uint32_t   kMagic      = 0x58454F43;   // COEX
+        static constexpr uint32_t   kVersion    = 1;
+        static constexpr size_t     kHeaderSize = 32;
+
+        OpeningExplorer();
+
+        /**
+         @brief         Map an explorer file, closing the one mapped before
+
+         @return        false if the file could not be mapped, or its header is not valid
+         */
+        bool                        open(const std::string & inPath);
+
+        void                        close();
+
+        bool                        isOpen() const { return _file.isOpen(); }
+
+        size_t                      getNumPositions() const { return _numPositions; }
+
+        /**
+         @brief         Number of plies from the start of the games the positions were taken from
+         */
+        size_t                      getMaxPlies() const { return _maxPlies; }
+
+        /**
+         @brief         Moves played in a position, the most played first
+
+         @param     outMoves        filled with the moves played in at least the minimum number
+         of games the table was built with
+
+         @return        number of games reaching the position, 0 if it is not in the table
+         */
+        size_t                      probe(const ChessEngine & inPosition,
+                                          std::vector<ExplorerMove> * outMoves) const;
+
+        /**
+         @brief         Build the explorer of a database from its position index
+
+         @param     inMaxPlies      positions reached after more plies are left out
+         @param     inMinGames      positions and moves of fewer games are left out
+
+         @return        false if the database or the index are damaged, or the file could not be
+         written
+         */
+        static bool                 build(const GameDatabase & inDatabase,
+                                          const PositionIndex & inIndex,
+                                          const std::string & inPath, size_t inMaxPlies,
+                                          size_t inMinGames);
+
+    private:
+        MappedFile                  _file;
+        size_t                      _numPositions;
+        size_t                      _numMoves;
+        size_t                      _maxPlies;
+        const uint8_t *             _positions;
+        const uint8_t *             _moves;
+    };
+}
@@ -0,0 +1,731 @@
+/***************************************************************************************************
+ *
+ *  @file       PgnReader.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Reading of games in the Portable Game Notation
+ *
+ **************************************************************************************************/
+
+#include "PgnReader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <thread>
+
+using namespace chessEngine;
+
+static bool
+_isSpace(char inChar)
+{
+    return (inChar == ' ') || (inChar == '\n') || (inChar == '\r') || (inChar == '\t') ||
+           (inChar == '\f') || (inChar == '\v');
+}
+
+static bool
+_isDigit(char inChar)
+{
+    return (inChar >= '0') && (inChar <= '9');
+}
+
+/**
+ @brief         Check if a character ends a token of the movetext
+ */
+static bool
+_isDelimiter(char inChar)
+{
+    return _isSpace(inChar) || (inChar == '{') || (inChar == '}') || (inChar == '(') ||
+           (inChar == ')') || (inChar == ';') || (inChar == '[') || (inChar == ']') ||
+           (inChar == '$');
+}
+
+static const char *
+_skipToLineEnd(const char * inCursor, const char * inEnd)
+{
+    while ((inCursor < inEnd) && (*inCursor != '\n'))
+    {
+        inCursor++;
+    }
+
+    return inCursor;
+}
+
+static const char *
+_skipComment(const char * inCursor, const char * inEnd)
+{
+    while ((inCursor < inEnd) && (*inCursor != '}'))
+    {
+        inCursor++;
+    }
+
+    return (inCursor < inEnd) ? inCursor + 1 : inEnd;
+}
+
+/**
+ @brief         Skip whitespace, and the escaped lines starting with % between the games
+ */
+static const char *
+_skipSpace(const char * inCursor, const char * inBegin, const char * inEnd)
+{
+    while (inCursor < inEnd)
+    {
+        if (_isSpace(*inCursor))
+        {
+            inCursor++;
+        }
+        else if ((*inCursor == '%') && ((inCursor == inBegin) || (inCursor[-1] == '\n')))
+        {
+            inCursor = _skipToLineEnd(inCursor, inEnd);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    return inCursor;
+}
+
+/**
+ @brief         Skip a variation, with the variations and comments nested in it
+ */
+static const char *
+_skipVariation(const char * inCursor, const char * inEnd)
+{
+    int depth = 0;
+
+    while (inCursor < inEnd)
+    {
+        char curr = *inCursor;
+
+        if (curr == '{')
+        {
+            inCursor = _skipComment(inCursor, inEnd);
+            continue;
+        }
+
+        if (curr == ';')
+        {
+            inCursor = _skipToLineEnd(inCursor, inEnd);
+            continue;
+        }
+
+        inCursor++;
+
+        if (curr == '(')
+        {
+            depth++;
+        }
+        else if ((curr == ')') && (--depth == 0))
+        {
+            break;
+        }
+    }
+
+    return inCursor;
+}
+
+/**
+ @brief         Check if a line starts with a tag, e.g. [Event "...
+ */
+static bool
+_isTagLine(const char * inCursor, const char * inEnd)
+{
+    const char * cursor = inCursor + 1;
+
+    while ((cursor < inEnd) && (isalnum(static_cast<unsigned char>(*cursor)) || (*cursor == '_')))
+    {
+        cursor++;
+    }
+
+    if ((cursor == inCursor + 1) || (cursor == inEnd) || !_isSpace(*cursor))
+    {
+        return false;
+    }
+
+    while ((cursor < inEnd) && _isSpace(*cursor) && (*cursor != '\n'))
+    {
+        cursor++;
+    }
+
+    return (cursor < inEnd) && (*cursor == '"');
+}
+
+/**
+ @brief         Start of the first game from a cursor on, the end if there is none
+
+ @discussion    A game starts with a tag line that does not follow another tag line. Brackets in
+ comments are not told apart from tags, unless they do not look like one.
+ */
+static const char *
+_findGameStart(const char * inCursor, const char * inBegin, const char * inEnd)
+{
+    while (inCursor < inEnd)
+    {
+        if ((inCursor != inBegin) && (inCursor[-1] != '\n'))
+        {
+            inCursor = _skipToLineEnd(inCursor, inEnd);
+            inCursor = (inCursor < inEnd) ? inCursor + 1 : inEnd;
+            continue;
+        }
+
+        if ((*inCursor == '[') && _isTagLine(inCursor, inEnd))
+        {
+            const char * prev = inCursor;
+
+            while ((prev != inBegin) && _isSpace(prev[-1]))
+            {
+                prev--;
+            }
+
+            while ((prev != inBegin) && (prev[-1] != '\n'))
+            {
+                prev--;
+            }
+
+            if ((prev == inCursor) || (*prev != '['))
+            {
+                return inCursor;
+            }
+        }
+
+        inCursor++;
+    }
+
+    return inEnd;
+}
+
+/**
+ @brief         Result that a token is, empty if it is not one
+ */
+static StringView
+_getResult(StringView inToken)
+{
+    static const StringView sResults[] = { "1-0", "0-1", "1/2-1/2", "*" };
+
+    for (auto result : sResults)
+    {
+        if (inToken == result)
+        {
+            return inToken;
+        }
+    }
+
+    return StringView();
+}
+
+static bool
+_getPieceName(char inLetter, attributes::ChessPieceName * outPiece)
+{
+    using attributes::ChessPieceName;
+
+    switch (inLetter)
+    {
+        case 'N':   *outPiece = ChessPieceName::kKnight;    return true;
+        case 'B':   *outPiece = ChessPieceName::kBishop;    return true;
+        case 'R':   *outPiece = ChessPieceName::kRook;      return true;
+        case 'Q':   *outPiece = ChessPieceName::kQueen;     return true;
+        case 'K':   *outPiece = ChessPieceName::kKing;      return true;
+        default:                                            return false;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark PgnGame
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StringView
+PgnGame::getTag(StringView inName) const
+{
+    for (auto & tag : tags)
+    {
+        if (tag.name == inName)
+        {
+            return tag.value;
+        }
+    }
+
+    return StringView();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark PgnParser
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PgnParser::PgnParser()
+{
+    _game.moves.reserve(ChessEngine::kMaxGamePly);
+}
+
+size_t
+PgnParser::parse(StringView inText, const GameCallback & inOnGame)
+{
+    const char * cursor = inText.begin();
+    const char * end    = inText.end();
+    size_t numGames     = 0;
+
+    // A byte order mark is allowed at the start of the text
+    if (inText.startsWith("\xEF\xBB\xBF"))
+    {
+        cursor += 3;
+    }
+
+    const char * begin = cursor;
+
+    while (true)
+    {
+        cursor = _skipSpace(cursor, begin, end);
+
+        if (!_parseGame(&cursor, end))
+        {
+            break;
+        }
+
+        // Stray text between the games
+        if (_game.tags.empty() && _game.moves.empty() && _game.result.isEmpty() &&
+            _game.isValid())
+        {
+            continue;
+        }
+
+        numGames++;
+
+        if (!inOnGame(_game))
+        {
+            break;
+        }
+    }
+
+    return numGames;
+}
+
+PackedMove
+PgnParser::parseSan(const ChessEngine & inPosition, StringView inSan)
+{
+    using attributes::ChessColor;
+    using attributes::ChessPieceName;
+
+    while (!inSan.isEmpty() && ((inSan.back() == '+') || (inSan.back() == '#') ||
+                                (inSan.back() == '!') || (inSan.back() == '?')))
+    {
+        inSan.size--;
+    }
+
+    MoveList moves;
+    inPosition.generateMoves(&moves);
+
+    bool isKingCastle  = (inSan == "O-O") || (inSan == "0-0");
+    bool isQueenCastle = (inSan == "O-O-O") || (inSan == "0-0-0");
+
+    if (isKingCastle || isQueenCastle)
+    {
+        uint8_t flags = isKingCastle ? PackedMove::kKingCastle : PackedMove::kQueenCastle;
+
+        for (auto move : moves)
+        {
+            if ((move.getFlags() == flags) && inPosition.isLegal(move))
+            {
+                return move;
+            }
+        }
+
+        return PackedMove();
+    }
+
+    ChessPieceName piece     = ChessPieceName::kPawn;
+    ChessPieceName promotion = ChessPieceName::kPawn;
+
+    if (!inSan.isEmpty() && _getPieceName(inSan.front(), &piece))
+    {
+        inSan = inSan.substr(1);
+    }
+
+    // Promotions are written e8=Q or e8Q
+    if ((inSan.size >= 3) && _getPieceName(inSan.back(), &promotion))
+    {
+        inSan.size -= (inSan[inSan.size - 2] == '=') ? 2 : 1;
+    }
+
+    if (inSan.size < 2)
+    {
+        return PackedMove();
+    }
+
+    char destCol = inSan[inSan.size - 2];
+    char destRow = inSan[inSan.size - 1];
+
+    if ((destCol < 'a') || (destCol > 'h') || (destRow < '1') || (destRow > '8'))
+    {
+        return PackedMove();
+    }
+
+    Square dest(static_cast<uint8_t>(destRow - '1'), static_cast<uint8_t>(destCol - 'a'));
+
+    // What is left is the disambiguation, and the capture sign which the move itself tells
+    int srcCol = -1;
+    int srcRow = -1;
+
+    for (size_t i = 0; i < inSan.size - 2; i++)
+    {
+        char curr = inSan[i];
+
+        if ((curr >= 'a') && (curr <= 'h'))
+        {
+            srcCol = curr - 'a';
+        }
+        else if ((curr >= '1') && (curr <= '8'))
+        {
+            srcRow = curr - '1';
+        }
+        else if ((curr != 'x') && (curr != ':') && (curr != '-'))
+        {
+            return PackedMove();
+        }
+    }
+
+    PackedMove found;
+
+    for (auto move : moves)
+    {
+        Square         src = move.getSrc();
+        ChessColor     color;
+        ChessPieceName movedPiece;
+
+        if ((move.getDest().index != dest.index) || move.isCastle() ||
+            ((srcCol >= 0) && (src.getCol() != srcCol)) ||
+            ((srcRow >= 0) && (src.getRow() != srcRow)))
+        {
+            continue;
+        }
+
+        if (!inPosition.getPieceAt(src, &color, &movedPiece) || (movedPiece != piece))
+        {
+            continue;
+        }
+
+        if (move.isPromotion() ? (move.getPromotion() != promotion)
+                               : (promotion != ChessPieceName::kPawn))
+        {
+            continue;
+        }
+
+        if (!inPosition.isLegal(move))
+        {
+            continue;
+        }
+
+        if (!found.isNull())
+        {
+            return PackedMove();
+        }
+
+        found = move;
+    }
+
+    return found;
+}
+
+std::vector<StringView>
+PgnParser::split(StringView inText, size_t inNumChunks)
+{
+    std::vector<StringView> chunks;
+
+    const char * begin      = inText.begin();
+    const char * end        = inText.end();
+    const char * chunkBegin = begin;
+    size_t       chunkSize  = std::max<size_t>(inText.size / std::max<size_t>(inNumChunks, 1), 1);
+
+    while (chunkBegin < end)
+    {
+        const char * chunkEnd = end;
+
+        if (static_cast<size_t>(end - chunkBegin) > chunkSize)
+        {
+            chunkEnd = _findGameStart(chunkBegin + chunkSize, begin, end);
+        }
+
+        chunks.push_back(StringView(chunkBegin, static_cast<size_t>(chunkEnd - chunkBegin)));
+        chunkBegin = chunkEnd;
+    }
+
+    return chunks;
+}
+
+size_t
+PgnParser::parseParallel(const std::vector<StringView> & inChunks, int inNumThreads,
+                         const ChunkCallback & inOnGame)
+{
+    std::atomic<size_t> nextChunk(0);
+    std::atomic<size_t> numGames(0);
+    std::atomic<bool>   isStopped(false);
+
+    auto work = [&] {
+        PgnParser parser;
+        size_t    chunk;
+
+        while (!isStopped && ((chunk = nextChunk++) < inChunks.size()))
+        {
+            parser.parse(inChunks[chunk], [&] (const PgnGame & inGame) {
+                if (isStopped)
+                {
+                    return false;
+                }
+
+                numGames++;
+
+                if (!inOnGame(chunk, inGame))
+                {
+                    isStopped = true;
+                    return false;
+                }
+
+                return true;
+            });
+        }
+    };
+
+    size_t numThreads = std::min(static_cast<size_t>(std::max(inNumThreads, 1)),
+                                 std::max<size_t>(inChunks.size(), 1));
+
+    // The calling thread is one of the workers
+    std::vector<std::thread> threads;
+
+    for (size_t i = 1; i < numThreads; i++)
+    {
+        threads.emplace_back(work);
+    }
+
+    work();
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    return numGames;
+}
+
+bool
+PgnParser::_parseGame(const char ** ioCursor, const char * inEnd)
+{
+    const char * cursor = *ioCursor;
+
+    if (cursor == inEnd)
+    {
+        return false;
+    }
+
+    _game.tags.clear();
+    _game.moves.clear();
+    _game.result = StringView();
+    _game.error  = StringView();
+
+    while ((cursor < inEnd) && (*cursor == '['))
+    {
+        _parseTag(&cursor, inEnd);
+        cursor = _skipSpace(cursor, *ioCursor, inEnd);
+    }
+
+    // Most games start from the initial position, which is copied rather than set up again
+    auto fen = _game.getTag("FEN");
+
+    _game.position = _startPosition;
+
+    if (!fen.isEmpty() && !_game.position.setFen(fen.toString()))
+    {
+        _game.error = fen;
+    }
+
+    _parseMoveText(&cursor, inEnd);
+
+    // Text that is neither tags nor moves is skipped, so that parsing always moves on
+    if (cursor == *ioCursor)
+    {
+        cursor++;
+    }
+
+    _game.text = StringView(*ioCursor, static_cast<size_t>(cursor - *ioCursor));
+    *ioCursor  = cursor;
+
+    return true;
+}
+
+void
+PgnParser::_parseTag(const char ** ioCursor, const char * inEnd)
+{
+    const char * cursor = *ioCursor + 1;
+    PgnTag       tag;
+
+    while ((cursor < inEnd) && _isSpace(*cursor))
+    {
+        cursor++;
+    }
+
+    const char * nameBegin = cursor;
+
+    while ((cursor < inEnd) && !_isSpace(*cursor) && (*cursor != '"') && (*cursor != ']'))
+    {
+        cursor++;
+    }
+
+    tag.name = StringView(nameBegin, static_cast<size_t>(cursor - nameBegin));
+
+    while ((cursor < inEnd) && (*cursor != '"') && (*cursor != ']') && (*cursor != '\n'))
+    {
+        cursor++;
+    }
+
+    if ((cursor < inEnd) && (*cursor == '"'))
+    {
+        const char * valueBegin = ++cursor;
+
+        // Quotes and backslashes in the value are escaped with a backslash
+        while ((cursor < inEnd) && (*cursor != '"') && (*cursor != '\n'))
+        {
+            cursor += ((*cursor == '\\') && (cursor + 1 < inEnd)) ? 2 : 1;
+        }
+
+        tag.value = StringView(valueBegin, static_cast<size_t>(cursor - valueBegin));
+    }
+
+    cursor = _skipToLineEnd(cursor, inEnd);
+
+    if (!tag.name.isEmpty())
+    {
+        _game.tags.push_back(tag);
+    }
+
+    *ioCursor = cursor;
+}
+
+void
+PgnParser::_parseMoveText(const char ** ioCursor, const char * inEnd)
+{
+    const char * begin  = *ioCursor;
+    const char * cursor = begin;
+
+    while (true)
+    {
+        cursor = _skipSpace(cursor, begin, inEnd);
+
+        if (cursor == inEnd)
+        {
+            break;
+        }
+
+        char curr = *cursor;
+
+        if (curr == '[')
+        {
+            // The tags of the next game, this one has no result
+            break;
+        }
+
+        if (curr == '{')
+        {
+            cursor = _skipComment(cursor, inEnd);
+            continue;
+        }
+
+        if (curr == ';')
+        {
+            cursor = _skipToLineEnd(cursor, inEnd);
+            continue;
+        }
+
+        if (curr == '(')
+        {
+            cursor = _skipVariation(cursor, inEnd);
+            continue;
+        }
+
+        if ((curr == '$') || (curr == ')') || (curr == '}') || (curr == ']'))
+        {
+            // Annotation glyphs, and stray closing brackets
+            do
+            {
+                cursor++;
+            }
+            while ((cursor < inEnd) && _isDigit(*cursor));
+
+            continue;
+        }
+
+        const char * tokenBegin = cursor;
+
+        while ((cursor < inEnd) && !_isDelimiter(*cursor))
+        {
+            cursor++;
+        }
+
+        StringView token(tokenBegin, static_cast<size_t>(cursor - tokenBegin));
+        StringView result = _getResult(token);
+
+        if (!result.isEmpty())
+        {
+            _game.result = result;
+            break;
+        }
+
+        // Move numbers, which may be written right before the move, e.g. 1.e4 or 12...Nf6
+        if (_isDigit(token.front()) && !token.startsWith("0-0"))
+        {
+            size_t numEnd = 0;
+
+            while ((numEnd < token.size) && _isDigit(token[numEnd]))
+            {
+                numEnd++;
+            }
+
+            while ((numEnd < token.size) && (token[numEnd] == '.'))
+            {
+                numEnd++;
+            }
+
+            token = token.substr(numEnd);
+        }
+
+        // Annotations written apart from the move
+        if (token.isEmpty() || (token.front() == '!') || (token.front() == '?'))
+        {
+            continue;
+        }
+
+        // The rest of a game is skipped once one of its moves could not be resolved
+        if (!_game.isValid())
+        {
+            continue;
+        }
+
+        auto move = parseSan(_game.position, token);
+
+        if (move.isNull())
+        {
+            _game.error = token;
+            continue;
+        }
+
+        _game.position.makeMove(move);
+        _game.moves.push_back(move);
+    }
+
+    *ioCursor = cursor;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark PgnReader
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+PgnReader::open(const std::string & inPath)
+{
+    return _file.open(inPath);
+}
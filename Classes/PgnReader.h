@@ -0,0 +1,204 @@
+/***************************************************************************************************
+ *
+ *  @file       PgnReader.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Reading of games in the Portable Game Notation
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "MappedFile.h"
+#include "StringView.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @class          PgnTag
+
+     @brief          A tag pair of a game, with the value still escaped as in the text
+     */
+    struct PgnTag
+    {
+        StringView                  name;
+        StringView                  value;
+    };
+
+    /**
+     @class          PgnGame
+
+     @brief          A game as parsed, viewing the text it was parsed from
+
+     @discussion     Only valid during the callback it is passed to, after which it is reused for
+     the next game.
+     */
+    struct PgnGame
+    {
+        std::vector<PgnTag>         tags;
+
+        /**
+         @brief         Moves of the game, up to the first one that could not be resolved
+         */
+        std::vector<PackedMove>     moves;
+
+        /**
+         @brief         Position after the moves, with the moves made so that they can be unmade
+         */
+        ChessEngine                 position;
+
+        /**
+         @brief         1-0, 0-1, 1/2-1/2 or *, empty if the game has no result
+         */
+        StringView                  result;
+
+        /**
+         @brief         The game as in the text, from its first tag to its result
+         */
+        StringView                  text;
+
+        /**
+         @brief         The move or FEN that could not be resolved, empty if the game is valid
+         */
+        StringView                  error;
+
+        bool                        isValid() const { return error.isEmpty(); }
+
+        /**
+         @brief         Value of a tag, empty if the game does not have it
+         */
+        StringView                  getTag(StringView inName) const;
+    };
+
+    /**
+     @class          PgnParser
+
+     @brief          Parses games out of text, without copying it
+
+     @discussion     Tags and tokens are views of the text. Every move is resolved against the
+     legal moves of the position and made, so that the game carries its positions. Comments,
+     variations, annotation glyphs and move numbers are skipped. A game whose move cannot be
+     resolved is still delivered, with the moves before it and the token as its error.
+
+     The game and its vectors are reused, so that parsing allocates nothing per game once they
+     have grown, apart from the rare games starting from a FEN.
+     */
+    class PgnParser
+    {
+    public:
+        /**
+         @return        false to stop parsing
+         */
+        using GameCallback = std::function<bool(const PgnGame &)>;
+
+        /**
+         @param     inChunk         index of the chunk the game is in
+
+         @return        false to stop parsing
+         */
+        using ChunkCallback = std::function<bool(size_t inChunk, const PgnGame &)>;
+
+        PgnParser();
+
+        /**
+         @brief         Parse every game of a text
+
+         @return        number of games delivered
+         */
+        size_t                      parse(StringView inText, const GameCallback & inOnGame);
+
+        /**
+         @brief         Legal move of a position in standard algebraic notation
+
+         @discussion    Check and annotation suffixes are ignored, castling may be written with
+         zeros and promotions with or without the equals sign.
+
+         @return        null if the move is not legal, or is ambiguous
+         */
+        static PackedMove           parseSan(const ChessEngine & inPosition, StringView inSan);
+
+        /**
+         @brief         Split a text at the starts of games into chunks of about the same size
+
+         @discussion    A game starts with a tag that does not follow another tag. The chunks are
+         in the order of the text, and together are the whole of it.
+
+         @return        at most inNumChunks chunks, fewer if the text has fewer games
+         */
+        static std::vector<StringView> split(StringView inText, size_t inNumChunks);
+
+        /**
+         @brief         Parse chunks on worker threads, each with a parser of its own
+
+         @discussion    Chunks are handed out in order to the next free thread, so that a few
+         large games do not hold up the others. The callback is called from the worker threads
+         concurrently, but the games of a chunk are delivered in order by one thread, so that
+         results kept per chunk can be merged in the order of the text afterwards.
+
+         @return        number of games delivered
+         */
+        static size_t               parseParallel(const std::vector<StringView> & inChunks,
+                                                  int inNumThreads,
+                                                  const ChunkCallback & inOnGame);
+
+    private:
+        /**
+         @brief         Parse the game at the cursor, which is past its last character after
+
+         @return        false if there was no game left
+         */
+        bool                        _parseGame(const char ** ioCursor, const char * inEnd);
+
+        void                        _parseTag(const char ** ioCursor, const char * inEnd);
+
+        void                        _parseMoveText(const char ** ioCursor, const char * inEnd);
+
+        PgnGame                     _game;
+        ChessEngine                 _startPosition;
+    };
+
+    /**
+     @class          PgnReader
+
+     @brief          Parses the games of a PGN file, mapped into memory
+
+     @discussion     The file is read front to back, letting the system read ahead, and the games
+     view its pages directly.
+     */
+    class PgnReader
+    {
+    public:
+        bool                        open(const std::string & inPath);
+
+        void                        close() { _file.close(); }
+
+        bool                        isOpen() const { return _file.isOpen(); }
+
+        /**
+         @brief         The whole text of the file
+         */
+        StringView                  getText() const
+        {
+            return StringView(reinterpret_cast<const char *>(_file.getData()), _file.getSize());
+        }
+
+        /**
+         @brief         Parse every game of the file
+
+         @return        number of games delivered
+         */
+        size_t                      read(const PgnParser::GameCallback & inOnGame)
+        { return _parser.parse(getText(), inOnGame); }
+
+    private:
+        MappedFile                  _file;
+        PgnParser                   _parser;
+    };
+}
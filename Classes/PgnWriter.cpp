@@ -0,0 +1,193 @@
+/***************************************************************************************************
+ *
+ *  @file       PgnWriter.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Writing of games in the Portable Game Notation
+ *
+ **************************************************************************************************/
+
+#include "PgnWriter.h"
+
+using namespace chessEngine;
+
+static constexpr size_t     kMaxLineLength = 79;
+
+static char
+_getPieceLetter(attributes::ChessPieceName inPiece)
+{
+    static const char kLetters[] = { 'P', 'N', 'B', 'R', 'Q', 'K' };
+
+    return kLetters[static_cast<int>(inPiece)];
+}
+
+static void
+_appendSquare(std::string * outString, Square inSq)
+{
+    *outString += static_cast<char>('a' + inSq.getCol());
+    *outString += static_cast<char>('1' + inSq.getRow());
+}
+
+/**
+ @brief         Append a token to the movetext, wrapping the line if it would get too long
+ */
+static void
+_appendToken(std::ostream & inOut, const std::string & inToken, size_t * inOutLineLength)
+{
+    if (*inOutLineLength + 1 + inToken.size() > kMaxLineLength)
+    {
+        inOut << '\n';
+        *inOutLineLength = 0;
+    }
+    else if (*inOutLineLength > 0)
+    {
+        inOut << ' ';
+        (*inOutLineLength)++;
+    }
+
+    inOut << inToken;
+    *inOutLineLength += inToken.size();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark PgnWriter
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string
+PgnWriter::toSan(ChessEngine * inOutPosition, PackedMove inMove)
+{
+    using attributes::ChessColor;
+    using attributes::ChessPieceName;
+
+    std::string san;
+
+    if (inMove.isCastle())
+    {
+        san = (inMove.getFlags() == PackedMove::kKingCastle) ? "O-O" : "O-O-O";
+    }
+    else
+    {
+        ChessColor     color;
+        ChessPieceName piece;
+
+        inOutPosition->getPieceAt(inMove.getSrc(), &color, &piece);
+
+        auto src  = inMove.getSrc();
+        auto dest = inMove.getDest();
+
+        if (piece == ChessPieceName::kPawn)
+        {
+            if (inMove.isCapture())
+            {
+                san += static_cast<char>('a' + src.getCol());
+            }
+        }
+        else
+        {
+            san += _getPieceLetter(piece);
+
+            // Other pieces of the same kind that can move to the same square
+            MoveList moves;
+            bool     isAmbiguous = false;
+            bool     isSameCol   = false;
+            bool     isSameRow   = false;
+
+            inOutPosition->generateLegalMoves(&moves);
+
+            for (auto move : moves)
+            {
+                ChessPieceName otherPiece;
+
+                if ((move.getDest().index != dest.index) || (move.getSrc().index == src.index) ||
+                    !inOutPosition->getPieceAt(move.getSrc(), &color, &otherPiece) ||
+                    (otherPiece != piece))
+                {
+                    continue;
+                }
+
+                isAmbiguous = true;
+                isSameCol   = isSameCol || (move.getSrc().getCol() == src.getCol());
+                isSameRow   = isSameRow || (move.getSrc().getRow() == src.getRow());
+            }
+
+            if (isAmbiguous && (!isSameCol || isSameRow))
+            {
+                san += static_cast<char>('a' + src.getCol());
+            }
+
+            if (isSameCol)
+            {
+                san += static_cast<char>('1' + src.getRow());
+            }
+        }
+
+        if (inMove.isCapture())
+        {
+            san += 'x';
+        }
+
+        _appendSquare(&san, dest);
+
+        if (inMove.isPromotion())
+        {
+            san += '=';
+            san += _getPieceLetter(inMove.getPromotion());
+        }
+    }
+
+    inOutPosition->makeMove(inMove);
+
+    if (inOutPosition->isInCheck())
+    {
+        MoveList replies;
+        inOutPosition->generateLegalMoves(&replies);
+
+        san += replies.isEmpty() ? '#' : '+';
+    }
+
+    inOutPosition->unmakeMove();
+
+    return san;
+}
+
+void
+PgnWriter::write(std::ostream & inOut, const PgnGame & inGame)
+{
+    using attributes::ChessColor;
+
+    ChessEngine position = inGame.position;
+
+    for (size_t i = 0; i < inGame.moves.size(); i++)
+    {
+        position.unmakeMove();
+    }
+
+    for (auto & tag : inGame.tags)
+    {
+        inOut << '[' << tag.name.toString() << " \"" << tag.value.toString() << "\"]\n";
+    }
+
+    inOut << '\n';
+
+    size_t lineLength = 0;
+
+    for (size_t i = 0; i < inGame.moves.size(); i++)
+    {
+        bool isWhite = (position.getCurrMove() == ChessColor::kWhite);
+
+        if (isWhite || (i == 0))
+        {
+            _appendToken(inOut, std::to_string(position.getFullMoveNumber()) +
+                         (isWhite ? "." : "..."), &lineLength);
+        }
+
+        _appendToken(inOut, toSan(&position, inGame.moves[i]), &lineLength);
+        position.makeMove(inGame.moves[i]);
+    }
+
+    _appendToken(inOut, inGame.result.isEmpty() ? "*" : inGame.result.toString(), &lineLength);
+    inOut << "\n\n";
+}
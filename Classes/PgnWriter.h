@@ -0,0 +1,46 @@
+/***************************************************************************************************
+ *
+ *  @file       PgnWriter.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Writing of games in the Portable Game Notation
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "PgnReader.h"
+
+#include <ostream>
+#include <string>
+
+namespace chessEngine
+{
+    /**
+     @class          PgnWriter
+
+     @brief          Writes games as PgnParser reads them
+     */
+    class PgnWriter
+    {
+    public:
+        /**
+         @brief         Move in standard algebraic notation, e.g. Nbd7, exd6 or e8=Q+
+
+         @param     inOutPosition   position the move is legal in, which the move is made in and
+         unmade again to find check and mate
+         */
+        static std::string          toSan(ChessEngine * inOutPosition, PackedMove inMove);
+
+        /**
+         @brief         Write a game, with its tags as they are, its moves and its result
+
+         @discussion    The moves are replayed from the position before them, so the game has to
+         carry its moves made as PgnParser leaves them. Lines are wrapped before 80 characters.
+         */
+        static void                 write(std::ostream & inOut, const PgnGame & inGame);
+    };
+}
@@ -0,0 +1,680 @@
+/***************************************************************************************************
+ *
+ *  @file       PositionIndex.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Index of the positions of a game database
+ *
+ **************************************************************************************************/
+
+#include "PositionIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+using namespace chessEngine;
+
+static constexpr size_t     kRunRecordSize   = 17;
+static constexpr size_t     kBlockEntrySize  = 16;
+static constexpr size_t     kGamesPerBatch   = 256;
+static constexpr size_t     kMinRunPostings  = 4096;
+static constexpr size_t     kCopyBufferSize  = 1 << 16;
+
+struct SortPosting
+{
+    ZobristKey                  key;
+    uint32_t                    game;
+    uint16_t                    ply;
+    uint16_t                    move;
+    uint8_t                     result;
+
+    bool                        operator< (const SortPosting & inOther) const
+    {
+        if (key != inOther.key)
+        {
+            return key < inOther.key;
+        }
+
+        return (game != inOther.game) ? (game < inOther.game) : (ply < inOther.ply);
+    }
+};
+
+static inline uint64_t
+_readLittleEndian(const uint8_t * inData, int inNumBytes)
+{
+    uint64_t value = 0;
+
+    for (auto i = inNumBytes - 1; i >= 0; i--)
+    {
+        value = (value << 8) | inData[i];
+    }
+
+    return value;
+}
+
+static inline void
+_writeLittleEndian(uint64_t inValue, int inNumBytes, uint8_t * outData)
+{
+    for (auto i = 0; i < inNumBytes; i++)
+    {
+        outData[i] = static_cast<uint8_t>(inValue);
+        inValue  >>= 8;
+    }
+}
+
+static void
+_appendVarint(uint64_t inValue, std::vector<uint8_t> * outData)
+{
+    while (inValue >= 0x80)
+    {
+        outData->push_back(static_cast<uint8_t>(inValue | 0x80));
+        inValue >>= 7;
+    }
+
+    outData->push_back(static_cast<uint8_t>(inValue));
+}
+
+/**
+ @return        false if the value does not end before inEnd
+ */
+static bool
+_readVarint(const uint8_t ** ioCursor, const uint8_t * inEnd, uint64_t * outValue)
+{
+    uint64_t value = 0;
+
+    for (int shift = 0; (*ioCursor < inEnd) && (shift < 64); shift += 7)
+    {
+        uint8_t byte = *(*ioCursor)++;
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            *outValue = value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ @brief         Add the postings of every position of a game
+
+ @param     inOutPosition   position the game is unmade on, so that it is reused between games
+ */
+static void
+_addPostings(uint32_t inGameIndex, const PgnGame & inGame, ChessEngine * inOutPosition,
+             std::vector<SortPosting> * outPostings)
+{
+    auto result = static_cast<uint8_t>(GameDatabase::getResult(inGame.result));
+    auto ply    = static_cast<uint16_t>(inGame.moves.size());
+
+    // The moves are unmade from the last position, which is cheaper than making them again
+    *inOutPosition = inGame.position;
+
+    outPostings->push_back({ inOutPosition->getHashKey(), inGameIndex, ply, 0, result });
+
+    while (ply > 0)
+    {
+        ply--;
+        inOutPosition->unmakeMove();
+
+        outPostings->push_back({ inOutPosition->getHashKey(), inGameIndex, ply,
+                                 inGame.moves[ply].data, result });
+    }
+}
+
+static bool
+_writeRun(const std::string & inPath, const std::vector<SortPosting> & inPostings)
+{
+    FILE * file = fopen(inPath.c_str(), "wb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> data(inPostings.size() * kRunRecordSize);
+    uint8_t *            record = data.data();
+
+    for (auto & posting : inPostings)
+    {
+        _writeLittleEndian(posting.key, 8, record);
+        _writeLittleEndian(posting.game, 4, record + 8);
+        _writeLittleEndian(posting.ply, 2, record + 12);
+        _writeLittleEndian(posting.move, 2, record + 14);
+        record[16] = posting.result;
+        record    += kRunRecordSize;
+    }
+
+    bool isWritten = (fwrite(data.data(), 1, data.size(), file) == data.size());
+
+    return (fclose(file) == 0) && isWritten;
+}
+
+static SortPosting
+_readRunRecord(const uint8_t * inRecord)
+{
+    SortPosting posting;
+
+    posting.key    = _readLittleEndian(inRecord, 8);
+    posting.game   = static_cast<uint32_t>(_readLittleEndian(inRecord + 8, 4));
+    posting.ply    = static_cast<uint16_t>(_readLittleEndian(inRecord + 12, 2));
+    posting.move   = static_cast<uint16_t>(_readLittleEndian(inRecord + 14, 2));
+    posting.result = inRecord[16];
+
+    return posting;
+}
+
+/**
+ @brief         Compress a block of postings
+ */
+static void
+_encodeBlock(const std::vector<SortPosting> & inPostings, std::vector<uint8_t> * outData)
+{
+    outData->clear();
+    outData->push_back(static_cast<uint8_t>(inPostings.size()));
+
+    uint8_t key[8];
+    _writeLittleEndian(inPostings[0].key, 8, key);
+    outData->insert(outData->end(), key, key + 8);
+
+    for (size_t i = 0; i < inPostings.size(); i++)
+    {
+        auto & posting = inPostings[i];
+
+        if (i > 0)
+        {
+            auto & prev = inPostings[i - 1];
+
+            _appendVarint(posting.key - prev.key, outData);
+
+            // Games of the same key are sorted, so only the difference is stored
+            _appendVarint((posting.key == prev.key) ? posting.game - prev.game : posting.game,
+                          outData);
+        }
+        else
+        {
+            _appendVarint(posting.game, outData);
+        }
+
+        _appendVarint(posting.ply, outData);
+        outData->push_back(static_cast<uint8_t>(posting.move));
+        outData->push_back(static_cast<uint8_t>(posting.move >> 8));
+        outData->push_back(posting.result);
+    }
+}
+
+/**
+ @brief         Merge sorted runs into the blocks of an index, with their index in another file
+
+ @return        number of postings written, or -1 if a file could not be read or written
+ */
+static int64_t
+_mergeRuns(const std::vector<std::string> & inRunPaths, FILE * inOutFile, FILE * inBlockFile,
+           uint64_t * inOutOffset)
+{
+    using Cursor = std::pair<SortPosting, size_t>;
+
+    auto isAfter = [] (const Cursor & inA, const Cursor & inB) { return inB.first < inA.first; };
+
+    std::vector<MappedFile> runs(inRunPaths.size());
+    std::vector<size_t>     positions(inRunPaths.size(), 0);
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(isAfter)> heap(isAfter);
+
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        if (!runs[i].open(inRunPaths[i]) || ((runs[i].getSize() % kRunRecordSize) != 0))
+        {
+            return -1;
+        }
+
+        heap.push(Cursor(_readRunRecord(runs[i].getData()), i));
+    }
+
+    std::vector<SortPosting> block;
+    std::vector<uint8_t>     data;
+    int64_t                  numPostings = 0;
+    bool                     isWritten   = true;
+
+    auto flushBlock = [&] {
+        uint8_t entry[kBlockEntrySize];
+
+        _encodeBlock(block, &data);
+        _writeLittleEndian(block[0].key, 8, entry);
+        _writeLittleEndian(*inOutOffset, 8, entry + 8);
+
+        isWritten = isWritten && (fwrite(entry, 1, sizeof(entry), inBlockFile) == sizeof(entry));
+        isWritten = isWritten && (fwrite(data.data(), 1, data.size(), inOutFile) == data.size());
+
+        *inOutOffset += data.size();
+        block.clear();
+    };
+
+    while (!heap.empty() && isWritten)
+    {
+        auto cursor = heap.top();
+        auto run    = cursor.second;
+
+        heap.pop();
+        block.push_back(cursor.first);
+        numPostings++;
+
+        if (block.size() == PositionIndex::kPostingsPerBlock)
+        {
+            flushBlock();
+        }
+
+        positions[run] += kRunRecordSize;
+
+        if (positions[run] < runs[run].getSize())
+        {
+            heap.push(Cursor(_readRunRecord(runs[run].getData() + positions[run]), run));
+        }
+    }
+
+    if (!block.empty())
+    {
+        flushBlock();
+    }
+
+    return isWritten ? numPostings : -1;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark PositionIndex
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+PositionIndex::PositionIndex() :
+_file(), _numPostings(0), _numBlocks(0), _blockIndex(nullptr)
+{ }
+
+bool
+PositionIndex::open(const std::string & inPath)
+{
+    close();
+
+    // Lookups jump around the file, read ahead would only waste the page cache
+    if (!_file.open(inPath, true))
+    {
+        return false;
+    }
+
+    auto data = _file.getData();
+    auto size = _file.getSize();
+
+    if ((size < kHeaderSize) || (_readLittleEndian(data, 4) != kMagic) ||
+        (_readLittleEndian(data + 4, 4) != kVersion))
+    {
+        close();
+        return false;
+    }
+
+    uint64_t numPostings = _readLittleEndian(data + 8, 8);
+    uint64_t numBlocks   = _readLittleEndian(data + 16, 8);
+    uint64_t indexOffset = _readLittleEndian(data + 24, 8);
+
+    if ((indexOffset < kHeaderSize) || (indexOffset > size) ||
+        (numBlocks != (size - indexOffset) / kBlockEntrySize))
+    {
+        close();
+        return false;
+    }
+
+    _numPostings = numPostings;
+    _numBlocks   = static_cast<size_t>(numBlocks);
+    _blockIndex  = data + indexOffset;
+
+    return true;
+}
+
+void
+PositionIndex::close()
+{
+    _file.close();
+    _numPostings = 0;
+    _numBlocks   = 0;
+    _blockIndex  = nullptr;
+}
+
+size_t
+PositionIndex::find(ZobristKey inKey, std::vector<PositionPosting> * outPostings) const
+{
+    outPostings->clear();
+
+    auto onPosting = [&] (ZobristKey inPostingKey, const PositionPosting & inPosting) {
+        if (inPostingKey == inKey)
+        {
+            outPostings->push_back(inPosting);
+        }
+
+        return inPostingKey <= inKey;
+    };
+
+    for (size_t block = _findBlock(inKey); block < _numBlocks; block++)
+    {
+        if ((_readLittleEndian(_blockIndex + (block * kBlockEntrySize), 8) > inKey) ||
+            !_decodeBlock(block, onPosting))
+        {
+            break;
+        }
+    }
+
+    return outPostings->size();
+}
+
+bool
+PositionIndex::scan(const PostingCallback & inOnPosting) const
+{
+    for (size_t block = 0; block < _numBlocks; block++)
+    {
+        if (!_decodeBlock(block, inOnPosting))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t
+PositionIndex::getMoveStats(const ChessEngine & inPosition,
+                            std::vector<PositionMoveStats> * outStats) const
+{
+    std::vector<PositionPosting> postings;
+    std::vector<PackedMove>      gameMoves;
+    MoveList                     legalMoves;
+    size_t                       numGames = 0;
+    bool                         hasGame  = false;
+    uint32_t                     game     = 0;
+
+    outStats->clear();
+    find(inPosition.getHashKey(), &postings);
+    inPosition.generateLegalMoves(&legalMoves);
+
+    for (auto & posting : postings)
+    {
+        // Games ending in the position count for it, but not for any of its moves
+        if (!posting.move.isNull() && !legalMoves.contains(posting.move))
+        {
+            continue;
+        }
+
+        // A game repeating the position counts once, and once for every move it played there
+        if (!hasGame || (posting.game != game))
+        {
+            hasGame = true;
+            game    = posting.game;
+            numGames++;
+            gameMoves.clear();
+        }
+
+        if (posting.move.isNull() ||
+            (std::find(gameMoves.begin(), gameMoves.end(), posting.move) != gameMoves.end()))
+        {
+            continue;
+        }
+
+        gameMoves.push_back(posting.move);
+
+        auto stats = std::find_if(outStats->begin(), outStats->end(),
+                                  [&] (const PositionMoveStats & inStats) {
+            return inStats.move == posting.move;
+        });
+
+        if (stats == outStats->end())
+        {
+            outStats->push_back({ posting.move, 0, 0, 0, 0 });
+            stats = outStats->end() - 1;
+        }
+
+        stats->numGames++;
+        stats->numWhiteWins += (posting.result == GameResult::kWhiteWins) ? 1 : 0;
+        stats->numDraws     += (posting.result == GameResult::kDraw) ? 1 : 0;
+        stats->numBlackWins += (posting.result == GameResult::kBlackWins) ? 1 : 0;
+    }
+
+    std::stable_sort(outStats->begin(), outStats->end(),
+                     [] (const PositionMoveStats & inA, const PositionMoveStats & inB) {
+        return inA.numGames > inB.numGames;
+    });
+
+    return numGames;
+}
+
+bool
+PositionIndex::build(const GameDatabase & inDatabase, const std::string & inPath,
+                     int inNumThreads, size_t inMemoryMb)
+{
+    size_t numGames   = inDatabase.getNumGames();
+    size_t numThreads = static_cast<size_t>(std::max(inNumThreads, 1));
+    size_t runSize    = std::max((std::max<size_t>(inMemoryMb, 1) << 20) / numThreads /
+                                 sizeof(SortPosting), kMinRunPostings);
+
+    if (numGames > UINT32_MAX)
+    {
+        return false;
+    }
+
+    std::atomic<size_t>      nextGame(0);
+    std::atomic<bool>        isFailed(false);
+    std::mutex               runMutex;
+    std::vector<std::string> runPaths;
+
+    auto writeRun = [&] (std::vector<SortPosting> * inOutPostings) {
+        std::string path;
+
+        {
+            std::lock_guard<std::mutex> lock(runMutex);
+
+            path = inPath + ".run" + std::to_string(runPaths.size());
+            runPaths.push_back(path);
+        }
+
+        std::sort(inOutPostings->begin(), inOutPostings->end());
+
+        if (!_writeRun(path, *inOutPostings))
+        {
+            isFailed = true;
+        }
+
+        inOutPostings->clear();
+    };
+
+    auto work = [&] {
+        std::vector<SortPosting> postings;
+        PgnGame                  game;
+        ChessEngine              position;
+
+        postings.reserve(runSize + ChessEngine::kMaxGamePly);
+
+        while (!isFailed)
+        {
+            size_t first = nextGame.fetch_add(kGamesPerBatch);
+
+            for (size_t i = first; (i < std::min(first + kGamesPerBatch, numGames)) && !isFailed;
+                 i++)
+            {
+                if (!inDatabase.readGame(i, &game))
+                {
+                    isFailed = true;
+                    break;
+                }
+
+                _addPostings(static_cast<uint32_t>(i), game, &position, &postings);
+
+                if (postings.size() >= runSize)
+                {
+                    writeRun(&postings);
+                }
+            }
+
+            if (first + kGamesPerBatch >= numGames)
+            {
+                break;
+            }
+        }
+
+        if (!postings.empty())
+        {
+            writeRun(&postings);
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (size_t i = 1; i < numThreads; i++)
+    {
+        threads.emplace_back(work);
+    }
+
+    work();
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    // The blocks are written after the header, their index to a file of its own and appended
+    std::string blockPath = inPath + ".blocks";
+    FILE *      file      = isFailed ? nullptr : fopen(inPath.c_str(), "wb");
+    FILE *      blockFile = (file == nullptr) ? nullptr : fopen(blockPath.c_str(), "w+b");
+    bool        isWritten = (blockFile != nullptr);
+    uint8_t     header[kHeaderSize] = { };
+    uint64_t    offset      = kHeaderSize;
+    int64_t     numPostings = -1;
+
+    if (isWritten)
+    {
+        isWritten   = (fwrite(header, 1, sizeof(header), file) == sizeof(header));
+        numPostings = isWritten ? _mergeRuns(runPaths, file, blockFile, &offset) : -1;
+        isWritten   = (numPostings >= 0);
+    }
+
+    uint64_t numBlocks = 0;
+
+    if (isWritten)
+    {
+        std::vector<uint8_t> buffer(kCopyBufferSize);
+        size_t               size;
+
+        rewind(blockFile);
+
+        while ((size = fread(buffer.data(), 1, buffer.size(), blockFile)) > 0)
+        {
+            isWritten  = isWritten && (fwrite(buffer.data(), 1, size, file) == size);
+            numBlocks += size / kBlockEntrySize;
+        }
+
+        _writeLittleEndian(kMagic, 4, header);
+        _writeLittleEndian(kVersion, 4, header + 4);
+        _writeLittleEndian(static_cast<uint64_t>(numPostings), 8, header + 8);
+        _writeLittleEndian(numBlocks, 8, header + 16);
+        _writeLittleEndian(offset, 8, header + 24);
+
+        isWritten = isWritten && (fseek(file, 0, SEEK_SET) == 0) &&
+                    (fwrite(header, 1, sizeof(header), file) == sizeof(header));
+    }
+
+    if (blockFile != nullptr)
+    {
+        fclose(blockFile);
+        remove(blockPath.c_str());
+    }
+
+    if (file != nullptr)
+    {
+        isWritten = (fclose(file) == 0) && isWritten;
+    }
+
+    for (auto & path : runPaths)
+    {
+        remove(path.c_str());
+    }
+
+    return isWritten;
+}
+
+bool
+PositionIndex::_decodeBlock(size_t inBlock, const PostingCallback & inOnPosting) const
+{
+    auto offset = _readLittleEndian(_blockIndex + (inBlock * kBlockEntrySize) + 8, 8);
+    auto end    = _blockIndex;
+
+    if ((offset < kHeaderSize) || (offset + 9 > static_cast<uint64_t>(end - _file.getData())))
+    {
+        return false;
+    }
+
+    auto     cursor      = _file.getData() + offset;
+    size_t   numPostings = *cursor;
+    auto     key         = _readLittleEndian(cursor + 1, 8);
+    uint64_t game        = 0;
+
+    cursor += 9;
+
+    for (size_t i = 0; i < numPostings; i++)
+    {
+        uint64_t keyDelta = 0;
+        uint64_t gameCode = 0;
+        uint64_t ply      = 0;
+
+        if (((i > 0) && !_readVarint(&cursor, end, &keyDelta)) ||
+            !_readVarint(&cursor, end, &gameCode) || !_readVarint(&cursor, end, &ply) ||
+            (end - cursor < 3))
+        {
+            return false;
+        }
+
+        game  = ((i > 0) && (keyDelta == 0)) ? game + gameCode : gameCode;
+        key  += keyDelta;
+
+        PositionPosting posting;
+        posting.game      = static_cast<uint32_t>(game);
+        posting.ply       = static_cast<uint16_t>(ply);
+        posting.move.data = static_cast<uint16_t>(cursor[0] | (cursor[1] << 8));
+        posting.result    = static_cast<GameResult>(cursor[2]);
+        cursor           += 3;
+
+        if (!inOnPosting(key, posting))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t
+PositionIndex::_findBlock(ZobristKey inKey) const
+{
+    // The first block with a key not below the one looked for
+    size_t low  = 0;
+    size_t high = _numBlocks;
+
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+
+        if (_readLittleEndian(_blockIndex + (mid * kBlockEntrySize), 8) < inKey)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    // Postings of the key may start at the end of the block before
+    return (low > 0) ? low - 1 : 0;
+}
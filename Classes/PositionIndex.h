@@ -0,0 +1,161 @@
+/***************************************************************************************************
+ *
+ *  @file       PositionIndex.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Index of the positions of a game database
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "GameDatabase.h"
+#include "MappedFile.h"
+#include "Zobrist.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @class          PositionPosting
+
+     @brief          A game reaching a position, and what was played from it
+     */
+    struct PositionPosting
+    {
+        uint32_t                    game;
+        uint16_t                    ply;
+
+        /**
+         @brief         Move played in the position, null if the game ended in it
+         */
+        PackedMove                  move;
+        GameResult                  result;
+    };
+
+    /**
+     @class          PositionMoveStats
+
+     @brief          How often a move was played in a position, and how the games ended
+     */
+    struct PositionMoveStats
+    {
+        PackedMove                  move;
+        uint32_t                    numGames;
+        uint32_t                    numWhiteWins;
+        uint32_t                    numDraws;
+        uint32_t                    numBlackWins;
+    };
+
+    /**
+     @class          PositionIndex
+
+     @brief          Games of a database by the positions they reach
+
+     @discussion     The file holds a posting for every position of every game, sorted by the
+     position key, then by game and ply. The postings are compressed in blocks of up to
+     kPostingsPerBlock: the first key of a block is stored whole, the keys after it as the
+     difference to the one before, and the numbers as variable length integers. An index of the
+     first key and offset of every block follows the blocks, so that a lookup is a binary search
+     over the index and the decoding of the few blocks holding the key.
+
+     The key is ChessEngine::getHashKey(), so postings of a key collision may be found along with
+     those of a position. getMoveStats() leaves out moves that are not legal in the position.
+
+     The index is built from a database with an external sort: every thread collects postings up
+     to its share of the memory, and writes them sorted to a run file next to the index. The runs
+     are then merged into the index and removed. The result does not depend on the number of
+     threads.
+     */
+    class PositionIndex
+    {
+    public:
+        static constexpr uint32_t   kMagic            = 0x58495043;   // CPIX
+        static constexpr uint32_t   kVersion          = 1;
+        static constexpr size_t     kHeaderSize       = 32;
+        static constexpr size_t     kPostingsPerBlock = 128;
+
+        /**
+         @return        false to stop
+         */
+        using PostingCallback = std::function<bool(ZobristKey inKey, const PositionPosting &)>;
+
+        PositionIndex();
+
+        /**
+         @brief         Map an index file, closing the one mapped before
+
+         @return        false if the file could not be mapped, or its header is not valid
+         */
+        bool                        open(const std::string & inPath);
+
+        void                        close();
+
+        bool                        isOpen() const { return _file.isOpen(); }
+
+        uint64_t                    getNumPostings() const { return _numPostings; }
+
+        /**
+         @brief         Find the games reaching a position
+
+         @param     outPostings     filled with the postings, in the order of the games
+
+         @return        number of postings found
+         */
+        size_t                      find(ZobristKey inKey,
+                                         std::vector<PositionPosting> * outPostings) const;
+
+        /**
+         @brief         Moves played in a position, the most played first
+
+         @param     outStats        filled with a statistic for every move
+
+         @return        number of games reaching the position, a game repeating it counted
+         once, as it is for every move it played there
+         */
+        size_t                      getMoveStats(const ChessEngine & inPosition,
+                                                 std::vector<PositionMoveStats> * outStats) const;
+
+        /**
+         @brief         Go through every posting, in the order of the keys
+
+         @return        false if stopped, or the file is damaged
+         */
+        bool                        scan(const PostingCallback & inOnPosting) const;
+
+        /**
+         @brief         Build the index of a database
+
+         @param     inNumThreads    threads reading the games and sorting the postings
+         @param     inMemoryMb      memory all the threads together keep postings in
+
+         @return        false if the database is damaged or a file could not be written
+         */
+        static bool                 build(const GameDatabase & inDatabase,
+                                          const std::string & inPath, int inNumThreads,
+                                          size_t inMemoryMb);
+
+    private:
+        /**
+         @brief         Index of the first block that may hold a key
+         */
+        size_t                      _findBlock(ZobristKey inKey) const;
+
+        /**
+         @return        false if stopped, or the block is damaged
+         */
+        bool                        _decodeBlock(size_t inBlock,
+                                                 const PostingCallback & inOnPosting) const;
+
+        MappedFile                  _file;
+        uint64_t                    _numPostings;
+        size_t                      _numBlocks;
+        const uint8_t *             _blockIndex;
+    };
+}
@@ -0,0 +1,1047 @@
+/***************************************************************************************************
+ *
+ *  @file       Search.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Alpha beta search of a position
+ *
+ **************************************************************************************************/
+
+#include "Search.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+using namespace chessEngine;
+
+static_assert(SearchStats::kMaxIterations >= Search::kMaxDepth,
+              "Every iteration needs its time in the statistics");
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark SearchStats
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void
+SearchStats::operator+= (const SearchStats & inOther)
+{
+    nodes            += inOther.nodes;
+    qNodes           += inOther.qNodes;
+    tbHits           += inOther.tbHits;
+    ttProbes         += inOther.ttProbes;
+    ttHits           += inOther.ttHits;
+    ttCollisions     += inOther.ttCollisions;
+    betaCutoffs      += inOther.betaCutoffs;
+    firstMoveCutoffs += inOther.firstMoveCutoffs;
+    nullMoveTries    += inOther.nullMoveTries;
+    nullMoveCutoffs  += inOther.nullMoveCutoffs;
+    lmrReductions    += inOther.lmrReductions;
+    lmrResearches    += inOther.lmrResearches;
+    eval             += inOther.eval;
+
+    for (int i = 0; i < inOther.numIterations; i++)
+    {
+        iterationUs[i] = ((i < numIterations) ? iterationUs[i] : 0) + inOther.iterationUs[i];
+    }
+
+    numIterations = std::max(numIterations, inOther.numIterations);
+}
+
+std::string
+SearchStats::toJson() const
+{
+    std::ostringstream json;
+
+    json << "{\"detailed\":" << (kIsDetailed ? "true" : "false")
+         << ",\"nodes\":" << nodes
+         << ",\"qNodes\":" << qNodes
+         << ",\"tbHits\":" << tbHits
+         << ",\"ttProbes\":" << ttProbes
+         << ",\"ttHits\":" << ttHits
+         << ",\"ttCollisions\":" << ttCollisions
+         << ",\"ttHitRate\":" << getTTHitRate()
+         << ",\"betaCutoffs\":" << betaCutoffs
+         << ",\"firstMoveCutoffs\":" << firstMoveCutoffs
+         << ",\"firstMoveCutoffRate\":" << getFirstMoveCutoffRate()
+         << ",\"nullMoveTries\":" << nullMoveTries
+         << ",\"nullMoveCutoffs\":" << nullMoveCutoffs
+         << ",\"nullMoveCutoffRate\":" << getNullMoveCutoffRate()
+         << ",\"lmrReductions\":" << lmrReductions
+         << ",\"lmrResearches\":" << lmrResearches
+         << ",\"lmrResearchRate\":" << getLmrResearchRate()
+         << ",\"seededPlies\":" << seededPlies
+         << ",\"iterationUs\":[";
+
+    for (int i = 0; i < numIterations; i++)
+    {
+        json << ((i == 0) ? "" : ",") << iterationUs[i];
+    }
+
+    json << "],\"eval\":{\"evaluations\":" << eval.evaluations
+         << ",\"pawnProbes\":" << eval.pawnProbes
+         << ",\"pawnHits\":" << eval.pawnHits
+         << ",\"pawnHitRate\":" << eval.getPawnHitRate() << "}}";
+
+    return json.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark SearchInfo
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+SearchInfo::isMate() const
+{
+    return abs(score) >= Search::kMateBound;
+}
+
+int
+SearchInfo::getMateInMoves() const
+{
+    int plies = Search::kMateScore - abs(score);
+
+    return (score > 0) ? (plies + 1) / 2 : -(plies / 2);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Move ordering
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static constexpr int kTTMoveScore       = 1 << 30;
+static constexpr int kSeedMoveScore     = kTTMoveScore - 1;
+static constexpr int kCaptureScore      = 1 << 26;
+static constexpr int kPromotionScore    = 1 << 25;
+static constexpr int kKillerScore       = 1 << 24;
+
+static constexpr int kHistoryMax        = 1 << 20;
+
+// Half width of the first window around the score of the previous iteration
+static constexpr int kAspirationWindow  = 25;
+static constexpr int kMinAspirationDepth = 4;
+
+// Lazy SMP helpers skip blocks of kSkipSizes iterations out of two, each starting at its own
+// phase, so that the threads spread over several depths rather than all search the same one
+static constexpr int kNumSkipPatterns   = 20;
+static constexpr int kSkipSizes[kNumSkipPatterns]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                                       3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static constexpr int kSkipPhases[kNumSkipPatterns] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                                                       4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+// Victims in the order of the piece names, pawn to king
+static constexpr int kVictimValues[6]   = { 100, 320, 330, 500, 900, 0 };
+
+static inline uint8_t
+_colorIndex(attributes::ChessColor inColor)
+{
+    return static_cast<uint8_t>(inColor);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Search
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Search::Search(TranspositionTable * inTable) :
+_table(inTable), _tablebases(nullptr), _isPrefetchEnabled(true), _isTableAgingEnabled(true),
+_helperIndex(0), _nextCheckNodes(0), _selDepth(0), _stop(false), _ponderHit(false),
+_ponderHitUs(0), _arena(new Arena()), _seedLength(0)
+{
+    clearHistory();
+
+    // Everything a search fills in is reserved here, so that searching never allocates
+    for (auto & lines : _arena->lines)
+    {
+        for (auto & line : lines)
+        {
+            line.pv.reserve(kMaxPly);
+        }
+    }
+
+    _lastPv.reserve(kMaxPly);
+    _lastPvKeys.reserve(kMaxPly);
+    _excludedRootMoves.reserve(MoveList::kMaxMoves);
+    _rootLineMoves.reserve(MoveList::kMaxMoves);
+}
+
+void
+Search::ponderHit()
+{
+    auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now().time_since_epoch()).count();
+    
+    _ponderHitUs.store(now, std::memory_order_relaxed);
+    _ponderHit.store(true, std::memory_order_release);
+}
+
+void
+Search::clearHistory()
+{
+    memset(_arena->killers, 0, sizeof(_arena->killers));
+    memset(_arena->history, 0, sizeof(_arena->history));
+}
+
+SearchResult
+Search::run(const ChessEngine & inPosition, const SearchLimits & inLimits,
+            const ProgressCallback & inOnProgress)
+{
+    SearchResult result;
+
+    run(inPosition, inLimits, &result, inOnProgress);
+
+    return result;
+}
+
+void
+Search::run(const ChessEngine & inPosition, const SearchLimits & inLimits,
+            SearchResult * outResult, const ProgressCallback & inOnProgress)
+{
+    // The lines are left as they are until they are overwritten, so as to keep their memory
+    SearchResult & result = *outResult;
+
+    result.bestMove   = PackedMove();
+    result.ponderMove = PackedMove();
+    result.score      = 0;
+    result.depth      = 0;
+
+    _engine     = inPosition;
+    _limits     = inLimits;
+    _stats      = SearchStats();
+    _startTime  = Clock::now();
+
+    // The moves of the search go on top of those of the game
+    _engine.reserveMoves(kMaxPly);
+
+    _timeManager.start(_limits);
+    _nextCheckNodes = _timeManager.getCheckInterval();
+
+    _evaluator.resetStats();
+
+    if (_isTableAgingEnabled)
+    {
+        _table->newSearch();
+    }
+
+    // Keep the history of the previous search as a hint, but let the new one dominate
+    for (auto & byColor : _arena->history)
+    {
+        for (auto & bySrc : byColor)
+        {
+            for (auto & value : bySrc)
+            {
+                value /= 2;
+            }
+        }
+    }
+
+    _seedFromLastPv();
+    _stats.seededPlies = _seedLength;
+
+    _rootMoves.clear();
+    _engine.generateLegalMoves(&_rootMoves);
+
+    _excludedRootMoves.clear();
+    _rootLineMoves.clear();
+
+    if (_rootMoves.isEmpty())
+    {
+        result.score = _engine.isInCheck() ? -kMateScore : 0;
+        result.lines.clear();
+        result.stats = _stats;
+        resetStop();
+        resetPonderHit();
+        return;
+    }
+
+    // Leave out the moves that spoil the outcome of a tablebase position
+    if ((_tablebases != nullptr) && _tablebases->filterRootMoves(_engine, &_rootMoves))
+    {
+        _stats.tbHits++;
+    }
+
+    // Always have a move to play, even if the first iteration is stopped
+    result.bestMove = _rootMoves[0];
+
+    int maxDepth = (_limits.depth > 0) ? std::min(_limits.depth, static_cast<int>(kMaxDepth))
+                                       : kMaxDepth;
+    int numLines = std::min(std::max(_limits.multiPv, 1), static_cast<int>(_rootMoves.size));
+
+    // The lines of the last complete iteration, the next one is written to the other buffer
+    int lastLinesIndex = 0;
+
+    for (int depth = 1; depth <= maxDepth; depth++)
+    {
+        if (_isSkippedDepth(depth))
+        {
+            _stats.iterationUs[depth - 1] = 0;
+            continue;
+        }
+
+        SearchInfo *       lines     = _arena->lines[lastLinesIndex ^ 1];
+        const SearchInfo * lastLines = _arena->lines[lastLinesIndex];
+        int64_t            startUs   = _getElapsedUs();
+
+        _excludedRootMoves.clear();
+
+        for (int lineIndex = 0; lineIndex < numLines; lineIndex++)
+        {
+            int alpha = -kInfinite;
+            int beta  = kInfinite;
+            int delta = kAspirationWindow;
+            int score;
+
+            // Expect the score of the line of the previous iteration, widening the window until
+            // the score falls inside, so that it is exact
+            if (depth >= kMinAspirationDepth)
+            {
+                alpha = std::max(lastLines[lineIndex].score - delta, -kInfinite);
+                beta  = std::min(lastLines[lineIndex].score + delta, static_cast<int>(kInfinite));
+            }
+
+            while (true)
+            {
+                _selDepth = 0;
+                score     = _alphaBeta(alpha, beta, depth, 0, false);
+
+                if (isStopped())
+                {
+                    break;
+                }
+
+                if (score <= alpha)
+                {
+                    alpha = std::max(score - delta, -kInfinite);
+                }
+                else if (score >= beta)
+                {
+                    beta  = std::min(score + delta, static_cast<int>(kInfinite));
+                }
+                else
+                {
+                    break;
+                }
+
+                delta *= 2;
+            }
+
+            if (isStopped())
+            {
+                break;
+            }
+
+            SearchInfo & info = lines[lineIndex];
+
+            info.multiPv  = lineIndex + 1;
+            info.depth    = depth;
+            info.selDepth = _selDepth;
+            info.score    = score;
+            info.nodes    = _stats.nodes;
+            info.timeMs   = _getElapsedMs();
+            info.pv.assign(&_arena->pv[0][0], &_arena->pv[0][_arena->pvLength[0]]);
+
+            if (lineIndex == 0)
+            {
+                _saveLastPv(_arena->pv[0], _arena->pvLength[0]);
+            }
+
+            _excludedRootMoves.push_back(_arena->pv[0][0]);
+
+            if (inOnProgress)
+            {
+                inOnProgress(info);
+            }
+        }
+
+        // A stopped iteration is incomplete, the result of the previous one stands
+        if (isStopped())
+        {
+            break;
+        }
+
+        const auto & best = lines[0];
+
+        lastLinesIndex ^= 1;
+
+        result.bestMove   = best.pv[0];
+        result.ponderMove = (best.pv.size() > 1) ? best.pv[1] : PackedMove();
+        result.score      = best.score;
+        result.depth      = depth;
+
+        _stats.iterationUs[depth - 1] = _getElapsedUs() - startUs;
+        _stats.numIterations          = depth;
+
+        _rootLineMoves = _excludedRootMoves;
+        _timeManager.onIteration(result.bestMove, result.score);
+
+        // Until the hit, a ponder search has no reason to end early
+        if (_isPondering())
+        {
+            continue;
+        }
+
+        // A mate found within the depth cannot get better
+        if ((abs(result.score) >= kMateBound) && ((kMateScore - abs(result.score)) <= depth))
+        {
+            break;
+        }
+
+        // The next iteration would not finish in the time left
+        if (!_timeManager.shouldStartIteration(_getLimitElapsedUs()))
+        {
+            break;
+        }
+    }
+
+    // The best move of a ponder search is only wanted once the reply is known
+    while (_isPondering() && !isStopped())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    _excludedRootMoves.clear();
+    _rootLineMoves.clear();
+
+    // Copied over the lines of the result, which only allocates where they are fewer or shorter
+    if (result.depth > 0)
+    {
+        const SearchInfo * lines = _arena->lines[lastLinesIndex];
+        result.lines.assign(lines, lines + numLines);
+    }
+    else
+    {
+        result.lines.clear();
+    }
+
+    _stats.eval   = _evaluator.getStats();
+    result.stats  = _stats;
+
+    resetStop();
+    resetPonderHit();
+}
+
+bool
+Search::_isSkippedDepth(int inDepth) const
+{
+    // The first iteration gives the move to play, whatever the thread
+    if ((_helperIndex == 0) || (inDepth == 1))
+    {
+        return false;
+    }
+
+    int pattern = (_helperIndex - 1) % kNumSkipPatterns;
+
+    return ((((inDepth + kSkipPhases[pattern]) / kSkipSizes[pattern]) % 2) != 0);
+}
+
+void
+Search::_seedFromLastPv()
+{
+    auto rootKey = _engine.getHashKey();
+
+    _seedLength    = 0;
+    _onSeedPath[0] = true;
+
+    for (size_t i = 0; i < _lastPvKeys.size(); i++)
+    {
+        if (_lastPvKeys[i] == rootKey)
+        {
+            for (size_t j = i; (j < _lastPv.size()) && (_seedLength < kMaxPly); j++)
+            {
+                _seedPv[_seedLength++] = _lastPv[j];
+            }
+
+            break;
+        }
+    }
+}
+
+void
+Search::_saveLastPv(const PackedMove * inPv, int inLength)
+{
+    _lastPv.assign(inPv, inPv + inLength);
+    _lastPvKeys.clear();
+
+    // Play the line to get the key of the position before each of its moves
+    for (int i = 0; i < inLength; i++)
+    {
+        _lastPvKeys.push_back(_engine.getHashKey());
+        _engine.makeMove(inPv[i]);
+    }
+
+    for (int i = 0; i < inLength; i++)
+    {
+        _engine.unmakeMove();
+    }
+}
+
+int
+Search::_alphaBeta(int inAlpha, int inBeta, int inDepth, int inPly, bool inAllowNull)
+{
+    bool isRoot  = (inPly == 0);
+    bool isPv    = (inBeta - inAlpha > 1);
+    bool inCheck = _engine.isInCheck();
+
+    _arena->pvLength[inPly] = inPly;
+
+    // Check extension
+    if (inCheck)
+    {
+        inDepth++;
+    }
+
+    if (inDepth <= 0)
+    {
+        return _quiescence(inAlpha, inBeta, inPly);
+    }
+
+    _countNode();
+
+    if (isStopped())
+    {
+        return 0;
+    }
+
+    _selDepth = std::max(_selDepth, inPly);
+
+    if (!isRoot)
+    {
+        if (_engine.isDraw())
+        {
+            return 0;
+        }
+
+        if (inPly >= kMaxPly - 1)
+        {
+            return inCheck ? 0 : _evaluator.evaluate(_engine);
+        }
+
+        // Mate distance pruning, a shorter mate has already been found
+        inAlpha = std::max(inAlpha, -kMateScore + inPly);
+        inBeta  = std::min(inBeta, kMateScore - inPly - 1);
+
+        if (inAlpha >= inBeta)
+        {
+            return inAlpha;
+        }
+    }
+
+    auto                     key = _engine.getHashKey();
+    TranspositionTable::Data ttData;
+    PackedMove               ttMove;
+
+    SEARCH_STAT(_stats.ttProbes++);
+
+    if (_table->probe(key, &ttData))
+    {
+        SEARCH_STAT(_stats.ttHits++);
+        ttMove = ttData.move;
+
+        int ttScore = _fromTTScore(ttData.score, inPly);
+
+        if (!isPv && (ttData.depth >= inDepth) &&
+            (((ttData.bound & TranspositionTable::kLower) && (ttScore >= inBeta)) ||
+             ((ttData.bound & TranspositionTable::kUpper) && (ttScore <= inAlpha))))
+        {
+            return ttScore;
+        }
+    }
+
+    // The tables know the outcome, and with the DTZ whether the 50 move rule spoils it
+    int tbScore;
+
+    if (!isRoot && _probeTablebases(inPly, &tbScore))
+    {
+        return tbScore;
+    }
+
+    int staticEval = inCheck ? -kInfinite : _evaluator.evaluate(_engine);
+
+    // Null move pruning: if passing still fails high, a real move will too. Not done without
+    // pieces, where zugzwang is common.
+    if (!isPv && inAllowNull && !inCheck && (inDepth >= 3) && (staticEval >= inBeta) &&
+        _engine.hasNonPawnMaterial(_engine.getCurrMove()))
+    {
+        int reduction = 2 + inDepth / 6;
+
+        _onSeedPath[inPly + 1] = false;
+
+        SEARCH_STAT(_stats.nullMoveTries++);
+
+        _engine.makeNullMove();
+        int score = -_alphaBeta(-inBeta, -inBeta + 1, inDepth - 1 - reduction, inPly + 1, false);
+        _engine.unmakeMove();
+
+        if (isStopped())
+        {
+            return 0;
+        }
+
+        if (score >= inBeta)
+        {
+            SEARCH_STAT(_stats.nullMoveCutoffs++);
+
+            // Do not trust mates found by passing
+            return (score >= kMateBound) ? inBeta : score;
+        }
+    }
+
+    auto & moves  = _arena->frames[inPly].moves;
+    auto   scores = _arena->frames[inPly].scores;
+
+    moves.clear();
+    _engine.generateMoves(&moves);
+    _scoreMoves(moves, ttMove, inPly, scores);
+
+    SEARCH_STAT(if (!ttMove.isNull() && !moves.contains(ttMove)) _stats.ttCollisions++);
+
+    int        alpha       = inAlpha;
+    int        bestScore   = -kInfinite;
+    PackedMove bestMove;
+    int        numLegal    = 0;
+
+    for (size_t i = 0; i < moves.size; i++)
+    {
+        _pickMove(&moves, scores, i);
+
+        auto move = moves[i];
+
+        if (!_engine.isLegal(move) || (isRoot && !_isSearchedRootMove(move)))
+        {
+            continue;
+        }
+
+        numLegal++;
+
+        bool isQuiet  = !move.isCapture() && !move.isPromotion();
+        bool isKiller = (move == _arena->killers[inPly][0]) || (move == _arena->killers[inPly][1]);
+        int  score;
+
+        _prefetchChild(move, true);
+        _enterChild(inPly, move);
+        _engine.makeMove(move);
+
+        if (numLegal == 1)
+        {
+            score = -_alphaBeta(-inBeta, -alpha, inDepth - 1, inPly + 1, true);
+        }
+        else
+        {
+            // Late quiet moves are unlikely to be best, search them shallower first
+            int reduction = 0;
+
+            if ((inDepth >= 3) && (numLegal > 3) && isQuiet && !isKiller && !inCheck &&
+                !_engine.isInCheck())
+            {
+                reduction = (numLegal > 6) ? 2 : 1;
+                reduction = std::min(reduction, inDepth - 2);
+            }
+
+            if (reduction > 0)
+            {
+                SEARCH_STAT(_stats.lmrReductions++);
+            }
+
+            score = -_alphaBeta(-alpha - 1, -alpha, inDepth - 1 - reduction, inPly + 1, true);
+
+            if ((score > alpha) && (reduction > 0))
+            {
+                SEARCH_STAT(_stats.lmrResearches++);
+                score = -_alphaBeta(-alpha - 1, -alpha, inDepth - 1, inPly + 1, true);
+            }
+
+            if ((score > alpha) && (score < inBeta))
+            {
+                score = -_alphaBeta(-inBeta, -alpha, inDepth - 1, inPly + 1, true);
+            }
+        }
+
+        _engine.unmakeMove();
+
+        if (isStopped())
+        {
+            return 0;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestMove  = move;
+
+            if (score > alpha)
+            {
+                alpha = score;
+                _updatePv(inPly, move);
+
+                if (alpha >= inBeta)
+                {
+                    SEARCH_STAT(_stats.betaCutoffs++);
+
+                    if (numLegal == 1)
+                    {
+                        SEARCH_STAT(_stats.firstMoveCutoffs++);
+                    }
+
+                    if (isQuiet)
+                    {
+                        _updateQuietStats(move, inDepth, inPly);
+                    }
+
+                    break;
+                }
+            }
+        }
+    }
+
+    if (numLegal == 0)
+    {
+        return inCheck ? -kMateScore + inPly : 0;
+    }
+
+    auto bound = ((bestScore >= inBeta) ? TranspositionTable::kLower :
+                  ((bestScore > inAlpha) ? TranspositionTable::kExact : TranspositionTable::kUpper));
+
+    // With root moves left out, the root result is not the one of the position
+    if (!isRoot || _excludedRootMoves.empty())
+    {
+        _table->store(key, bestMove, _toTTScore(bestScore, inPly), staticEval, inDepth, bound);
+    }
+
+    return bestScore;
+}
+
+int
+Search::_quiescence(int inAlpha, int inBeta, int inPly)
+{
+    _countNode();
+    _stats.qNodes++;
+
+    if (isStopped())
+    {
+        return 0;
+    }
+
+    _arena->pvLength[inPly] = inPly;
+    _selDepth        = std::max(_selDepth, inPly);
+
+    bool inCheck = _engine.isInCheck();
+
+    if (inPly >= kMaxPly - 1)
+    {
+        return inCheck ? 0 : _evaluator.evaluate(_engine);
+    }
+
+    int bestScore = -kInfinite;
+    int alpha     = inAlpha;
+
+    // Standing pat is not an option when in check, every evasion is searched instead
+    if (!inCheck)
+    {
+        bestScore = _evaluator.evaluate(_engine);
+
+        if (bestScore >= inBeta)
+        {
+            return bestScore;
+        }
+
+        alpha = std::max(alpha, bestScore);
+    }
+
+    auto & moves  = _arena->frames[inPly].moves;
+    auto   scores = _arena->frames[inPly].scores;
+
+    moves.clear();
+    _engine.generateMoves(&moves, !inCheck);
+    _scoreMoves(moves, PackedMove(), inPly, scores);
+
+    int numLegal = 0;
+
+    for (size_t i = 0; i < moves.size; i++)
+    {
+        _pickMove(&moves, scores, i);
+
+        auto move = moves[i];
+
+        if (!_engine.isLegal(move))
+        {
+            continue;
+        }
+
+        numLegal++;
+
+        _prefetchChild(move, false);
+        _enterChild(inPly, move);
+        _engine.makeMove(move);
+        int score = -_quiescence(-inBeta, -alpha, inPly + 1);
+        _engine.unmakeMove();
+
+        if (isStopped())
+        {
+            return 0;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+
+            if (score > alpha)
+            {
+                alpha = score;
+                _updatePv(inPly, move);
+
+                if (alpha >= inBeta)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (inCheck && (numLegal == 0))
+    {
+        return -kMateScore + inPly;
+    }
+
+    return bestScore;
+}
+
+void
+Search::_prefetchChild(PackedMove inMove, bool inIsTableProbed)
+{
+    if (!_isPrefetchEnabled)
+    {
+        return;
+    }
+
+    ZobristKey hashKey, pawnKey;
+    _engine.getKeysAfter(inMove, &hashKey, &pawnKey);
+
+    if (inIsTableProbed)
+    {
+        _table->prefetch(hashKey);
+    }
+
+    // The network does not use the pawn table, and the entry of an unchanged pawn key is already
+    // in the cache
+    if ((_engine.getNetwork() == nullptr) && (pawnKey != _engine.getPawnKey()))
+    {
+        _evaluator.getPawnTable().prefetch(pawnKey);
+    }
+}
+
+bool
+Search::_probeTablebases(int inPly, int * outScore)
+{
+    Tablebases::Wdl wdl;
+
+    if ((_tablebases == nullptr) || !_tablebases->probeWdlWithClock(_engine, &wdl))
+    {
+        return false;
+    }
+
+    _stats.tbHits++;
+
+    switch (wdl)
+    {
+        case Tablebases::kWin:          *outScore = kTBWinScore - inPly;    break;
+        case Tablebases::kLoss:         *outScore = -kTBWinScore + inPly;   break;
+        default:                        *outScore = wdl;                    break;
+    }
+
+    return true;
+}
+
+void
+Search::_scoreMoves(const MoveList & inMoves, PackedMove inTTMove, int inPly,
+                    int * outScores) const
+{
+    auto us = _colorIndex(_engine.getCurrMove());
+
+    for (size_t i = 0; i < inMoves.size; i++)
+    {
+        auto move = inMoves[i];
+
+        if (move == inTTMove)
+        {
+            outScores[i] = kTTMoveScore;
+        }
+        else if (_onSeedPath[inPly] && (inPly < _seedLength) && (move == _seedPv[inPly]))
+        {
+            outScores[i] = kSeedMoveScore;
+        }
+        else if ((inPly == 0) && (_getRootLineRank(move) >= 0))
+        {
+            // Root moves of the previous lines, in their order
+            outScores[i] = kSeedMoveScore - 1 - _getRootLineRank(move);
+        }
+        else if (move.isCapture())
+        {
+            attributes::ChessColor     color;
+            attributes::ChessPieceName victim   = attributes::ChessPieceName::kPawn;
+            attributes::ChessPieceName attacker = attributes::ChessPieceName::kPawn;
+
+            // En passant leaves the victim square empty, the victim being a pawn
+            _engine.getPieceAt(move.getDest(), &color, &victim);
+            _engine.getPieceAt(move.getSrc(), &color, &attacker);
+
+            // Most valuable victim first, then least valuable attacker
+            outScores[i] = (kCaptureScore + kVictimValues[static_cast<uint8_t>(victim)] * 8 -
+                            static_cast<uint8_t>(attacker));
+
+            if (move.isPromotion())
+            {
+                outScores[i] += kVictimValues[static_cast<uint8_t>(move.getPromotion())];
+            }
+        }
+        else if (move.isPromotion())
+        {
+            outScores[i] = kPromotionScore + kVictimValues[static_cast<uint8_t>(move.getPromotion())];
+        }
+        else if (move == _arena->killers[inPly][0])
+        {
+            outScores[i] = kKillerScore + 1;
+        }
+        else if (move == _arena->killers[inPly][1])
+        {
+            outScores[i] = kKillerScore;
+        }
+        else
+        {
+            outScores[i] = _arena->history[us][move.getSrc().index][move.getDest().index];
+        }
+    }
+}
+
+void
+Search::_pickMove(MoveList * inOutMoves, int * inOutScores, size_t inIndex)
+{
+    size_t best = inIndex;
+
+    for (size_t i = inIndex + 1; i < inOutMoves->size; i++)
+    {
+        if (inOutScores[i] > inOutScores[best])
+        {
+            best = i;
+        }
+    }
+
+    if (best != inIndex)
+    {
+        std::swap(inOutMoves->moves[inIndex], inOutMoves->moves[best]);
+        std::swap(inOutScores[inIndex], inOutScores[best]);
+    }
+}
+
+void
+Search::_updatePv(int inPly, PackedMove inMove)
+{
+    _arena->pv[inPly][inPly] = inMove;
+
+    for (int i = inPly + 1; i < _arena->pvLength[inPly + 1]; i++)
+    {
+        _arena->pv[inPly][i] = _arena->pv[inPly + 1][i];
+    }
+
+    _arena->pvLength[inPly] = std::max(_arena->pvLength[inPly + 1], inPly + 1);
+}
+
+void
+Search::_updateQuietStats(PackedMove inMove, int inDepth, int inPly)
+{
+    if (_arena->killers[inPly][0] != inMove)
+    {
+        _arena->killers[inPly][1] = _arena->killers[inPly][0];
+        _arena->killers[inPly][0] = inMove;
+    }
+
+    int & history = _arena->history[_colorIndex(_engine.getCurrMove())][inMove.getSrc().index]
+                            [inMove.getDest().index];
+
+    history = std::min(history + inDepth * inDepth, kHistoryMax);
+}
+
+void
+Search::_checkLimits()
+{
+    if ((_limits.nodes > 0) && (_stats.nodes >= _limits.nodes))
+    {
+        stop();
+    }
+
+    if (_timeManager.isLimited() && !_isPondering() &&
+        _timeManager.isHardLimitReached(_getLimitElapsedUs()))
+    {
+        stop();
+    }
+
+    _timeManager.updateNodeRate(_stats.nodes, _getElapsedUs());
+    _nextCheckNodes = _stats.nodes + _timeManager.getCheckInterval();
+
+    // Do not overshoot the node limit by more than a node
+    if (_limits.nodes > 0)
+    {
+        _nextCheckNodes = std::min(_nextCheckNodes, _limits.nodes);
+    }
+}
+
+int64_t
+Search::_getElapsedUs() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                                 _startTime).count();
+}
+
+int64_t
+Search::_getLimitElapsedUs() const
+{
+    if (!_limits.ponder)
+    {
+        return _getElapsedUs();
+    }
+
+    auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now().time_since_epoch()).count();
+
+    return now - _ponderHitUs.load(std::memory_order_relaxed);
+}
+
+int
+Search::_toTTScore(int inScore, int inPly)
+{
+    // Mates are stored relative to the position, not to the root
+    if (inScore >= kMateBound)
+    {
+        return inScore + inPly;
+    }
+
+    if (inScore <= -kMateBound)
+    {
+        return inScore - inPly;
+    }
+
+    return inScore;
+}
+
+int
+Search::_fromTTScore(int inScore, int inPly)
+{
+    if (inScore >= kMateBound)
+    {
+        return inScore - inPly;
+    }
+
+    if (inScore <= -kMateBound)
+    {
+        return inScore + inPly;
+    }
+
+    return inScore;
+}
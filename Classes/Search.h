@@ -0,0 +1,521 @@
+/***************************************************************************************************
+ *
+ *  @file       Search.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Alpha beta search of a position
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "Evaluation.h"
+#include "Tablebase.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chessEngine
+{
+    // The detailed counters of SearchStats cost a little speed, they are only counted with
+    // CHESS_SEARCH_STATS defined. The build defines it for the engine library and everything
+    // linking it alike, in debug builds or when asked for, never per file, so that SearchStats
+    // means the same in every translation unit
+    #if defined(CHESS_SEARCH_STATS)
+        #define SEARCH_STAT(inStatement)    do { inStatement; } while (0)
+    #else
+        #define SEARCH_STAT(inStatement)    do { } while (0)
+    #endif
+
+    /**
+     @class          SearchStats
+
+     @brief          Counters of a search
+
+     @discussion     Every search thread counts into its own, and the counters of the threads are
+     added up when the search ends. The nodes, the tablebase hits and the seeded plies are always
+     counted. The rest are only counted if kIsDetailed, and stay 0 otherwise.
+     */
+    struct SearchStats
+    {
+#if defined(CHESS_SEARCH_STATS)
+        static constexpr bool       kIsDetailed = true;
+#else
+        static constexpr bool       kIsDetailed = false;
+#endif
+        static constexpr int        kMaxIterations = 64;
+
+        uint64_t                    nodes;
+        uint64_t                    qNodes;
+        uint64_t                    tbHits;
+
+        uint64_t                    ttProbes;
+        uint64_t                    ttHits;
+
+        /**
+         @brief         Hits whose move is not a move of the position, so the entry was written for
+         another position of the same cluster, or torn by another thread
+         */
+        uint64_t                    ttCollisions;
+
+        uint64_t                    betaCutoffs;
+        uint64_t                    firstMoveCutoffs;
+
+        uint64_t                    nullMoveTries;
+        uint64_t                    nullMoveCutoffs;
+
+        /**
+         @brief         Moves searched with a late move reduction, and those of them searched again
+         at full depth because they beat alpha
+         */
+        uint64_t                    lmrReductions;
+        uint64_t                    lmrResearches;
+
+        /**
+         @brief         Time each completed iteration took, from depth 1, 0 for the ones a
+         helper skipped
+         */
+        int64_t                     iterationUs[kMaxIterations];
+        int                         numIterations;
+
+        /**
+         @brief         Number of moves of the previous principal variation used to order moves
+         */
+        uint32_t                    seededPlies;
+
+        EvalStats                   eval;
+
+        SearchStats() :
+        nodes(0), qNodes(0), tbHits(0), ttProbes(0), ttHits(0), ttCollisions(0), betaCutoffs(0),
+        firstMoveCutoffs(0), nullMoveTries(0), nullMoveCutoffs(0), lmrReductions(0),
+        lmrResearches(0), numIterations(0), seededPlies(0)
+        { }
+
+        /**
+         @brief         Add the counters of another search or thread. The times of the same depth
+         are added too, the seeded plies are the ones of this search.
+         */
+        void                        operator+= (const SearchStats & inOther);
+
+        double                      getTTHitRate() const
+        { return (ttProbes == 0) ? 0.0 : static_cast<double>(ttHits) / ttProbes; }
+
+        /**
+         @brief         Fraction of the cutoffs made by the first move, a measure of move ordering
+         */
+        double                      getFirstMoveCutoffRate() const
+        { return (betaCutoffs == 0) ? 0.0 : static_cast<double>(firstMoveCutoffs) / betaCutoffs; }
+
+        double                      getNullMoveCutoffRate() const
+        {
+            return (nullMoveTries == 0) ? 0.0 :
+                   static_cast<double>(nullMoveCutoffs) / nullMoveTries;
+        }
+
+        double                      getLmrResearchRate() const
+        { return (lmrReductions == 0) ? 0.0 : static_cast<double>(lmrResearches) / lmrReductions; }
+
+        /**
+         @brief         The counters and rates as a JSON object, on one line
+         */
+        std::string                 toJson() const;
+    };
+
+    /**
+     @class          SearchInfo
+
+     @brief          Progress of a search, reported for every line of every completed iteration
+     */
+    struct SearchInfo
+    {
+        /**
+         @brief         Rank of the line, from 1 for the best
+         */
+        int                         multiPv;
+
+        int                         depth;
+        int                         selDepth;
+        int                         score;
+        uint64_t                    nodes;
+        int64_t                     timeMs;
+
+        std::vector<PackedMove>     pv;
+
+        SearchInfo() :
+        multiPv(1), depth(0), selDepth(0), score(0), nodes(0), timeMs(0)
+        { }
+
+        /**
+         @brief         Check if the score is a forced mate, for either side
+         */
+        bool                        isMate() const;
+
+        /**
+         @brief         Moves to mate, negative if the side to move gets mated. Only valid if
+         isMate()
+         */
+        int                         getMateInMoves() const;
+    };
+
+    /**
+     @class          SearchResult
+
+     @brief          Outcome of a search
+     */
+    struct SearchResult
+    {
+        PackedMove                  bestMove;
+        PackedMove                  ponderMove;
+
+        int                         score;
+        int                         depth;
+
+        /**
+         @brief         Lines of the last completed iteration, best first, as many as asked for by
+         SearchLimits::multiPv and the position allows
+         */
+        std::vector<SearchInfo>     lines;
+
+        SearchStats                 stats;
+
+        SearchResult() :
+        score(0), depth(0)
+        { }
+    };
+
+    /**
+     @class          Search
+
+     @brief          Iterative deepening principal variation search
+
+     @discussion     Uses a transposition table, null move pruning, late move reductions,
+     killer and history move ordering and a quiescence search of captures. The table may be shared
+     between threads, everything else belongs to one search object, which runs on one thread.
+
+     The principal variation of the last search is kept. If a later search starts from a position
+     along it, e.g. after the expected reply was played, the rest of it is tried first.
+
+     With tablebases, positions with few enough pieces right after a capture or pawn move are
+     scored by them instead of being searched, and at the root only the moves that keep the best
+     outcome are searched.
+
+     For several lines, each iteration searches the root once per line, leaving out the root moves
+     of the lines already found. The table is shared by the passes, and the root moves are tried in
+     the order of the lines of the previous iteration.
+     */
+    class Search
+    {
+    public:
+        static constexpr int        kMaxPly       = 128;
+        static constexpr int        kMaxDepth     = 64;
+        static constexpr int        kInfinite     = 32500;
+        static constexpr int        kMateScore    = 32000;
+
+        /**
+         @brief         Scores beyond this are mates, the distance to mate in plies being the
+         difference to kMateScore
+         */
+        static constexpr int        kMateBound    = kMateScore - kMaxPly;
+
+        /**
+         @brief         Score of a tablebase win at the root, below any mate
+         */
+        static constexpr int        kTBWinScore   = kMateBound - 1;
+
+        using ProgressCallback = std::function<void(const SearchInfo &)>;
+
+        Search(TranspositionTable * inTable);
+
+        /**
+         @brief         Search a position
+
+         @discussion    Blocks until a limit is reached or stop() is called. A position without
+         legal moves returns a null best move and no lines. A ponder search does not return before
+         ponderHit() or stop() is called.
+
+         The lines of the returned result are the only memory the search allocates. To search
+         without allocating at all, reuse a result with the other run().
+
+         @param     inPosition      the position, with the moves that led to it for detecting
+         repetitions
+         @param     inLimits        when to stop
+         @param     inOnProgress    called on this thread for every line of every completed
+         iteration
+         */
+        SearchResult                run(const ChessEngine & inPosition, const SearchLimits & inLimits,
+                                        const ProgressCallback & inOnProgress = nullptr);
+
+        /**
+         @brief         Search a position into a result of an earlier search
+
+         @discussion    The lines are copied over those of the result, keeping their memory, so
+         that once a result has held as many lines as asked for, nothing is allocated. Only a game
+         longer than any before, past ChessEngine::kMaxGamePly moves, grows the undo stack of the
+         copy of the position once.
+         */
+        void                        run(const ChessEngine & inPosition, const SearchLimits & inLimits,
+                                        SearchResult * outResult,
+                                        const ProgressCallback & inOnProgress = nullptr);
+
+        /**
+         @brief         Stop the running search as soon as possible, callable from any thread
+
+         @discussion    A stop requested while no search is running applies to the next one,
+         unless resetStop() is called in between.
+         */
+        void                        stop() { _stop.store(true, std::memory_order_relaxed); }
+
+        void                        resetStop() { _stop.store(false, std::memory_order_relaxed); }
+
+        /**
+         @brief         The expected reply was played, turn the ponder search into a normal one,
+         callable from any thread
+
+         @discussion    The time limit counts from this call. Like stop(), a hit while no search is
+         running applies to the next one, unless resetPonderHit() is called in between.
+         */
+        void                        ponderHit();
+
+        void                        resetPonderHit()
+        { _ponderHit.store(false, std::memory_order_release); }
+
+        bool                        isStopped() const
+        { return _stop.load(std::memory_order_relaxed); }
+
+        /**
+         @brief         Forget the killer moves and history, e.g. for a new game
+         */
+        void                        clearHistory();
+
+        Evaluator &                 getEvaluator() { return _evaluator; }
+
+        /**
+         @brief         Use tablebases, or none if null. They may be shared by several searches.
+         */
+        void                        setTablebases(const Tablebases * inTablebases)
+        { _tablebases = inTablebases; }
+
+        /**
+         @brief         Prefetch the table entries of a child before making its move, on by
+         default. Only meant for measuring the difference.
+         */
+        void                        setPrefetch(bool inIsEnabled)
+        { _isPrefetchEnabled = inIsEnabled; }
+
+        /**
+         @brief         Age the table at the start of every search, on by default
+
+         @discussion    Searches running at once on a shared table must leave it to their owner,
+         who calls TranspositionTable::newSearch() before starting them.
+         */
+        void                        setTableAging(bool inIsEnabled)
+        { _isTableAgingEnabled = inIsEnabled; }
+
+        /**
+         @brief         Make this search a helper of Lazy SMP, from 1 up, or the main search if 0
+
+         @discussion    A helper skips some of the iterations after the first, in a pattern of its
+         own, so that helpers sharing a table search at different depths and fill it with entries
+         the others can use. The main search skips none.
+         */
+        void                        setHelperIndex(int inIndex)
+        { _helperIndex = std::max(inIndex, 0); }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         @class          Arena
+
+         @brief          What the search works on from node to node, allocated with the search
+
+         @discussion     The moves of every ply live here rather than on the stack, which keeps the
+         recursion to a small frame per ply on threads with small stacks. Together with the vectors
+         of the search being reserved up front, nothing is allocated from the start of a search to
+         the copy of the lines into its result.
+         */
+        struct Arena
+        {
+            /**
+             @brief         Moves of the node at a ply and their ordering scores
+             */
+            struct Frame
+            {
+                MoveList            moves;
+                int                 scores[MoveList::kMaxMoves];
+            };
+
+            Frame                   frames[kMaxPly];
+
+            PackedMove              pv[kMaxPly][kMaxPly];
+            int                     pvLength[kMaxPly];
+
+            PackedMove              killers[kMaxPly][2];
+            int                     history[2][64][64];
+
+            /**
+             @brief         Lines of the iteration being searched and of the previous one, each
+             with room for a full principal variation, used in turns
+             */
+            SearchInfo              lines[2][MoveList::kMaxMoves];
+        };
+
+        int                         _alphaBeta(int inAlpha, int inBeta, int inDepth, int inPly,
+                                               bool inAllowNull);
+
+        int                         _quiescence(int inAlpha, int inBeta, int inPly);
+
+        /**
+         @brief         Score the moves for ordering, best first
+         */
+        void                        _scoreMoves(const MoveList & inMoves, PackedMove inTTMove,
+                                                int inPly, int * outScores) const;
+
+        /**
+         @brief         Move the best scored move from inIndex onwards to inIndex
+         */
+        static void                 _pickMove(MoveList * inOutMoves, int * inOutScores,
+                                              size_t inIndex);
+
+        void                        _updatePv(int inPly, PackedMove inMove);
+
+        void                        _updateQuietStats(PackedMove inMove, int inDepth, int inPly);
+
+        /**
+         @brief         Count a node, checking the limits every so many nodes
+         */
+        void                        _countNode()
+        {
+            if (++_stats.nodes >= _nextCheckNodes)
+            {
+                _checkLimits();
+            }
+        }
+
+        /**
+         @brief         Check the time and node limits, setting the stop flag if one is reached
+         */
+        void                        _checkLimits();
+
+        int64_t                     _getElapsedMs() const { return _getElapsedUs() / 1000; }
+
+        int64_t                     _getElapsedUs() const;
+
+        /**
+         @brief         Time counted against the limit, which starts at the ponder hit when
+         pondering
+         */
+        int64_t                     _getLimitElapsedUs() const;
+
+        /**
+         @brief         Check if a root move is searched in the current pass
+         */
+        bool                        _isSearchedRootMove(PackedMove inMove) const
+        {
+            return (_rootMoves.contains(inMove) &&
+                    (std::find(_excludedRootMoves.begin(), _excludedRootMoves.end(), inMove) ==
+                     _excludedRootMoves.end()));
+        }
+
+        /**
+         @brief         Score a position by the tablebases, if it is in them
+         */
+        bool                        _probeTablebases(int inPly, int * outScore);
+
+        /**
+         @brief         Rank of a root move among the lines of the previous iteration, -1 if it has
+         none
+         */
+        int                         _getRootLineRank(PackedMove inMove) const
+        {
+            auto it = std::find(_rootLineMoves.begin(), _rootLineMoves.end(), inMove);
+            return (it == _rootLineMoves.end()) ? -1 : static_cast<int>(it - _rootLineMoves.begin());
+        }
+
+        bool                        _isPondering() const
+        { return _limits.ponder && !_ponderHit.load(std::memory_order_acquire); }
+
+        /**
+         @brief         Set up ordering by the previous principal variation, if the root is on it
+         */
+        void                        _seedFromLastPv();
+
+        /**
+         @brief         Remember the principal variation and the keys of the positions along it
+         */
+        void                        _saveLastPv(const PackedMove * inPv, int inLength);
+
+        /**
+         @brief         Start loading the entries the child of a move will probe, so that the cache
+         misses overlap with making the move
+
+         @param     inIsTableProbed the child probes the transposition table, and not only the
+         pawn hash table
+         */
+        void                        _prefetchChild(PackedMove inMove, bool inIsTableProbed);
+
+        void                        _enterChild(int inPly, PackedMove inMove)
+        {
+            _onSeedPath[inPly + 1] = (_onSeedPath[inPly] && (inPly < _seedLength) &&
+                                      (inMove == _seedPv[inPly]));
+        }
+
+        /**
+         @brief         Check if the iteration of a depth is skipped, for a helper
+         */
+        bool                        _isSkippedDepth(int inDepth) const;
+
+        static int                  _toTTScore(int inScore, int inPly);
+        static int                  _fromTTScore(int inScore, int inPly);
+
+        ChessEngine                 _engine;
+        TranspositionTable *        _table;
+        const Tablebases *          _tablebases;
+        Evaluator                   _evaluator;
+        bool                        _isPrefetchEnabled;
+        bool                        _isTableAgingEnabled;
+        int                         _helperIndex;
+
+        SearchLimits                _limits;
+        TimeManager                 _timeManager;
+        SearchStats                 _stats;
+        uint64_t                    _nextCheckNodes;
+        Clock::time_point           _startTime;
+        int                         _selDepth;
+
+        std::atomic<bool>           _stop;
+        std::atomic<bool>           _ponderHit;
+        std::atomic<int64_t>        _ponderHitUs;
+
+        std::unique_ptr<Arena>      _arena;
+
+        std::vector<PackedMove>     _lastPv;
+        std::vector<ZobristKey>     _lastPvKeys;
+
+        /**
+         @brief         Root moves to search, all the legal ones unless the tablebases filtered them
+         */
+        MoveList                    _rootMoves;
+
+        /**
+         @brief         Root moves of the lines found by the earlier passes of this iteration, and
+         of all the lines of the previous iteration, best first
+         */
+        std::vector<PackedMove>     _excludedRootMoves;
+        std::vector<PackedMove>     _rootLineMoves;
+
+        PackedMove                  _seedPv[kMaxPly];
+        int                         _seedLength;
+        bool                        _onSeedPath[kMaxPly + 1];
+    };
+}
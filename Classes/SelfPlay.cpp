@@ -0,0 +1,236 @@
+/***************************************************************************************************
+ *
+ *  @file       SelfPlay.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Training data from games the engine plays against itself
+ *
+ **************************************************************************************************/
+
+#include "SelfPlay.h"
+
+#include "Search.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace chessEngine;
+
+/**
+ @brief         A position written once the result of its game is known
+ */
+struct GamePosition
+{
+    PackedPosition              position;
+    int16_t                     score;
+    bool                        isWhiteToMove;
+};
+
+/**
+ @brief         Play the random moves that open a game
+
+ @discussion    An opening that ends the game, or draws it by repetition, is played again.
+ */
+static void
+_playOpening(int inNumPlies, std::mt19937_64 * inOutRandom, ChessEngine * outPosition)
+{
+    int ply = 0;
+
+    outPosition->setFen(ChessEngine::kStartFen);
+
+    while (ply < inNumPlies)
+    {
+        MoveList moves;
+        outPosition->generateLegalMoves(&moves);
+
+        if (moves.isEmpty() || outPosition->isDraw())
+        {
+            outPosition->setFen(ChessEngine::kStartFen);
+            ply = 0;
+            continue;
+        }
+
+        outPosition->makeMove(moves[(*inOutRandom)() % moves.size]);
+        ply++;
+    }
+}
+
+/**
+ @brief         Play a game from the opening to its end
+
+ @return        1 if White won, 0 for a draw and -1 if Black won
+ */
+static int
+_playGame(uint64_t inGame, const SelfPlayOptions & inOptions, Search * inOutSearch,
+          TranspositionTable * inOutTable, ChessEngine * inOutPosition,
+          std::vector<GamePosition> * outPositions)
+{
+    std::mt19937_64 random(inOptions.seed ^ (inGame * 0x9E3779B97F4A7C15ULL));
+
+    outPositions->clear();
+    inOutTable->clear();
+    inOutSearch->clearHistory();
+
+    _playOpening(inOptions.numRandomPlies, &random, inOutPosition);
+
+    for (int ply = 0; ; ply++)
+    {
+        auto     isWhiteToMove = (inOutPosition->getCurrMove() == attributes::ChessColor::kWhite);
+        MoveList moves;
+
+        inOutPosition->generateLegalMoves(&moves);
+
+        if (moves.isEmpty())
+        {
+            // Mated, or stalemated
+            return !inOutPosition->isInCheck() ? 0 : (isWhiteToMove ? -1 : 1);
+        }
+
+        if (inOutPosition->isDraw() || (ply >= inOptions.maxPlies))
+        {
+            return 0;
+        }
+
+        auto         result = inOutSearch->run(*inOutPosition, inOptions.limits);
+        GamePosition position;
+
+        if (!inOutPosition->isInCheck() && (std::abs(result.score) < Search::kMateBound) &&
+            inOutPosition->getPackedPosition(&position.position))
+        {
+            position.score         = static_cast<int16_t>(result.score);
+            position.isWhiteToMove = isWhiteToMove;
+            outPositions->push_back(position);
+        }
+
+        inOutPosition->makeMove(result.bestMove);
+    }
+}
+
+static void
+_appendRecords(const std::vector<GamePosition> & inPositions, int inWhiteResult,
+               std::vector<uint8_t> * outData)
+{
+    outData->resize(inPositions.size() * SelfPlay::kRecordSize);
+
+    uint8_t * record = outData->data();
+
+    for (auto & position : inPositions)
+    {
+        auto score  = static_cast<uint16_t>(position.score);
+        auto result = position.isWhiteToMove ? inWhiteResult : -inWhiteResult;
+
+        std::copy(position.position.data.begin(), position.position.data.end(), record);
+        record[PackedPosition::kSize]     = static_cast<uint8_t>(score);
+        record[PackedPosition::kSize + 1] = static_cast<uint8_t>(score >> 8);
+        record[PackedPosition::kSize + 2] = static_cast<uint8_t>(static_cast<int8_t>(result));
+        record[PackedPosition::kSize + 3] = 0;
+        record += SelfPlay::kRecordSize;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark SelfPlay
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+SelfPlay::run(const std::string & inPath, const SelfPlayOptions & inOptions,
+              SelfPlayStats * outStats, const ProgressCallback & inOnProgress)
+{
+    FILE * file = fopen(inPath.c_str(), "wb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::atomic<uint64_t> nextGame(0);
+    std::atomic<bool>     isFailed(false);
+    std::mutex            fileMutex;
+    SelfPlayStats         stats;
+    uint64_t              numUnflushed = 0;
+
+    auto work = [&] {
+        TranspositionTable        table(inOptions.hashSizeMb);
+        Search                    search(&table);
+        ChessEngine               position;
+        std::vector<GamePosition> positions;
+        std::vector<uint8_t>      data;
+
+        for (auto game = nextGame++; (game < inOptions.numGames) && !isFailed; game = nextGame++)
+        {
+            int result = _playGame(game, inOptions, &search, &table, &position, &positions);
+
+            _appendRecords(positions, result, &data);
+
+            std::lock_guard<std::mutex> lock(fileMutex);
+
+            if (fwrite(data.data(), 1, data.size(), file) != data.size())
+            {
+                isFailed = true;
+                break;
+            }
+
+            // Flushing after a whole number of games leaves a file that can be read at any time
+            if (++numUnflushed >= inOptions.flushInterval)
+            {
+                isFailed     = isFailed || (fflush(file) != 0);
+                numUnflushed = 0;
+            }
+
+            stats.numGames++;
+            stats.numWhiteWins += (result > 0) ? 1 : 0;
+            stats.numDraws     += (result == 0) ? 1 : 0;
+            stats.numBlackWins += (result < 0) ? 1 : 0;
+            stats.numRecords   += positions.size();
+
+            if (inOnProgress)
+            {
+                inOnProgress(stats);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int i = 1; i < inOptions.numThreads; i++)
+    {
+        threads.emplace_back(work);
+    }
+
+    work();
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    if (outStats != nullptr)
+    {
+        *outStats = stats;
+    }
+
+    return (fclose(file) == 0) && !isFailed;
+}
+
+SelfPlayRecord
+SelfPlay::readRecord(const uint8_t * inData)
+{
+    SelfPlayRecord record;
+
+    std::copy(inData, inData + PackedPosition::kSize, record.position.data.begin());
+    record.score  = static_cast<int16_t>(inData[PackedPosition::kSize] |
+                                         (inData[PackedPosition::kSize + 1] << 8));
+    record.result = static_cast<int8_t>(inData[PackedPosition::kSize + 2]);
+
+    return record;
+}
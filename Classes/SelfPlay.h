@@ -0,0 +1,146 @@
+/***************************************************************************************************
+ *
+ *  @file       SelfPlay.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Training data from games the engine plays against itself
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "TimeManager.h"
+
+#include <functional>
+#include <string>
+
+namespace chessEngine
+{
+    /**
+     @class          SelfPlayOptions
+
+     @brief          What games are played, and how
+     */
+    struct SelfPlayOptions
+    {
+        uint64_t                    numGames;
+        int                         numThreads;
+
+        /**
+         @brief         Limits of the search of every move, a depth or a number of nodes so that
+         the games do not depend on the speed of the machine
+         */
+        SearchLimits                limits;
+
+        /**
+         @brief         Random moves at the start of every game, which are not written
+         */
+        int                         numRandomPlies;
+
+        /**
+         @brief         Games still going after this many plies are scored as draws
+         */
+        int                         maxPlies;
+
+        /**
+         @brief         Size of the table of every thread
+         */
+        size_t                      hashSizeMb;
+        uint64_t                    seed;
+
+        /**
+         @brief         Number of games after which the file is flushed
+         */
+        uint64_t                    flushInterval;
+
+        SelfPlayOptions() :
+        numGames(100), numThreads(1), numRandomPlies(8), maxPlies(400), hashSizeMb(16), seed(1),
+        flushInterval(64)
+        {
+            limits.nodes = 5000;
+        }
+    };
+
+    /**
+     @class          SelfPlayStats
+
+     @brief          Games played and records written so far
+     */
+    struct SelfPlayStats
+    {
+        uint64_t                    numGames;
+        uint64_t                    numWhiteWins;
+        uint64_t                    numDraws;
+        uint64_t                    numBlackWins;
+        uint64_t                    numRecords;
+
+        SelfPlayStats() :
+        numGames(0), numWhiteWins(0), numDraws(0), numBlackWins(0), numRecords(0)
+        { }
+    };
+
+    /**
+     @class          SelfPlayRecord
+
+     @brief          A position of a game, its search score and the result of the game, both for
+     the side to move
+     */
+    struct SelfPlayRecord
+    {
+        PackedPosition              position;
+        int16_t                     score;
+
+        /**
+         @brief         1 if the side to move won, 0 for a draw and -1 if it lost
+         */
+        int8_t                      result;
+    };
+
+    /**
+     @class          SelfPlay
+
+     @brief          Plays games of the engine against itself and writes their positions
+
+     @discussion     Every thread plays games with a search and a table of its own, cleared before
+     every game. A game starts with random moves, picked by a generator seeded with the seed and
+     the number of the game, so with node or depth limits every game is the same whatever the
+     number of threads. A game ends in mate, stalemate, a draw by ChessEngine::isDraw(), or as a
+     draw once it reaches the maximum number of plies.
+
+     Once a game is over, its positions after the random moves are appended to the file, unless
+     the side to move is in check or the score is a mate. The file is a plain sequence of records,
+     kRecordSize bytes each: the packed position, the score in 2 bytes little endian, the result
+     in 1 byte, and a byte of zero. As it has no header, whatever was flushed of an interrupted run
+     can be read, and files of several runs can be concatenated.
+     */
+    class SelfPlay
+    {
+    public:
+        static constexpr size_t     kRecordSize = PackedPosition::kSize + 4;
+
+        /**
+         @brief         Called after every game, on the thread that played it, one call at a time
+         */
+        using ProgressCallback = std::function<void(const SelfPlayStats &)>;
+
+        /**
+         @brief         Play the games, writing a new file
+
+         @param     outStats        games played and records written, may be null
+
+         @return        false if the file could not be written
+         */
+        static bool                 run(const std::string & inPath,
+                                        const SelfPlayOptions & inOptions,
+                                        SelfPlayStats * outStats = nullptr,
+                                        const ProgressCallback & inOnProgress = nullptr);
+
+        /**
+         @brief         Read a record of a file
+         */
+        static SelfPlayRecord       readRecord(const uint8_t * inData);
+    };
+}
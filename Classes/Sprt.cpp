@@ -0,0 +1,164 @@
+/***************************************************************************************************
+ *
+ *  @file       Sprt.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Sequential probability ratio test of a match
+ *
+ **************************************************************************************************/
+
+#include "Sprt.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace chessEngine;
+
+/**
+ @brief         Expected score of an Elo difference
+ */
+static double
+_getScore(double inElo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -inElo / 400.0));
+}
+
+/**
+ @brief         Elo difference of an expected score
+ */
+static double
+_getElo(double inScore)
+{
+    // A score of 0 or 1 would be infinite
+    double score = std::min(std::max(inScore, 1e-6), 1.0 - 1e-6);
+
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Sprt
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Sprt::Sprt(double inElo0, double inElo1, double inAlpha, double inBeta) :
+_elo0(inElo0), _elo1(inElo1), _alpha(inAlpha), _beta(inBeta), _pairs()
+{ }
+
+void
+Sprt::addPair(int inHalfPoints)
+{
+    _pairs[std::min(std::max(inHalfPoints, 0), kNumPairScores - 1)]++;
+}
+
+uint64_t
+Sprt::getNumPairs() const
+{
+    uint64_t numPairs = 0;
+
+    for (auto count : _pairs)
+    {
+        numPairs += count;
+    }
+
+    return numPairs;
+}
+
+double
+Sprt::getLlr() const
+{
+    double mean, variance;
+
+    // Until both sides have scored differently there is nothing to go by
+    if (!_getMoments(&mean, &variance) || (variance <= 0.0))
+    {
+        return 0.0;
+    }
+
+    double score0 = _getScore(_elo0);
+    double score1 = _getScore(_elo1);
+
+    return getNumPairs() * (score1 - score0) * (2.0 * mean - score0 - score1) / (2.0 * variance);
+}
+
+double
+Sprt::getLowerBound() const
+{
+    return std::log(_beta / (1.0 - _alpha));
+}
+
+double
+Sprt::getUpperBound() const
+{
+    return std::log((1.0 - _beta) / _alpha);
+}
+
+Sprt::Status
+Sprt::getStatus() const
+{
+    double llr = getLlr();
+
+    if (llr <= getLowerBound())
+    {
+        return Status::kAcceptH0;
+    }
+
+    return (llr >= getUpperBound()) ? Status::kAcceptH1 : Status::kContinue;
+}
+
+double
+Sprt::getElo(double * outError) const
+{
+    double mean, variance;
+
+    if (!_getMoments(&mean, &variance))
+    {
+        if (outError != nullptr)
+        {
+            *outError = 0.0;
+        }
+
+        return 0.0;
+    }
+
+    if (outError != nullptr)
+    {
+        double margin = 1.96 * std::sqrt(variance / getNumPairs());
+
+        *outError = (_getElo(mean + margin) - _getElo(mean - margin)) / 2.0;
+    }
+
+    return _getElo(mean);
+}
+
+bool
+Sprt::_getMoments(double * outMean, double * outVariance) const
+{
+    auto numPairs = getNumPairs();
+
+    if (numPairs == 0)
+    {
+        return false;
+    }
+
+    double mean     = 0.0;
+    double variance = 0.0;
+
+    for (int i = 0; i < kNumPairScores; i++)
+    {
+        mean += _pairs[i] * (i / 4.0);
+    }
+
+    mean /= numPairs;
+
+    for (int i = 0; i < kNumPairScores; i++)
+    {
+        variance += _pairs[i] * (i / 4.0 - mean) * (i / 4.0 - mean);
+    }
+
+    *outMean     = mean;
+    *outVariance = variance / numPairs;
+
+    return true;
+}
@@ -0,0 +1,95 @@
+/***************************************************************************************************
+ *
+ *  @file       Sprt.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Sequential probability ratio test of a match
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+
+#include <array>
+
+namespace chessEngine
+{
+    /**
+     @class          Sprt
+
+     @brief          Decides from the results of a match whether an engine is stronger than another
+
+     @discussion     The hypotheses are that the first engine is elo0 stronger (H0) or elo1
+     stronger (H1), in logistic Elo. The games are counted in pairs played from the same opening
+     with the colors swapped, by the points the first engine made in both, so that the bias of the
+     openings cancels out. The log likelihood ratio is the generalized one of a normal
+     approximation of the pair scores:
+
+     LLR = N (s1 - s0) (2 m - s0 - s1) / (2 v)
+
+     with N pairs of mean score m and variance v, and s0 and s1 the expected scores of the
+     hypotheses. H0 is accepted once it falls below log(beta / (1 - alpha)), H1 once it rises
+     above log((1 - beta) / alpha).
+     */
+    class Sprt
+    {
+    public:
+        enum class Status
+        {
+            kContinue,
+            kAcceptH0,
+            kAcceptH1
+        };
+
+        static constexpr int        kNumPairScores = 5;
+
+        Sprt(double inElo0 = 0.0, double inElo1 = 5.0, double inAlpha = 0.05,
+             double inBeta = 0.05);
+
+        /**
+         @brief         Add a pair of games
+
+         @param     inHalfPoints    points of the first engine in both games, in half points
+         from 0 to 4
+         */
+        void                        addPair(int inHalfPoints);
+
+        uint64_t                    getNumPairs() const;
+
+        /**
+         @brief         Number of pairs of each score, in half points
+         */
+        const std::array<uint64_t, kNumPairScores> & getPairs() const { return _pairs; }
+
+        double                      getLlr() const;
+
+        double                      getLowerBound() const;
+
+        double                      getUpperBound() const;
+
+        Status                      getStatus() const;
+
+        /**
+         @brief         Elo difference of the first engine to the second, from the mean score
+
+         @param     outError        half the width of the 95% confidence interval, may be null
+         */
+        double                      getElo(double * outError = nullptr) const;
+
+    private:
+        /**
+         @brief         Mean and variance of the pair scores, from 0 to 1
+
+         @return        false if there are no pairs
+         */
+        bool                        _getMoments(double * outMean, double * outVariance) const;
+
+        double                      _elo0;
+        double                      _elo1;
+        double                      _alpha;
+        double                      _beta;
+        std::array<uint64_t, kNumPairScores> _pairs;
+    };
+}
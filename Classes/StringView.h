@@ -0,0 +1,81 @@
+/***************************************************************************************************
+ *
+ *  @file       StringView.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      A view of characters owned by someone else
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+
+#include <cstring>
+#include <string>
+
+namespace chessEngine
+{
+    /**
+     @class          StringView
+
+     @brief          Characters that are not copied, e.g. of a mapped file
+
+     @discussion     The characters are not null terminated and have to outlive the view.
+     */
+    struct StringView
+    {
+        const char *                data;
+        size_t                      size;
+
+        StringView() :
+        data(nullptr), size(0)
+        { }
+
+        StringView(const char * inData, size_t inSize) :
+        data(inData), size(inSize)
+        { }
+
+        StringView(const char * inString) :
+        data(inString), size(strlen(inString))
+        { }
+
+        StringView(const std::string & inString) :
+        data(inString.data()), size(inString.size())
+        { }
+
+        bool                        isEmpty() const { return size == 0; }
+
+        char                        operator[] (size_t inIndex) const { return data[inIndex]; }
+
+        const char *                begin() const { return data; }
+
+        const char *                end() const { return data + size; }
+
+        char                        front() const { return data[0]; }
+
+        char                        back() const { return data[size - 1]; }
+
+        /**
+         @brief         View of at most inCount characters from inPos, which must not be past the
+         end
+         */
+        StringView                  substr(size_t inPos, size_t inCount = SIZE_MAX) const
+        { return StringView(data + inPos, (inCount < size - inPos) ? inCount : size - inPos); }
+
+        bool                        startsWith(StringView inPrefix) const
+        { return (size >= inPrefix.size) && (memcmp(data, inPrefix.data, inPrefix.size) == 0); }
+
+        std::string                 toString() const { return std::string(data, size); }
+
+        bool                        operator== (StringView inOther) const
+        {
+            return ((size == inOther.size) &&
+                    ((size == 0) || (memcmp(data, inOther.data, size) == 0)));
+        }
+
+        bool                        operator!= (StringView inOther) const
+        { return !(*this == inOther); }
+    };
+}
@@ -0,0 +1,1622 @@
+/***************************************************************************************************
+ *
+ *  @file       Tablebase.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Endgame tablebases
+ *
+ **************************************************************************************************/
+
+#include "Tablebase.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <cstdlib>
+
+using namespace chessEngine;
+
+static const char kTypeChars[TablebaseMaterial::kNumTypes] = { 'Q', 'R', 'B', 'N', 'P' };
+
+// Plies without zeroing after which either side may claim a draw
+static constexpr int kFiftyMovePlies = 100;
+
+static inline uint8_t
+_typeIndex(attributes::ChessPieceName inPiece)
+{
+    return static_cast<uint8_t>(inPiece);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark TablebaseMaterial
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const attributes::ChessPieceName TablebaseMaterial::kTypeOrder[TablebaseMaterial::kNumTypes] = {
+    attributes::ChessPieceName::kQueen,
+    attributes::ChessPieceName::kRook,
+    attributes::ChessPieceName::kBishop,
+    attributes::ChessPieceName::kKnight,
+    attributes::ChessPieceName::kPawn
+};
+
+TablebaseMaterial::TablebaseMaterial()
+{
+    memset(counts, 0, sizeof(counts));
+}
+
+TablebaseMaterial
+TablebaseMaterial::fromPosition(const ChessEngine & inPosition)
+{
+    TablebaseMaterial material;
+
+    for (auto type : kTypeOrder)
+    {
+        material.counts[0][_typeIndex(type)] =
+            inPosition.getPieces(attributes::ChessColor::kWhite, type).count();
+        material.counts[1][_typeIndex(type)] =
+            inPosition.getPieces(attributes::ChessColor::kBlack, type).count();
+    }
+
+    return material;
+}
+
+bool
+TablebaseMaterial::fromName(const std::string & inName, TablebaseMaterial * outMaterial)
+{
+    TablebaseMaterial material;
+    int               side = 0;
+    bool              isKingNext = true;
+
+    for (auto c : inName)
+    {
+        if (isKingNext)
+        {
+            if (c != 'K')
+            {
+                return false;
+            }
+
+            isKingNext = false;
+        }
+        else if ((c == 'v') && (side == 0))
+        {
+            side       = 1;
+            isKingNext = true;
+        }
+        else
+        {
+            auto found = std::find(kTypeChars, kTypeChars + kNumTypes, c);
+
+            if (found == kTypeChars + kNumTypes)
+            {
+                return false;
+            }
+
+            material.counts[side][_typeIndex(kTypeOrder[found - kTypeChars])]++;
+        }
+    }
+
+    if ((side != 1) || isKingNext || (material.getNumPieces() > Tablebases::kMaxPieces))
+    {
+        return false;
+    }
+
+    *outMaterial = material;
+    return true;
+}
+
+std::string
+TablebaseMaterial::getName() const
+{
+    std::string name;
+
+    for (int side = 0; side < 2; side++)
+    {
+        name += (side == 0) ? "K" : "vK";
+
+        for (int i = 0; i < kNumTypes; i++)
+        {
+            name.append(counts[side][_typeIndex(kTypeOrder[i])], kTypeChars[i]);
+        }
+    }
+
+    return name;
+}
+
+uint64_t
+TablebaseMaterial::getKey() const
+{
+    uint64_t key = 0;
+
+    for (int side = 0; side < 2; side++)
+    {
+        for (int type = 0; type < kNumTypes; type++)
+        {
+            key |= static_cast<uint64_t>(counts[side][type] & 0x0F) << ((side * kNumTypes + type) * 4);
+        }
+    }
+
+    return key;
+}
+
+TablebaseMaterial
+TablebaseMaterial::getFlipped() const
+{
+    TablebaseMaterial flipped;
+
+    memcpy(flipped.counts[0], counts[1], sizeof(counts[1]));
+    memcpy(flipped.counts[1], counts[0], sizeof(counts[0]));
+
+    return flipped;
+}
+
+int
+TablebaseMaterial::getNumPieces() const
+{
+    int numPieces = 2;
+
+    for (int side = 0; side < 2; side++)
+    {
+        for (int type = 0; type < kNumTypes; type++)
+        {
+            numPieces += counts[side][type];
+        }
+    }
+
+    return numPieces;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark TablebaseIndex
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static constexpr uint8_t kPawnCode          = 1;
+static constexpr uint8_t kSecondSideCode    = 8;
+
+/**
+ @brief         Ranks above the a1-h8 diagonal less files, 0 on it
+ */
+static inline int
+_getDiagonalOffset(int inSquare)
+{
+    return (inSquare >> 3) - (inSquare & 7);
+}
+
+static inline bool
+_isAdjacent(int inA, int inB)
+{
+    return ((abs((inA >> 3) - (inB >> 3)) <= 1) && (abs((inA & 7) - (inB & 7)) <= 1));
+}
+
+/**
+ @brief         Sorts a few squares or piece codes in place, by their value in the map if given
+ */
+static void
+_sortSquares(uint8_t * inOutBegin, uint8_t * inOutEnd, const int8_t * inMap)
+{
+    for (uint8_t * i = inOutBegin + 1; i < inOutEnd; i++)
+    {
+        uint8_t square = *i;
+        int     key    = inMap ? inMap[square] : square;
+        auto    j      = i;
+
+        for (; (j > inOutBegin) && ((inMap ? inMap[*(j - 1)] : *(j - 1)) > key); j--)
+        {
+            *j = *(j - 1);
+        }
+
+        *j = square;
+    }
+}
+
+/**
+ @brief         Maps of squares and binomials of the index, the same for every table
+ */
+struct IndexMaps
+{
+    /**
+     @brief         Squares below the a1-h8 diagonal, 0 to 27
+     */
+    int8_t                      belowDiagonal[64];
+
+    /**
+     @brief         Squares of the a1-d1-d4 triangle, 0 to 5 below the diagonal and 6 to 9 on it
+     */
+    int8_t                      triangle[64];
+
+    /**
+     @brief         Both kings by the triangle square of the first one, 0 to 461
+     */
+    int16_t                     kings[10][64];
+
+    /**
+     @brief         Pawn squares, 0 to 47, the highest nearest to the edge and then to rank 2
+     */
+    int8_t                      pawns[64];
+
+    uint64_t                    binomials[TablebaseIndex::kMaxPieces][64];
+
+    /**
+     @brief         Index of the leading pawns by their number and the square of the one leading
+     */
+    uint64_t                    leadingPawns[TablebaseIndex::kMaxPieces][64];
+
+    uint64_t                    leadingPawnSizes[TablebaseIndex::kMaxPieces][4];
+
+    IndexMaps();
+};
+
+IndexMaps::IndexMaps()
+{
+    memset(this, 0, sizeof(*this));
+
+    int code = 0;
+
+    for (int sq = 0; sq < 64; sq++)
+    {
+        if (_getDiagonalOffset(sq) < 0)
+        {
+            belowDiagonal[sq] = code++;
+        }
+    }
+
+    // The diagonal squares of the triangle come last
+    code = 0;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int sq = 0; sq <= 27; sq++)
+        {
+            if (((sq & 7) <= 3) && ((_getDiagonalOffset(sq) < 0) == (pass == 0)) &&
+                (_getDiagonalOffset(sq) <= 0))
+            {
+                triangle[sq] = code++;
+            }
+        }
+    }
+
+    // With the first king on the diagonal, the other one is not above it, and if both are on it
+    // they come last
+    code = 0;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            for (int first = 0; first <= 27; first++)
+            {
+                // b1 is the only square at 0
+                if ((triangle[first] != i) || ((i == 0) && (first != 1)))
+                {
+                    continue;
+                }
+
+                for (int second = 0; second < 64; second++)
+                {
+                    bool isFirstOnDiagonal = (_getDiagonalOffset(first) == 0);
+
+                    if (_isAdjacent(first, second) ||
+                        (isFirstOnDiagonal && (_getDiagonalOffset(second) > 0)))
+                    {
+                        continue;
+                    }
+
+                    bool isBothOnDiagonal = isFirstOnDiagonal && (_getDiagonalOffset(second) == 0);
+
+                    if (isBothOnDiagonal == (pass == 1))
+                    {
+                        kings[i][second] = code++;
+                    }
+                }
+            }
+        }
+    }
+
+    binomials[0][0] = 1;
+
+    for (int n = 1; n < 64; n++)
+    {
+        for (int k = 0; (k < TablebaseIndex::kMaxPieces) && (k <= n); k++)
+        {
+            binomials[k][n] = (((k > 0) ? binomials[k - 1][n - 1] : 0) +
+                               ((k < n) ? binomials[k][n - 1] : 0));
+        }
+    }
+
+    // Each rank of a file and of its mirror, from rank 2, one file after the other
+    int pawnCode = 47;
+
+    for (int numLeading = 1; numLeading < TablebaseIndex::kMaxPieces; numLeading++)
+    {
+        for (int file = 0; file < 4; file++)
+        {
+            uint64_t index = 0;
+
+            for (int rank = 1; rank <= 6; rank++)
+            {
+                int sq = rank * 8 + file;
+
+                if (numLeading == 1)
+                {
+                    pawns[sq]     = pawnCode--;
+                    pawns[sq ^ 7] = pawnCode--;
+                }
+
+                leadingPawns[numLeading][sq] = index;
+                index += binomials[numLeading - 1][pawns[sq]];
+            }
+
+            leadingPawnSizes[numLeading][file] = index;
+        }
+    }
+}
+
+static const IndexMaps &
+_getIndexMaps()
+{
+    static const IndexMaps sMaps;
+    return sMaps;
+}
+
+TablebaseIndex::TablebaseIndex() :
+numPieces(0), hasPawns(false), hasUniquePieces(false), hasPawnsOnBothSides(false)
+{
+    memset(pieces, 0, sizeof(pieces));
+    memset(groupLengths, 0, sizeof(groupLengths));
+    memset(groupFactors, 0, sizeof(groupFactors));
+}
+
+bool
+TablebaseIndex::init(const uint8_t * inPieces, int inNumPieces, const uint8_t inOrder[2],
+                     int inFile)
+{
+    auto & maps = _getIndexMaps();
+    int    counts[16] = { 0 };
+
+    numPieces = static_cast<uint8_t>(inNumPieces);
+    memcpy(pieces, inPieces, inNumPieces);
+
+    for (int i = 0; i < inNumPieces; i++)
+    {
+        counts[pieces[i] & 0x0F]++;
+    }
+
+    hasPawns            = (counts[kPawnCode] + counts[kSecondSideCode | kPawnCode]) > 0;
+    hasPawnsOnBothSides = (counts[kPawnCode] > 0) && (counts[kSecondSideCode | kPawnCode] > 0);
+    hasUniquePieces     = false;
+
+    for (int code = kPawnCode; code < 6; code++)
+    {
+        hasUniquePieces = (hasUniquePieces || (counts[code] == 1) ||
+                           (counts[kSecondSideCode | code] == 1));
+    }
+
+    // The first group is the kings and a unique piece, the kings, or the run of leading pawns
+    int firstLength = hasPawns ? 0 : (hasUniquePieces ? 3 : 2);
+    int numGroups   = 0;
+
+    groupLengths[0] = 1;
+
+    for (int i = 1; i < inNumPieces; i++)
+    {
+        if ((--firstLength > 0) || (pieces[i] == pieces[i - 1]))
+        {
+            groupLengths[numGroups]++;
+        }
+        else
+        {
+            groupLengths[++numGroups] = 1;
+        }
+    }
+
+    groupLengths[++numGroups] = 0;
+
+    // The order of the groups in the index is a parameter of the sub-table: the leading group,
+    // the pawns of the other side, and the others in turn fill in the places left
+    int      next        = hasPawnsOnBothSides ? 2 : 1;
+    int      freeSquares = 64 - groupLengths[0] - (hasPawnsOnBothSides ? groupLengths[1] : 0);
+    uint64_t factor      = 1;
+
+    for (int k = 0; (next < numGroups) || (k == inOrder[0]) || (k == inOrder[1]); k++)
+    {
+        if (k == inOrder[0])
+        {
+            groupFactors[0] = factor;
+            factor *= (hasPawns ? maps.leadingPawnSizes[groupLengths[0]][inFile] :
+                                  (hasUniquePieces ? 31332 : 462));
+        }
+        else if (k == inOrder[1])
+        {
+            groupFactors[1] = factor;
+            factor *= maps.binomials[groupLengths[1]][48 - groupLengths[0]];
+        }
+        else if (next < numGroups)
+        {
+            groupFactors[next] = factor;
+            factor *= maps.binomials[groupLengths[next]][freeSquares];
+            freeSquares -= groupLengths[next++];
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    groupFactors[numGroups] = factor;
+
+    return true;
+}
+
+uint64_t
+TablebaseIndex::getSize() const
+{
+    int group = 0;
+
+    while (groupLengths[group] != 0)
+    {
+        group++;
+    }
+
+    return groupFactors[group];
+}
+
+int
+TablebaseIndex::setLeadingPawns(uint8_t * inOutSquares, uint8_t * inOutPieces, int inNumPieces,
+                                uint8_t inLeadingPawn)
+{
+    auto & maps       = _getIndexMaps();
+    int    numLeading = 0;
+
+    for (int i = 0; i < inNumPieces; i++)
+    {
+        if (inOutPieces[i] == inLeadingPawn)
+        {
+            std::swap(inOutSquares[i], inOutSquares[numLeading]);
+            std::swap(inOutPieces[i], inOutPieces[numLeading]);
+            numLeading++;
+        }
+    }
+
+    int leader = 0;
+
+    for (int i = 1; i < numLeading; i++)
+    {
+        if (maps.pawns[inOutSquares[i]] > maps.pawns[inOutSquares[leader]])
+        {
+            leader = i;
+        }
+    }
+
+    std::swap(inOutSquares[0], inOutSquares[leader]);
+
+    int file = inOutSquares[0] & 7;
+
+    return std::min(file, 7 - file);
+}
+
+uint64_t
+TablebaseIndex::getIndex(uint8_t * inOutSquares, uint8_t * inOutPieces) const
+{
+    auto &    maps       = _getIndexMaps();
+    uint8_t * squares    = inOutSquares;
+    int       numLeading = hasPawns ? groupLengths[0] : 0;
+
+    // The pieces in the order of the sub-table
+    for (int i = numLeading; i < numPieces - 1; i++)
+    {
+        for (int j = i + 1; j < numPieces; j++)
+        {
+            if (inOutPieces[j] == pieces[i])
+            {
+                std::swap(squares[i], squares[j]);
+                std::swap(inOutPieces[i], inOutPieces[j]);
+                break;
+            }
+        }
+    }
+
+    // The first piece on the files a to d
+    if ((squares[0] & 7) > 3)
+    {
+        for (int i = 0; i < numPieces; i++)
+        {
+            squares[i] ^= 7;
+        }
+    }
+
+    uint64_t index;
+
+    if (hasPawns)
+    {
+        index = maps.leadingPawns[numLeading][squares[0]];
+
+        _sortSquares(squares + 1, squares + numLeading, maps.pawns);
+
+        for (int i = 1; i < numLeading; i++)
+        {
+            index += maps.binomials[i][maps.pawns[squares[i]]];
+        }
+    }
+    else
+    {
+        // Without pawns, also on the ranks 1 to 4, and the first piece of the first group off the
+        // a1-h8 diagonal below it
+        if ((squares[0] >> 3) > 3)
+        {
+            for (int i = 0; i < numPieces; i++)
+            {
+                squares[i] ^= 56;
+            }
+        }
+
+        for (int i = 0; i < groupLengths[0]; i++)
+        {
+            int offset = _getDiagonalOffset(squares[i]);
+
+            if (offset == 0)
+            {
+                continue;
+            }
+
+            if (offset > 0)
+            {
+                for (int j = i; j < numPieces; j++)
+                {
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+            }
+
+            break;
+        }
+
+        if (hasUniquePieces)
+        {
+            // Each of the three pieces on the squares left by the ones before, and fewer squares
+            // for the ones after a piece on the diagonal
+            int adjust1 = (squares[1] > squares[0]);
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+            if (_getDiagonalOffset(squares[0]) != 0)
+            {
+                index = ((maps.triangle[squares[0]] * 63 + (squares[1] - adjust1)) * 62 +
+                         squares[2] - adjust2);
+            }
+            else if (_getDiagonalOffset(squares[1]) != 0)
+            {
+                index = ((6 * 63 + (squares[0] >> 3) * 28 + maps.belowDiagonal[squares[1]]) * 62 +
+                         squares[2] - adjust2);
+            }
+            else if (_getDiagonalOffset(squares[2]) != 0)
+            {
+                index = (6 * 63 * 62 + 4 * 28 * 62 + (squares[0] >> 3) * 7 * 28 +
+                         ((squares[1] >> 3) - adjust1) * 28 + maps.belowDiagonal[squares[2]]);
+            }
+            else
+            {
+                index = (6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + (squares[0] >> 3) * 7 * 6 +
+                         ((squares[1] >> 3) - adjust1) * 6 + ((squares[2] >> 3) - adjust2));
+            }
+        }
+        else
+        {
+            index = maps.kings[maps.triangle[squares[0]]][squares[1]];
+        }
+    }
+
+    index *= groupFactors[0];
+
+    // The other groups, each piece on the squares that the groups before leave, and the pawns of
+    // the other side on the ranks 2 to 7
+    int  start        = groupLengths[0];
+    bool isOtherPawns = hasPawnsOnBothSides;
+
+    for (int group = 1; groupLengths[group] != 0; group++)
+    {
+        int      end = start + groupLengths[group];
+        uint64_t n   = 0;
+
+        _sortSquares(squares + start, squares + end, nullptr);
+
+        for (int i = start; i < end; i++)
+        {
+            int adjust = 0;
+
+            for (int j = 0; j < start; j++)
+            {
+                adjust += (squares[i] > squares[j]);
+            }
+
+            n += maps.binomials[i - start + 1][squares[i] - adjust - (isOtherPawns ? 8 : 0)];
+        }
+
+        isOtherPawns = false;
+        index       += n * groupFactors[group];
+        start        = end;
+    }
+
+    return index;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Tablebases
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char * const  Tablebases::kWdlSuffix   = ".rtbw";
+const char * const  Tablebases::kDtzSuffix   = ".rtbz";
+const uint8_t       Tablebases::kWdlMagic[4] = { 0x71, 0xE8, 0x23, 0x5D };
+const uint8_t       Tablebases::kDtzMagic[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+static inline uint16_t
+_readLe16(const uint8_t * inData)
+{
+    return static_cast<uint16_t>(inData[0] | (inData[1] << 8));
+}
+
+static inline uint32_t
+_readLe32(const uint8_t * inData)
+{
+    return (static_cast<uint32_t>(inData[0]) | (static_cast<uint32_t>(inData[1]) << 8) |
+            (static_cast<uint32_t>(inData[2]) << 16) | (static_cast<uint32_t>(inData[3]) << 24));
+}
+
+static inline uint32_t
+_readBe32(const uint8_t * inData)
+{
+    return ((static_cast<uint32_t>(inData[0]) << 24) | (static_cast<uint32_t>(inData[1]) << 16) |
+            (static_cast<uint32_t>(inData[2]) << 8) | static_cast<uint32_t>(inData[3]));
+}
+
+/**
+ @brief         Left hand symbol of a pair, or the value of a symbol that is not one
+ */
+static inline int
+_getLeftSymbol(const uint8_t * inPairs, int inSymbol)
+{
+    auto pair = inPairs + 3 * inSymbol;
+    return ((pair[1] & 0x0F) << 8) | pair[0];
+}
+
+/**
+ @brief         Right hand symbol of a pair, 0xFFF for a symbol that is not one
+ */
+static inline int
+_getRightSymbol(const uint8_t * inPairs, int inSymbol)
+{
+    auto pair = inPairs + 3 * inSymbol;
+    return (pair[2] << 4) | (pair[1] >> 4);
+}
+
+/**
+ @brief         Number of values of a symbol less one, which pairs up two others recursively
+ */
+static int
+_getSymbolLength(const uint8_t * inPairs, int inSymbol, std::vector<uint8_t> * inOutLengths,
+                 std::vector<bool> * inOutVisited)
+{
+    (*inOutVisited)[inSymbol] = true;
+
+    int right = _getRightSymbol(inPairs, inSymbol);
+    int left  = _getLeftSymbol(inPairs, inSymbol);
+
+    if ((right == 0xFFF) || (right >= static_cast<int>(inOutLengths->size())) ||
+        (left >= static_cast<int>(inOutLengths->size())))
+    {
+        return 0;
+    }
+
+    for (int child : { left, right })
+    {
+        if (!(*inOutVisited)[child])
+        {
+            (*inOutLengths)[child] = static_cast<uint8_t>(_getSymbolLength(inPairs, child,
+                                                                           inOutLengths,
+                                                                           inOutVisited));
+        }
+    }
+
+    return (*inOutLengths)[left] + (*inOutLengths)[right] + 1;
+}
+
+/**
+ @brief         Plies of a win or loss whose best move zeroes, which the DTZ file does not have
+ */
+static int
+_getDtzBeforeZeroing(Tablebases::Wdl inWdl)
+{
+    switch (inWdl)
+    {
+        case Tablebases::kWin:          return 1;
+        case Tablebases::kCursedWin:    return 101;
+        case Tablebases::kBlessedLoss:  return -101;
+        case Tablebases::kLoss:         return -1;
+        default:                        return 0;
+    }
+}
+
+static inline int
+_getSign(int inValue)
+{
+    return (inValue > 0) - (inValue < 0);
+}
+
+static bool
+_isZeroing(const ChessEngine & inPosition, PackedMove inMove)
+{
+    attributes::ChessColor     color;
+    attributes::ChessPieceName piece = attributes::ChessPieceName::kKing;
+
+    inPosition.getPieceAt(inMove.getSrc(), &color, &piece);
+
+    return inMove.isCapture() || (piece == attributes::ChessPieceName::kPawn);
+}
+
+/**
+ @brief         Every material with up to so many pieces more than the kings
+ */
+static void
+_enumerateMaterials(int inSlot, int inPiecesLeft, TablebaseMaterial * inOutMaterial,
+                    std::vector<TablebaseMaterial> * outMaterials)
+{
+    if (inSlot == 2 * TablebaseMaterial::kNumTypes)
+    {
+        if (inOutMaterial->getNumPieces() > 2)
+        {
+            outMaterials->push_back(*inOutMaterial);
+        }
+
+        return;
+    }
+
+    auto & count = inOutMaterial->counts[inSlot / TablebaseMaterial::kNumTypes]
+                                        [inSlot % TablebaseMaterial::kNumTypes];
+
+    for (int n = 0; n <= inPiecesLeft; n++)
+    {
+        count = n;
+        _enumerateMaterials(inSlot + 1, inPiecesLeft - n, inOutMaterial, outMaterials);
+    }
+
+    count = 0;
+}
+
+Tablebases::Tablebases() :
+_maxPieces(0)
+{ }
+
+size_t
+Tablebases::load(const std::string & inDirectory)
+{
+    clear();
+
+    std::vector<TablebaseMaterial> materials;
+    TablebaseMaterial              material;
+
+    _enumerateMaterials(0, kMaxPieces - 2, &material, &materials);
+
+    for (const auto & candidate : materials)
+    {
+        _loadTable(inDirectory, candidate);
+    }
+
+    std::sort(_tables.begin(), _tables.end(), [] (const Table & inA, const Table & inB) {
+        return inA.key < inB.key;
+    });
+
+    return _tables.size();
+}
+
+void
+Tablebases::clear()
+{
+    _tables.clear();
+    _maxPieces = 0;
+}
+
+bool
+Tablebases::_loadTable(const std::string & inDirectory, const TablebaseMaterial & inMaterial)
+{
+    std::string path = inDirectory;
+
+    if (!path.empty() && (path.back() != '/'))
+    {
+        path += '/';
+    }
+
+    path += inMaterial.getName();
+
+    Table table = Table();
+    table.key         = inMaterial.getKey();
+    table.material    = inMaterial;
+    table.isSymmetric = (inMaterial.getFlipped().getKey() == table.key);
+
+    if (!table.wdl.file.open(path + kWdlSuffix, true) || !_initFile(table, true, &table.wdl))
+    {
+        return false;
+    }
+
+    // The DTZ file is optional, it is only needed at the root and with a running clock
+    if (table.dtz.file.open(path + kDtzSuffix, true) && !_initFile(table, false, &table.dtz))
+    {
+        table.dtz.file.close();
+    }
+
+    _maxPieces = std::max(_maxPieces, inMaterial.getNumPieces());
+    _tables.push_back(std::move(table));
+
+    return true;
+}
+
+bool
+Tablebases::_initFile(const Table & inTable, bool inIsWdl, TableFile * inOutFile)
+{
+    const auto & file  = inOutFile->file;
+    auto         data  = file.getData();
+    auto         size  = file.getSize();
+    auto         magic = inIsWdl ? kWdlMagic : kDtzMagic;
+
+    // The blocks are 64 byte aligned and followed by a 16 byte checksum
+    if ((size < 64) || ((size % 64) != 16) || (memcmp(data, magic, 4) != 0))
+    {
+        return false;
+    }
+
+    const auto & counts    = inTable.material.counts;
+    uint8_t      pawn      = _typeIndex(attributes::ChessPieceName::kPawn);
+    bool         hasPawns  = (counts[0][pawn] + counts[1][pawn]) > 0;
+    bool         bothPawns = (counts[0][pawn] > 0) && (counts[1][pawn] > 0);
+    int          numPieces = inTable.material.getNumPieces();
+    int          numFiles  = hasPawns ? 4 : 1;
+    int          numSides  = (inIsWdl && !inTable.isSymmetric) ? 2 : 1;
+    size_t       offset    = 4;
+
+    if (((data[offset++] & kHasPawns) != 0) != hasPawns)
+    {
+        return false;
+    }
+
+    // Every sub-table has the pieces of the material, in an order of its own
+    uint8_t expected[kMaxPieces];
+    int     numExpected = 0;
+
+    for (int side = 0; side < 2; side++)
+    {
+        uint8_t sideCode = side ? kSecondSideCode : 0;
+
+        expected[numExpected++] = sideCode | (_typeIndex(attributes::ChessPieceName::kKing) + 1);
+
+        for (int type = 0; type < TablebaseMaterial::kNumTypes; type++)
+        {
+            for (int i = 0; i < counts[side][type]; i++)
+            {
+                expected[numExpected++] = sideCode | (type + 1);
+            }
+        }
+    }
+
+    _sortSquares(expected, expected + numExpected, nullptr);
+
+    for (int tbFile = 0; tbFile < numFiles; tbFile++)
+    {
+        if (offset + 1 + bothPawns + numPieces > size)
+        {
+            return false;
+        }
+
+        uint8_t orders[2][2] = {
+            { static_cast<uint8_t>(data[offset] & 0x0F),
+              static_cast<uint8_t>(bothPawns ? (data[offset + 1] & 0x0F) : 0x0F) },
+            { static_cast<uint8_t>(data[offset] >> 4),
+              static_cast<uint8_t>(bothPawns ? (data[offset + 1] >> 4) : 0x0F) }
+        };
+
+        offset += 1 + bothPawns;
+
+        for (int side = 0; side < numSides; side++)
+        {
+            uint8_t pieces[kMaxPieces];
+            uint8_t sorted[kMaxPieces];
+
+            for (int i = 0; i < numPieces; i++)
+            {
+                pieces[i] = side ? (data[offset + i] >> 4) : (data[offset + i] & 0x0F);
+                sorted[i] = pieces[i];
+            }
+
+            _sortSquares(sorted, sorted + numPieces, nullptr);
+
+            if ((memcmp(sorted, expected, numPieces) != 0) ||
+                !inOutFile->subTables[side][tbFile].index.init(pieces, numPieces, orders[side],
+                                                               tbFile))
+            {
+                return false;
+            }
+        }
+
+        offset += numPieces;
+    }
+
+    offset += offset & 1;
+
+    for (int tbFile = 0; tbFile < numFiles; tbFile++)
+    {
+        for (int side = 0; side < numSides; side++)
+        {
+            if (!_initSizes(file, &offset, &inOutFile->subTables[side][tbFile]))
+            {
+                return false;
+            }
+        }
+    }
+
+    // The DTZ maps of the sub-tables whose values are indices into them, 4 lists each for the
+    // win, loss, cursed win and blessed loss
+    if (!inIsWdl)
+    {
+        size_t mapOffset = offset;
+
+        inOutFile->map = data + mapOffset;
+
+        for (int tbFile = 0; tbFile < numFiles; tbFile++)
+        {
+            auto & subTable = inOutFile->subTables[0][tbFile];
+
+            if (!(subTable.flags & kMapped))
+            {
+                continue;
+            }
+
+            bool isWide = (subTable.flags & kWideMap) != 0;
+
+            offset += isWide ? (offset & 1) : 0;
+
+            for (int i = 0; i < 4; i++)
+            {
+                if (offset + 2 > size)
+                {
+                    return false;
+                }
+
+                subTable.mapStarts[i] = static_cast<uint16_t>(
+                    (isWide ? ((offset - mapOffset) / 2) : (offset - mapOffset)) + 1);
+                offset += isWide ? (2 * _readLe16(data + offset) + 2) : (data[offset] + 1);
+            }
+        }
+
+        offset += offset & 1;
+    }
+
+    for (int tbFile = 0; tbFile < numFiles; tbFile++)
+    {
+        for (int side = 0; side < numSides; side++)
+        {
+            auto & subTable = inOutFile->subTables[side][tbFile];
+
+            subTable.sparseIndex = data + offset;
+            offset += 6 * subTable.numSparseEntries;
+        }
+    }
+
+    for (int tbFile = 0; tbFile < numFiles; tbFile++)
+    {
+        for (int side = 0; side < numSides; side++)
+        {
+            auto & subTable = inOutFile->subTables[side][tbFile];
+
+            subTable.blockLengths = data + offset;
+            offset += 2 * subTable.numBlockLengths;
+        }
+    }
+
+    for (int tbFile = 0; tbFile < numFiles; tbFile++)
+    {
+        for (int side = 0; side < numSides; side++)
+        {
+            auto & subTable = inOutFile->subTables[side][tbFile];
+
+            offset = (offset + 63) & ~static_cast<size_t>(63);
+
+            subTable.data = data + offset;
+            offset += subTable.numBlocks * subTable.blockSize;
+        }
+    }
+
+    return (offset <= size);
+}
+
+bool
+Tablebases::_initSizes(const MappedFile & inFile, size_t * inOutOffset, SubTable * outSubTable)
+{
+    auto   data     = inFile.getData();
+    auto   size     = inFile.getSize();
+    auto   offset   = *inOutOffset;
+    auto & subTable = *outSubTable;
+
+    if (offset + 2 > size)
+    {
+        return false;
+    }
+
+    subTable.flags = data[offset++];
+
+    if (subTable.flags & kSingleValue)
+    {
+        subTable.singleValue      = data[offset++];
+        subTable.numBlocks        = 0;
+        subTable.numSparseEntries = 0;
+        subTable.numBlockLengths  = 0;
+        *inOutOffset = offset;
+        return true;
+    }
+
+    if ((offset + 10 > size) || (data[offset] > 24) || (data[offset + 1] > 30))
+    {
+        return false;
+    }
+
+    subTable.blockSize        = static_cast<size_t>(1) << data[offset++];
+    subTable.span             = static_cast<uint64_t>(1) << data[offset++];
+    subTable.numSparseEntries = (subTable.index.getSize() + subTable.span - 1) / subTable.span;
+
+    int padding = data[offset++];
+
+    subTable.numBlocks       = _readLe32(data + offset);
+    offset += 4;
+    subTable.numBlockLengths = subTable.numBlocks + padding;
+    subTable.maxLength       = data[offset++];
+    subTable.minLength       = data[offset++];
+    subTable.lowestSymbols   = data + offset;
+
+    if ((subTable.minLength == 0) || (subTable.maxLength < subTable.minLength) ||
+        (subTable.maxLength > 32))
+    {
+        return false;
+    }
+
+    int numLengths = subTable.maxLength - subTable.minLength + 1;
+
+    if (offset + 2 * numLengths + 2 > size)
+    {
+        return false;
+    }
+
+    // Canonical Huffman codes, the longer ones with the lower values: each length starts where the
+    // codes of the next one end, at half the value. The symbols of a length are consecutive from
+    // the lowest one, which is stored.
+    subTable.codeBases.assign(numLengths, 0);
+
+    for (int i = numLengths - 2; i >= 0; i--)
+    {
+        int64_t numLonger = (static_cast<int64_t>(_readLe16(subTable.lowestSymbols + 2 * i)) -
+                             _readLe16(subTable.lowestSymbols + 2 * (i + 1)));
+
+        subTable.codeBases[i] = (subTable.codeBases[i + 1] + numLonger) / 2;
+    }
+
+    for (int i = 0; i < numLengths; i++)
+    {
+        subTable.codeBases[i] <<= 64 - i - subTable.minLength;
+    }
+
+    offset += 2 * numLengths;
+
+    int numSymbols = _readLe16(data + offset);
+    offset += 2;
+
+    if (offset + 3 * numSymbols > size)
+    {
+        return false;
+    }
+
+    subTable.pairs = data + offset;
+    subTable.symbolLengths.assign(numSymbols, 0);
+
+    std::vector<bool> isVisited(numSymbols, false);
+
+    for (int symbol = 0; symbol < numSymbols; symbol++)
+    {
+        if (!isVisited[symbol])
+        {
+            subTable.symbolLengths[symbol] = static_cast<uint8_t>(
+                _getSymbolLength(subTable.pairs, symbol, &subTable.symbolLengths, &isVisited));
+        }
+    }
+
+    *inOutOffset = offset + 3 * numSymbols + (numSymbols & 1);
+
+    return true;
+}
+
+const Tablebases::Table *
+Tablebases::_find(const ChessEngine & inPosition, bool * outIsFlipped) const
+{
+    auto material = TablebaseMaterial::fromPosition(inPosition);
+
+    for (int flip = 0; flip < 2; flip++)
+    {
+        auto key   = flip ? material.getFlipped().getKey() : material.getKey();
+        auto found = std::lower_bound(_tables.begin(), _tables.end(), key,
+                                      [] (const Table & inTable, uint64_t inKey) {
+            return inTable.key < inKey;
+        });
+
+        if ((found != _tables.end()) && (found->key == key))
+        {
+            *outIsFlipped = (flip != 0);
+            return &*found;
+        }
+    }
+
+    return nullptr;
+}
+
+int
+Tablebases::_decompress(const SubTable & inSubTable, uint64_t inIndex)
+{
+    if (inSubTable.flags & kSingleValue)
+    {
+        return inSubTable.singleValue;
+    }
+
+    // The sparse index has the block and the offset in it of the value in the middle of each span,
+    // from which the block lengths lead to the one of the index
+    auto     entry  = inSubTable.sparseIndex + 6 * (inIndex / inSubTable.span);
+    uint32_t block  = _readLe32(entry);
+    int      offset = (_readLe16(entry + 4) + static_cast<int>(inIndex % inSubTable.span) -
+                       static_cast<int>(inSubTable.span / 2));
+
+    while (offset < 0)
+    {
+        offset += _readLe16(inSubTable.blockLengths + 2 * --block) + 1;
+    }
+
+    while (offset > _readLe16(inSubTable.blockLengths + 2 * block))
+    {
+        offset -= _readLe16(inSubTable.blockLengths + 2 * block++) + 1;
+    }
+
+    // Symbols are decoded from the start of the block, up to the one that has the offset
+    auto     next    = inSubTable.data + static_cast<size_t>(block) * inSubTable.blockSize;
+    uint64_t bits    = (static_cast<uint64_t>(_readBe32(next)) << 32) | _readBe32(next + 4);
+    int      numBits = 64;
+    int      symbol;
+
+    next += 8;
+
+    for ( ; ; )
+    {
+        int length = 0;
+
+        while (bits < inSubTable.codeBases[length])
+        {
+            length++;
+        }
+
+        symbol  = static_cast<int>((bits - inSubTable.codeBases[length]) >>
+                                   (64 - length - inSubTable.minLength));
+        symbol += _readLe16(inSubTable.lowestSymbols + 2 * length);
+
+        if (offset <= inSubTable.symbolLengths[symbol])
+        {
+            break;
+        }
+
+        offset  -= inSubTable.symbolLengths[symbol] + 1;
+        length  += inSubTable.minLength;
+        bits   <<= length;
+        numBits -= length;
+
+        if (numBits <= 32)
+        {
+            numBits += 32;
+            bits    |= static_cast<uint64_t>(_readBe32(next)) << (64 - numBits);
+            next    += 4;
+        }
+    }
+
+    // The symbol pairs up two others, the values of the left one first
+    while (inSubTable.symbolLengths[symbol] != 0)
+    {
+        int left = _getLeftSymbol(inSubTable.pairs, symbol);
+
+        if (offset <= inSubTable.symbolLengths[left])
+        {
+            symbol = left;
+        }
+        else
+        {
+            offset -= inSubTable.symbolLengths[left] + 1;
+            symbol  = _getRightSymbol(inSubTable.pairs, symbol);
+        }
+    }
+
+    return _getLeftSymbol(inSubTable.pairs, symbol);
+}
+
+int
+Tablebases::_probeTable(const ChessEngine & inPosition, bool inIsDtz, Wdl inWdl,
+                        ProbeState * outState) const
+{
+    // Bare kings
+    if (inPosition.getOccupied().count() == 2)
+    {
+        return kDraw;
+    }
+
+    bool isFlipped;
+    auto table = _find(inPosition, &isFlipped);
+
+    if ((table == nullptr) || (inIsDtz && !table->dtz.file.isOpen()))
+    {
+        *outState = kProbeFailed;
+        return 0;
+    }
+
+    const auto & file          = inIsDtz ? table->dtz : table->wdl;
+    const auto & firstIndex    = file.subTables[0][0].index;
+    bool         isBlackToMove = (inPosition.getCurrMove() == attributes::ChessColor::kBlack);
+
+    // With the same pieces on both sides, the tables only have the first side to move
+    isFlipped = isFlipped || (table->isSymmetric && isBlackToMove);
+
+    int     side   = (isFlipped != isBlackToMove) ? 1 : 0;
+    uint8_t mirror = isFlipped ? 56 : 0;
+    uint8_t squares[kMaxPieces];
+    uint8_t pieces[kMaxPieces];
+    int     numPieces = 0;
+
+    for (auto color : { attributes::ChessColor::kWhite, attributes::ChessColor::kBlack })
+    {
+        bool    isFirstSide = ((color == attributes::ChessColor::kWhite) != isFlipped);
+        uint8_t sideCode    = isFirstSide ? 0 : kSecondSideCode;
+
+        for (int type = 0; type <= _typeIndex(attributes::ChessPieceName::kKing); type++)
+        {
+            auto piece = static_cast<attributes::ChessPieceName>(type);
+
+            for (auto sq : inPosition.getPieces(color, piece))
+            {
+                squares[numPieces]  = sq.index ^ mirror;
+                pieces[numPieces++] = sideCode | (type + 1);
+            }
+        }
+    }
+
+    int tbFile = 0;
+
+    if (firstIndex.hasPawns)
+    {
+        tbFile = TablebaseIndex::setLeadingPawns(squares, pieces, numPieces, firstIndex.pieces[0]);
+    }
+
+    if (!inIsDtz)
+    {
+        const auto & subTable = file.subTables[table->isSymmetric ? 0 : side][tbFile];
+        return _decompress(subTable, subTable.index.getIndex(squares, pieces)) + kLoss;
+    }
+
+    // A DTZ file only has one side to move, the other is searched
+    const auto & subTable = file.subTables[0][tbFile];
+
+    if (((subTable.flags & kSideToMove) != side) && !(table->isSymmetric && !firstIndex.hasPawns))
+    {
+        *outState = kProbeOtherSide;
+        return 0;
+    }
+
+    int value = _decompress(subTable, subTable.index.getIndex(squares, pieces));
+
+    // Mapped values are indices into the list of the outcome
+    if (subTable.flags & kMapped)
+    {
+        static const int kMapLists[kWin - kLoss + 1] = { 1, 3, 0, 2, 0 };
+
+        int start = subTable.mapStarts[kMapLists[inWdl - kLoss]];
+
+        value = ((subTable.flags & kWideMap) ? _readLe16(file.map + 2 * (start + value)) :
+                                               file.map[start + value]);
+    }
+
+    // Values are in moves unless the flags tell plies, and always are for cursed wins and blessed
+    // losses
+    if (((inWdl == kWin) && !(subTable.flags & kWinPlies)) ||
+        ((inWdl == kLoss) && !(subTable.flags & kLossPlies)) ||
+        (inWdl == kCursedWin) || (inWdl == kBlessedLoss))
+    {
+        value *= 2;
+    }
+
+    return value + 1;
+}
+
+Tablebases::Wdl
+Tablebases::_searchWdl(ChessEngine & inPosition, bool inHasPawnMoves, ProbeState * outState) const
+{
+    MoveList moves;
+    Wdl      best        = kLoss;
+    size_t   numSearched = 0;
+
+    inPosition.generateLegalMoves(&moves);
+
+    for (auto move : moves)
+    {
+        if (!(inHasPawnMoves ? _isZeroing(inPosition, move) : move.isCapture()))
+        {
+            continue;
+        }
+
+        numSearched++;
+
+        inPosition.makeMove(move);
+        auto value = static_cast<Wdl>(-_searchWdl(inPosition, false, outState));
+        inPosition.unmakeMove();
+
+        if (*outState == kProbeFailed)
+        {
+            return kDraw;
+        }
+
+        if (value > best)
+        {
+            best = value;
+
+            if (value == kWin)
+            {
+                *outState = kProbeZeroing;
+                return value;
+            }
+        }
+    }
+
+    // With every move searched the table is not needed. It may be wrong then, as it leaves out
+    // en passant captures.
+    bool isAllSearched = (numSearched > 0) && (numSearched == moves.size);
+    Wdl  value         = best;
+
+    if (!isAllSearched)
+    {
+        value = static_cast<Wdl>(_probeTable(inPosition, false, kDraw, outState));
+
+        if (*outState == kProbeFailed)
+        {
+            return kDraw;
+        }
+    }
+
+    // The table stores any value where a capture is the best move
+    if (best >= value)
+    {
+        *outState = ((best > kDraw) || isAllSearched) ? kProbeZeroing : kProbeOk;
+        return best;
+    }
+
+    *outState = kProbeOk;
+    return value;
+}
+
+int
+Tablebases::_probeDtz(ChessEngine & inPosition, ProbeState * outState) const
+{
+    auto wdl = _searchWdl(inPosition, true, outState);
+
+    if ((*outState == kProbeFailed) || (wdl == kDraw))
+    {
+        return 0;
+    }
+
+    // A capture or pawn move wins, which the DTZ file does not count
+    if (*outState == kProbeZeroing)
+    {
+        return _getDtzBeforeZeroing(wdl);
+    }
+
+    int dtz = _probeTable(inPosition, true, wdl, outState);
+
+    if (*outState == kProbeFailed)
+    {
+        return 0;
+    }
+
+    if (*outState != kProbeOtherSide)
+    {
+        bool isCursed = (wdl == kCursedWin) || (wdl == kBlessedLoss);
+        return (dtz + (isCursed ? kFiftyMovePlies : 0)) * _getSign(wdl);
+    }
+
+    // The file has the other side to move: the best move of the same outcome, one ply more
+    MoveList moves;
+    int      best = INT_MAX;
+
+    *outState = kProbeOk;
+    inPosition.generateLegalMoves(&moves);
+
+    for (auto move : moves)
+    {
+        bool isZeroing = _isZeroing(inPosition, move);
+
+        inPosition.makeMove(move);
+
+        // After a zeroing move only the outcome counts
+        int value = (isZeroing ? -_getDtzBeforeZeroing(_searchWdl(inPosition, false, outState)) :
+                                 -_probeDtz(inPosition, outState));
+
+        if ((value == 1) && inPosition.isInCheck())
+        {
+            MoveList replies;
+            inPosition.generateLegalMoves(&replies);
+
+            // Mate
+            if (replies.isEmpty())
+            {
+                best = 1;
+            }
+        }
+
+        if (!isZeroing)
+        {
+            value += _getSign(value);
+        }
+
+        if ((value < best) && (_getSign(value) == _getSign(wdl)))
+        {
+            best = value;
+        }
+
+        inPosition.unmakeMove();
+
+        if (*outState == kProbeFailed)
+        {
+            return 0;
+        }
+    }
+
+    // Without moves the side to move is mated
+    return (best == INT_MAX) ? -1 : best;
+}
+
+bool
+Tablebases::canProbe(const ChessEngine & inPosition) const
+{
+    int numPieces = inPosition.getOccupied().count();
+
+    // Bare kings need no table
+    return (((numPieces == 2) || (numPieces <= _maxPieces)) &&
+            (inPosition.getCastlingRights() == 0));
+}
+
+bool
+Tablebases::probeWdl(ChessEngine & inPosition, Wdl * outWdl) const
+{
+    if (!canProbe(inPosition))
+    {
+        return false;
+    }
+
+    ProbeState state = kProbeOk;
+    auto       wdl   = _searchWdl(inPosition, false, &state);
+
+    if (state == kProbeFailed)
+    {
+        return false;
+    }
+
+    *outWdl = wdl;
+    return true;
+}
+
+bool
+Tablebases::probeWdlWithClock(ChessEngine & inPosition, Wdl * outWdl) const
+{
+    Wdl wdl;
+
+    if (!probeWdl(inPosition, &wdl))
+    {
+        return false;
+    }
+
+    if ((inPosition.getHalfMoveClock() > 0) && ((wdl == kWin) || (wdl == kLoss)))
+    {
+        int dtz;
+
+        if (!probeDtz(inPosition, &dtz))
+        {
+            return false;
+        }
+
+        if (inPosition.getHalfMoveClock() + abs(dtz) > kFiftyMovePlies)
+        {
+            wdl = (wdl == kWin) ? kCursedWin : kBlessedLoss;
+        }
+    }
+
+    *outWdl = wdl;
+    return true;
+}
+
+bool
+Tablebases::probeDtz(ChessEngine & inPosition, int * outDtz) const
+{
+    if (!canProbe(inPosition))
+    {
+        return false;
+    }
+
+    ProbeState state = kProbeOk;
+    int        dtz   = _probeDtz(inPosition, &state);
+
+    if (state == kProbeFailed)
+    {
+        return false;
+    }
+
+    *outDtz = dtz;
+    return true;
+}
+
+bool
+Tablebases::filterRootMoves(const ChessEngine & inPosition, MoveList * inOutMoves) const
+{
+    if (!canProbe(inPosition) || inOutMoves->isEmpty())
+    {
+        return false;
+    }
+
+    ChessEngine position(inPosition);
+    int         ranks[MoveList::kMaxMoves];
+    int         bestRank = INT_MIN;
+
+    for (size_t i = 0; i < inOutMoves->size; i++)
+    {
+        auto move      = (*inOutMoves)[i];
+        bool isZeroing = _isZeroing(position, move);
+        Wdl  wdl       = kDraw;
+        int  dtz       = 0;
+
+        position.makeMove(move);
+
+        // After a zeroing move only the outcome matters, the count starts over
+        bool isFound = (isZeroing ? probeWdl(position, &wdl) :
+                                    (probeWdl(position, &wdl) && probeDtz(position, &dtz)));
+
+        // Otherwise the clock runs on, and may run out before the next zeroing move
+        if (isFound && !isZeroing && ((wdl == kWin) || (wdl == kLoss)) &&
+            (position.getHalfMoveClock() + abs(dtz) > kFiftyMovePlies))
+        {
+            wdl = (wdl == kWin) ? kCursedWin : kBlessedLoss;
+        }
+
+        position.unmakeMove();
+
+        if (!isFound)
+        {
+            return false;
+        }
+
+        // The outcome first, then the plies to convert a win or to lose
+        int outcome = -wdl;
+        int plies   = isZeroing ? 1 : (1 + abs(dtz));
+
+        ranks[i] = outcome * 1024 + ((outcome > 0) ? -plies : ((outcome < 0) ? plies : 0));
+        bestRank = std::max(bestRank, ranks[i]);
+    }
+
+    size_t numKept = 0;
+
+    for (size_t i = 0; i < inOutMoves->size; i++)
+    {
+        if (ranks[i] == bestRank)
+        {
+            inOutMoves->moves[numKept++] = inOutMoves->moves[i];
+        }
+    }
+
+    inOutMoves->size = numKept;
+
+    return true;
+}
@@ -0,0 +1,398 @@
+/***************************************************************************************************
+ *
+ *  @file       Tablebase.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Endgame tablebases
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @class          TablebaseMaterial
+
+     @brief          Pieces of a table, by side and type
+
+     @discussion     The sides are the ones of the table name, e.g. KQvK, the first of which is
+     white in the table. A position with the colors the other way round is probed flipped.
+     */
+    struct TablebaseMaterial
+    {
+        static constexpr int        kNumTypes = 5;
+
+        /**
+         @brief         Piece types in the order of the table name and of the index, after the king
+         */
+        static const attributes::ChessPieceName kTypeOrder[kNumTypes];
+
+        /**
+         @brief         Number of pieces of each side, by ChessPieceName up to the queen
+         */
+        uint8_t                     counts[2][kNumTypes];
+
+        TablebaseMaterial();
+
+        /**
+         @brief         Material of a position, white being the first side
+         */
+        static TablebaseMaterial    fromPosition(const ChessEngine & inPosition);
+
+        /**
+         @brief         Parse a table name such as KRPvKR
+         */
+        static bool                 fromName(const std::string & inName, TablebaseMaterial * outMaterial);
+
+        std::string                 getName() const;
+
+        /**
+         @brief         Key that is unique for the material and the order of the sides
+         */
+        uint64_t                    getKey() const;
+
+        TablebaseMaterial           getFlipped() const;
+
+        /**
+         @brief         Number of pieces, kings included
+         */
+        int                         getNumPieces() const;
+    };
+
+    /**
+     @class          TablebaseIndex
+
+     @brief          Index of a position in a sub-table of a Syzygy file
+
+     @discussion     A file is split into sub-tables by the side to move, unless both sides have the
+     same pieces, and by the file of the leading pawn. Each one lists the pieces in an order of its
+     own, in groups that are indexed together: first the kings, with a third piece if some piece is
+     the only one of its kind, or the leading pawns in tables with pawns, then the pawns of the
+     other side, then every run of pieces of the same kind. The board is mirrored so that the
+     first piece is in the a1-d1-d4 triangle, or the leading pawn on the files a to d.
+
+     Pieces are coded as in the files, the type from 1 for a pawn to 6 for the king, plus 8 for
+     the second side of the table name.
+     */
+    struct TablebaseIndex
+    {
+        static constexpr int        kMaxPieces = 6;
+
+        uint8_t                     numPieces;
+        bool                        hasPawns;
+        bool                        hasUniquePieces;
+        bool                        hasPawnsOnBothSides;
+
+        /**
+         @brief         Pieces in the order of the sub-table
+         */
+        uint8_t                     pieces[kMaxPieces];
+
+        /**
+         @brief         Number of pieces of each group, ending with 0
+         */
+        uint8_t                     groupLengths[kMaxPieces + 1];
+
+        /**
+         @brief         Factor of each group in the index, then the number of indices
+         */
+        uint64_t                    groupFactors[kMaxPieces + 1];
+
+        TablebaseIndex();
+
+        /**
+         @brief         Set up the groups of a sub-table
+
+         @param     inPieces        pieces in the order of the sub-table
+         @param     inNumPieces     number of pieces, kings included
+         @param     inOrder         place in the index of the leading group and of the pawns of
+         the other side, 0x0F if there are none
+         @param     inFile          file of the leading pawn, 0 without pawns
+
+         @return        false if the order does not fit the groups
+         */
+        bool                        init(const uint8_t * inPieces, int inNumPieces,
+                                         const uint8_t inOrder[2], int inFile);
+
+        uint64_t                    getSize() const;
+
+        /**
+         @brief         Put the leading pawns first, the one that leads at the front
+
+         @param     inOutSquares    squares of the pieces, reordered in place
+         @param     inOutPieces     pieces on the squares, reordered in place
+         @param     inLeadingPawn   code of the pawns of the side that leads
+
+         @return        file of the leading pawn, mirrored to the files a to d, which selects
+         the sub-table
+         */
+        static int                  setLeadingPawns(uint8_t * inOutSquares, uint8_t * inOutPieces,
+                                                    int inNumPieces, uint8_t inLeadingPawn);
+
+        /**
+         @brief         Index of a position
+
+         @param     inOutSquares    squares of the pieces, in the colors of the table, with the
+         leading pawns first if there are any. Reordered and mirrored in place.
+         @param     inOutPieces     pieces on the squares, reordered in place
+         */
+        uint64_t                    getIndex(uint8_t * inOutSquares, uint8_t * inOutPieces) const;
+    };
+
+    /**
+     @class          Tablebases
+
+     @brief          Win, draw and loss, and distance to zeroing, of endgames with few pieces
+
+     @discussion     Each table is a pair of Syzygy files, the WDL file and the optional DTZ file,
+     compressed in blocks of canonical Huffman codes of symbols that pair up runs of values. The
+     files are mapped read only, so that the page cache is shared by every thread and process
+     probing them. A probe only decodes the block it needs, through a sparse index and the block
+     lengths, and never allocates: only the pages of the headers and of the block are touched.
+
+     The files do not store the positions where a capture is the best move, nor en passant
+     captures, which are searched on the position instead. Positions with castling rights are not
+     in the tables.
+     */
+    class Tablebases
+    {
+    public:
+        /**
+         @brief         Outcome with best play, for the side to move. The cursed win and blessed
+         loss are draws by the 50 move rule.
+         */
+        enum Wdl : int8_t
+        {
+            kLoss                   = -2,
+            kBlessedLoss            = -1,
+            kDraw                   = 0,
+            kCursedWin              = 1,
+            kWin                    = 2
+        };
+
+        /**
+         @brief         Flags of a file, in the byte after its magic
+         */
+        enum FileFlags : uint8_t
+        {
+            kSplit                  = 0x01,
+            kHasPawns               = 0x02
+        };
+
+        /**
+         @brief         Flags of a sub-table. Only the single value one is used in WDL files.
+         */
+        enum DtzFlags : uint8_t
+        {
+            kSideToMove             = 0x01,
+            kMapped                 = 0x02,
+            kWinPlies               = 0x04,
+            kLossPlies              = 0x08,
+            kWideMap                = 0x10,
+            kSingleValue            = 0x80
+        };
+
+        static constexpr int        kMaxPieces      = TablebaseIndex::kMaxPieces;
+
+        static const char * const   kWdlSuffix;
+        static const char * const   kDtzSuffix;
+        static const uint8_t        kWdlMagic[4];
+        static const uint8_t        kDtzMagic[4];
+
+        Tablebases();
+
+        /**
+         @brief         Map the tables found in a directory, replacing the ones mapped before
+
+         @discussion    Not thread safe, no search may be probing.
+
+         @return        number of tables found
+         */
+        size_t                      load(const std::string & inDirectory);
+
+        void                        clear();
+
+        size_t                      getNumTables() const { return _tables.size(); }
+
+        /**
+         @brief         Most pieces of a loaded table, 0 if there is none
+         */
+        int                         getMaxPieces() const { return _maxPieces; }
+
+        /**
+         @brief         Check if the position may be in the tables, before probing. Bare kings
+         always are.
+         */
+        bool                        canProbe(const ChessEngine & inPosition) const;
+
+        /**
+         @brief         Look up the outcome of a position
+
+         @discussion    Captures are searched first, making and unmaking them on the position,
+         which is left as it was.
+
+         @return        false if the position, or one after a capture, is not in the tables
+         */
+        bool                        probeWdl(ChessEngine & inPosition, Wdl * outWdl) const;
+
+        /**
+         @brief         Look up the outcome of a position with the plies already on its 50 move
+         clock
+
+         @discussion    The tables count from a zeroing move. With a running clock, a win or a loss
+         is only kept if the DTZ brings the next zeroing move before the 50 move rule, and is
+         otherwise a cursed win or blessed loss.
+
+         @return        false if the position is not in the tables, or is won or lost with a
+         running clock and its DTZ file is not loaded
+         */
+        bool                        probeWdlWithClock(ChessEngine & inPosition, Wdl * outWdl) const;
+
+        /**
+         @brief         Look up the plies to the next capture or pawn move with best play
+
+         @discussion    Files that count in moves round the plies up by one. If the file only has
+         the other side to move, the moves of the position are searched.
+
+         @param     outDtz          positive if the side to move wins, negative if it loses, 0 for
+         a draw, -1 if it is mated
+
+         @return        false if the position or its DTZ file is not in the tables
+         */
+        bool                        probeDtz(ChessEngine & inPosition, int * outDtz) const;
+
+        /**
+         @brief         Keep the root moves that preserve the outcome, and if it is won or lost,
+         that are the fastest to convert or the slowest to lose
+
+         @discussion    A win that the 50 move clock of the position runs out on before the next
+         zeroing move ranks as a cursed win.
+
+         @return        false if the moves were left alone, because the position or one after a
+         move is not in the tables
+         */
+        bool                        filterRootMoves(const ChessEngine & inPosition,
+                                                    MoveList * inOutMoves) const;
+
+    private:
+        enum ProbeState
+        {
+            kProbeFailed,
+            kProbeOk,
+            kProbeZeroing,
+            kProbeOtherSide
+        };
+
+        /**
+         @brief         Decoder of a sub-table
+         */
+        struct SubTable
+        {
+            TablebaseIndex          index;
+            uint8_t                 flags;
+            uint8_t                 singleValue;
+            uint8_t                 minLength;
+            uint8_t                 maxLength;
+            uint32_t                numBlocks;
+            size_t                  blockSize;
+            uint64_t                span;
+            uint64_t                numSparseEntries;
+            uint64_t                numBlockLengths;
+            const uint8_t *         lowestSymbols;
+            const uint8_t *         pairs;
+            const uint8_t *         sparseIndex;
+            const uint8_t *         blockLengths;
+            const uint8_t *         data;
+            uint16_t                mapStarts[4];
+
+            /**
+             @brief         Lowest code of each length, left aligned, from the shortest length
+             */
+            std::vector<uint64_t>   codeBases;
+
+            /**
+             @brief         Number of values of each symbol, less one
+             */
+            std::vector<uint8_t>    symbolLengths;
+        };
+
+        struct TableFile
+        {
+            MappedFile              file;
+            SubTable                subTables[2][4];
+            const uint8_t *         map;
+        };
+
+        struct Table
+        {
+            uint64_t                key;
+            TablebaseMaterial       material;
+            bool                    isSymmetric;
+            TableFile               wdl;
+            TableFile               dtz;
+        };
+
+        /**
+         @brief         Find the table of a position, null if it is not loaded
+         */
+        const Table *               _find(const ChessEngine & inPosition, bool * outIsFlipped) const;
+
+        /**
+         @brief         Map the files of one table, if they exist and are valid
+         */
+        bool                        _loadTable(const std::string & inDirectory,
+                                               const TablebaseMaterial & inMaterial);
+
+        /**
+         @brief         Read the headers of a mapped file into its sub-tables
+
+         @return        false if the file is not a valid one of the table
+         */
+        static bool                 _initFile(const Table & inTable, bool inIsWdl,
+                                              TableFile * inOutFile);
+
+        /**
+         @brief         Read the sizes and the Huffman code of a sub-table, once its index is set
+         */
+        static bool                 _initSizes(const MappedFile & inFile, size_t * inOutOffset,
+                                               SubTable * outSubTable);
+
+        /**
+         @brief         Value of an index, from the block that holds it
+         */
+        static int                  _decompress(const SubTable & inSubTable, uint64_t inIndex);
+
+        /**
+         @brief         Value stored for a position, without searching it
+
+         @param     inIsDtz         read the DTZ file, which needs the outcome
+         @param     inWdl           outcome of the position, for the DTZ file
+         */
+        int                         _probeTable(const ChessEngine & inPosition, bool inIsDtz,
+                                                Wdl inWdl, ProbeState * outState) const;
+
+        /**
+         @brief         Outcome of a position after its captures, and its pawn moves if asked
+
+         @discussion    The state is kProbeZeroing if the best move is one of them, in which case
+         the DTZ file does not have the position.
+         */
+        Wdl                         _searchWdl(ChessEngine & inPosition, bool inHasPawnMoves,
+                                               ProbeState * outState) const;
+
+        int                         _probeDtz(ChessEngine & inPosition,
+                                              ProbeState * outState) const;
+
+        std::vector<Table>          _tables;
+        int                         _maxPieces;
+    };
+}
@@ -0,0 +1,1072 @@
+/***************************************************************************************************
+ *
+ *  @file       TablebaseGenerator.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Generation of endgame tablebases
+ *
+ **************************************************************************************************/
+
+#include "TablebaseGenerator.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <vector>
+
+using namespace chessEngine;
+
+// A child move is either terminal, leaving the table with a known outcome, or an index in the table
+static constexpr uint32_t kTerminalBit    = 1u << 31;
+static constexpr uint32_t kZeroingBit     = 1u << 30;
+static constexpr uint32_t kIndexMask      = kZeroingBit - 1;
+
+static constexpr int8_t   kUnknown        = 100;
+static constexpr int8_t   kInvalid        = 101;
+
+static constexpr int16_t  kUnknownDtz     = -1;
+
+// Beyond this many plies to zeroing, a win is a draw by the 50 move rule
+static constexpr int      kFiftyMovePlies = 100;
+
+// Blocks of 64 bytes, and an entry of the sparse index every 1024 values
+static constexpr int      kBlockSizeLog   = 6;
+static constexpr int      kSpanLog        = 10;
+
+// Values in a block, leaving room for the offset of the last entry of the sparse index
+static constexpr int      kMaxBlockValues = 65536 - (1 << kSpanLog);
+
+// Symbols that pair up two others, at most 4095 symbols in all
+static constexpr int      kMaxPairs       = 256;
+static constexpr int      kMaxCodeLength  = 32;
+
+static constexpr uint16_t kUnset          = 0xFFFF;
+
+static const char kPieceChars[6] = { 'p', 'n', 'b', 'r', 'q', 'k' };
+
+struct TablePiece
+{
+    int                         side;
+    attributes::ChessPieceName  type;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark Helpers
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ @brief         Pieces in the order of the index
+ */
+static std::vector<TablePiece>
+_getPieces(const TablebaseMaterial & inMaterial)
+{
+    std::vector<TablePiece> pieces;
+
+    for (int side = 0; side < 2; side++)
+    {
+        pieces.push_back({ side, attributes::ChessPieceName::kKing });
+
+        for (auto type : TablebaseMaterial::kTypeOrder)
+        {
+            for (int i = 0; i < inMaterial.counts[side][static_cast<uint8_t>(type)]; i++)
+            {
+                pieces.push_back({ side, type });
+            }
+        }
+    }
+
+    return pieces;
+}
+
+static void
+_decodeIndex(uint64_t inIndex, size_t inNumPieces, int * outSideToMove, uint8_t * outSquares)
+{
+    for (size_t i = inNumPieces; i > 0; i--)
+    {
+        outSquares[i - 1] = inIndex & 63;
+        inIndex >>= 6;
+    }
+
+    *outSideToMove = static_cast<int>(inIndex);
+}
+
+/**
+ @brief         Positions of the index, both sides to move
+ */
+static uint64_t
+_getNumPositions(const TablebaseMaterial & inMaterial)
+{
+    return 2ULL << (6 * inMaterial.getNumPieces());
+}
+
+/**
+ @brief         Index of a position while generating: the side to move, then the squares of the
+ pieces in the order of _getPieces(), 6 bits each. Pieces of the same kind are in square order.
+ */
+static uint64_t
+_getIndex(const TablebaseMaterial & inMaterial, const ChessEngine & inPosition)
+{
+    uint64_t index = (inPosition.getCurrMove() == attributes::ChessColor::kWhite) ? 0 : 1;
+
+    for (int side = 0; side < 2; side++)
+    {
+        auto color = (side == 0) ? attributes::ChessColor::kWhite : attributes::ChessColor::kBlack;
+
+        for (auto sq : inPosition.getPieces(color, attributes::ChessPieceName::kKing))
+        {
+            index = (index << 6) | sq.index;
+        }
+
+        for (auto type : TablebaseMaterial::kTypeOrder)
+        {
+            if (inMaterial.counts[side][static_cast<uint8_t>(type)] == 0)
+            {
+                continue;
+            }
+
+            for (auto sq : inPosition.getPieces(color, type))
+            {
+                index = (index << 6) | sq.index;
+            }
+        }
+    }
+
+    return index;
+}
+
+static bool
+_isSamePiece(const TablePiece & inA, const TablePiece & inB)
+{
+    return (inA.side == inB.side) && (inA.type == inB.type);
+}
+
+static std::string
+_getFen(const std::vector<TablePiece> & inPieces, const uint8_t * inSquares, int inSideToMove)
+{
+    char board[64] = { 0 };
+
+    for (size_t i = 0; i < inPieces.size(); i++)
+    {
+        char c = kPieceChars[static_cast<uint8_t>(inPieces[i].type)];
+        board[inSquares[i]] = (inPieces[i].side == 0) ? static_cast<char>(toupper(c)) : c;
+    }
+
+    std::string fen;
+
+    for (int row = 7; row >= 0; row--)
+    {
+        int empty = 0;
+
+        for (int col = 0; col < 8; col++)
+        {
+            char c = board[row * 8 + col];
+
+            if (c == 0)
+            {
+                empty++;
+                continue;
+            }
+
+            if (empty > 0)
+            {
+                fen += static_cast<char>('0' + empty);
+                empty = 0;
+            }
+
+            fen += c;
+        }
+
+        if (empty > 0)
+        {
+            fen += static_cast<char>('0' + empty);
+        }
+
+        if (row > 0)
+        {
+            fen += '/';
+        }
+    }
+
+    fen += (inSideToMove == 0) ? " w - - 0 1" : " b - - 0 1";
+
+    return fen;
+}
+
+/**
+ @brief         Code of a piece in the Syzygy files
+ */
+static uint8_t
+_getCode(const TablePiece & inPiece)
+{
+    return static_cast<uint8_t>((inPiece.side ? 8 : 0) | (static_cast<uint8_t>(inPiece.type) + 1));
+}
+
+/**
+ @brief         Pieces in the order of the Syzygy sub-tables, as codes
+
+ @discussion    With pawns the leading ones come first, those of the side with fewer pawns if both
+ have some, then the pawns of the other side. Without pawns the kings come first, then the first
+ piece that is the only one of its kind, if there is one.
+ */
+static std::vector<uint8_t>
+_getSyzygyPieces(const TablebaseMaterial & inMaterial)
+{
+    std::vector<uint8_t> codes;
+
+    for (const auto & piece : _getPieces(inMaterial))
+    {
+        codes.push_back(_getCode(piece));
+    }
+
+    uint8_t pawn       = static_cast<uint8_t>(attributes::ChessPieceName::kPawn);
+    int     firstPawns = inMaterial.counts[0][pawn];
+    int     otherPawns = inMaterial.counts[1][pawn];
+
+    if (firstPawns + otherPawns > 0)
+    {
+        bool isFirstLeading = ((otherPawns == 0) ||
+                               ((firstPawns > 0) && (otherPawns >= firstPawns)));
+        auto leading        = _getCode({ isFirstLeading ? 0 : 1,
+                                         attributes::ChessPieceName::kPawn });
+
+        std::stable_sort(codes.begin(), codes.end(), [leading] (uint8_t inA, uint8_t inB) {
+            auto getRank = [leading] (uint8_t inCode) {
+                return (inCode == leading) ? 0 : (((inCode & 7) == (leading & 7)) ? 1 : 2);
+            };
+
+            return getRank(inA) < getRank(inB);
+        });
+
+        return codes;
+    }
+
+    uint8_t king = _getCode({ 0, attributes::ChessPieceName::kKing });
+
+    std::stable_sort(codes.begin(), codes.end(), [king] (uint8_t inA, uint8_t inB) {
+        return ((inA & 7) == king) && ((inB & 7) != king);
+    });
+
+    for (size_t i = 2; i < codes.size(); i++)
+    {
+        if (std::count(codes.begin(), codes.end(), codes[i]) == 1)
+        {
+            std::rotate(codes.begin() + 2, codes.begin() + i, codes.begin() + i + 1);
+            break;
+        }
+    }
+
+    return codes;
+}
+
+/**
+ @brief         Value of a position in the DTZ file, in plies less one, and in moves for a cursed
+ win or blessed loss
+ */
+static uint16_t
+_getStoredDtz(int inWdl, int inDistance)
+{
+    int value = 0;
+
+    if ((inWdl == Tablebases::kWin) || (inWdl == Tablebases::kLoss))
+    {
+        value = inDistance - 1;
+    }
+    else if (inWdl != Tablebases::kDraw)
+    {
+        value = (inDistance - kFiftyMovePlies) / 2;
+    }
+
+    return static_cast<uint16_t>(std::max(value, 0));
+}
+
+/**
+ @brief         Set the value of an index, which positions with the same index must agree on
+ */
+static bool
+_setValue(uint16_t * inOutSlot, uint16_t inValue)
+{
+    if (*inOutSlot == kUnset)
+    {
+        *inOutSlot = inValue;
+    }
+
+    return (*inOutSlot == inValue);
+}
+
+static void
+_appendLe16(std::vector<uint8_t> * outData, uint32_t inValue)
+{
+    outData->push_back(static_cast<uint8_t>(inValue));
+    outData->push_back(static_cast<uint8_t>(inValue >> 8));
+}
+
+static void
+_appendLe32(std::vector<uint8_t> * outData, uint32_t inValue)
+{
+    _appendLe16(outData, inValue & 0xFFFF);
+    _appendLe16(outData, inValue >> 16);
+}
+
+/**
+ @brief         Lengths of the Huffman codes of symbols, 0 for the ones that do not occur
+ */
+static std::vector<int>
+_getCodeLengths(const std::vector<uint64_t> & inFrequencies)
+{
+    typedef std::pair<uint64_t, int> Node;
+
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+    std::vector<int> parents(inFrequencies.size(), -1);
+    std::vector<int> lengths(inFrequencies.size(), 0);
+
+    for (size_t i = 0; i < inFrequencies.size(); i++)
+    {
+        if (inFrequencies[i] > 0)
+        {
+            queue.push(Node(inFrequencies[i], static_cast<int>(i)));
+        }
+    }
+
+    // A single symbol still takes a bit
+    if (queue.size() == 1)
+    {
+        lengths[queue.top().second] = 1;
+        return lengths;
+    }
+
+    while (queue.size() > 1)
+    {
+        auto first = queue.top();
+        queue.pop();
+        auto second = queue.top();
+        queue.pop();
+
+        auto parent = static_cast<int>(parents.size());
+
+        parents.push_back(-1);
+        parents[first.second]  = parent;
+        parents[second.second] = parent;
+
+        queue.push(Node(first.first + second.first, parent));
+    }
+
+    for (size_t i = 0; i < inFrequencies.size(); i++)
+    {
+        for (int node = parents[i]; (inFrequencies[i] > 0) && (node >= 0); node = parents[node])
+        {
+            lengths[i]++;
+        }
+    }
+
+    return lengths;
+}
+
+/**
+ @brief         A sub-table compressed as in the Syzygy files
+ */
+struct CompressedTable
+{
+    /**
+     @brief         From the flags to the end of the symbol pairs
+     */
+    std::vector<uint8_t>        sizes;
+    std::vector<uint8_t>        sparseIndex;
+    std::vector<uint8_t>        blockLengths;
+    std::vector<uint8_t>        blocks;
+};
+
+/**
+ @brief         Compress the values of a sub-table
+
+ @discussion    The most frequent pair of adjacent symbols is replaced by a new symbol, over and
+ over, and the symbols are then coded with canonical Huffman codes, the longer codes having the
+ lower values, in blocks that hold whole symbols.
+
+ @return        false if a code is too long to be decoded
+ */
+static bool
+_compress(const std::vector<uint16_t> & inValues, uint8_t inFlags, CompressedTable * outTable)
+{
+    auto & sizes = outTable->sizes;
+
+    if (std::all_of(inValues.begin(), inValues.end(), [&inValues] (uint16_t inValue) {
+        return inValue == inValues[0];
+    }))
+    {
+        sizes.push_back(inFlags | Tablebases::kSingleValue);
+        sizes.push_back(static_cast<uint8_t>(inValues[0]));
+        return true;
+    }
+
+    // A symbol that is not a pair has its value on the left
+    struct Symbol
+    {
+        int                     left;
+        int                     right;
+        int                     numValues;
+    };
+
+    std::vector<Symbol> symbols;
+    std::vector<int>    leaves(4096, -1);
+    std::vector<int>    sequence;
+
+    for (auto value : inValues)
+    {
+        if (leaves[value] < 0)
+        {
+            leaves[value] = static_cast<int>(symbols.size());
+            symbols.push_back({ value, 0xFFF, 1 });
+        }
+
+        sequence.push_back(leaves[value]);
+    }
+
+    for (int numPairs = 0; numPairs < kMaxPairs; numPairs++)
+    {
+        size_t                numSymbols = symbols.size();
+        std::vector<uint32_t> counts(numSymbols * numSymbols, 0);
+
+        for (size_t i = 0; i + 1 < sequence.size(); i++)
+        {
+            counts[sequence[i] * numSymbols + sequence[i + 1]]++;
+        }
+
+        size_t   best      = 0;
+        uint32_t bestCount = 0;
+
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            // A symbol has at most 256 values
+            if ((counts[i] > bestCount) &&
+                (symbols[i / numSymbols].numValues + symbols[i % numSymbols].numValues <= 256))
+            {
+                best      = i;
+                bestCount = counts[i];
+            }
+        }
+
+        // Rare pairs do not pay for their entry
+        if (bestCount < 8)
+        {
+            break;
+        }
+
+        int left   = static_cast<int>(best / numSymbols);
+        int right  = static_cast<int>(best % numSymbols);
+        int paired = static_cast<int>(numSymbols);
+
+        symbols.push_back({ left, right, symbols[left].numValues + symbols[right].numValues });
+
+        size_t numKept = 0;
+
+        for (size_t i = 0; i < sequence.size(); i++)
+        {
+            if ((i + 1 < sequence.size()) && (sequence[i] == left) && (sequence[i + 1] == right))
+            {
+                sequence[numKept++] = paired;
+                i++;
+            }
+            else
+            {
+                sequence[numKept++] = sequence[i];
+            }
+        }
+
+        sequence.resize(numKept);
+    }
+
+    std::vector<uint64_t> frequencies(symbols.size(), 0);
+
+    for (auto symbol : sequence)
+    {
+        frequencies[symbol]++;
+    }
+
+    auto lengths   = _getCodeLengths(frequencies);
+    int  minLength = kMaxCodeLength;
+    int  maxLength = 0;
+
+    for (auto length : lengths)
+    {
+        if (length > 0)
+        {
+            minLength = std::min(minLength, length);
+            maxLength = std::max(maxLength, length);
+        }
+    }
+
+    if (maxLength > kMaxCodeLength)
+    {
+        return false;
+    }
+
+    // Symbols are numbered from the longest codes, the ones without a code last
+    std::vector<int> order(symbols.size());
+    std::vector<int> ids(symbols.size());
+
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = static_cast<int>(i);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&lengths] (int inA, int inB) {
+        return lengths[inA] > lengths[inB];
+    });
+
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        ids[order[i]] = static_cast<int>(i);
+    }
+
+    // Each length starts where the codes of the next one end, at half the value
+    std::vector<int>      numCodes(kMaxCodeLength + 2, 0);
+    std::vector<uint32_t> lowestIds(kMaxCodeLength + 2, 0);
+    std::vector<uint64_t> bases(kMaxCodeLength + 2, 0);
+
+    for (auto length : lengths)
+    {
+        numCodes[length]++;
+    }
+
+    for (int length = maxLength - 1; length >= minLength; length--)
+    {
+        lowestIds[length] = lowestIds[length + 1] + numCodes[length + 1];
+        bases[length]     = (bases[length + 1] + numCodes[length + 1]) / 2;
+    }
+
+    sizes.push_back(inFlags);
+    sizes.push_back(kBlockSizeLog);
+    sizes.push_back(kSpanLog);
+
+    // No padding of the block lengths
+    sizes.push_back(0);
+
+    size_t numBlocksOffset = sizes.size();
+
+    _appendLe32(&sizes, 0);
+    sizes.push_back(static_cast<uint8_t>(maxLength));
+    sizes.push_back(static_cast<uint8_t>(minLength));
+
+    for (int length = minLength; length <= maxLength; length++)
+    {
+        _appendLe16(&sizes, lowestIds[length]);
+    }
+
+    _appendLe16(&sizes, static_cast<uint32_t>(symbols.size()));
+
+    for (auto symbol : order)
+    {
+        bool isPair = (symbols[symbol].right != 0xFFF);
+        int  left   = isPair ? ids[symbols[symbol].left] : symbols[symbol].left;
+        int  right  = isPair ? ids[symbols[symbol].right] : 0xFFF;
+
+        sizes.push_back(static_cast<uint8_t>(left));
+        sizes.push_back(static_cast<uint8_t>((left >> 8) | ((right & 0x0F) << 4)));
+        sizes.push_back(static_cast<uint8_t>(right >> 4));
+    }
+
+    if (symbols.size() & 1)
+    {
+        sizes.push_back(0);
+    }
+
+    // The codes, most significant bit first
+    const int             blockBits = 8 << kBlockSizeLog;
+    auto &                blocks    = outTable->blocks;
+    std::vector<uint32_t> blockValues;
+    int                   numBits   = 0;
+
+    for (auto symbol : sequence)
+    {
+        int length = lengths[symbol];
+
+        if (blockValues.empty() || (numBits + length > blockBits) ||
+            (blockValues.back() + symbols[symbol].numValues > kMaxBlockValues))
+        {
+            blocks.resize(blocks.size() + (1 << kBlockSizeLog), 0);
+            blockValues.push_back(0);
+            numBits = 0;
+        }
+
+        uint64_t code  = bases[length] + (ids[symbol] - lowestIds[length]);
+        size_t   start = blocks.size() - (1 << kBlockSizeLog);
+
+        for (int bit = length - 1; bit >= 0; bit--, numBits++)
+        {
+            if ((code >> bit) & 1)
+            {
+                blocks[start + numBits / 8] |= static_cast<uint8_t>(0x80 >> (numBits % 8));
+            }
+        }
+
+        blockValues.back() += symbols[symbol].numValues;
+    }
+
+    auto numBlocks = static_cast<uint32_t>(blockValues.size());
+
+    for (int i = 0; i < 4; i++)
+    {
+        sizes[numBlocksOffset + i] = static_cast<uint8_t>(numBlocks >> (8 * i));
+    }
+
+    for (auto numValues : blockValues)
+    {
+        _appendLe16(&outTable->blockLengths, numValues - 1);
+    }
+
+    // The block and offset of the value in the middle of each span, past the last block for the
+    // middle of the last span if the values end before it
+    const uint64_t span       = 1ULL << kSpanLog;
+    size_t         block      = 0;
+    uint64_t       blockStart = 0;
+
+    for (uint64_t start = 0; start < inValues.size(); start += span)
+    {
+        uint64_t middle = start + span / 2;
+
+        while ((block + 1 < blockValues.size()) && (middle >= blockStart + blockValues[block]))
+        {
+            blockStart += blockValues[block++];
+        }
+
+        _appendLe32(&outTable->sparseIndex, static_cast<uint32_t>(block));
+        _appendLe16(&outTable->sparseIndex, static_cast<uint32_t>(middle - blockStart));
+    }
+
+    return true;
+}
+
+/**
+ @brief         Write a file in the Syzygy layout
+
+ @param     inPieces        codes of the pieces, in the order of every sub-table
+ @param     inNumSides      sub-tables of each file of the leading pawn
+ @param     inTables        compressed sub-tables by file of the leading pawn, then side to move
+ */
+static bool
+_writeFile(const std::string & inPath, const uint8_t * inMagic, uint8_t inFlags,
+           const std::vector<uint8_t> & inPieces, bool inHasPawnsOnBothSides, int inNumSides,
+           const std::vector<CompressedTable> & inTables)
+{
+    std::vector<uint8_t> data(inMagic, inMagic + 4);
+
+    data.push_back(inFlags);
+
+    for (size_t tbFile = 0; tbFile < inTables.size() / inNumSides; tbFile++)
+    {
+        // The leading group is the first in the index, the pawns of the other side the second
+        data.push_back(0x00);
+
+        if (inHasPawnsOnBothSides)
+        {
+            data.push_back(0x11);
+        }
+
+        for (auto piece : inPieces)
+        {
+            data.push_back(static_cast<uint8_t>(piece | (piece << 4)));
+        }
+    }
+
+    if (data.size() & 1)
+    {
+        data.push_back(0);
+    }
+
+    for (const auto & table : inTables)
+    {
+        data.insert(data.end(), table.sizes.begin(), table.sizes.end());
+    }
+
+    for (const auto & table : inTables)
+    {
+        data.insert(data.end(), table.sparseIndex.begin(), table.sparseIndex.end());
+    }
+
+    for (const auto & table : inTables)
+    {
+        data.insert(data.end(), table.blockLengths.begin(), table.blockLengths.end());
+    }
+
+    for (const auto & table : inTables)
+    {
+        data.resize((data.size() + 63) & ~static_cast<size_t>(63), 0);
+        data.insert(data.end(), table.blocks.begin(), table.blocks.end());
+    }
+
+    // The checksum at the end is left empty
+    data.resize(((data.size() + 63) & ~static_cast<size_t>(63)) + 16, 0);
+
+    FILE * file = fopen(inPath.c_str(), "wb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    bool ret = (fwrite(data.data(), data.size(), 1, file) == 1);
+
+    return (fclose(file) == 0) && ret;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark TablebaseGenerator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+TablebaseGenerator::generate(const std::string & inName, const std::string & inDirectory,
+                             const Tablebases & inSubTables)
+{
+    TablebaseMaterial material;
+
+    if (!TablebaseMaterial::fromName(inName, &material) || (material.getNumPieces() > kMaxPieces))
+    {
+        return false;
+    }
+
+    auto     pieces       = _getPieces(material);
+    auto     numPieces    = pieces.size();
+    uint64_t numPositions = _getNumPositions(material);
+
+    std::vector<int8_t>   values(numPositions, kInvalid);
+    std::vector<uint32_t> childStart(numPositions + 1, 0);
+    std::vector<uint32_t> children;
+
+    ChessEngine position;
+    MoveList    moves;
+
+    // Set up every position once and keep where its moves lead
+    for (uint64_t index = 0; index < numPositions; index++)
+    {
+        childStart[index] = static_cast<uint32_t>(children.size());
+
+        int      sideToMove;
+        uint8_t  squares[kMaxPieces];
+        uint64_t occupied = 0;
+        bool     isValid  = true;
+
+        _decodeIndex(index, numPieces, &sideToMove, squares);
+
+        for (size_t i = 0; (i < numPieces) && isValid; i++)
+        {
+            bool isPawn     = (pieces[i].type == attributes::ChessPieceName::kPawn);
+            bool isLastRank = ((squares[i] / 8) == 0) || ((squares[i] / 8) == 7);
+
+            // Other orders of the same pieces are filled in from the canonical one at the end
+            isValid = (!(occupied & (1ULL << squares[i])) && !(isPawn && isLastRank) &&
+                       !((i > 0) && _isSamePiece(pieces[i], pieces[i - 1]) &&
+                         (squares[i] < squares[i - 1])));
+
+            occupied |= 1ULL << squares[i];
+        }
+
+        if (!isValid || !position.setFen(_getFen(pieces, squares, sideToMove)))
+        {
+            continue;
+        }
+
+        auto us   = position.getCurrMove();
+        auto them = (us == attributes::ChessColor::kWhite) ?
+                    attributes::ChessColor::kBlack : attributes::ChessColor::kWhite;
+
+        auto theirKing = *position.getPieces(them, attributes::ChessPieceName::kKing).begin();
+
+        // The side that just moved cannot be in check
+        if (position.isSquareAttacked(theirKing, us))
+        {
+            continue;
+        }
+
+        values[index] = kUnknown;
+
+        moves.clear();
+        position.generateLegalMoves(&moves);
+
+        if (moves.isEmpty())
+        {
+            values[index] = position.isInCheck() ? Tablebases::kLoss : Tablebases::kDraw;
+            continue;
+        }
+
+        for (auto move : moves)
+        {
+            attributes::ChessColor     color;
+            attributes::ChessPieceName piece = attributes::ChessPieceName::kKing;
+
+            position.getPieceAt(move.getSrc(), &color, &piece);
+
+            bool isZeroing = move.isCapture() || (piece == attributes::ChessPieceName::kPawn);
+
+            position.makeMove(move);
+
+            if (move.isCapture() || move.isPromotion())
+            {
+                Tablebases::Wdl wdl;
+
+                if (!inSubTables.probeWdl(position, &wdl))
+                {
+                    chessEngine::log("TablebaseGenerator: no table for %s\n", position.getFen().c_str());
+                    return false;
+                }
+
+                children.push_back(kTerminalBit | kZeroingBit |
+                                   static_cast<uint32_t>(wdl - Tablebases::kLoss));
+            }
+            else
+            {
+                auto childIndex = static_cast<uint32_t>(_getIndex(material, position));
+                children.push_back(childIndex | (isZeroing ? kZeroingBit : 0));
+            }
+
+            position.unmakeMove();
+        }
+    }
+
+    childStart[numPositions] = static_cast<uint32_t>(children.size());
+
+    auto getChildValue = [&values, &children] (uint32_t inChild) -> int8_t {
+        return ((inChild & kTerminalBit) ?
+                static_cast<int8_t>((inChild & kIndexMask) + Tablebases::kLoss) :
+                values[inChild & kIndexMask]);
+    };
+
+    // Outcomes without the 50 move rule: a win if a move leads to a loss, a loss if all moves lead
+    // to wins, until nothing changes. What is left is a draw.
+    for (bool isChanged = true; isChanged; )
+    {
+        isChanged = false;
+
+        for (uint64_t index = 0; index < numPositions; index++)
+        {
+            if (values[index] != kUnknown)
+            {
+                continue;
+            }
+
+            bool isAnyLoss = false;
+            bool isAllWins = true;
+
+            for (auto i = childStart[index]; i < childStart[index + 1]; i++)
+            {
+                auto value = getChildValue(children[i]);
+
+                isAnyLoss = isAnyLoss || (value < Tablebases::kDraw);
+                isAllWins = isAllWins && (value != kUnknown) && (value > Tablebases::kDraw);
+            }
+
+            if (isAnyLoss || isAllWins)
+            {
+                values[index] = isAnyLoss ? Tablebases::kWin : Tablebases::kLoss;
+                isChanged     = true;
+            }
+        }
+    }
+
+    // Distances to zeroing by levels: a win takes the shortest way to a zeroing move or to a loss
+    // of the opponent, a loss the longest
+    std::vector<int16_t> dtz(numPositions, kUnknownDtz);
+    std::vector<bool>    isValid(numPositions, false);
+
+    for (uint64_t index = 0; index < numPositions; index++)
+    {
+        isValid[index] = (values[index] != kInvalid);
+
+        if ((values[index] == kUnknown) || (values[index] == kInvalid))
+        {
+            values[index] = Tablebases::kDraw;
+        }
+
+        if ((values[index] == Tablebases::kDraw) || (childStart[index] == childStart[index + 1]))
+        {
+            dtz[index] = 0;
+        }
+    }
+
+    bool isChanged = true;
+
+    for (int level = 1; isChanged; level++)
+    {
+        isChanged = false;
+
+        for (uint64_t index = 0; index < numPositions; index++)
+        {
+            if (dtz[index] != kUnknownDtz)
+            {
+                continue;
+            }
+
+            bool isWin   = (values[index] > Tablebases::kDraw);
+            int  best    = isWin ? INT_MAX : 0;
+            bool isFound = !isWin;
+
+            for (auto i = childStart[index]; i < childStart[index + 1]; i++)
+            {
+                auto child = children[i];
+                int  plies = kUnknownDtz;
+
+                if (child & kZeroingBit)
+                {
+                    plies = 1;
+                }
+                else if ((dtz[child & kIndexMask] != kUnknownDtz) &&
+                         (dtz[child & kIndexMask] < level))
+                {
+                    plies = 1 + dtz[child & kIndexMask];
+                }
+
+                if (isWin)
+                {
+                    // Only moves to a lost position keep the win
+                    if ((getChildValue(child) < Tablebases::kDraw) && (plies != kUnknownDtz))
+                    {
+                        best    = std::min(best, plies);
+                        isFound = true;
+                    }
+                }
+                else if (plies == kUnknownDtz)
+                {
+                    isFound = false;
+                    break;
+                }
+                else
+                {
+                    best = std::max(best, plies);
+                }
+            }
+
+            if (isFound)
+            {
+                dtz[index] = static_cast<int16_t>(best);
+                isChanged  = true;
+            }
+        }
+    }
+
+    // The Syzygy sub-tables: with the same pieces on both sides only the first side to move, as
+    // probes flip the other, and the DTZ file only has the first side to move in any case
+    auto    syzygyPieces = _getSyzygyPieces(material);
+    uint8_t pawn         = static_cast<uint8_t>(attributes::ChessPieceName::kPawn);
+    bool    hasPawns     = (material.counts[0][pawn] + material.counts[1][pawn]) > 0;
+    bool    bothPawns    = (material.counts[0][pawn] > 0) && (material.counts[1][pawn] > 0);
+    bool    isSymmetric  = (material.getFlipped().getKey() == material.getKey());
+    int     numFiles     = hasPawns ? 4 : 1;
+    int     numWdlSides  = isSymmetric ? 1 : 2;
+    uint8_t order[2]     = { 0, static_cast<uint8_t>(bothPawns ? 1 : 0x0F) };
+
+    std::vector<TablebaseIndex>        indexes(numFiles);
+    std::vector<std::vector<uint16_t>> wdlValues(numFiles * numWdlSides);
+    std::vector<std::vector<uint16_t>> dtzValues(numFiles);
+
+    for (int tbFile = 0; tbFile < numFiles; tbFile++)
+    {
+        indexes[tbFile].init(syzygyPieces.data(), static_cast<int>(numPieces), order, tbFile);
+        dtzValues[tbFile].assign(indexes[tbFile].getSize(), kUnset);
+
+        for (int side = 0; side < numWdlSides; side++)
+        {
+            wdlValues[tbFile * numWdlSides + side].assign(indexes[tbFile].getSize(), kUnset);
+        }
+    }
+
+    for (uint64_t index = 0; index < numPositions; index++)
+    {
+        int     sideToMove;
+        uint8_t squares[kMaxPieces];
+        uint8_t codes[kMaxPieces];
+
+        _decodeIndex(index, numPieces, &sideToMove, squares);
+
+        if (!isValid[index] || (isSymmetric && (sideToMove != 0)))
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < numPieces; i++)
+        {
+            codes[i] = _getCode(pieces[i]);
+        }
+
+        int tbFile = 0;
+
+        if (hasPawns)
+        {
+            tbFile = TablebaseIndex::setLeadingPawns(squares, codes, static_cast<int>(numPieces),
+                                                     syzygyPieces[0]);
+        }
+
+        auto tbIndex  = indexes[tbFile].getIndex(squares, codes);
+        int  value    = values[index];
+        int  distance = std::max<int>(dtz[index], 0);
+
+        if ((value != Tablebases::kDraw) && (distance > kFiftyMovePlies))
+        {
+            value = (value > Tablebases::kDraw) ? Tablebases::kCursedWin : Tablebases::kBlessedLoss;
+        }
+
+        // Mirrored positions, and the same pieces in another order, share an index
+        bool isSet = _setValue(&wdlValues[tbFile * numWdlSides + sideToMove][tbIndex],
+                               static_cast<uint16_t>(value - Tablebases::kLoss));
+
+        if (sideToMove == 0)
+        {
+            isSet = isSet && _setValue(&dtzValues[tbFile][tbIndex], _getStoredDtz(value, distance));
+        }
+
+        if (!isSet)
+        {
+            chessEngine::log("TablebaseGenerator: positions of one index differ in %s\n",
+                             material.getName().c_str());
+            return false;
+        }
+    }
+
+    std::vector<CompressedTable> wdlTables(wdlValues.size());
+    std::vector<CompressedTable> dtzTables(dtzValues.size());
+
+    for (size_t i = 0; i < wdlValues.size() + dtzValues.size(); i++)
+    {
+        bool isWdl   = (i < wdlValues.size());
+        auto & table = isWdl ? wdlValues[i] : dtzValues[i - wdlValues.size()];
+
+        // Indices of no position take the value before them, which pairs up best
+        for (size_t j = 0; j < table.size(); j++)
+        {
+            if (table[j] == kUnset)
+            {
+                table[j] = (j > 0) ? table[j - 1] : 0;
+            }
+        }
+
+        // Distances of wins and losses in plies, of the first side to move
+        uint8_t flags = isWdl ? 0 : (Tablebases::kWinPlies | Tablebases::kLossPlies);
+
+        if (!_compress(table, flags, isWdl ? &wdlTables[i] : &dtzTables[i - wdlValues.size()]))
+        {
+            return false;
+        }
+    }
+
+    std::string path = inDirectory;
+
+    if (!path.empty() && (path.back() != '/'))
+    {
+        path += '/';
+    }
+
+    path += material.getName();
+
+    uint8_t flags = ((isSymmetric ? 0 : Tablebases::kSplit) |
+                     (hasPawns ? Tablebases::kHasPawns : 0));
+
+    return (_writeFile(path + Tablebases::kWdlSuffix, Tablebases::kWdlMagic, flags, syzygyPieces,
+                       bothPawns, numWdlSides, wdlTables) &&
+            _writeFile(path + Tablebases::kDtzSuffix, Tablebases::kDtzMagic, flags, syzygyPieces,
+                       bothPawns, 1, dtzTables));
+}
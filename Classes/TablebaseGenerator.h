@@ -0,0 +1,56 @@
+/***************************************************************************************************
+ *
+ *  @file       TablebaseGenerator.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Generation of endgame tablebases
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "Tablebase.h"
+
+#include <string>
+
+namespace chessEngine
+{
+    /**
+     @class          TablebaseGenerator
+
+     @brief          Builds the files read by Tablebases, by retrograde analysis
+
+     @discussion     Every position of the table is set up once and its moves kept in memory, after
+     which the outcomes are found by iterating from the mates, and then the distances to zeroing.
+     The 50 move rule is applied by the distance to zeroing within the table only. Positions are
+     indexed without en passant rights, so a capture en passant right after a double push into a
+     position of the table is not seen.
+
+     The files are written in the Syzygy layout, with the same index and Huffman compression of
+     pairs of values, though not with the same choice of pairs as the published files.
+
+     Captures and promotions lead to other tables, which have to be generated and loaded first.
+     Keeping the moves in memory limits the generator to tables of up to 4 pieces.
+     */
+    class TablebaseGenerator
+    {
+    public:
+        static constexpr int        kMaxPieces = 4;
+
+        /**
+         @brief         Generate the WDL and DTZ files of a table
+
+         @param     inName          table, such as KRvK
+         @param     inDirectory     where the files are written
+         @param     inSubTables     the tables of the material that captures and promotions lead to
+
+         @return        false if the name is invalid or too large, a table of a capture or
+         promotion is missing, or a file could not be written
+         */
+        static bool                 generate(const std::string & inName,
+                                             const std::string & inDirectory,
+                                             const Tablebases & inSubTables);
+    };
+}
@@ -0,0 +1,137 @@
+/***************************************************************************************************
+ *
+ *  @file       TimeManager.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Time budget of a search
+ *
+ **************************************************************************************************/
+
+#include "TimeManager.h"
+
+#include <algorithm>
+
+using namespace chessEngine;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark TimeManager
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// The hard limit is at most this many soft limits
+static constexpr int64_t kMaxSoftLimits        = 5;
+
+// Share of the clock a single move may take, unless it is the last before the time control
+static constexpr int64_t kMaxClockShareNum     = 4;
+static constexpr int64_t kMaxClockShareDen     = 5;
+
+// Node rates are not measured over less than this
+static constexpr int64_t kMinRateSampleUs      = 1000;
+
+TimeManager::TimeManager()
+{
+    start(SearchLimits());
+}
+
+void
+TimeManager::start(const SearchLimits & inLimits)
+{
+    _softLimitUs      = 0;
+    _hardLimitUs      = 0;
+    _isFixed          = false;
+    _lastBestMove     = PackedMove();
+    _lastScore        = 0;
+    _numIterations    = 0;
+    _stableIterations = 0;
+    _scoreFactor      = 1.0;
+    _checkInterval    = kMinCheckInterval;
+
+    if (inLimits.moveTimeMs > 0)
+    {
+        // An iteration takes about as long as all the earlier ones together
+        _isFixed     = true;
+        _hardLimitUs = inLimits.moveTimeMs * 1000;
+        _softLimitUs = _hardLimitUs / 2;
+    }
+    else if (inLimits.timeLeftMs > 0)
+    {
+        int64_t movesToGo = (inLimits.movesToGo > 0) ? inLimits.movesToGo : kDefaultMovesToGo;
+        int64_t usableMs  = std::max<int64_t>(inLimits.timeLeftMs - kMoveOverheadMs, 1);
+        int64_t softMs    = usableMs / movesToGo + inLimits.incrementMs * 3 / 4;
+        int64_t maxMs     = (movesToGo == 1) ? usableMs :
+                                               usableMs * kMaxClockShareNum / kMaxClockShareDen;
+        int64_t hardMs    = std::min(softMs * kMaxSoftLimits, maxMs);
+
+        _hardLimitUs = std::max<int64_t>(hardMs, 1) * 1000;
+        _softLimitUs = std::min(std::max<int64_t>(softMs, 1) * 1000, _hardLimitUs);
+    }
+}
+
+void
+TimeManager::onIteration(PackedMove inBestMove, int inScore)
+{
+    if ((_numIterations > 0) && (inBestMove == _lastBestMove))
+    {
+        _stableIterations++;
+    }
+    else
+    {
+        _stableIterations = 0;
+    }
+
+    if (_numIterations > 0)
+    {
+        // A falling score means trouble, look deeper for a way out
+        int drop     = std::min(_lastScore - inScore, 100);
+        _scoreFactor = (drop > 0) ? (1.0 + drop / 200.0) : 1.0;
+    }
+
+    _numIterations++;
+    _lastBestMove = inBestMove;
+    _lastScore    = inScore;
+}
+
+int64_t
+TimeManager::getSoftLimitUs() const
+{
+    if (_isFixed)
+    {
+        return _softLimitUs;
+    }
+
+    // From 1.3 while the best move changes down to 0.7 once it stayed for 6 iterations
+    double stabilityFactor = 1.3 - 0.1 * std::min(_stableIterations, 6);
+    double scaledUs        = _softLimitUs * stabilityFactor * _scoreFactor;
+
+    return std::min(static_cast<int64_t>(scaledUs), _hardLimitUs);
+}
+
+bool
+TimeManager::shouldStartIteration(int64_t inElapsedUs) const
+{
+    return !isLimited() || (inElapsedUs < getSoftLimitUs());
+}
+
+void
+TimeManager::updateNodeRate(uint64_t inNodes, int64_t inElapsedUs)
+{
+    if (inElapsedUs < kMinRateSampleUs)
+    {
+        return;
+    }
+
+    uint64_t interval = inNodes * kCheckPeriodUs / static_cast<uint64_t>(inElapsedUs);
+
+    if (interval < kMinCheckInterval)
+    {
+        interval = kMinCheckInterval;
+    }
+    else if (interval > kMaxCheckInterval)
+    {
+        interval = kMaxCheckInterval;
+    }
+
+    _checkInterval = interval;
+}
@@ -0,0 +1,150 @@
+/***************************************************************************************************
+ *
+ *  @file       TimeManager.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Time budget of a search
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+
+namespace chessEngine
+{
+    /**
+     @class          SearchLimits
+
+     @brief          When a search stops, and how many lines it reports. A zero limit is no limit.
+     */
+    struct SearchLimits
+    {
+        int                         depth;
+        uint64_t                    nodes;
+        int64_t                     moveTimeMs;
+
+        /**
+         @brief         Clock of the side to move, used if there is no move time
+         */
+        int64_t                     timeLeftMs;
+        int64_t                     incrementMs;
+
+        /**
+         @brief         Moves until the next time control, zero if the clock is for the game
+         */
+        int                         movesToGo;
+
+        /**
+         @brief         Search the position expected after the opponent's reply, ignoring the
+         time limit until Search::ponderHit() is called
+         */
+        bool                        ponder;
+
+        /**
+         @brief         Number of best moves to search with their principal variations and exact
+         scores, rather than just the best one
+         */
+        int                         multiPv;
+
+        SearchLimits() :
+        depth(0), nodes(0), moveTimeMs(0), timeLeftMs(0), incrementMs(0), movesToGo(0),
+        ponder(false), multiPv(1)
+        { }
+    };
+
+    /**
+     @class          TimeManager
+
+     @brief          Decides how long a search may take
+
+     @discussion     The hard limit is a deadline, the search is stopped as soon as it is reached.
+     The soft limit only decides whether to start another iteration. It is stretched while the best
+     move keeps changing or the score drops, and shrunk once the best move is stable.
+
+     How often the clock is read is derived from the measured node rate, so that a deadline is met
+     within a fraction of a millisecond whatever the speed of the machine.
+     */
+    class TimeManager
+    {
+    public:
+        /**
+         @brief         Time kept back for the lag between the engine and the clock
+         */
+        static constexpr int64_t    kMoveOverheadMs     = 10;
+
+        /**
+         @brief         Moves the rest of the game is expected to take, if not given
+         */
+        static constexpr int        kDefaultMovesToGo   = 30;
+
+        /**
+         @brief         Target time between two reads of the clock
+         */
+        static constexpr int64_t    kCheckPeriodUs      = 250;
+
+        static constexpr uint64_t   kMinCheckInterval   = 64;
+        static constexpr uint64_t   kMaxCheckInterval   = 1 << 16;
+
+        TimeManager();
+
+        /**
+         @brief         Set up the budget of a search
+         */
+        void                        start(const SearchLimits & inLimits);
+
+        /**
+         @brief         Check if there is a time limit at all
+         */
+        bool                        isLimited() const { return _hardLimitUs > 0; }
+
+        /**
+         @brief         Adapt the soft limit after a completed iteration
+
+         @param     inBestMove      best move of the iteration
+         @param     inScore         score of the iteration
+         */
+        void                        onIteration(PackedMove inBestMove, int inScore);
+
+        /**
+         @brief         Check if another iteration should be started
+         */
+        bool                        shouldStartIteration(int64_t inElapsedUs) const;
+
+        bool                        isHardLimitReached(int64_t inElapsedUs) const
+        { return isLimited() && (inElapsedUs >= _hardLimitUs); }
+
+        /**
+         @brief         Update the node rate, from which the check interval follows
+         */
+        void                        updateNodeRate(uint64_t inNodes, int64_t inElapsedUs);
+
+        /**
+         @brief         Nodes to search before the clock is read again
+         */
+        uint64_t                    getCheckInterval() const { return _checkInterval; }
+
+        int64_t                     getSoftLimitUs() const;
+
+        int64_t                     getHardLimitUs() const { return _hardLimitUs; }
+
+    private:
+        int64_t                     _softLimitUs;
+        int64_t                     _hardLimitUs;
+
+        /**
+         @brief         Fixed move time, the full time is used whatever the stability
+         */
+        bool                        _isFixed;
+
+        PackedMove                  _lastBestMove;
+        int                         _lastScore;
+        int                         _numIterations;
+        int                         _stableIterations;
+        double                      _scoreFactor;
+
+        uint64_t                    _checkInterval;
+    };
+}
@@ -0,0 +1,204 @@
+/***************************************************************************************************
+ *
+ *  @file       TranspositionTable.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Cache of search results keyed by position
+ *
+ **************************************************************************************************/
+
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <new>
+
+using namespace chessEngine;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark TranspositionTable
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static constexpr size_t kCacheLineSize = 64;
+
+TranspositionTable::TranspositionTable(size_t inSizeMb) :
+_clusters(nullptr), _numClusters(0), _sizeMb(0), _generation(0)
+{
+    resize(inSizeMb);
+}
+
+void
+TranspositionTable::resize(size_t inSizeMb)
+{
+    size_t maxClusters = (std::max<size_t>(inSizeMb, 1) << 20) / sizeof(Cluster);
+    size_t numClusters = 1;
+
+    while ((numClusters << 1) <= maxClusters)
+    {
+        numClusters <<= 1;
+    }
+
+    // Over allocate to start the clusters on a cache line
+    _memory.reset(new uint8_t[numClusters * sizeof(Cluster) + kCacheLineSize]);
+
+    auto address = reinterpret_cast<uintptr_t>(_memory.get());
+    address      = (address + kCacheLineSize - 1) & ~(kCacheLineSize - 1);
+
+    _clusters    = reinterpret_cast<Cluster *>(address);
+    _numClusters = numClusters;
+    _sizeMb      = (numClusters * sizeof(Cluster)) >> 20;
+
+    for (size_t i = 0; i < _numClusters; i++)
+    {
+        new (&_clusters[i]) Cluster();
+    }
+
+    clear();
+}
+
+void
+TranspositionTable::clear()
+{
+    for (size_t i = 0; i < _numClusters; i++)
+    {
+        for (auto & entry : _clusters[i].entries)
+        {
+            entry.keyXorData.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    _generation = 0;
+}
+
+bool
+TranspositionTable::probe(ZobristKey inKey, Data * outData) const
+{
+    auto cluster = _getCluster(inKey);
+
+    for (auto & entry : cluster->entries)
+    {
+        auto data = entry.data.load(std::memory_order_relaxed);
+
+        if (((entry.keyXorData.load(std::memory_order_relaxed) ^ data) == inKey) && (data != 0))
+        {
+            *outData = _unpack(data);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+TranspositionTable::store(ZobristKey inKey, PackedMove inMove, int inScore, int inEval,
+                          int inDepth, Bound inBound)
+{
+    auto    cluster     = _getCluster(inKey);
+    Entry * replace     = &cluster->entries[0];
+    int     worstValue  = INT32_MAX;
+
+    for (auto & entry : cluster->entries)
+    {
+        auto data = entry.data.load(std::memory_order_relaxed);
+
+        if ((entry.keyXorData.load(std::memory_order_relaxed) ^ data) == inKey)
+        {
+            // Keep a deeper result of the same search, unless the new one is exact
+            Data old = _unpack(data);
+
+            if ((inBound != kExact) && (old.depth > inDepth + 2) &&
+                (_getGeneration(data) == _generation))
+            {
+                return;
+            }
+
+            if (inMove.isNull())
+            {
+                inMove = old.move;
+            }
+
+            replace = &entry;
+            break;
+        }
+
+        if (data == 0)
+        {
+            replace     = &entry;
+            worstValue  = INT32_MIN;
+            continue;
+        }
+
+        // Older searches lose 8 plies of value per generation
+        int age   = (_generation - _getGeneration(data)) & kGenerationMask;
+        int value = _unpack(data).depth - 8 * age;
+
+        if (value < worstValue)
+        {
+            replace     = &entry;
+            worstValue  = value;
+        }
+    }
+
+    Data newData;
+
+    newData.move  = inMove;
+    newData.score = static_cast<int16_t>(inScore);
+    newData.eval  = static_cast<int16_t>(inEval);
+    newData.depth = static_cast<int8_t>(std::max(std::min(inDepth, 127), -128));
+    newData.bound = inBound;
+
+    auto data = _pack(newData, _generation);
+
+    replace->keyXorData.store(inKey ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+int
+TranspositionTable::getHashFull() const
+{
+    size_t numClusters = std::min<size_t>(_numClusters, 1000 / kClusterSize);
+    int    numUsed     = 0;
+
+    for (size_t i = 0; i < numClusters; i++)
+    {
+        for (auto & entry : _clusters[i].entries)
+        {
+            auto data = entry.data.load(std::memory_order_relaxed);
+
+            if ((data != 0) && (_getGeneration(data) == _generation))
+            {
+                numUsed++;
+            }
+        }
+    }
+
+    return static_cast<int>(numUsed * 1000 / (numClusters * kClusterSize));
+}
+
+uint64_t
+TranspositionTable::_pack(const Data & inData, uint8_t inGeneration)
+{
+    return (static_cast<uint64_t>(inData.move.data) |
+            (static_cast<uint64_t>(static_cast<uint16_t>(inData.score)) << 16) |
+            (static_cast<uint64_t>(static_cast<uint16_t>(inData.eval)) << 32) |
+            (static_cast<uint64_t>(static_cast<uint8_t>(inData.depth)) << 48) |
+            (static_cast<uint64_t>(inData.bound) << 56) |
+            (static_cast<uint64_t>(inGeneration) << 58));
+}
+
+TranspositionTable::Data
+TranspositionTable::_unpack(uint64_t inData)
+{
+    Data data;
+
+    data.move.data = static_cast<uint16_t>(inData);
+    data.score     = static_cast<int16_t>(inData >> 16);
+    data.eval      = static_cast<int16_t>(inData >> 32);
+    data.depth     = static_cast<int8_t>(inData >> 48);
+    data.bound     = static_cast<Bound>((inData >> 56) & 0x3);
+
+    return data;
+}
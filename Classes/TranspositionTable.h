@@ -0,0 +1,140 @@
+/***************************************************************************************************
+ *
+ *  @file       TranspositionTable.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Cache of search results keyed by position
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "Zobrist.h"
+
+#include <atomic>
+#include <memory>
+
+namespace chessEngine
+{
+    /**
+     @class          TranspositionTable
+
+     @brief          A table of search results shared by all the search threads
+
+     @discussion     Entries are grouped in clusters of a cache line. Each entry holds the key
+     xor-ed with its data, so that an entry torn by two threads writing at once fails the key
+     check instead of returning wrong data. No locks are taken.
+     */
+    class TranspositionTable
+    {
+    public:
+        enum Bound : uint8_t
+        {
+            kNone                   = 0,
+            kUpper                  = 1,
+            kLower                  = 2,
+            kExact                  = kUpper | kLower
+        };
+
+        /**
+         @class          Data
+
+         @brief          Unpacked contents of an entry
+         */
+        struct Data
+        {
+            PackedMove              move;
+            int16_t                 score;
+            int16_t                 eval;
+            int8_t                  depth;
+            Bound                   bound;
+        };
+
+        static constexpr size_t     kDefaultSizeMb = 16;
+        static constexpr size_t     kClusterSize   = 4;
+
+        /**
+         @param     inSizeMb        size of the table in megabytes, rounded down to a power of 2
+         clusters
+         */
+        TranspositionTable(size_t inSizeMb = kDefaultSizeMb);
+
+        /**
+         @brief         Change the size of the table, which also clears it
+
+         @discussion    Not thread safe, no search may be running.
+         */
+        void                        resize(size_t inSizeMb);
+
+        void                        clear();
+
+        /**
+         @brief         Start a new search, ageing the entries of the earlier ones
+         */
+        void                        newSearch() { _generation = (_generation + 1) & kGenerationMask; }
+
+        /**
+         @brief         Look up a position
+
+         @return        true if there is an entry for the key
+         */
+        bool                        probe(ZobristKey inKey, Data * outData) const;
+
+        /**
+         @brief         Store the result of searching a position
+
+         @discussion    Replaces the entry of the same key, or otherwise the least valuable entry
+         of the cluster, preferring shallow entries of older searches. The move of an existing
+         entry is kept if inMove is null.
+         */
+        void                        store(ZobristKey inKey, PackedMove inMove, int inScore,
+                                          int inEval, int inDepth, Bound inBound);
+
+        /**
+         @brief         Start loading the cluster of a key into the cache, ahead of a probe
+         */
+        void                        prefetch(ZobristKey inKey) const
+        { PREFETCH(_getCluster(inKey)); }
+
+        /**
+         @brief         Permille of the entries used by the current search, estimated from the
+         first clusters
+         */
+        int                         getHashFull() const;
+
+        size_t                      getSizeMb() const { return _sizeMb; }
+
+        size_t                      getNumEntries() const { return _numClusters * kClusterSize; }
+
+    private:
+        static constexpr uint8_t    kGenerationMask = 0x3F;
+
+        struct Entry
+        {
+            std::atomic<uint64_t>   keyXorData;
+            std::atomic<uint64_t>   data;
+        };
+
+        struct Cluster
+        {
+            Entry                   entries[kClusterSize];
+        };
+
+        static uint64_t             _pack(const Data & inData, uint8_t inGeneration);
+        static Data                 _unpack(uint64_t inData);
+        static uint8_t              _getGeneration(uint64_t inData) { return inData >> 58; }
+
+        Cluster *                   _getCluster(ZobristKey inKey) const
+        { return &_clusters[inKey & (_numClusters - 1)]; }
+
+        std::unique_ptr<uint8_t[]>  _memory;
+        Cluster *                   _clusters;
+        size_t                      _numClusters;
+        size_t                      _sizeMb;
+
+        uint8_t                     _generation;
+    };
+}
@@ -0,0 +1,452 @@
+/***************************************************************************************************
+ *
+ *  @file       UciConnection.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Lines exchanged with an engine speaking UCI
+ *
+ **************************************************************************************************/
+
+#include "UciConnection.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+    #define NOMINMAX
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <csignal>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+using namespace chessEngine;
+
+static constexpr int64_t    kQuitTimeoutMs = 1000;
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t
+_getRemainingMs(Clock::time_point inDeadline)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(inDeadline -
+                                                                 Clock::now()).count();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark UciLocalConnection
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+UciLocalConnection::UciLocalConnection() :
+_buffer(this), _out(&_buffer), _engine(new UciEngine(_out)), _isQuit(false)
+{ }
+
+bool
+UciLocalConnection::send(const std::string & inLine)
+{
+    if (_isQuit)
+    {
+        return false;
+    }
+
+    _isQuit = !_engine->handleCommand(inLine);
+
+    return true;
+}
+
+bool
+UciLocalConnection::receive(int64_t inTimeoutMs, std::string * outLine)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (!_condition.wait_for(lock, std::chrono::milliseconds(inTimeoutMs),
+                             [this] { return !_lines.empty(); }))
+    {
+        return false;
+    }
+
+    *outLine = _lines.front();
+    _lines.pop_front();
+
+    return true;
+}
+
+UciLocalConnection::LineBuffer::int_type
+UciLocalConnection::LineBuffer::overflow(int_type inChar)
+{
+    if (traits_type::eq_int_type(inChar, traits_type::eof()))
+    {
+        return traits_type::not_eof(inChar);
+    }
+
+    if (traits_type::to_char_type(inChar) != '\n')
+    {
+        _line += traits_type::to_char_type(inChar);
+        return inChar;
+    }
+
+    // The engine writes every line under a lock of its own, so lines come whole
+    {
+        std::lock_guard<std::mutex> lock(_connection->_mutex);
+        _connection->_lines.push_back(_line);
+    }
+
+    _connection->_condition.notify_all();
+    _line.clear();
+
+    return inChar;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark UciProcess
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+UciProcess::receive(int64_t inTimeoutMs, std::string * outLine)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(inTimeoutMs);
+
+    while (true)
+    {
+        auto end = _received.find('\n');
+
+        if (end != std::string::npos)
+        {
+            // Engines on Windows may end their lines with a carriage return
+            *outLine = _received.substr(0, ((end > 0) && (_received[end - 1] == '\r')) ? end - 1
+                                                                                     : end);
+            _received.erase(0, end + 1);
+            return true;
+        }
+
+        auto remainingMs = _getRemainingMs(deadline);
+
+        if ((remainingMs <= 0) || !_read(remainingMs))
+        {
+            return false;
+        }
+    }
+}
+
+#if defined(_WIN32)
+
+UciProcess::UciProcess() :
+_process(nullptr), _input(nullptr), _output(nullptr)
+{ }
+
+UciProcess::~UciProcess()
+{
+    _stop();
+}
+
+bool
+UciProcess::start(const std::string & inCommand)
+{
+    _stop();
+
+    SECURITY_ATTRIBUTES attributes = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+    HANDLE              childInput, input, output, childOutput;
+
+    if (!CreatePipe(&childInput, &input, &attributes, 0))
+    {
+        return false;
+    }
+
+    if (!CreatePipe(&output, &childOutput, &attributes, 0))
+    {
+        CloseHandle(childInput);
+        CloseHandle(input);
+        return false;
+    }
+
+    // Only the ends of the child are inherited
+    SetHandleInformation(input, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(output, HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOA        startup = { };
+    PROCESS_INFORMATION process = { };
+    std::vector<char>   commandLine(inCommand.begin(), inCommand.end());
+
+    commandLine.push_back('\0');
+
+    startup.cb         = sizeof(startup);
+    startup.dwFlags    = STARTF_USESTDHANDLES;
+    startup.hStdInput  = childInput;
+    startup.hStdOutput = childOutput;
+    startup.hStdError  = GetStdHandle(STD_ERROR_HANDLE);
+
+    bool isStarted = (CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, TRUE, 0,
+                                     nullptr, nullptr, &startup, &process) != FALSE);
+
+    CloseHandle(childInput);
+    CloseHandle(childOutput);
+
+    if (!isStarted)
+    {
+        CloseHandle(input);
+        CloseHandle(output);
+        return false;
+    }
+
+    CloseHandle(process.hThread);
+
+    _process = process.hProcess;
+    _input   = input;
+    _output  = output;
+
+    return true;
+}
+
+bool
+UciProcess::send(const std::string & inLine)
+{
+    std::string line = inLine + "\n";
+    size_t      sent = 0;
+
+    while ((_input != nullptr) && (sent < line.size()))
+    {
+        DWORD size;
+
+        if (!WriteFile(_input, line.data() + sent, static_cast<DWORD>(line.size() - sent), &size,
+                       nullptr))
+        {
+            return false;
+        }
+
+        sent += size;
+    }
+
+    return (_input != nullptr);
+}
+
+bool
+UciProcess::_read(int64_t inTimeoutMs)
+{
+    // Anonymous pipes cannot be waited on with a timeout, so they are polled
+    auto deadline = Clock::now() + std::chrono::milliseconds(inTimeoutMs);
+
+    while (_output != nullptr)
+    {
+        DWORD available = 0;
+
+        if (!PeekNamedPipe(_output, nullptr, 0, nullptr, &available, nullptr))
+        {
+            return false;
+        }
+
+        if (available > 0)
+        {
+            char  data[4096];
+            DWORD size;
+
+            if (!ReadFile(_output, data, std::min<DWORD>(available, sizeof(data)), &size, nullptr))
+            {
+                return false;
+            }
+
+            _received.append(data, size);
+            return true;
+        }
+
+        if (_getRemainingMs(deadline) <= 0)
+        {
+            return true;
+        }
+
+        Sleep(1);
+    }
+
+    return false;
+}
+
+void
+UciProcess::_stop()
+{
+    if (_process == nullptr)
+    {
+        return;
+    }
+
+    send("quit");
+
+    if (WaitForSingleObject(_process, static_cast<DWORD>(kQuitTimeoutMs)) != WAIT_OBJECT_0)
+    {
+        TerminateProcess(_process, 1);
+        WaitForSingleObject(_process, INFINITE);
+    }
+
+    CloseHandle(_input);
+    CloseHandle(_output);
+    CloseHandle(_process);
+
+    _process = nullptr;
+    _input   = nullptr;
+    _output  = nullptr;
+    _received.clear();
+}
+
+#else
+
+UciProcess::UciProcess() :
+_pid(-1), _input(-1), _output(-1)
+{ }
+
+UciProcess::~UciProcess()
+{
+    _stop();
+}
+
+bool
+UciProcess::start(const std::string & inCommand)
+{
+    // Pipes are created and marked close on exec under a lock, so that a process started by
+    // another thread in between does not inherit them and keep them open
+    static std::mutex sForkMutex;
+
+    _stop();
+    signal(SIGPIPE, SIG_IGN);
+
+    std::lock_guard<std::mutex> lock(sForkMutex);
+
+    int input[2], output[2];
+
+    if (pipe(input) != 0)
+    {
+        return false;
+    }
+
+    if (pipe(output) != 0)
+    {
+        close(input[0]);
+        close(input[1]);
+        return false;
+    }
+
+    for (auto fd : { input[0], input[1], output[0], output[1] })
+    {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        execl("/bin/sh", "sh", "-c", inCommand.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+    }
+
+    close(input[0]);
+    close(output[1]);
+
+    if (pid < 0)
+    {
+        close(input[1]);
+        close(output[0]);
+        return false;
+    }
+
+    _pid    = pid;
+    _input  = input[1];
+    _output = output[0];
+
+    return true;
+}
+
+bool
+UciProcess::send(const std::string & inLine)
+{
+    std::string line = inLine + "\n";
+    size_t      sent = 0;
+
+    while ((_input >= 0) && (sent < line.size()))
+    {
+        auto size = write(_input, line.data() + sent, line.size() - sent);
+
+        if (size <= 0)
+        {
+            return false;
+        }
+
+        sent += static_cast<size_t>(size);
+    }
+
+    return (_input >= 0);
+}
+
+bool
+UciProcess::_read(int64_t inTimeoutMs)
+{
+    if (_output < 0)
+    {
+        return false;
+    }
+
+    pollfd output = { _output, POLLIN, 0 };
+    int    result = poll(&output, 1, static_cast<int>(inTimeoutMs));
+
+    if (result <= 0)
+    {
+        // Nothing in time, or a signal, which is as good as nothing for the caller
+        return true;
+    }
+
+    char data[4096];
+    auto size = read(_output, data, sizeof(data));
+
+    if (size <= 0)
+    {
+        return false;
+    }
+
+    _received.append(data, static_cast<size_t>(size));
+
+    return true;
+}
+
+void
+UciProcess::_stop()
+{
+    if (_pid < 0)
+    {
+        return;
+    }
+
+    send("quit");
+    close(_input);
+
+    auto deadline = Clock::now() + std::chrono::milliseconds(kQuitTimeoutMs);
+
+    while (waitpid(_pid, nullptr, WNOHANG) == 0)
+    {
+        if (_getRemainingMs(deadline) <= 0)
+        {
+            kill(_pid, SIGKILL);
+            waitpid(_pid, nullptr, 0);
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    close(_output);
+
+    _pid    = -1;
+    _input  = -1;
+    _output = -1;
+    _received.clear();
+}
+
+#endif
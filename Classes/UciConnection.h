@@ -0,0 +1,148 @@
+/***************************************************************************************************
+ *
+ *  @file       UciConnection.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Lines exchanged with an engine speaking UCI
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "UciEngine.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+
+namespace chessEngine
+{
+    /**
+     @class          UciConnection
+
+     @brief          Sends commands to an engine and receives its answers, one line at a time
+     */
+    class UciConnection
+    {
+    public:
+        virtual ~UciConnection() { }
+
+        /**
+         @brief         Send a command, without its line break
+
+         @return        false if the engine is gone
+         */
+        virtual bool                send(const std::string & inLine) = 0;
+
+        /**
+         @brief         Wait for the next line of the engine, without its line break
+
+         @return        false if none came in time, or the engine is gone
+         */
+        virtual bool                receive(int64_t inTimeoutMs, std::string * outLine) = 0;
+    };
+
+    /**
+     @class          UciLocalConnection
+
+     @brief          An engine of this build, run in the process
+
+     @discussion     Commands are handled on the thread sending them, searches on the worker of
+     the engine, as UciEngine does. The lines it writes are queued until received.
+     */
+    class UciLocalConnection : public UciConnection
+    {
+    public:
+        UciLocalConnection();
+
+        bool                        send(const std::string & inLine) override;
+
+        bool                        receive(int64_t inTimeoutMs, std::string * outLine) override;
+
+    private:
+        /**
+         @brief         Cuts what the engine writes into lines
+         */
+        class LineBuffer : public std::streambuf
+        {
+        public:
+            LineBuffer(UciLocalConnection * inConnection) :
+            _connection(inConnection)
+            { }
+
+        protected:
+            int_type                overflow(int_type inChar) override;
+
+        private:
+            UciLocalConnection *    _connection;
+            std::string             _line;
+        };
+
+        std::mutex                  _mutex;
+        std::condition_variable     _condition;
+        std::deque<std::string>     _lines;
+        LineBuffer                  _buffer;
+        std::ostream                _out;
+        std::unique_ptr<UciEngine>  _engine;
+        bool                        _isQuit;
+    };
+
+    /**
+     @class          UciProcess
+
+     @brief          An engine run as a process of its own, e.g. another build of this one
+
+     @discussion     The command is run by the shell, or by CreateProcess on Windows, with its
+     standard input and output connected to the pipes of the connection. The process is asked to
+     quit when the connection is destroyed, and killed if it does not within a second.
+
+     Writing to a process that is gone would raise SIGPIPE, which is ignored from the first start
+     on.
+     */
+    class UciProcess : public UciConnection
+    {
+    public:
+        UciProcess();
+
+        ~UciProcess();
+
+        UciProcess(const UciProcess &) = delete;
+        UciProcess & operator= (const UciProcess &) = delete;
+
+        /**
+         @return        false if the process could not be started
+         */
+        bool                        start(const std::string & inCommand);
+
+        bool                        send(const std::string & inLine) override;
+
+        bool                        receive(int64_t inTimeoutMs, std::string * outLine) override;
+
+    private:
+        /**
+         @brief         Read what the process wrote so far, waiting up to a timeout for anything
+
+         @return        false if the process closed its output
+         */
+        bool                        _read(int64_t inTimeoutMs);
+
+        void                        _stop();
+
+        std::string                 _received;
+
+#if defined(_WIN32)
+        void *                      _process;
+        void *                      _input;
+        void *                      _output;
+#else
+        int                         _pid;
+        int                         _input;
+        int                         _output;
+#endif
+    };
+}
@@ -0,0 +1,493 @@
+/***************************************************************************************************
+ *
+ *  @file       UciEngine.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      The engine behind the UCI protocol
+ *
+ **************************************************************************************************/
+
+#include "UciEngine.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+
+using namespace chessEngine;
+
+static std::string
+_toLower(std::string inString)
+{
+    std::transform(inString.begin(), inString.end(), inString.begin(),
+                   [] (char inChar) { return static_cast<char>(tolower(inChar)); });
+    return inString;
+}
+
+/**
+ @brief         Legal move of a position in long algebraic notation, null if there is none
+ */
+static PackedMove
+_parseMove(const ChessEngine & inPosition, const std::string & inMove)
+{
+    MoveList moves;
+    inPosition.generateLegalMoves(&moves);
+
+    for (auto move : moves)
+    {
+        if (move.toString() == inMove)
+        {
+            return move;
+        }
+    }
+
+    return PackedMove();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark UciEngine
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+UciEngine::UciEngine(std::ostream & inOut) :
+_out(inOut), _table(TranspositionTable::kDefaultSizeMb), _multiPv(1), _network(),
+_isStopRequested(false)
+{
+    _addSearch();
+}
+
+UciEngine::~UciEngine()
+{
+    _stopSearch();
+}
+
+bool
+UciEngine::handleCommand(const std::string & inCommand)
+{
+    std::istringstream args(inCommand);
+    std::string        command;
+
+    args >> command;
+
+    if (command == "uci")
+    {
+        _uci();
+    }
+    else if (command == "isready")
+    {
+        _send("readyok");
+    }
+    else if (command == "ucinewgame")
+    {
+        _newGame();
+    }
+    else if (command == "setoption")
+    {
+        _setOption(args);
+    }
+    else if (command == "position")
+    {
+        _setPosition(args);
+    }
+    else if (command == "go")
+    {
+        _go(args);
+    }
+    else if (command == "stop")
+    {
+        _stopSearch();
+    }
+    else if (command == "ponderhit")
+    {
+        _searches[0]->ponderHit();
+    }
+    else if (command == "quit")
+    {
+        _stopSearch();
+        return false;
+    }
+
+    return true;
+}
+
+void
+UciEngine::waitForSearch()
+{
+    if (_worker.joinable())
+    {
+        _worker.join();
+    }
+}
+
+void
+UciEngine::_uci()
+{
+    std::ostringstream options;
+
+    _send("id name Chess");
+    _send("id author Virag Doshi");
+
+    options << "option name Hash type spin default " << TranspositionTable::kDefaultSizeMb
+            << " min 1 max " << kMaxHashSizeMb;
+    _send(options.str());
+
+    options.str("");
+    options << "option name Threads type spin default 1 min 1 max " << kMaxThreads;
+    _send(options.str());
+
+    options.str("");
+    options << "option name MultiPV type spin default 1 min 1 max " << kMaxMultiPv;
+    _send(options.str());
+
+    // Only tells the interface that it may send go ponder
+    _send("option name Ponder type check default false");
+
+    // A network file, <empty> for the handcrafted evaluation
+    _send("option name EvalFile type string default <empty>");
+    _send("uciok");
+}
+
+void
+UciEngine::_newGame()
+{
+    _stopSearch();
+    _table.clear();
+
+    for (auto & search : _searches)
+    {
+        search->clearHistory();
+    }
+}
+
+void
+UciEngine::_setOption(std::istringstream & inArgs)
+{
+    std::string token;
+    std::string name;
+    std::string value;
+    std::string * part = nullptr;
+
+    // Names may have spaces
+    while (inArgs >> token)
+    {
+        if (token == "name")
+        {
+            part = &name;
+        }
+        else if (token == "value")
+        {
+            part = &value;
+        }
+        else if (part != nullptr)
+        {
+            *part += (part->empty() ? "" : " ") + token;
+        }
+    }
+
+    _stopSearch();
+
+    name = _toLower(name);
+
+    if (name == "hash")
+    {
+        long long sizeMb = std::max(1LL, std::min(atoll(value.c_str()),
+                                                 static_cast<long long>(kMaxHashSizeMb)));
+        _table.resize(static_cast<size_t>(sizeMb));
+    }
+    else if (name == "threads")
+    {
+        int numThreads = std::max(1, std::min(atoi(value.c_str()), static_cast<int>(kMaxThreads)));
+
+        _searches.resize(std::min(_searches.size(), static_cast<size_t>(numThreads)));
+
+        while (_searches.size() < static_cast<size_t>(numThreads))
+        {
+            _addSearch();
+        }
+    }
+    else if (name == "multipv")
+    {
+        _multiPv = std::max(1, std::min(atoi(value.c_str()), static_cast<int>(kMaxMultiPv)));
+    }
+    else if (name == "evalfile")
+    {
+        std::unique_ptr<nnue::Network> network;
+
+        if (!value.empty() && (value != "<empty>"))
+        {
+            network.reset(new nnue::Network());
+
+            // The evaluation in use is kept if the file is not a network
+            if (!network->load(value.c_str()))
+            {
+                _send("info string Could not load the network " + value);
+                return;
+            }
+        }
+
+        // No search runs, so the old network is not in use once the position lets it go
+        _position.setNetwork(network.get());
+        _network = std::move(network);
+    }
+}
+
+void
+UciEngine::_setPosition(std::istringstream & inArgs)
+{
+    std::string token;
+    ChessEngine position;
+
+    position.setNetwork(_network.get());
+    inArgs >> token;
+
+    if (token == "fen")
+    {
+        std::string fen;
+
+        while ((inArgs >> token) && (token != "moves"))
+        {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+
+        if (!position.setFen(fen))
+        {
+            _send("info string Invalid FEN " + fen);
+            return;
+        }
+    }
+    else if (token == "startpos")
+    {
+        inArgs >> token;
+    }
+    else
+    {
+        return;
+    }
+
+    // The moves are made rather than set up, so that repetitions are known to the search
+    if (token == "moves")
+    {
+        while (inArgs >> token)
+        {
+            auto move = _parseMove(position, token);
+
+            if (move.isNull())
+            {
+                _send("info string Illegal move " + token);
+                break;
+            }
+
+            position.makeMove(move);
+        }
+    }
+
+    _stopSearch();
+    _position = position;
+}
+
+void
+UciEngine::_go(std::istringstream & inArgs)
+{
+    using attributes::ChessColor;
+
+    _stopSearch();
+
+    SearchLimits limits;
+    std::string  token;
+    bool         isInfinite = false;
+    bool         isWhite    = (_position.getCurrMove() == ChessColor::kWhite);
+
+    limits.multiPv = _multiPv;
+
+    while (inArgs >> token)
+    {
+        long long value = 0;
+
+        if (token == "infinite")
+        {
+            isInfinite = true;
+        }
+        else if (token == "ponder")
+        {
+            limits.ponder = true;
+        }
+        else if (inArgs >> value)
+        {
+            if (token == "depth")
+            {
+                limits.depth = static_cast<int>(std::min<long long>(value, Search::kMaxDepth));
+            }
+            else if (token == "nodes")
+            {
+                limits.nodes = static_cast<uint64_t>(value);
+            }
+            else if (token == "movetime")
+            {
+                limits.moveTimeMs = value;
+            }
+            else if (token == (isWhite ? "wtime" : "btime"))
+            {
+                limits.timeLeftMs = value;
+            }
+            else if (token == (isWhite ? "winc" : "binc"))
+            {
+                limits.incrementMs = value;
+            }
+            else if (token == "movestogo")
+            {
+                limits.movesToGo = static_cast<int>(value);
+            }
+        }
+        else
+        {
+            inArgs.clear();
+        }
+    }
+
+    // Without any limit the search goes on until stopped
+    isInfinite = isInfinite || ((limits.depth == 0) && (limits.nodes == 0) &&
+                                (limits.moveTimeMs == 0) && (limits.timeLeftMs == 0) &&
+                                !limits.ponder);
+
+    // A stop or hit received from here on is for this search, and must not be lost
+    for (auto & search : _searches)
+    {
+        search->resetStop();
+        search->resetPonderHit();
+    }
+
+    _isStopRequested = false;
+    _worker          = std::thread(&UciEngine::_search, this, _position, limits, isInfinite);
+}
+
+void
+UciEngine::_addSearch()
+{
+    std::unique_ptr<Search> search(new Search(&_table));
+
+    // The table is aged once per go, before any of the threads start
+    search->setTableAging(false);
+    search->setHelperIndex(static_cast<int>(_searches.size()));
+    _searches.push_back(std::move(search));
+}
+
+void
+UciEngine::_stopSearch()
+{
+    if (!_worker.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_stopMutex);
+        _isStopRequested = true;
+    }
+
+    _stopCondition.notify_one();
+
+    for (auto & search : _searches)
+    {
+        search->stop();
+    }
+
+    _worker.join();
+}
+
+void
+UciEngine::_search(const ChessEngine & inPosition, const SearchLimits & inLimits,
+                   bool inIsInfinite)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // The helpers have no limits of their own, they are stopped with the first thread
+    std::vector<SearchResult> helperResults(_searches.size());
+    std::vector<std::thread>  helpers;
+
+    _table.newSearch();
+
+    for (size_t i = 1; i < _searches.size(); i++)
+    {
+        helpers.emplace_back([this, i, &inPosition, &helperResults] {
+            helperResults[i] = _searches[i]->run(inPosition, SearchLimits());
+        });
+    }
+
+    auto result = _searches[0]->run(inPosition, inLimits, [this] (const SearchInfo & inInfo) {
+        _send(_formatInfo(inInfo));
+    });
+
+    for (size_t i = 1; i < _searches.size(); i++)
+    {
+        _searches[i]->stop();
+        helpers[i - 1].join();
+
+        result.stats += helperResults[i].stats;
+    }
+
+    // The protocol does not allow the best move of an infinite search before stop
+    if (inIsInfinite)
+    {
+        std::unique_lock<std::mutex> lock(_stopMutex);
+        _stopCondition.wait(lock, [this] { return _isStopRequested; });
+    }
+
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::ostringstream line;
+
+    line << "info nodes " << result.stats.nodes << " time " << elapsedMs
+         << " nps " << (result.stats.nodes * 1000 / std::max<long long>(elapsedMs, 1))
+         << " hashfull " << _table.getHashFull();
+    _send(line.str());
+
+    line.str("");
+    line << "bestmove " << (result.bestMove.isNull() ? "0000" : result.bestMove.toString());
+
+    if (!result.ponderMove.isNull())
+    {
+        line << " ponder " << result.ponderMove.toString();
+    }
+
+    _send(line.str());
+}
+
+void
+UciEngine::_send(const std::string & inLine)
+{
+    std::lock_guard<std::mutex> lock(_outMutex);
+
+    _out << inLine << std::endl;
+}
+
+std::string
+UciEngine::_formatInfo(const SearchInfo & inInfo) const
+{
+    std::ostringstream line;
+
+    line << "info depth " << inInfo.depth << " seldepth " << inInfo.selDepth
+         << " multipv " << inInfo.multiPv;
+
+    if (inInfo.isMate())
+    {
+        line << " score mate " << inInfo.getMateInMoves();
+    }
+    else
+    {
+        line << " score cp " << inInfo.score;
+    }
+
+    line << " nodes " << inInfo.nodes << " time " << inInfo.timeMs
+         << " nps " << (inInfo.nodes * 1000 / std::max<int64_t>(inInfo.timeMs, 1))
+         << " pv";
+
+    for (auto move : inInfo.pv)
+    {
+        line << " " << move.toString();
+    }
+
+    return line.str();
+}
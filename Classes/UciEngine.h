@@ -0,0 +1,144 @@
+/***************************************************************************************************
+ *
+ *  @file       UciEngine.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      The engine behind the UCI protocol
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include "Chess.h"
+#include "ChessEngine.h"
+#include "Nnue.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chessEngine
+{
+    /**
+     @class          UciEngine
+
+     @brief          Handles the commands of a UCI graphical interface, one line at a time
+
+     @discussion     Searches run on a worker thread, so that stop and ponderhit are handled while
+     they run. The worker writes the info and bestmove lines, the thread handling commands writes
+     the answers to them, each line under a lock.
+
+     With more than one thread, the searches run Lazy SMP: every thread searches the same position
+     with its own history, sharing only the table. The helpers skip iterations, each in its own
+     pattern, so that they run ahead of the first thread at other depths. The first thread reports
+     and decides the move, the others are stopped when it returns, and their counters are added to
+     its own.
+
+     Supported are uci, isready, ucinewgame, setoption for Hash, Threads, MultiPV, Ponder and
+     EvalFile, position with startpos or fen and moves, go with depth, nodes, movetime, wtime,
+     btime, winc, binc, movestogo, infinite and ponder, stop, ponderhit and quit. EvalFile loads a
+     network for the evaluation in place of the handcrafted one, <empty> goes back to it.
+     */
+    class UciEngine
+    {
+    public:
+        static constexpr size_t     kMaxHashSizeMb = 4096;
+        static constexpr int        kMaxThreads    = 64;
+        static constexpr int        kMaxMultiPv    = 64;
+
+        /**
+         @param     inOut           where the answers are written
+         */
+        UciEngine(std::ostream & inOut);
+
+        /**
+         @brief         Stops the running search and waits for it
+         */
+        ~UciEngine();
+
+        UciEngine(const UciEngine &) = delete;
+        UciEngine & operator= (const UciEngine &) = delete;
+
+        /**
+         @brief         Handle a command, without its line break
+
+         @discussion    Unknown commands are ignored, as the protocol asks.
+
+         @return        false once quit was received
+         */
+        bool                        handleCommand(const std::string & inCommand);
+
+        /**
+         @brief         Wait until the running search, if any, has written its best move
+
+         @discussion    Never returns for an infinite or ponder search that is not stopped.
+         */
+        void                        waitForSearch();
+
+    private:
+        void                        _uci();
+
+        void                        _newGame();
+
+        void                        _setOption(std::istringstream & inArgs);
+
+        void                        _setPosition(std::istringstream & inArgs);
+
+        void                        _go(std::istringstream & inArgs);
+
+        /**
+         @brief         Add the search of one more thread
+         */
+        void                        _addSearch();
+
+        /**
+         @brief         Stop the running search, if any, and wait for it
+         */
+        void                        _stopSearch();
+
+        /**
+         @brief         Search on the worker thread, and write the best move
+
+         @param     inIsInfinite    the best move is only written once stop is received
+         */
+        void                        _search(const ChessEngine & inPosition,
+                                            const SearchLimits & inLimits, bool inIsInfinite);
+
+        /**
+         @brief         Write a line of the protocol
+         */
+        void                        _send(const std::string & inLine);
+
+        /**
+         @brief         The info line of a line of the principal variation
+         */
+        std::string                 _formatInfo(const SearchInfo & inInfo) const;
+
+        std::ostream &              _out;
+        std::mutex                  _outMutex;
+
+        TranspositionTable          _table;
+        std::vector<std::unique_ptr<Search>> _searches;
+        int                         _multiPv;
+
+        ChessEngine                 _position;
+
+        /**
+         @brief         Network of the EvalFile option, null for the handcrafted evaluation
+         */
+        std::unique_ptr<nnue::Network> _network;
+
+        std::thread                 _worker;
+        std::mutex                  _stopMutex;
+        std::condition_variable     _stopCondition;
+        bool                        _isStopRequested;
+    };
+}
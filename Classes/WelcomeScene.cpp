@@ -58,7 +58,7 @@ WelcomeScene::init()
     actions.pushBack(cocos2d::DelayTime::create(1.5));
     actions.pushBack(cocos2d::FadeTo::create(1.5, 0));
     actions.pushBack(cocos2d::CallFunc::create([=] () -> void {
-        LOG("Sending callback");
+        chessEngine::log("Sending callback");
         this->_actionsOver();
     }));
 
@@ -86,9 +86,9 @@ WelcomeScene::init()
 void
 WelcomeScene::_actionsOver()
 {
-	auto event = new AppEvent(ChessAppEvents::kWelcomeScreenAnimationOver);
-	stateMachine->receiveEvent(event);
-    LOG("Event sent");
+	AppEvent event(ChessAppEvents::kWelcomeScreenAnimationOver);
+	stateMachine->receiveEvent(&event);
+    chessEngine::log("Event sent");
 }
 
 
@@ -100,25 +100,25 @@ WelcomeScene::_actionsOver()
 void
 WelcomeSceneState::_enter()
 {
-    LOG("WelcomeSceneState::_enter()");
+    chessEngine::log("WelcomeSceneState::_enter()");
     
     WelcomeScene * welcomeScene;
     auto scene = WelcomeScene::createScene(_getStateMachine(), &welcomeScene);
     AppDelegate::getInstance()->setNewScene(scene);
     
-    LOG("WelcomeSceneState::_enter() new scene careated");
+    chessEngine::log("WelcomeSceneState::_enter() new scene careated");
 }
 
 void
 WelcomeSceneState::_exit()
 {
-    LOG("WelcomeSceneState::_exit()");
+    chessEngine::log("WelcomeSceneState::_exit()");
 }
 
 AppState *
 WelcomeSceneState::_react(AppEvent * inEvent)
 {
-    LOG("WelcomeSceneState::_react(%d)", inEvent->getID());
+    chessEngine::log("WelcomeSceneState::_react(%d)", inEvent->getID());
     
 	switch (inEvent->getID())
 	{
@@ -13,6 +13,8 @@
 #include "Chess.h"
 #include "ChessAppStateMachine.h"
 
+#include "cocos2d.h"
+
 namespace render
 {
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,67 @@
+/***************************************************************************************************
+ *
+ *  @file       Zobrist.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Zobrist keys used to hash positions
+ *
+ **************************************************************************************************/
+
+#include "Zobrist.h"
+
+using namespace chessEngine;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark -
+#pragma mark ZobristLUT
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ZobristKey       ZobristLUT::kPieces[2][6][64];
+ZobristKey       ZobristLUT::kCastling[4];
+ZobristKey       ZobristLUT::kEnPassantFile[8];
+ZobristKey       ZobristLUT::kBlackToMove;
+ZobristKey       ZobristLUT::kNoPawns;
+
+// xorshift64* with a fixed seed, so that the keys (and anything keyed by them) are the same
+// across runs and builds
+static ZobristKey
+_nextRandom(ZobristKey * inOutState)
+{
+    *inOutState ^= *inOutState >> 12;
+    *inOutState ^= *inOutState << 25;
+    *inOutState ^= *inOutState >> 27;
+
+    return *inOutState * 0x2545F4914F6CDD1DULL;
+}
+
+void
+ZobristLUT::init()
+{
+    ZobristKey state = 0x9D39247E33776D41ULL;
+
+    for (auto color = 0; color < 2; color++)
+    {
+        for (auto piece = 0; piece < 6; piece++)
+        {
+            for (auto sq = 0; sq < 64; sq++)
+            {
+                kPieces[color][piece][sq] = _nextRandom(&state);
+            }
+        }
+    }
+
+    for (auto i = 0; i < 4; i++)
+    {
+        kCastling[i] = _nextRandom(&state);
+    }
+
+    for (auto i = 0; i < 8; i++)
+    {
+        kEnPassantFile[i] = _nextRandom(&state);
+    }
+
+    kBlackToMove = _nextRandom(&state);
+    kNoPawns     = _nextRandom(&state);
+}
@@ -0,0 +1,75 @@
+/***************************************************************************************************
+ *
+ *  @file       Zobrist.h
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Zobrist keys used to hash positions
+ *
+ **************************************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include "Chess.h"
+
+namespace chessEngine
+{
+    using ZobristKey = uint64_t;
+
+    namespace ZobristLUT
+    {
+        /**
+         @brief         Keys for a piece of a color on a square, indexed by [color][piece][square]
+         */
+        extern ZobristKey           kPieces[2][6][64];
+
+        /**
+         @brief         Keys for each castling right, white king side, white queen side, black
+         king side and black queen side
+         */
+        extern ZobristKey           kCastling[4];
+
+        /**
+         @brief         Keys for the file of the en passant square, only used when a capture is
+         possible
+         */
+        extern ZobristKey           kEnPassantFile[8];
+
+        /**
+         @brief         Key toggled when it is black's turn
+         */
+        extern ZobristKey           kBlackToMove;
+
+        /**
+         @brief         Seed of the pawn key so that a position without pawns does not hash to 0
+         */
+        extern ZobristKey           kNoPawns;
+
+        void                        init();
+
+        static inline ZobristKey    getForPiece(attributes::ChessColor inColor,
+                                                attributes::ChessPieceName inPiece,
+                                                uint8_t inSquareIndex)
+        {
+            return kPieces[static_cast<uint8_t>(inColor)][static_cast<uint8_t>(inPiece)]
+                          [inSquareIndex];
+        }
+
+        static inline ZobristKey    getForCastling(uint8_t inCastlingRights)
+        {
+            ZobristKey key = 0;
+
+            for (auto i = 0; i < 4; i++)
+            {
+                if (inCastlingRights & (1 << i))
+                {
+                    key ^= kCastling[i];
+                }
+            }
+
+            return key;
+        }
+    }
+}
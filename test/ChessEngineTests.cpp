@@ -0,0 +1,401 @@
+/***************************************************************************************************
+ *
+ *  @file       ChessEngineTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+
+using namespace chessEngine;
+
+static PackedMove
+_move(const char * inSrc, const char * inDest, uint8_t inFlags)
+{
+    Square src(inSrc[1] - '1', inSrc[0] - 'a');
+    Square dest(inDest[1] - '1', inDest[0] - 'a');
+    
+    return PackedMove(src, dest, inFlags);
+}
+
+static void
+_checkKeys(const ChessEngine & inEngine)
+{
+    CHECK(inEngine.getHashKey() == inEngine.computeHashKey());
+    CHECK(inEngine.getPawnKey() == inEngine.computePawnKey());
+}
+
+TEST_CASE( "Test FEN", "[ChessEngine]")
+{
+    ChessEngine::init();
+    
+    ChessEngine engine;
+    
+    CHECK(engine.getFen() == ChessEngine::kStartFen);
+    
+    const char * fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 2"
+    };
+    
+    for (auto fen : fens)
+    {
+        INFO(fen);
+        
+        REQUIRE(engine.setFen(fen));
+        CHECK(engine.getFen() == fen);
+        _checkKeys(engine);
+    }
+    
+    CHECK(engine.getEnPassantSquare().index == Square(5, 3).index);
+    
+    // No white pawn next to d5, so the square is dropped
+    REQUIRE(engine.setFen("4k3/8/8/3p4/8/8/8/4K3 w - d6 0 2"));
+    CHECK(engine.getEnPassantSquare().isOutside());
+    
+    auto fen = engine.getFen();
+    
+    CHECK_FALSE(engine.setFen("4k3/8/8/9/8/8/8/4K3 w - - 0 1"));
+    CHECK_FALSE(engine.setFen("4k3/8/8/8/8/8/4K3 w - - 0 1"));
+    CHECK_FALSE(engine.setFen("4k3/8/8/8/8/8/8/4K3 x - - 0 1"));
+    CHECK(engine.getFen() == fen);
+}
+
+TEST_CASE( "Test make and unmake", "[ChessEngine]")
+{
+    ChessEngine::init();
+    
+    ChessEngine engine;
+    
+    REQUIRE(engine.setFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"));
+    
+    auto startFen = engine.getFen();
+    auto startKey = engine.getHashKey();
+    
+    PackedMove moves[] = {
+        _move("e1", "g1", PackedMove::kKingCastle),
+        _move("e8", "c8", PackedMove::kQueenCastle),
+        _move("a2", "a4", PackedMove::kDoublePawnPush),
+        _move("b4", "a3", PackedMove::kEnPassant),
+        _move("d5", "e6", PackedMove::kCapture),
+        _move("a3", "b2", PackedMove::kCapture),
+        _move("e6", "f7", PackedMove::kCapture),
+        _move("b2", "a1", PackedMove::kKnightPromotionCapture)
+    };
+    
+    std::vector<std::string> fens;
+    
+    for (auto move : moves)
+    {
+        INFO(move.toString());
+        
+        fens.push_back(engine.getFen());
+        engine.makeMove(move);
+        _checkKeys(engine);
+    }
+    
+    CHECK(engine.getFen() == "2kr3r/p1ppqPb1/bn3np1/4N3/4P3/2N2Q1p/2PBBPPP/n4RK1 w - - 0 5");
+    CHECK(engine.getNumMovesMade() == 8);
+    
+    for (auto i = fens.size(); i > 0; i--)
+    {
+        engine.unmakeMove();
+        
+        CHECK(engine.getFen() == fens[i - 1]);
+        _checkKeys(engine);
+    }
+    
+    CHECK(engine.getFen() == startFen);
+    CHECK(engine.getHashKey() == startKey);
+}
+
+TEST_CASE( "Test attempt move side effects", "[ChessEngine]")
+{
+    ChessEngine::init();
+    
+    ChessEngine engine;
+    Move        sideEffect;
+    bool        isPromotion;
+    
+    REQUIRE(engine.setFen("r3k2n/6P1/8/3pP3/8/8/8/R3K2R w KQq d6 0 1"));
+    
+    // En passant removes the pawn next to the capturing pawn
+    REQUIRE(engine.attemptMove(Move(Position(4, 4), Position(5, 3)), &sideEffect, &isPromotion));
+    CHECK(sideEffect.src.row == 4);
+    CHECK(sideEffect.src.col == 3);
+    CHECK(sideEffect.dest.isOutside());
+    CHECK_FALSE(isPromotion);
+    
+    // Castling moves the rook
+    REQUIRE(engine.attemptMove(Move(Position(7, 4), Position(7, 2)), &sideEffect, &isPromotion));
+    CHECK(sideEffect.src.row == 7);
+    CHECK(sideEffect.src.col == 0);
+    CHECK(sideEffect.dest.row == 7);
+    CHECK(sideEffect.dest.col == 3);
+    
+    // Promotion with a capture
+    REQUIRE(engine.attemptMove(Move(Position(6, 6), Position(7, 7)), &sideEffect, &isPromotion));
+    CHECK(sideEffect.src.row == 7);
+    CHECK(sideEffect.src.col == 7);
+    CHECK(sideEffect.dest.isOutside());
+    CHECK(isPromotion);
+    
+    CHECK(engine.getFen() == "2kr3Q/8/3P4/8/8/8/8/R3K2R b KQ - 0 2");
+    
+    // Moving the opponent's piece is refused
+    CHECK_FALSE(engine.attemptMove(Move(Position(0, 0), Position(1, 0)), &sideEffect, &isPromotion));
+}
+
+TEST_CASE( "Test packed position", "[ChessEngine]")
+{
+    ChessEngine::init();
+    
+    ChessEngine    engine;
+    ChessEngine    unpacked;
+    PackedPosition packed;
+    
+    const char * fens[] = {
+        ChessEngine::kStartFen,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/8/8/8/8/8/8/R3K2R b Kq - 7 60",
+        "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 2",
+        "4k3/8/8/8/3pP3/8/8/4K3 b - e3 0 300",
+        "8/8/8/8/8/8/8/k6K b - - 99 1"
+    };
+    
+    for (auto fen : fens)
+    {
+        INFO(fen);
+        
+        REQUIRE(engine.setFen(fen));
+        REQUIRE(engine.getPackedPosition(&packed));
+        REQUIRE(unpacked.setPackedPosition(packed));
+        CHECK(unpacked.getFen() == fen);
+        CHECK(unpacked.getHashKey() == engine.getHashKey());
+        _checkKeys(unpacked);
+    }
+    
+    // The side to move and the en passant square change the board bytes, the clocks do not
+    PackedPosition other;
+    
+    auto isSameBoard = [&] {
+        return std::equal(packed.data.begin(), packed.data.begin() + PackedPosition::kBoardSize,
+                          other.data.begin());
+    };
+    
+    REQUIRE(engine.setFen("4k3/8/8/3pP3/8/8/8/4K3 w - - 0 2"));
+    REQUIRE(engine.getPackedPosition(&packed));
+    REQUIRE(engine.setFen("4k3/8/8/3pP3/8/8/8/4K3 b - - 0 2"));
+    REQUIRE(engine.getPackedPosition(&other));
+    CHECK_FALSE(isSameBoard());
+    
+    REQUIRE(engine.setFen("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 2"));
+    REQUIRE(engine.getPackedPosition(&other));
+    CHECK_FALSE(isSameBoard());
+    
+    REQUIRE(engine.setFen("4k3/8/8/3pP3/8/8/8/4K3 w - d6 12 40"));
+    REQUIRE(engine.getPackedPosition(&packed));
+    CHECK(packed != other);
+    CHECK(isSameBoard());
+    
+    // Positions reached in random games pack and unpack as they are
+    uint32_t random = 3;
+    
+    for (int game = 0; game < 20; game++)
+    {
+        engine.setFen(ChessEngine::kStartFen);
+        
+        for (int ply = 0; ply < 200; ply++)
+        {
+            MoveList moves;
+            engine.generateLegalMoves(&moves);
+            
+            if (moves.isEmpty())
+            {
+                break;
+            }
+            
+            random = random * 1103515245 + 12345;
+            engine.makeMove(moves[(random >> 16) % moves.size]);
+            
+            REQUIRE(engine.getPackedPosition(&packed));
+            REQUIRE(unpacked.setPackedPosition(packed));
+            CHECK(unpacked.getFen() == engine.getFen());
+        }
+    }
+    
+    // A castling right without its rook, or too many pieces, cannot be packed
+    REQUIRE(engine.setFen("4k3/8/8/8/8/8/8/4K3 w K - 0 1"));
+    CHECK_FALSE(engine.getPackedPosition(&packed));
+    REQUIRE(engine.setFen("QQQQQQQQ/QQQQQQQQ/QQQQQQQQ/QQQQQQQQ/Q7/8/8/k6K w - - 0 1"));
+    CHECK_FALSE(engine.getPackedPosition(&packed));
+    
+    // A castling rook away from its corner is not valid data
+    auto fen = unpacked.getFen();
+    
+    REQUIRE(engine.setFen("4k3/8/8/8/8/8/8/R3K3 w Q - 0 1"));
+    REQUIRE(engine.getPackedPosition(&packed));
+    packed.data[0] = 0x02;
+    CHECK_FALSE(unpacked.setPackedPosition(packed));
+    CHECK(unpacked.getFen() == fen);
+}
+
+/**
+ @brief         Write the checksum of a snapshot that was changed on purpose
+ */
+static void
+_signSnapshot(std::vector<uint8_t> * inOutData)
+{
+    uint32_t crc    = 0xFFFFFFFF;
+    auto     offset = ChessEngine::kSnapshotChecksumOffset;
+    
+    for (size_t i = 0; i < inOutData->size(); i++)
+    {
+        crc ^= ((i >= offset) && (i < offset + 4)) ? 0 : (*inOutData)[i];
+        
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+        }
+    }
+    
+    crc = ~crc;
+    
+    for (size_t i = 0; i < 4; i++)
+    {
+        (*inOutData)[offset + i] = static_cast<uint8_t>(crc >> (8 * i));
+    }
+}
+
+TEST_CASE( "Test snapshot", "[ChessEngine]")
+{
+    ChessEngine::init();
+    
+    ChessEngine          engine;
+    ChessEngine          restored;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> other;
+    
+    // Random games, with their moves unmade on the restored engine down to the start
+    uint32_t random = 7;
+    
+    for (int game = 0; game < 10; game++)
+    {
+        std::vector<std::string> fens;
+        
+        engine.setFen(ChessEngine::kStartFen);
+        
+        for (int ply = 0; ply < 150; ply++)
+        {
+            MoveList moves;
+            engine.generateLegalMoves(&moves);
+            
+            if (moves.isEmpty())
+            {
+                break;
+            }
+            
+            fens.push_back(engine.getFen());
+            random = random * 1103515245 + 12345;
+            engine.makeMove(moves[(random >> 16) % moves.size]);
+        }
+        
+        engine.getSnapshot(&data);
+        REQUIRE(data.size() ==
+                ChessEngine::kSnapshotHeaderSize + fens.size() * ChessEngine::kSnapshotMoveSize);
+        REQUIRE(restored.setSnapshot(data.data(), data.size()));
+        CHECK(restored.getFen() == engine.getFen());
+        CHECK(restored.getHashKey() == engine.getHashKey());
+        CHECK(restored.getNumMovesMade() == fens.size());
+        CHECK(restored.getLastMove() == engine.getLastMove());
+        
+        restored.getSnapshot(&other);
+        CHECK(other == data);
+        
+        while (!fens.empty())
+        {
+            restored.unmakeMove();
+            REQUIRE(restored.getFen() == fens.back());
+            _checkKeys(restored);
+            fens.pop_back();
+        }
+    }
+    
+    // The positions before the snapshot still count for repetitions
+    engine.setFen(ChessEngine::kStartFen);
+    
+    engine.makeMove(_move("g1", "f3", PackedMove::kQuiet));
+    engine.makeMove(_move("g8", "f6", PackedMove::kQuiet));
+    engine.makeMove(_move("f3", "g1", PackedMove::kQuiet));
+    engine.getSnapshot(&data);
+    REQUIRE(restored.setSnapshot(data.data(), data.size()));
+    CHECK_FALSE(restored.isDraw());
+    restored.makeMove(_move("f6", "g8", PackedMove::kQuiet));
+    CHECK(restored.isDraw());
+    
+    // Any damaged byte of the moves is caught, and a last move that cannot have been made
+    auto lastMove = ChessEngine::kSnapshotHeaderSize + 2 * ChessEngine::kSnapshotMoveSize;
+    auto empty    = _move("f3", "e5", PackedMove::kQuiet);
+    
+    other = data;
+    other[lastMove + 2] ^= 1;
+    CHECK_FALSE(restored.setSnapshot(other.data(), other.size()));
+    
+    other = data;
+    _signSnapshot(&other);
+    CHECK(other == data);
+    
+    other[lastMove]     = static_cast<uint8_t>(empty.data);
+    other[lastMove + 1] = static_cast<uint8_t>(empty.data >> 8);
+    _signSnapshot(&other);
+    CHECK_FALSE(restored.setSnapshot(other.data(), other.size()));
+    
+    // Castling rights and the en passant square come back
+    REQUIRE(engine.setFen("r3k2r/8/8/3pP3/8/8/8/R3K2R w Kq d6 3 20"));
+    engine.getSnapshot(&data);
+    REQUIRE(restored.setSnapshot(data.data(), data.size()));
+    CHECK(restored.getFen() == "r3k2r/8/8/3pP3/8/8/8/R3K2R w Kq d6 3 20");
+    
+    // Data that is not a snapshot of this version leaves the engine as it is
+    auto fen     = restored.getFen();
+    auto isValid = [&] (size_t inIndex, uint8_t inValue) {
+        other = data;
+        other[inIndex] ^= inValue;
+        return restored.setSnapshot(other.data(), other.size());
+    };
+    
+    CHECK_FALSE(isValid(0, 1));
+    CHECK_FALSE(isValid(4, 2));
+    CHECK_FALSE(isValid(8 + 8 * 6, 1));
+    CHECK_FALSE(isValid(104, 1));
+    CHECK_FALSE(isValid(105, 4));
+    CHECK_FALSE(isValid(106, 1));
+    CHECK_FALSE(isValid(112, 1));
+    CHECK_FALSE(restored.setSnapshot(data.data(), data.size() - 1));
+    CHECK_FALSE(restored.setSnapshot(data.data(), 10));
+    CHECK(restored.getFen() == fen);
+}
+
+static std::string sLogged;
+
+TEST_CASE( "Test log handler", "[ChessEngine]")
+{
+    setLogHandler([] (const char * inMessage) { sLogged += std::string(inMessage) + "|"; });
+
+    chessEngine::log("Searched %d nodes\n", 42);
+    chessEngine::log("No line break");
+
+    setLogHandler(nullptr);
+
+    // Back to the standard error
+    chessEngine::log("Not handled");
+
+    CHECK(sLogged == "Searched 42 nodes|No line break|");
+}
@@ -0,0 +1,169 @@
+/***************************************************************************************************
+ *
+ *  @file       EpdSuiteTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "EpdSuite.h"
+#include "Search.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace chessEngine;
+
+TEST_CASE( "Test EPD suite", "[EpdSuite]")
+{
+    ChessEngine::init();
+
+    SECTION( "Lines" )
+    {
+        EpdPosition position;
+
+        REQUIRE(EpdSuite::parseLine("r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5Q2/PPPP1PPP/RNB1K1NR w KQkq "
+                                    "- bm Qxf7#; id \"mate; in one\";", &position));
+        CHECK(position.fen == "r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5Q2/PPPP1PPP/RNB1K1NR w KQkq - 0 1");
+        CHECK(position.id == "mate; in one");
+        REQUIRE(position.bestMoves.size() == 1);
+        CHECK(position.bestMoves[0].toString() == "f3f7");
+        CHECK(position.avoidMoves.empty());
+        CHECK(position.isSolution(position.bestMoves[0]));
+
+        // Clocks after the position, several moves and a move to avoid
+        REQUIRE(EpdSuite::parseLine("4k3/8/8/8/8/8/4P3/4K3 w - - 12 40 bm e4 e3; am Kd1;",
+                                    &position));
+        CHECK(position.fen == "4k3/8/8/8/8/8/4P3/4K3 w - - 12 40");
+        CHECK(position.id.empty());
+        CHECK(position.bestMoves.size() == 2);
+        CHECK(position.avoidMoves.size() == 1);
+
+        REQUIRE(EpdSuite::parseLine("4k3/8/8/8/8/8/4P3/4K3 w - - am Kd1 Kf1;", &position));
+
+        for (auto move : position.avoidMoves)
+        {
+            CHECK(!position.isSolution(move));
+        }
+
+        CHECK(position.isSolution(PackedMove(Square(1, 4), Square(3, 4),
+                                             PackedMove::kDoublePawnPush)));
+
+        // Not a move of the position, no move to find, an operation without its semicolon
+        CHECK(!EpdSuite::parseLine("4k3/8/8/8/8/8/4P3/4K3 w - - bm e5;", &position));
+        CHECK(!EpdSuite::parseLine("4k3/8/8/8/8/8/4P3/4K3 w - - id \"x\";", &position));
+        CHECK(!EpdSuite::parseLine("4k3/8/8/8/8/8/4P3/4K3 w - - bm e4", &position));
+        CHECK(!EpdSuite::parseLine("4k3/8/8/8 w - - bm e4;", &position));
+    }
+
+    SECTION( "Files" )
+    {
+        static const char * const kPath = "EpdSuiteTests.epd";
+
+        std::vector<EpdPosition> positions;
+        int                      errorLine;
+
+        {
+            std::ofstream file(kPath);
+            file << "# a comment\n\n";
+            file << "4k3/8/8/8/8/8/4P3/4K3 w - - bm e4; id \"1\";\n";
+            file << "4k3/8/8/8/8/8/4P3/4K3 b - - bm Kd7; id \"2\";\n";
+        }
+
+        REQUIRE(EpdSuite::load(kPath, &positions, &errorLine));
+        CHECK(errorLine == 0);
+        REQUIRE(positions.size() == 2);
+        CHECK(positions[1].id == "2");
+
+        {
+            std::ofstream file(kPath, std::ios::app);
+            file << "4k3/8/8/8/8/8/4P3/4K3 w - - bm Kd7;\n";
+        }
+
+        CHECK(!EpdSuite::load(kPath, &positions, &errorLine));
+        CHECK(errorLine == 5);
+        CHECK(!EpdSuite::load("EpdSuiteTests.missing.epd", &positions, &errorLine));
+        CHECK(errorLine == 0);
+
+        remove(kPath);
+    }
+
+    SECTION( "Searches" )
+    {
+        static const char * const kLines[] = {
+            // Mate in one
+            "r1bqkbnr/pppp1ppp/2n5/4p3/2B1P3/5Q2/PPPP1PPP/RNB1K1NR w KQkq - bm Qxf7#; id \"m1\";",
+            // A queen left hanging
+            "rnb1kbnr/pppp1ppp/8/4p1q1/4P3/3P4/PPP2PPP/RNBQKBNR w KQkq - bm Bxg5; id \"q\";",
+            // Anything but the move to avoid, where there is a mate
+            "rnbqkbnr/pppp1ppp/8/4p3/6P1/5P2/PPPPP2P/RNBQKBNR b KQkq - am Qe7; id \"a\";",
+            // A best move that is not, giving the queen away
+            "rnb1kbnr/pppp1ppp/8/4p1q1/4P3/3P4/PPP2PPP/RNBQKBNR b KQkq - bm Qxg2; id \"x\";"
+        };
+
+        std::vector<EpdPosition> positions;
+
+        for (auto line : kLines)
+        {
+            EpdPosition position;
+
+            REQUIRE(EpdSuite::parseLine(line, &position));
+            positions.push_back(position);
+        }
+
+        EpdOptions options;
+        size_t     numProgress = 0;
+
+        options.limits.moveTimeMs = 0;
+        options.limits.nodes      = 20000;
+        options.numThreads        = 3;
+        options.hashSizeMb        = 1;
+
+        auto results = EpdSuite::run(positions, options, [&] (size_t inIndex,
+                                                              const EpdResult & inResult) {
+            CHECK(inIndex < positions.size());
+            CHECK(inResult.nodes > 0);
+            numProgress++;
+        });
+
+        REQUIRE(results.size() == positions.size());
+        CHECK(numProgress == positions.size());
+
+        for (size_t i = 0; i < 3; i++)
+        {
+            CHECK(results[i].isSolved);
+            CHECK(results[i].solutionNodes <= results[i].nodes);
+            CHECK(results[i].solutionTimeMs <= results[i].timeMs);
+        }
+
+        CHECK(results[0].score >= static_cast<int>(Search::kMateBound));
+        CHECK(!results[3].isSolved);
+
+        // The positions are searched from scratch, whatever the thread
+        options.numThreads = 1;
+
+        auto otherResults = EpdSuite::run(positions, options);
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            CHECK(otherResults[i].move == results[i].move);
+            CHECK(otherResults[i].nodes == results[i].nodes);
+            CHECK(otherResults[i].solutionNodes == results[i].solutionNodes);
+        }
+
+        auto json = EpdSuite::toJson(positions, results, options);
+
+        CHECK(json.find("\"positions\":4,\"solved\":3,") != std::string::npos);
+        CHECK(json.find("{\"id\":\"m1\",\"fen\":") != std::string::npos);
+        CHECK(json.find("\"bestMoves\":[\"Qxf7#\"],\"avoidMoves\":[],\"move\":\"Qxf7#\","
+                        "\"solved\":true") != std::string::npos);
+        CHECK(json.find("\"avoidMoves\":[\"Qe7\"]") != std::string::npos);
+        CHECK(json.front() == '{');
+        CHECK(json.back() == '}');
+    }
+}
@@ -0,0 +1,110 @@
+/***************************************************************************************************
+ *
+ *  @file       EvaluationTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "Evaluation.h"
+
+using namespace chessEngine;
+
+static void
+_play(ChessEngine * inEngine, uint8_t inSrcRow, uint8_t inSrcCol,
+      uint8_t inDestRow, uint8_t inDestCol)
+{
+    Move sideEffect;
+    bool isPromotion;
+
+    REQUIRE(inEngine->attemptMove(Move(Position(inSrcRow, inSrcCol),
+                                       Position(inDestRow, inDestCol)),
+                                  &sideEffect, &isPromotion));
+
+    CHECK(inEngine->getHashKey() == inEngine->computeHashKey());
+    CHECK(inEngine->getPawnKey() == inEngine->computePawnKey());
+}
+
+TEST_CASE( "Test incremental keys", "[Evaluation]")
+{
+    ChessEngine::init();
+
+    ChessEngine engine;
+    auto startKey     = engine.getHashKey();
+    auto startPawnKey = engine.getPawnKey();
+
+    // Knight moves do not touch the pawn key
+    _play(&engine, 0, 6, 2, 5);
+    CHECK(engine.getPawnKey() == startPawnKey);
+    CHECK(engine.getHashKey() != startKey);
+
+    _play(&engine, 7, 6, 5, 5);
+    _play(&engine, 2, 5, 0, 6);
+    _play(&engine, 5, 5, 7, 6);
+
+    // Back to the start position
+    CHECK(engine.getHashKey() == startKey);
+
+    _play(&engine, 1, 3, 3, 3);
+    CHECK(engine.getPawnKey() != startPawnKey);
+
+    _play(&engine, 6, 4, 4, 4);
+    _play(&engine, 3, 3, 4, 4);
+}
+
+TEST_CASE( "Test pawn hash table", "[Evaluation]")
+{
+    ChessEngine::init();
+
+    ChessEngine engine;
+    Evaluator   evaluator;
+
+    CHECK(evaluator.evaluate(engine) == 0);
+    CHECK(evaluator.getStats().pawnProbes == 1);
+    CHECK(evaluator.getStats().pawnHits == 0);
+
+    CHECK(evaluator.evaluate(engine) == 0);
+    CHECK(evaluator.getStats().pawnHits == 1);
+
+    // 1. d4 e5 2. dxe5 leaves white with doubled e-pawns and an extra pawn
+    _play(&engine, 1, 3, 3, 3);
+    _play(&engine, 6, 4, 4, 4);
+    _play(&engine, 3, 3, 4, 4);
+
+    PawnHashEntry entry;
+    Evaluator::computePawnEntry(engine, &entry);
+
+    CHECK(entry.key == engine.getPawnKey());
+    CHECK(entry.structure == -12);
+    CHECK(entry.passed[0].mask == 0);
+    CHECK(entry.passed[1].mask == 0);
+
+    // Black to move
+    CHECK(evaluator.evaluate(engine) == -88);
+    CHECK(evaluator.evaluate(engine) == -88);
+
+    auto & stats = evaluator.getStats();
+
+    CHECK(stats.evaluations == 4);
+    CHECK(stats.pawnProbes == 4);
+    CHECK(stats.pawnHits == 2);
+    CHECK(stats.getPawnHitRate() == Approx(0.5));
+
+    auto cached = evaluator.getPawnTable().getEntry(engine.getPawnKey());
+
+    CHECK(cached->key == entry.key);
+    CHECK(cached->structure == entry.structure);
+
+    for (auto c = 0; c < 2; c++)
+    {
+        for (auto col = 0; col < 8; col++)
+        {
+            CHECK(cached->shield[c][col] == entry.shield[c][col]);
+        }
+    }
+}
@@ -0,0 +1,168 @@
+/***************************************************************************************************
+ *
+ *  @file       GameDatabaseTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "GameDatabase.h"
+#include "PgnReader.h"
+#include "PgnWriter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace chessEngine;
+
+static const char * const kGames =
+    "[Event \"Casual\"]\n"
+    "[White \"A\"]\n"
+    "[Black \"B\"]\n"
+    "[Result \"1-0\"]\n"
+    "\n"
+    "1. e4 e5 2. Nf3 Nc6 3. Bc4 {a comment} Nf6 4. Ng5 d5 5. exd5 Nxd5 6. Nxf7 Kxf7\n"
+    "7. Qf3+ Ke6 8. Nc3 Ncb4 9. a3 Nxc2+ 10. Kd1 Nxa1 11. Nxd5 Kd6 12. d4 c6 1-0\n"
+    "\n"
+    "[Event \"Promotion\"]\n"
+    "[FEN \"8/1P2k3/8/8/8/8/4K3/8 w - - 0 40\"]\n"
+    "\n"
+    "40. b8=N Kd6 41. Kd3 *\n"
+    "\n"
+    "[Event \"Illegal\"]\n"
+    "\n"
+    "1. e4 e4 1-0\n"
+    "\n"
+    "[Event \"Castling\"]\n"
+    "\n"
+    "1. e4 e5 2. Nf3 Nf6 3. Bc4 Bc5 4. O-O O-O 5. d3 d6 1/2-1/2\n";
+
+static std::vector<std::string>
+_parseGames(const std::string & inText)
+{
+    std::vector<std::string> games;
+    PgnParser                parser;
+
+    parser.parse(inText, [&] (const PgnGame & inGame) {
+        std::ostringstream out;
+
+        PgnWriter::write(out, inGame);
+        games.push_back(out.str());
+        return true;
+    });
+
+    return games;
+}
+
+TEST_CASE( "Test SAN writing", "[GameDatabase]")
+{
+    ChessEngine::init();
+
+    ChessEngine engine;
+
+    REQUIRE(engine.setFen("4k3/8/8/8/8/2N3N1/8/N3K1N1 w - - 0 1"));
+
+    for (auto san : { "N1e2", "Ng3e2", "Nce2", "Nb3", "Nh5", "Kd2" })
+    {
+        auto move = PgnParser::parseSan(engine, san);
+
+        REQUIRE(!move.isNull());
+        CHECK(PgnWriter::toSan(&engine, move) == san);
+    }
+
+    // The position is left as it was
+    CHECK(engine.getFen() == "4k3/8/8/8/8/2N3N1/8/N3K1N1 w - - 0 1");
+
+    REQUIRE(engine.setFen("3rk3/2P5/8/8/8/8/8/4K3 w - - 0 1"));
+    CHECK(PgnWriter::toSan(&engine, PgnParser::parseSan(engine, "cxd8=Q+")) == "cxd8=Q+");
+    CHECK(PgnWriter::toSan(&engine, PgnParser::parseSan(engine, "c8=N")) == "c8=N");
+
+    REQUIRE(engine.setFen("6k1/5ppp/8/8/8/8/8/R3K2R w KQ - 0 1"));
+
+    for (auto san : { "O-O", "O-O-O", "Ra8#", "Rxh7" })
+    {
+        CHECK(PgnWriter::toSan(&engine, PgnParser::parseSan(engine, san)) == san);
+    }
+
+    REQUIRE(engine.setFen("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1"));
+    CHECK(PgnWriter::toSan(&engine, PgnParser::parseSan(engine, "exd6")) == "exd6");
+}
+
+TEST_CASE( "Test game database", "[GameDatabase]")
+{
+    ChessEngine::init();
+
+    static const char * const kPgnPath    = "GameDatabaseTests.pgn";
+    static const char * const kPath       = "GameDatabaseTests.db";
+    static const char * const kExportPath = "GameDatabaseTests.export.pgn";
+
+    {
+        std::ofstream file(kPgnPath, std::ios::binary);
+        file << kGames;
+    }
+
+    size_t numSkipped = 0;
+
+    REQUIRE(GameDatabase::importPgn(kPgnPath, kPath, &numSkipped));
+    CHECK(numSkipped == 1);
+
+    GameDatabase database;
+
+    REQUIRE(database.open(kPath));
+    REQUIRE(database.getNumGames() == 3);
+
+    // Games are read directly, in any order
+    PgnGame game;
+
+    REQUIRE(database.readGame(2, &game));
+    CHECK(game.getTag("Event") == "Castling");
+    CHECK(game.result == "1/2-1/2");
+    CHECK(game.moves.size() == 10);
+
+    REQUIRE(database.readGame(1, &game));
+    CHECK(game.getTag("Event") == "Promotion");
+    CHECK(game.result == "*");
+    CHECK(game.moves.size() == 3);
+    CHECK(game.position.getFen() == "1N6/8/3k4/8/8/3K4/8/8 b - - 2 41");
+
+    REQUIRE(database.readGame(0, &game));
+    CHECK(game.tags.size() == 4);
+    CHECK(game.moves.size() == 24);
+
+    CHECK(!database.readGame(3, &game));
+
+    // The moves take far less than their text
+    std::ifstream pgnFile(kPgnPath, std::ios::binary | std::ios::ate);
+    std::ifstream file(kPath, std::ios::binary | std::ios::ate);
+
+    CHECK(file.tellg() < pgnFile.tellg());
+
+    // Exporting gives back the games that were imported, without comments
+    REQUIRE(GameDatabase::exportPgn(kPath, kExportPath));
+
+    std::ifstream      exportFile(kExportPath, std::ios::binary);
+    std::ostringstream exported;
+
+    exported << exportFile.rdbuf();
+
+    auto games = _parseGames(kGames);
+    REQUIRE(games.size() == 4);
+
+    games.erase(games.begin() + 2);
+    CHECK(_parseGames(exported.str()) == games);
+    CHECK(exported.str() == games[0] + games[1] + games[2]);
+
+    // A file that is not a database
+    CHECK(!database.open(kPgnPath));
+    CHECK(!database.isOpen());
+
+    remove(kPgnPath);
+    remove(kPath);
+    remove(kExportPath);
+}
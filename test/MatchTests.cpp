@@ -0,0 +1,159 @@
+/***************************************************************************************************
+ *
+ *  @file       MatchTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "Match.h"
+#include "UciConnection.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace chessEngine;
+
+TEST_CASE( "Test SPRT", "[Match]")
+{
+    Sprt sprt(0.0, 10.0);
+
+    CHECK(sprt.getLowerBound() == Approx(-2.944).epsilon(0.001));
+    CHECK(sprt.getUpperBound() == Approx(2.944).epsilon(0.001));
+    CHECK(sprt.getStatus() == Sprt::Status::kContinue);
+    CHECK(sprt.getElo() == 0.0);
+
+    // Even results favor the engines being equal
+    Sprt even = sprt;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        even.addPair(i % 5);
+    }
+
+    CHECK(even.getNumPairs() == 5000);
+    CHECK(even.getElo() == Approx(0.0).margin(1e-6));
+    CHECK(even.getLlr() < even.getLowerBound());
+    CHECK(even.getStatus() == Sprt::Status::kAcceptH0);
+
+    // A pair won by half a point for every pair drawn is about 89 Elo
+    Sprt strong = sprt;
+    double error;
+
+    for (int i = 0; i < 200; i++)
+    {
+        strong.addPair(2 + (i % 2));
+    }
+
+    CHECK(strong.getElo(&error) == Approx(88.7).epsilon(0.01));
+    CHECK(error > 0.0);
+    CHECK(error < 20.0);
+    CHECK(strong.getStatus() == Sprt::Status::kAcceptH1);
+
+    // Scores beyond a pair are clamped
+    sprt.addPair(-1);
+    sprt.addPair(7);
+    CHECK(sprt.getPairs()[0] == 1);
+    CHECK(sprt.getPairs()[4] == 1);
+}
+
+TEST_CASE( "Test match", "[Match]")
+{
+    ChessEngine::init();
+
+    SECTION( "Openings" )
+    {
+        static const char * const kPath = "MatchTests.epd";
+
+        std::vector<std::string> openings;
+
+        {
+            std::ofstream file(kPath);
+            file << "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - bm e5;\n\n";
+            file << "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2\n";
+        }
+
+        REQUIRE(Match::loadOpenings(kPath, &openings));
+        REQUIRE(openings.size() == 2);
+        CHECK(openings[0] == "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+        CHECK(openings[1] == "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2");
+
+        {
+            std::ofstream file(kPath, std::ios::app);
+            file << "not a position\n";
+        }
+
+        CHECK(!Match::loadOpenings(kPath, &openings));
+        CHECK(!Match::loadOpenings("MatchTests.missing.epd", &openings));
+
+        remove(kPath);
+    }
+
+    SECTION( "Time scale" )
+    {
+        CHECK(Match::getTimeScale(1) == 1.0);
+        CHECK(Match::getTimeScale(100000) > 1.0);
+    }
+
+    SECTION( "Games" )
+    {
+        MatchEngine  first;
+        MatchEngine  second;
+        MatchOptions options;
+        MatchStats   stats;
+        uint64_t     numProgress = 0;
+
+        first.options.push_back({ "Hash", "1" });
+        second.options.push_back({ "Hash", "1" });
+
+        options.numGames    = 6;
+        options.concurrency = 2;
+        options.nodes       = 300;
+        options.maxPlies    = 40;
+        options.openings    = { ChessEngine::kStartFen,
+            "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2" };
+
+        REQUIRE(Match::run(first, second, options, &stats, [&] (const MatchStats & inStats) {
+            CHECK(inStats.numGames == 2 * ++numProgress);
+        }));
+
+        CHECK(stats.numGames == options.numGames);
+        CHECK(stats.numWins + stats.numDraws + stats.numLosses == stats.numGames);
+        CHECK(stats.numForfeits == 0);
+        CHECK(stats.sprt.getNumPairs() == options.numGames / 2);
+
+        // An engine that does not answer loses the match before it starts
+        second.command = "true";
+
+        CHECK(!Match::run(first, second, options));
+    }
+}
+
+#if !defined(_WIN32)
+
+TEST_CASE( "Test UCI process", "[Match]")
+{
+    UciProcess  process;
+    std::string line;
+
+    REQUIRE(process.start("cat"));
+    REQUIRE(process.send("uci"));
+    REQUIRE(process.receive(1000, &line));
+    CHECK(line == "uci");
+    CHECK(!process.receive(10, &line));
+
+    // Another start stops the process first
+    REQUIRE(process.start("printf 'id name x\\r\\nuciok\\r\\n'"));
+    REQUIRE(process.receive(1000, &line));
+    CHECK(line == "id name x");
+    REQUIRE(process.receive(1000, &line));
+    CHECK(line == "uciok");
+    CHECK(!process.receive(1000, &line));
+}
+
+#endif
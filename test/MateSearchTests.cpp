@@ -0,0 +1,207 @@
+/***************************************************************************************************
+ *
+ *  @file       MateSearchTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "MateSearch.h"
+#include "Search.h"
+
+using namespace chessEngine;
+
+/**
+ @brief         Check that a line is legal from a position and ends in mate
+ */
+static bool
+_isMatingLine(ChessEngine inPosition, const std::vector<PackedMove> & inLine)
+{
+    for (auto move : inLine)
+    {
+        MoveList moves;
+        inPosition.generateLegalMoves(&moves);
+
+        if (!moves.contains(move))
+        {
+            return false;
+        }
+
+        inPosition.makeMove(move);
+    }
+
+    MoveList moves;
+    inPosition.generateLegalMoves(&moves);
+
+    return moves.isEmpty() && inPosition.isInCheck();
+}
+
+TEST_CASE( "Test mate search", "[MateSearch]")
+{
+    ChessEngine::init();
+
+    MateSearch  search(1);
+    ChessEngine engine;
+    MateLimits  limits;
+
+    limits.maxMoves = 4;
+
+    SECTION( "Mates are found with their line" )
+    {
+        static const struct
+        {
+            const char *    fen;
+            int             mateInMoves;
+            const char *    firstMove;
+        } kMates[] = {
+            { "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1", 1, "d1d8" },
+            { "r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1", 2, "d5f6" },
+            { "6k1/pp4p1/2p5/2bp4/8/P5Pb/1P3rrP/2BRRN1K b - - 0 1", 2, "g2g1" },
+            { "r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1", 3, "f8c5" },
+        };
+
+        for (const auto & mate : kMates)
+        {
+            REQUIRE(engine.setFen(mate.fen));
+
+            auto result = search.run(engine, limits);
+
+            CHECK(result.mateInMoves == mate.mateInMoves);
+            CHECK(result.isComplete);
+            REQUIRE(result.pv.size() == static_cast<size_t>(2 * mate.mateInMoves - 1));
+            CHECK(result.pv[0].toString() == mate.firstMove);
+            CHECK(_isMatingLine(engine, result.pv));
+
+            // The general search agrees on the distance
+            TranspositionTable table(4);
+            Search             fullSearch(&table);
+            SearchLimits       fullLimits;
+
+            fullLimits.depth = 2 * mate.mateInMoves + 1;
+
+            auto fullResult = fullSearch.run(engine, fullLimits);
+
+            REQUIRE(!fullResult.lines.empty());
+            REQUIRE(fullResult.lines[0].isMate());
+            CHECK(fullResult.lines[0].getMateInMoves() == mate.mateInMoves);
+            CHECK(result.nodes < fullResult.stats.nodes);
+        }
+    }
+
+    SECTION( "The shortest mate is found" )
+    {
+        // Mate in 1 with the queen, and many longer mates
+        REQUIRE(engine.setFen("7k/8/6K1/8/8/8/8/Q7 w - - 0 1"));
+
+        auto result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves == 1);
+        REQUIRE(result.pv.size() == 1);
+        CHECK(_isMatingLine(engine, result.pv));
+    }
+
+    SECTION( "Quiet mating moves are only tried without checks only" )
+    {
+        REQUIRE(engine.setFen("k7/8/2K5/8/8/8/8/7R w - - 0 1"));
+
+        auto result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves == 2);
+        REQUIRE(!result.pv.empty());
+        CHECK(result.pv[0].toString() == "c6b6");
+
+        limits.isChecksOnly = true;
+        search.clear();
+
+        result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves == 0);
+        CHECK(result.isComplete);
+    }
+
+    SECTION( "A search of checks only leaves the table right for a full search" )
+    {
+        REQUIRE(engine.setFen("7k/8/5K2/8/8/8/8/6R1 w - - 0 1"));
+
+        MateSearch other(1);
+
+        limits.maxMoves = 3;
+
+        auto expected = other.run(engine, limits);
+
+        REQUIRE(expected.mateInMoves > 0);
+
+        limits.isChecksOnly = true;
+
+        auto result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves != expected.mateInMoves);
+
+        limits.isChecksOnly = false;
+        result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves == expected.mateInMoves);
+        CHECK(result.isComplete);
+        CHECK(_isMatingLine(engine, result.pv));
+    }
+
+    SECTION( "Positions without a mate" )
+    {
+        auto result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves == 0);
+        CHECK(result.isComplete);
+        CHECK(result.pv.empty());
+
+        // Stalemate is no mate
+        REQUIRE(engine.setFen("7k/5K2/6Q1/8/8/8/8/8 b - - 0 1"));
+
+        result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves == 0);
+        CHECK(result.isComplete);
+    }
+
+    SECTION( "Limits" )
+    {
+        REQUIRE(engine.setFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"));
+        limits.nodes = 1000;
+
+        auto result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves == 0);
+        CHECK_FALSE(result.isComplete);
+        CHECK(result.nodes <= limits.nodes);
+
+        // The limit is reached on the node that proves the mate, the line is still built
+        REQUIRE(engine.setFen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1"));
+        limits.nodes = 1;
+
+        result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves == 1);
+        REQUIRE(result.pv.size() == 1);
+        CHECK(result.pv[0].toString() == "d1d8");
+
+        // A mate in 3 is not looked for beyond 2 moves
+        REQUIRE(engine.setFen("r1b1kb1r/pppp1ppp/5q2/4n3/3KP3/2N3PN/PPP4P/R1BQ1B1R b kq - 0 1"));
+        limits.nodes    = 0;
+        limits.maxMoves = 2;
+
+        result = search.run(engine, limits);
+
+        CHECK(result.mateInMoves == 0);
+        CHECK(result.isComplete);
+
+        search.stop();
+        result = search.run(engine, limits);
+        search.resetStop();
+
+        CHECK_FALSE(result.isComplete);
+    }
+}
@@ -0,0 +1,209 @@
+/***************************************************************************************************
+ *
+ *  @file       MoveGenerationTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+
+using namespace chessEngine;
+
+static uint64_t
+_perft(ChessEngine * inEngine, int inDepth)
+{
+    MoveList moves;
+    inEngine->generateLegalMoves(&moves);
+
+    if (inDepth == 1)
+    {
+        return moves.size;
+    }
+
+    uint64_t nodes = 0;
+
+    for (auto move : moves)
+    {
+        inEngine->makeMove(move);
+        nodes += _perft(inEngine, inDepth - 1);
+        inEngine->unmakeMove();
+    }
+
+    return nodes;
+}
+
+TEST_CASE( "Test attack tables", "[MoveGeneration]")
+{
+    ChessEngine::init();
+
+    // Knight on b1
+    CHECK(Bitboard::getKnightAttacks(Square(0, 1)).mask == 0x50800ULL);
+    // King on h8
+    CHECK(Bitboard::getKingAttacks(Square(7, 7)).count() == 3);
+    // White pawn on a2 only attacks b3, black pawn on a7 only attacks b6
+    CHECK(Bitboard::getPawnAttacks(attributes::ChessColor::kWhite, Square(1, 0)).mask ==
+          Bitboard::getForSquare(Square(2, 1)).mask);
+    CHECK(Bitboard::getPawnAttacks(attributes::ChessColor::kBlack, Square(6, 0)).mask ==
+          Bitboard::getForSquare(Square(5, 1)).mask);
+
+    // Rook on d4 blocked on d6 and f4
+    Bitboard blockers = Bitboard::getForSquare(Square(5, 3)) | Bitboard::getForSquare(Square(3, 5));
+    CHECK(Bitboard::getRookAttacks(Square(3, 3), blockers).count() == 10);
+    CHECK(Bitboard::getRowAttacks(Square(3, 3), blockers).count() == 5);
+    CHECK(Bitboard::getBishopAttacks(Square(3, 3), Bitboard()).count() == 13);
+}
+
+TEST_CASE( "Test perft", "[MoveGeneration]")
+{
+    ChessEngine::init();
+
+    ChessEngine engine;
+
+    SECTION( "Start position" )
+    {
+        CHECK(_perft(&engine, 1) == 20);
+        CHECK(_perft(&engine, 2) == 400);
+        CHECK(_perft(&engine, 3) == 8902);
+        CHECK(_perft(&engine, 4) == 197281);
+    }
+
+    SECTION( "Castling, promotions and pins" )
+    {
+        REQUIRE(engine.setFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"));
+        CHECK(_perft(&engine, 1) == 48);
+        CHECK(_perft(&engine, 2) == 2039);
+        CHECK(_perft(&engine, 3) == 97862);
+    }
+
+    SECTION( "En passant discovering a check" )
+    {
+        REQUIRE(engine.setFen("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -"));
+        CHECK(_perft(&engine, 4) == 43238);
+    }
+
+    SECTION( "Promotions with captures" )
+    {
+        REQUIRE(engine.setFen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"));
+        CHECK(_perft(&engine, 3) == 9467);
+
+        REQUIRE(engine.setFen("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"));
+        CHECK(_perft(&engine, 3) == 62379);
+    }
+
+    CHECK(engine.getHashKey() == engine.computeHashKey());
+}
+
+/**
+ @brief         Check the keys predicted before every move against the ones after making it, down to
+ a depth
+ */
+static void
+_checkKeysAfter(ChessEngine * inEngine, int inDepth)
+{
+    MoveList moves;
+    inEngine->generateLegalMoves(&moves);
+
+    for (auto move : moves)
+    {
+        ZobristKey hashKey, pawnKey;
+        inEngine->getKeysAfter(move, &hashKey, &pawnKey);
+
+        inEngine->makeMove(move);
+
+        // The en passant square set by a double push is the one thing left out
+        auto enPassant = inEngine->getEnPassantSquare();
+        auto expected  = inEngine->getHashKey();
+
+        if (!enPassant.isOutside())
+        {
+            expected ^= ZobristLUT::kEnPassantFile[enPassant.getCol()];
+        }
+
+        CHECK(hashKey == expected);
+        CHECK(pawnKey == inEngine->getPawnKey());
+
+        if (inDepth > 1)
+        {
+            _checkKeysAfter(inEngine, inDepth - 1);
+        }
+
+        inEngine->unmakeMove();
+    }
+}
+
+TEST_CASE( "Test keys after a move", "[MoveGeneration]")
+{
+    ChessEngine::init();
+
+    ChessEngine engine;
+
+    REQUIRE(engine.setFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"));
+    _checkKeysAfter(&engine, 2);
+
+    REQUIRE(engine.setFen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"));
+    _checkKeysAfter(&engine, 2);
+
+    REQUIRE(engine.setFen("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -"));
+    _checkKeysAfter(&engine, 3);
+}
+
+TEST_CASE( "Test checks and draws", "[MoveGeneration]")
+{
+    ChessEngine::init();
+
+    ChessEngine engine;
+    MoveList    moves;
+
+    // Fool's mate
+    REQUIRE(engine.setFen("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3"));
+    engine.generateLegalMoves(&moves);
+    CHECK(engine.isInCheck());
+    CHECK(moves.isEmpty());
+
+    // Stalemate
+    moves.clear();
+    REQUIRE(engine.setFen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"));
+    engine.generateLegalMoves(&moves);
+    CHECK(!engine.isInCheck());
+    CHECK(moves.isEmpty());
+
+    // Knights shuffling back and forth repeat the start position
+    REQUIRE(engine.setFen(ChessEngine::kStartFen));
+
+    Move sideEffect;
+    bool isPromotion;
+
+    CHECK(!engine.isDraw());
+
+    for (auto i = 0; i < 2; i++)
+    {
+        REQUIRE(engine.attemptMove(Move(Position(0, 6), Position(2, 5)), &sideEffect, &isPromotion));
+        REQUIRE(engine.attemptMove(Move(Position(7, 6), Position(5, 5)), &sideEffect, &isPromotion));
+        REQUIRE(engine.attemptMove(Move(Position(2, 5), Position(0, 6)), &sideEffect, &isPromotion));
+        REQUIRE(engine.attemptMove(Move(Position(5, 5), Position(7, 6)), &sideEffect, &isPromotion));
+        CHECK(engine.isDraw());
+    }
+
+    // Illegal moves are rejected
+    CHECK(!engine.attemptMove(Move(Position(0, 4), Position(0, 6)), &sideEffect, &isPromotion));
+    CHECK(!engine.attemptMove(Move(Position(1, 4), Position(4, 4)), &sideEffect, &isPromotion));
+
+    REQUIRE(engine.setFen("8/8/8/8/8/8/8/K1k1B3 w - - 0 1"));
+    CHECK(engine.isDraw());
+
+    REQUIRE(engine.setFen("8/8/8/8/8/8/P7/K1k5 w - - 0 1"));
+    CHECK(!engine.isDraw());
+
+    // Null move flips the side to move and comes back
+    auto key = engine.getHashKey();
+    engine.makeNullMove();
+    CHECK(engine.getCurrMove() == attributes::ChessColor::kBlack);
+    CHECK(engine.getHashKey() == engine.computeHashKey());
+    engine.unmakeMove();
+    CHECK(engine.getHashKey() == key);
+}
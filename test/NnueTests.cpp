@@ -0,0 +1,180 @@
+/***************************************************************************************************
+ *
+ *  @file       NnueTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "Evaluation.h"
+#include "Nnue.h"
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace chessEngine;
+
+static void
+_randomise(nnue::Network * outNetwork)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> small(-40, 40);
+    std::uniform_int_distribution<int> weight(-127, 127);
+    
+    for (auto & row : outNetwork->l1Weights)
+    {
+        for (auto & w : row)
+        {
+            w = static_cast<int16_t>(small(rng));
+        }
+    }
+    
+    for (auto & b : outNetwork->l1Biases)
+    {
+        b = static_cast<int16_t>(small(rng) + 40);
+    }
+    
+    for (auto & row : outNetwork->l2Weights)
+    {
+        for (auto & w : row)
+        {
+            w = static_cast<int8_t>(weight(rng));
+        }
+    }
+    
+    for (auto & b : outNetwork->l2Biases)
+    {
+        b = small(rng) * 64;
+    }
+    
+    for (auto & w : outNetwork->outWeights)
+    {
+        w = static_cast<int8_t>(weight(rng));
+    }
+    
+    outNetwork->outBias = small(rng);
+}
+
+static bool
+_isEqual(const nnue::Accumulator & inA, const nnue::Accumulator & inB)
+{
+    return memcmp(&inA, &inB, sizeof(nnue::Accumulator)) == 0;
+}
+
+TEST_CASE( "Test network file", "[Nnue]")
+{
+    std::unique_ptr<nnue::Network> network(new nnue::Network());
+    std::unique_ptr<nnue::Network> loaded(new nnue::Network());
+    
+    _randomise(network.get());
+    
+    const char * path = "NnueTests.nnue";
+    
+    REQUIRE(network->save(path));
+    REQUIRE(loaded->load(path));
+    
+    CHECK(memcmp(network.get(), loaded.get(), sizeof(nnue::Network)) == 0);
+    
+    // The file is little endian, whatever the host
+    std::vector<char> data;
+    FILE *            file = fopen(path, "rb");
+    
+    for (int c = fgetc(file); c != EOF; c = fgetc(file))
+    {
+        data.push_back(static_cast<char>(c));
+    }
+    
+    fclose(file);
+    
+    REQUIRE(data.size() == 5 * sizeof(uint32_t) + sizeof(nnue::Network));
+    CHECK(std::string(data.data(), 4) == "CCNN");
+    CHECK(data[4] == 1);
+    
+    // Files cut in the weights, or with a byte too many, leave the loaded network as it was
+    auto write = [&] (size_t inSize) {
+        file = fopen(path, "wb");
+        fwrite(data.data(), 1, inSize, file);
+        fclose(file);
+    };
+    
+    data.push_back(0);
+    
+    for (auto size : { data.size(), data.size() - 2, data.size() / 2, size_t(4) })
+    {
+        write(size);
+        CHECK_FALSE(loaded->load(path));
+        CHECK(memcmp(network.get(), loaded.get(), sizeof(nnue::Network)) == 0);
+    }
+    
+    CHECK_FALSE(loaded->load("NnueTests.missing"));
+    
+    remove(path);
+}
+
+TEST_CASE( "Test incremental accumulator", "[Nnue]")
+{
+    ChessEngine::init();
+    
+    std::unique_ptr<nnue::Network> network(new nnue::Network());
+    _randomise(network.get());
+    
+    INFO("Kernels: " << nnue::Network::getKernelName());
+    
+    ChessEngine engine;
+    REQUIRE(engine.setFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"));
+    engine.setNetwork(network.get());
+    
+    nnue::Accumulator fresh;
+    network->refresh(engine, &fresh);
+    
+    const nnue::Accumulator start = engine.getAccumulator();
+    CHECK(_isEqual(start, fresh));
+    
+    PackedMove moves[] = {
+        PackedMove(Square(4), Square(6), PackedMove::kKingCastle),
+        PackedMove(Square(60), Square(58), PackedMove::kQueenCastle),
+        PackedMove(Square(8), Square(24), PackedMove::kDoublePawnPush),
+        PackedMove(Square(25), Square(16), PackedMove::kEnPassant),
+        PackedMove(Square(35), Square(44), PackedMove::kCapture),
+        PackedMove(Square(16), Square(9), PackedMove::kCapture),
+        PackedMove(Square(44), Square(53), PackedMove::kCapture),
+        PackedMove(Square(9), Square(0), PackedMove::kQueenPromotionCapture)
+    };
+    
+    Evaluator evaluator;
+    
+    for (auto move : moves)
+    {
+        INFO(move.toString());
+        
+        engine.makeMove(move);
+        network->refresh(engine, &fresh);
+        
+        CHECK(_isEqual(engine.getAccumulator(), fresh));
+        
+        auto & acc = engine.getAccumulator();
+        auto stm   = engine.getCurrMove();
+        
+        CHECK(network->evaluate(acc, stm) == network->evaluateScalar(acc, stm));
+        CHECK(evaluator.evaluate(engine) == network->evaluate(acc, stm));
+    }
+    
+    for (auto i = 0; i < 8; i++)
+    {
+        engine.unmakeMove();
+    }
+    
+    CHECK(_isEqual(engine.getAccumulator(), start));
+    
+    // Back to the handcrafted evaluation
+    engine.setNetwork(nullptr);
+    CHECK(evaluator.evaluate(engine) != network->evaluate(start, engine.getCurrMove()));
+}
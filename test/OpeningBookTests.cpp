@@ -0,0 +1,254 @@
+/***************************************************************************************************
+ *
+ *  @file       OpeningBookTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "OpeningBook.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace chessEngine;
+
+/**
+ @brief         Legal move of a position in long algebraic notation, null if there is none
+ */
+static PackedMove
+_findMove(const ChessEngine & inPosition, const std::string & inMove)
+{
+    MoveList moves;
+    inPosition.generateLegalMoves(&moves);
+
+    for (auto move : moves)
+    {
+        if (move.toString() == inMove)
+        {
+            return move;
+        }
+    }
+
+    return PackedMove();
+}
+
+TEST_CASE( "Test opening book move encoding", "[OpeningBook]")
+{
+    ChessEngine::init();
+
+    ChessEngine engine;
+
+    // e2e4
+    CHECK(OpeningBook::encodeMove(_findMove(engine, "e2e4")) == ((12 << 6) | 28));
+
+    // Castling is the king taking its rook
+    REQUIRE(engine.setFen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"));
+    CHECK(OpeningBook::encodeMove(_findMove(engine, "e1g1")) == ((4 << 6) | 7));
+    CHECK(OpeningBook::encodeMove(_findMove(engine, "e1c1")) == ((4 << 6) | 0));
+
+    REQUIRE(engine.setFen("4k3/1P6/8/8/8/8/8/4K3 w - - 0 1"));
+    CHECK(OpeningBook::encodeMove(_findMove(engine, "b7b8q")) == ((4 << 12) | (49 << 6) | 57));
+    CHECK(OpeningBook::encodeMove(_findMove(engine, "b7b8n")) == ((1 << 12) | (49 << 6) | 57));
+}
+
+TEST_CASE( "Test opening book", "[OpeningBook]")
+{
+    ChessEngine::init();
+
+    static const char * const kPath = "OpeningBookTests.bin";
+
+    ChessEngine            engine;
+    std::vector<BookEntry> entries;
+
+    ZobristKey startKey = OpeningBook::getPolyglotKey(engine);
+
+    entries.push_back(BookEntry(startKey, _findMove(engine, "e2e4"), 2));
+    entries.push_back(BookEntry(startKey, _findMove(engine, "d2d4"), 1));
+    entries.push_back(BookEntry(startKey, _findMove(engine, "g1f3"), 0));
+
+    // The same move again is merged into one entry
+    entries.push_back(BookEntry(startKey, _findMove(engine, "e2e4"), 1));
+
+    engine.makeMove(_findMove(engine, "e2e4"));
+    entries.push_back(BookEntry(OpeningBook::getPolyglotKey(engine), _findMove(engine, "c7c5"),
+                                5));
+
+    ChessEngine castling;
+    REQUIRE(castling.setFen("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"));
+    entries.push_back(BookEntry(OpeningBook::getPolyglotKey(castling),
+                                _findMove(castling, "e1c1"), 1));
+
+    REQUIRE(OpeningBook::write(kPath, entries));
+
+    OpeningBook book;
+    REQUIRE(book.open(kPath));
+    CHECK(book.getNumEntries() == 5);
+
+    BookEntry found[8];
+
+    SECTION( "Moves of a position, highest weight first" )
+    {
+        ChessEngine start;
+        REQUIRE(book.probe(start, found, 8) == 3);
+        CHECK(found[0].move.toString() == "e2e4");
+        CHECK(found[0].weight == 3);
+        CHECK(found[1].move.toString() == "d2d4");
+        CHECK(found[2].move.toString() == "g1f3");
+
+        // The reply, after the move was made on the engine
+        REQUIRE(book.probe(engine, found, 8) == 1);
+        CHECK(found[0].move.toString() == "c7c5");
+
+        REQUIRE(book.probe(castling, found, 8) == 1);
+        CHECK(found[0].move.isCastle());
+
+        engine.makeMove(_findMove(engine, "c7c5"));
+        CHECK(book.probe(engine, found, 8) == 0);
+    }
+
+    SECTION( "Moves are picked by weight" )
+    {
+        ChessEngine start;
+        int         numPicked[2] = { 0, 0 };
+
+        for (uint32_t random = 0; random < 300; random++)
+        {
+            auto move = book.pickMove(start, random);
+
+            REQUIRE(!move.isNull());
+            numPicked[(move.toString() == "e2e4") ? 0 : 1]++;
+
+            // The move of weight 0 is never played
+            CHECK(move.toString() != "g1f3");
+        }
+
+        CHECK(numPicked[0] == 225);
+        CHECK(numPicked[1] == 75);
+    }
+
+    SECTION( "Invalid files are rejected" )
+    {
+        FILE * file = fopen(kPath, "ab");
+        REQUIRE(file != nullptr);
+        fputc(0, file);
+        fclose(file);
+
+        OpeningBook truncated;
+        CHECK_FALSE(truncated.open(kPath));
+        CHECK_FALSE(truncated.open("NoSuchBook.bin"));
+    }
+
+    book.close();
+    remove(kPath);
+}
+
+TEST_CASE( "Test opening book Polyglot keys", "[OpeningBook]")
+{
+    ChessEngine::init();
+
+    const ZobristKey * r = OpeningBook::kPolyglotRandoms;
+    ChessEngine        engine;
+
+    SECTION( "Keys of the format description" )
+    {
+        static const struct
+        {
+            const char *        moves;
+            ZobristKey          key;
+        } kKeys[] = {
+            { "",                                   0x463B96181691FC9CULL },
+            { "e2e4",                               0x823C9B50FD114196ULL },
+            { "e2e4 d7d5",                          0x0756B94461C50FB0ULL },
+            { "e2e4 d7d5 e4e5",                     0x662FAFB965DB29D4ULL },
+            { "e2e4 d7d5 e4e5 f7f5",                0x22A48B5A8E47FF78ULL },
+            { "e2e4 d7d5 e4e5 f7f5 e1e2",           0x652A607CA3F242C1ULL },
+            { "e2e4 d7d5 e4e5 f7f5 e1e2 e8f7",      0x00FDD303C946BDD9ULL },
+            { "a2a4 b7b5 h2h4 b5b4 c2c4",           0x3C8123EA7B067637ULL },
+            { "a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3", 0x5C3F9B829B279560ULL }
+        };
+
+        for (const auto & entry : kKeys)
+        {
+            ChessEngine position;
+            std::string moves(entry.moves);
+            size_t      start = 0;
+
+            while (start < moves.size())
+            {
+                size_t end  = std::min(moves.find(' ', start), moves.size());
+                auto   move = _findMove(position, moves.substr(start, end - start));
+
+                REQUIRE(!move.isNull());
+                position.makeMove(move);
+                start = end + 1;
+            }
+
+            CHECK(OpeningBook::getPolyglotKey(position) == entry.key);
+        }
+    }
+
+    SECTION( "Pieces and side to move" )
+    {
+        // Black king on e8, white pawn on e2 and white king on e1
+        REQUIRE(engine.setFen("4k3/8/8/8/8/8/4P3/4K3 w - - 0 1"));
+        CHECK(OpeningBook::getPolyglotKey(engine) ==
+              (r[(64 * 10) + 60] ^ r[(64 * 1) + 12] ^ r[(64 * 11) + 4] ^ r[780]));
+
+        REQUIRE(engine.setFen("4k3/8/8/8/8/8/4P3/4K3 b - - 0 1"));
+        CHECK(OpeningBook::getPolyglotKey(engine) ==
+              (r[(64 * 10) + 60] ^ r[(64 * 1) + 12] ^ r[(64 * 11) + 4]));
+    }
+
+    SECTION( "Castling rights" )
+    {
+        REQUIRE(engine.setFen("r3k2r/8/8/8/8/8/8/R3K2R b - - 0 1"));
+        auto noRights = OpeningBook::getPolyglotKey(engine);
+
+        REQUIRE(engine.setFen("r3k2r/8/8/8/8/8/8/R3K2R b Kq - 0 1"));
+        CHECK(OpeningBook::getPolyglotKey(engine) == (noRights ^ r[768] ^ r[771]));
+    }
+
+    SECTION( "En passant file only when a pawn can capture" )
+    {
+        ChessEngine after;
+
+        REQUIRE(engine.setFen("4k3/8/8/8/3p4/8/4P3/4K3 w - - 0 1"));
+        engine.makeMove(_findMove(engine, "e2e4"));
+        REQUIRE(after.setFen("4k3/8/8/8/3pP3/8/8/4K3 b - - 0 1"));
+        CHECK(OpeningBook::getPolyglotKey(engine) ==
+              (OpeningBook::getPolyglotKey(after) ^ r[772 + 4]));
+
+        REQUIRE(engine.setFen("4k3/8/8/8/8/3p4/4P3/4K3 w - - 0 1"));
+        engine.makeMove(_findMove(engine, "e2e4"));
+        REQUIRE(after.setFen("4k3/8/8/8/4P3/3p4/8/4K3 b - - 0 1"));
+        CHECK(OpeningBook::getPolyglotKey(engine) == OpeningBook::getPolyglotKey(after));
+    }
+
+    SECTION( "Books of engine keys are opened as such" )
+    {
+        static const char * const kPath = "OpeningBookTests.engine.bin";
+
+        std::vector<BookEntry> entries;
+        entries.push_back(BookEntry(engine.getHashKey(), _findMove(engine, "d2d4"), 1));
+        REQUIRE(OpeningBook::write(kPath, entries));
+
+        OpeningBook book;
+        BookEntry   found[4];
+
+        REQUIRE(book.open(kPath));
+        CHECK(book.probe(engine, found, 4) == 0);
+
+        REQUIRE(book.open(kPath, OpeningBook::kEngineKeys));
+        REQUIRE(book.probe(engine, found, 4) == 1);
+        CHECK(found[0].move.toString() == "d2d4");
+
+        book.close();
+        remove(kPath);
+    }
+}
@@ -0,0 +1,225 @@
+/***************************************************************************************************
+ *
+ *  @file       OpeningExplorerTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "GameDatabase.h"
+#include "OpeningExplorer.h"
+#include "PgnReader.h"
+#include "PositionIndex.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace chessEngine;
+
+TEST_CASE( "Test opening explorer", "[OpeningExplorer]")
+{
+    ChessEngine::init();
+
+    static const char * const kDatabasePath = "OpeningExplorerTests.db";
+    static const char * const kIndexPath    = "OpeningExplorerTests.idx";
+    static const char * const kPath         = "OpeningExplorerTests.oex";
+    static constexpr size_t   kNumGames     = 400;
+    static constexpr size_t   kNumPlies     = 20;
+    static constexpr size_t   kMaxPlies     = 8;
+
+    // Games of random moves from a few first moves, every other of them rated
+    GameDatabaseWriter writer;
+    uint32_t           random = 7;
+
+    REQUIRE(writer.open(kDatabasePath));
+
+    for (size_t i = 0; i < kNumGames; i++)
+    {
+        PgnGame game;
+
+        for (size_t ply = 0; ply < kNumPlies; ply++)
+        {
+            MoveList moves;
+            game.position.generateLegalMoves(&moves);
+
+            if (moves.isEmpty())
+            {
+                break;
+            }
+
+            random = random * 1103515245 + 12345;
+
+            auto move = moves[(ply < 2) ? (random >> 16) % 2 : (random >> 16) % moves.size];
+
+            game.position.makeMove(move);
+            game.moves.push_back(move);
+        }
+
+        if ((i % 2) == 0)
+        {
+            game.tags.push_back({ "WhiteElo", (i % 4) ? "2000" : "2200" });
+            game.tags.push_back({ "BlackElo", "2100" });
+        }
+
+        game.result = GameDatabase::getResultToken(static_cast<GameResult>(1 + (i % 3)));
+
+        REQUIRE(writer.addGame(game));
+    }
+
+    REQUIRE(writer.close());
+
+    GameDatabase  database;
+    PositionIndex index;
+
+    REQUIRE(database.open(kDatabasePath));
+    REQUIRE(PositionIndex::build(database, kIndexPath, 2, 4));
+    REQUIRE(index.open(kIndexPath));
+    REQUIRE(OpeningExplorer::build(database, index, kPath, kMaxPlies, 2));
+
+    OpeningExplorer explorer;
+    REQUIRE(explorer.open(kPath));
+    CHECK(explorer.getMaxPlies() == kMaxPlies);
+    CHECK(explorer.getNumPositions() > 4);
+
+    // The explorer agrees with the index, apart from the moves of a single game
+    std::vector<ExplorerMove>      moves;
+    std::vector<PositionMoveStats> stats;
+    ChessEngine                    position;
+
+    REQUIRE(explorer.probe(position, &moves) == kNumGames);
+    REQUIRE(moves.size() == 2);
+    CHECK(moves[0].numGames + moves[1].numGames == kNumGames);
+    CHECK(moves[0].numGames >= moves[1].numGames);
+    CHECK(moves[0].averageRating > 2000);
+    CHECK(moves[0].averageRating < 2150);
+
+    for (size_t ply = 0; ply < kMaxPlies; ply++)
+    {
+        size_t numGames = explorer.probe(position, &moves);
+
+        REQUIRE(numGames > 0);
+        CHECK(numGames == index.getMoveStats(position, &stats));
+
+        size_t numStats = std::count_if(stats.begin(), stats.end(),
+                                        [] (const PositionMoveStats & inStats) {
+            return inStats.numGames >= 2;
+        });
+
+        REQUIRE(moves.size() == numStats);
+
+        for (size_t i = 0; i < moves.size(); i++)
+        {
+            CHECK(moves[i].move == stats[i].move);
+            CHECK(moves[i].numGames == stats[i].numGames);
+            CHECK(moves[i].numWhiteWins == stats[i].numWhiteWins);
+            CHECK(moves[i].numDraws == stats[i].numDraws);
+            CHECK(moves[i].numBlackWins == stats[i].numBlackWins);
+            CHECK(moves[i].getWhiteScore() >= 0.0);
+            CHECK(moves[i].getWhiteScore() <= 100.0);
+        }
+
+        if (moves.empty())
+        {
+            break;
+        }
+
+        position.makeMove(moves[0].move);
+    }
+
+    // Positions reached after the last ply are left out
+    PgnGame game;
+
+    REQUIRE(database.readGame(0, &game));
+    CHECK(explorer.probe(game.position, &moves) == 0);
+    CHECK(moves.empty());
+
+    index.close();
+    database.close();
+    explorer.close();
+
+    remove(kDatabasePath);
+    remove(kIndexPath);
+    remove(kPath);
+}
+
+TEST_CASE( "Test opening explorer repetitions", "[OpeningExplorer]")
+{
+    ChessEngine::init();
+
+    static const char * const kDatabasePath = "OpeningExplorerTests.repeat.db";
+    static const char * const kIndexPath    = "OpeningExplorerTests.repeat.idx";
+    static const char * const kPath         = "OpeningExplorerTests.repeat.oex";
+
+    // The first game is back to the start twice, the second one has no result
+    static const char * const kGames[][9] = {
+        { "Nf3", "Nf6", "Ng1", "Ng8", "Nf3", "Nf6", "Ng1", "Ng8", "Nc3" },
+        { "e4" }
+    };
+    static const GameResult   kResults[] = { GameResult::kWhiteWins, GameResult::kUnknown };
+
+    GameDatabaseWriter writer;
+    REQUIRE(writer.open(kDatabasePath));
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        PgnGame game;
+
+        for (auto san : kGames[i])
+        {
+            if (san == nullptr)
+            {
+                break;
+            }
+
+            auto move = PgnParser::parseSan(game.position, san);
+
+            REQUIRE(!move.isNull());
+            game.position.makeMove(move);
+            game.moves.push_back(move);
+        }
+
+        game.result = GameDatabase::getResultToken(kResults[i]);
+        REQUIRE(writer.addGame(game));
+    }
+
+    REQUIRE(writer.close());
+
+    GameDatabase  database;
+    PositionIndex index;
+
+    REQUIRE(database.open(kDatabasePath));
+    REQUIRE(PositionIndex::build(database, kIndexPath, 1, 1));
+    REQUIRE(index.open(kIndexPath));
+    REQUIRE(OpeningExplorer::build(database, index, kPath, 16, 1));
+
+    OpeningExplorer           explorer;
+    std::vector<ExplorerMove> moves;
+    ChessEngine               start;
+
+    REQUIRE(explorer.open(kPath));
+    CHECK(explorer.probe(start, &moves) == 2);
+    REQUIRE(moves.size() == 3);
+
+    for (auto & move : moves)
+    {
+        bool isUnknown = (move.move == PgnParser::parseSan(start, "e4"));
+
+        CHECK(move.numGames == 1);
+        CHECK(move.numWhiteWins == (isUnknown ? 0 : 1));
+        CHECK(move.numDraws == 0);
+        CHECK(move.numBlackWins == 0);
+    }
+
+    index.close();
+    database.close();
+    explorer.close();
+
+    remove(kDatabasePath);
+    remove(kIndexPath);
+    remove(kPath);
+}
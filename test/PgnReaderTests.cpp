@@ -0,0 +1,274 @@
+/***************************************************************************************************
+ *
+ *  @file       PgnReaderTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "PgnReader.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+
+using namespace chessEngine;
+
+static std::string
+_parseSan(const std::string & inFen, const char * inSan)
+{
+    ChessEngine engine;
+
+    if (!engine.setFen(inFen))
+    {
+        return "invalid";
+    }
+
+    auto move = PgnParser::parseSan(engine, inSan);
+
+    return move.isNull() ? "" : move.toString();
+}
+
+TEST_CASE( "Test SAN parsing", "[PgnReader]")
+{
+    ChessEngine::init();
+
+    static const char * const kStart = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    CHECK(_parseSan(kStart, "e4") == "e2e4");
+    CHECK(_parseSan(kStart, "Nf3") == "g1f3");
+    CHECK(_parseSan(kStart, "Nf3!?") == "g1f3");
+    CHECK(_parseSan(kStart, "e5") == "");
+    CHECK(_parseSan(kStart, "Ke2") == "");
+    CHECK(_parseSan(kStart, "xyz") == "");
+
+    // Castling, with letters or zeros
+    static const char * const kCastling = "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1";
+
+    CHECK(_parseSan(kCastling, "O-O") == "e1g1");
+    CHECK(_parseSan(kCastling, "0-0-0+") == "e1c1");
+
+    // Disambiguation by column, row or both
+    static const char * const kKnights = "4k3/8/8/8/8/2N3N1/8/N3K1N1 w - - 0 1";
+
+    CHECK(_parseSan(kKnights, "N1e2") == "g1e2");
+    CHECK(_parseSan(kKnights, "Nge2") == "");
+    CHECK(_parseSan(kKnights, "N3e2") == "");
+    CHECK(_parseSan(kKnights, "Ng3e2") == "g3e2");
+    CHECK(_parseSan(kKnights, "Nce2") == "c3e2");
+    CHECK(_parseSan(kKnights, "Ne2") == "");
+    CHECK(_parseSan(kKnights, "Na1b3") == "a1b3");
+    CHECK(_parseSan(kKnights, "Nb3") == "a1b3");
+
+    // A pinned piece does not make a move ambiguous
+    CHECK(_parseSan("4k3/4r3/8/1N6/8/8/4N3/4K3 w - - 0 1", "Nd4") == "b5d4");
+
+    // Captures, en passant and promotions
+    CHECK(_parseSan("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "exd6") == "e5d6");
+    CHECK(_parseSan("3rk3/2P5/8/8/8/8/8/4K3 w - - 0 1", "cxd8=Q+") == "c7d8q");
+    CHECK(_parseSan("3rk3/2P5/8/8/8/8/8/4K3 w - - 0 1", "c8N") == "c7c8n");
+    CHECK(_parseSan("3rk3/2P5/8/8/8/8/8/4K3 w - - 0 1", "c8") == "");
+}
+
+TEST_CASE( "Test PGN parsing", "[PgnReader]")
+{
+    ChessEngine::init();
+
+    static const char * const kText =
+        "\xEF\xBB\xBF% exported games\n"
+        "[Event \"Casual \\\"blitz\\\"\"]\n"
+        "[White \"A\"]\n"
+        "[Result \"1-0\"]\n"
+        "\n"
+        "1. e4 e5 2. Nf3 {a comment with (parentheses)} Nc6 $1 3.Bc4 (3. Bb5 a6 (3... Nf6) 4. Ba4)\n"
+        "3... Nf6 ; a comment to the end of the line, 4. Nc3\n"
+        "4. Ng5\n"
+        "4... d5 5. exd5 Nxd5?! 6. Nxf7 Kxf7 7. Qf3+ Ke6 8. Nc3 1-0\n"
+        "\n"
+        "[Event \"From a position\"]\n"
+        "[FEN \"4k3/8/4K3/8/8/8/8/7R w - - 0 1\"]\n"
+        "\n"
+        "1. Rh8# 1-0\n"
+        "\n"
+        "[Event \"Illegal\"]\n"
+        "\n"
+        "1. e4 e5 2. Ke3 Nc6 *\n"
+        "\n"
+        "[Event \"No result\"]\n"
+        "\n"
+        "1. d4\n";
+
+    std::vector<std::string> events;
+    std::vector<std::string> results;
+    std::vector<size_t>      numMoves;
+    std::vector<std::string> errors;
+    std::vector<std::string> fens;
+
+    PgnParser parser;
+
+    size_t numGames = parser.parse(kText, [&] (const PgnGame & inGame) {
+        events.push_back(inGame.getTag("Event").toString());
+        results.push_back(inGame.result.toString());
+        numMoves.push_back(inGame.moves.size());
+        errors.push_back(inGame.error.toString());
+        fens.push_back(inGame.position.getFen());
+
+        // The moves are made, and can be unmade again
+        CHECK(inGame.position.getLastMove() ==
+              (inGame.moves.empty() ? PackedMove() : inGame.moves.back()));
+        CHECK(inGame.text.startsWith("[Event"));
+        CHECK(inGame.getTag("Missing").isEmpty());
+
+        return true;
+    });
+
+    REQUIRE(numGames == 4);
+
+    CHECK(events[0] == "Casual \\\"blitz\\\"");
+    CHECK(results[0] == "1-0");
+    CHECK(numMoves[0] == 15);
+    CHECK(errors[0] == "");
+    CHECK(fens[0] == "r1bq1b1r/ppp3pp/2n1k3/3np3/2B5/2N2Q2/PPPP1PPP/R1B1K2R b KQ - 3 8");
+
+    CHECK(events[1] == "From a position");
+    CHECK(numMoves[1] == 1);
+    CHECK(fens[1] == "4k2R/8/4K3/8/8/8/8/8 b - - 1 1");
+
+    // The game is still delivered, with the moves before the illegal one
+    CHECK(results[2] == "*");
+    CHECK(numMoves[2] == 2);
+    CHECK(errors[2] == "Ke3");
+
+    CHECK(results[3] == "");
+    CHECK(numMoves[3] == 1);
+
+    // Parsing stops when asked to
+    numGames = parser.parse(kText, [] (const PgnGame &) { return false; });
+    CHECK(numGames == 1);
+
+    CHECK(parser.parse("", [] (const PgnGame &) { return true; }) == 0);
+    CHECK(parser.parse("\n% only an escaped line\n", [] (const PgnGame &) { return true; }) == 0);
+}
+
+TEST_CASE( "Test PGN reader", "[PgnReader]")
+{
+    ChessEngine::init();
+
+    static const char * const kPath = "PgnReaderTests.pgn";
+
+    {
+        std::ofstream file(kPath, std::ios::binary);
+
+        for (int i = 0; i < 100; i++)
+        {
+            file << "[Round \"" << i << "\"]\n\n1. d4 d5 2. c4 c6 1/2-1/2\n\n";
+        }
+    }
+
+    PgnReader reader;
+
+    REQUIRE(reader.open(kPath));
+
+    int    roundSum = 0;
+    size_t numGames = reader.read([&] (const PgnGame & inGame) {
+        CHECK(inGame.moves.size() == 4);
+        CHECK(inGame.result == "1/2-1/2");
+
+        roundSum += atoi(inGame.getTag("Round").toString().c_str());
+
+        // The game views the mapped file
+        CHECK(inGame.text.begin() >= reader.getText().begin());
+        CHECK(inGame.text.end() <= reader.getText().end());
+
+        return true;
+    });
+
+    CHECK(numGames == 100);
+    CHECK(roundSum == 99 * 100 / 2);
+
+    reader.close();
+    CHECK(!reader.isOpen());
+    CHECK(!reader.open("PgnReaderTests.missing"));
+
+    remove(kPath);
+}
+
+TEST_CASE( "Test parallel PGN parsing", "[PgnReader]")
+{
+    ChessEngine::init();
+
+    std::string text;
+
+    for (int i = 0; i < 200; i++)
+    {
+        text += "[Round \"" + std::to_string(i) + "\"]\n[White \"A\"]\n\n";
+
+        // Some games have no result, some a tag like line in a comment
+        text += (i % 7 == 0) ? "1. e4 e5\n" : "1. e4 {\n[not a tag]} e5 2. Nf3 1-0\n";
+        text += "\n";
+    }
+
+    std::vector<int> sequential;
+
+    PgnParser parser;
+    parser.parse(text, [&] (const PgnGame & inGame) {
+        sequential.push_back(atoi(inGame.getTag("Round").toString().c_str()));
+        return true;
+    });
+
+    REQUIRE(sequential.size() == 200);
+
+    for (size_t numChunks : { 1, 3, 16, 1000 })
+    {
+        auto chunks = PgnParser::split(text, numChunks);
+
+        REQUIRE(!chunks.empty());
+        CHECK(chunks.size() <= numChunks);
+        CHECK(chunks.front().begin() == text.data());
+        CHECK(chunks.back().end() == text.data() + text.size());
+
+        for (size_t i = 1; i < chunks.size(); i++)
+        {
+            CHECK(chunks[i].begin() == chunks[i - 1].end());
+            CHECK(chunks[i].startsWith("[Round"));
+        }
+
+        // Results kept per chunk, merged in order, are those of parsing on one thread
+        std::vector<std::vector<int>> rounds(chunks.size());
+
+        size_t numGames = PgnParser::parseParallel(chunks, 4, [&] (size_t inChunk,
+                                                                  const PgnGame & inGame) {
+            CHECK(inGame.isValid());
+            rounds[inChunk].push_back(atoi(inGame.getTag("Round").toString().c_str()));
+            return true;
+        });
+
+        std::vector<int> merged;
+
+        for (auto & chunkRounds : rounds)
+        {
+            merged.insert(merged.end(), chunkRounds.begin(), chunkRounds.end());
+        }
+
+        CHECK(numGames == 200);
+        CHECK(merged == sequential);
+    }
+
+    // Parsing stops on all the threads when asked to
+    std::atomic<int> numCalls(0);
+
+    size_t numGames = PgnParser::parseParallel(PgnParser::split(text, 16), 4,
+                                               [&] (size_t, const PgnGame &) {
+        return ++numCalls < 5;
+    });
+
+    CHECK(numGames == static_cast<size_t>(numCalls.load()));
+    CHECK(numGames < 200);
+
+    CHECK(PgnParser::split("", 4).empty());
+}
@@ -0,0 +1,228 @@
+/***************************************************************************************************
+ *
+ *  @file       PositionIndexTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "GameDatabase.h"
+#include "PgnReader.h"
+#include "PositionIndex.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace chessEngine;
+
+static std::string
+_readFile(const char * inPath)
+{
+    std::ifstream      file(inPath, std::ios::binary);
+    std::ostringstream data;
+
+    data << file.rdbuf();
+
+    return data.str();
+}
+
+TEST_CASE( "Test position index", "[PositionIndex]")
+{
+    ChessEngine::init();
+
+    static const char * const kDatabasePath = "PositionIndexTests.db";
+    static const char * const kPath         = "PositionIndexTests.idx";
+    static const char * const kOtherPath    = "PositionIndexTests.other.idx";
+    static constexpr size_t   kNumGames     = 600;
+    static constexpr size_t   kNumPlies     = 30;
+
+    // Games of random moves, the first of them only from a few, with what the index should find
+    std::map<uint16_t, PositionMoveStats> firstMoves;
+    std::map<size_t, ZobristKey>          midKeys;
+    GameDatabaseWriter                    writer;
+    uint32_t                              random = 1;
+
+    REQUIRE(writer.open(kDatabasePath));
+
+    for (size_t i = 0; i < kNumGames; i++)
+    {
+        PgnGame game;
+
+        for (size_t ply = 0; ply < kNumPlies; ply++)
+        {
+            MoveList moves;
+            game.position.generateLegalMoves(&moves);
+
+            if (moves.isEmpty())
+            {
+                break;
+            }
+
+            random = random * 1103515245 + 12345;
+
+            auto move = moves[(ply == 0) ? (random >> 16) % 3 : (random >> 16) % moves.size];
+
+            if (ply == kNumPlies / 2)
+            {
+                midKeys[i] = game.position.getHashKey();
+            }
+
+            game.position.makeMove(move);
+            game.moves.push_back(move);
+        }
+
+        game.result = GameDatabase::getResultToken(static_cast<GameResult>(1 + (i % 3)));
+
+        auto & stats = firstMoves[game.moves[0].data];
+
+        stats.move = game.moves[0];
+        stats.numGames++;
+        stats.numWhiteWins += ((i % 3) == 0) ? 1 : 0;
+        stats.numBlackWins += ((i % 3) == 1) ? 1 : 0;
+        stats.numDraws     += ((i % 3) == 2) ? 1 : 0;
+
+        REQUIRE(writer.addGame(game));
+    }
+
+    REQUIRE(writer.close());
+
+    GameDatabase database;
+    REQUIRE(database.open(kDatabasePath));
+
+    // Many small runs on several threads give the same index as one run
+    REQUIRE(PositionIndex::build(database, kPath, 4, 1));
+    REQUIRE(PositionIndex::build(database, kOtherPath, 1, 64));
+    CHECK(_readFile(kPath) == _readFile(kOtherPath));
+
+    PositionIndex index;
+    REQUIRE(index.open(kPath));
+    CHECK(index.getNumPostings() >= kNumGames * kNumPlies);
+
+    ChessEngine                  start;
+    std::vector<PositionPosting> postings;
+
+    REQUIRE(index.find(start.getHashKey(), &postings) == kNumGames);
+
+    for (size_t i = 0; i < postings.size(); i++)
+    {
+        CHECK(postings[i].game == i);
+        CHECK(postings[i].ply == 0);
+    }
+
+    std::vector<PositionMoveStats> stats;
+
+    CHECK(index.getMoveStats(start, &stats) == kNumGames);
+    REQUIRE(stats.size() == firstMoves.size());
+
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        auto & expected = firstMoves[stats[i].move.data];
+
+        CHECK(stats[i].numGames == expected.numGames);
+        CHECK(stats[i].numWhiteWins == expected.numWhiteWins);
+        CHECK(stats[i].numDraws == expected.numDraws);
+        CHECK(stats[i].numBlackWins == expected.numBlackWins);
+        CHECK(((i == 0) || (stats[i - 1].numGames >= stats[i].numGames)));
+    }
+
+    // Every game is found from the middle of it, unless it ended before
+    CHECK(midKeys.size() > kNumGames * 9 / 10);
+
+    for (auto & midKey : midKeys)
+    {
+        size_t game = midKey.first;
+
+        index.find(midKey.second, &postings);
+
+        auto found = std::find_if(postings.begin(), postings.end(),
+                                  [game] (const PositionPosting & inPosting) {
+            return (inPosting.game == game) && (inPosting.ply == kNumPlies / 2);
+        });
+
+        CHECK(found != postings.end());
+    }
+
+    CHECK(index.find(0x123456789ULL, &postings) == 0);
+
+    index.close();
+    database.close();
+
+    remove(kDatabasePath);
+    remove(kPath);
+    remove(kOtherPath);
+}
+
+TEST_CASE( "Test position index repetitions", "[PositionIndex]")
+{
+    ChessEngine::init();
+
+    static const char * const kDatabasePath = "PositionIndexTests.repeat.db";
+    static const char * const kPath         = "PositionIndexTests.repeat.idx";
+
+    // The first game is back to the start twice, and leaves it with another move the last time
+    static const char * const kGames[][9] = {
+        { "Nf3", "Nf6", "Ng1", "Ng8", "Nf3", "Nf6", "Ng1", "Ng8", "Nc3" },
+        { "e4" }
+    };
+
+    GameDatabaseWriter writer;
+    REQUIRE(writer.open(kDatabasePath));
+
+    for (auto & moves : kGames)
+    {
+        PgnGame game;
+
+        for (auto san : moves)
+        {
+            if (san == nullptr)
+            {
+                break;
+            }
+
+            auto move = PgnParser::parseSan(game.position, san);
+
+            REQUIRE(!move.isNull());
+            game.position.makeMove(move);
+            game.moves.push_back(move);
+        }
+
+        game.result = GameDatabase::getResultToken(GameResult::kWhiteWins);
+        REQUIRE(writer.addGame(game));
+    }
+
+    REQUIRE(writer.close());
+
+    GameDatabase  database;
+    PositionIndex index;
+
+    REQUIRE(database.open(kDatabasePath));
+    REQUIRE(PositionIndex::build(database, kPath, 1, 1));
+    REQUIRE(index.open(kPath));
+
+    ChessEngine                    start;
+    std::vector<PositionPosting>   postings;
+    std::vector<PositionMoveStats> stats;
+
+    CHECK(index.find(start.getHashKey(), &postings) == 4);
+    CHECK(index.getMoveStats(start, &stats) == 2);
+    REQUIRE(stats.size() == 3);
+
+    for (auto & moveStats : stats)
+    {
+        CHECK(moveStats.numGames == 1);
+        CHECK(moveStats.numWhiteWins == 1);
+    }
+
+    index.close();
+    database.close();
+
+    remove(kDatabasePath);
+    remove(kPath);
+}
@@ -0,0 +1,529 @@
+/***************************************************************************************************
+ *
+ *  @file       SearchTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "Search.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+using namespace chessEngine;
+
+// Allocations of the thread that counts them, to check that searches do not allocate. Replacing
+// the global operator new is the only way to see every allocation, including the ones of the
+// standard library.
+static thread_local bool     sIsCountingAllocations = false;
+static thread_local uint64_t sNumAllocations        = 0;
+
+void *
+operator new(size_t inSize)
+{
+    if (sIsCountingAllocations)
+    {
+        sNumAllocations++;
+    }
+
+    void * memory = malloc((inSize == 0) ? 1 : inSize);
+
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void
+operator delete(void * inMemory) noexcept
+{
+    free(inMemory);
+}
+
+TEST_CASE( "Test transposition table", "[Search]")
+{
+    ChessEngine::init();
+
+    TranspositionTable       table(1);
+    TranspositionTable::Data data;
+    PackedMove               move(Square(12), Square(28), PackedMove::kDoublePawnPush);
+
+    CHECK_FALSE(table.probe(0x1234, &data));
+
+    table.store(0x1234, move, -250, 17, 6, TranspositionTable::kLower);
+
+    REQUIRE(table.probe(0x1234, &data));
+    CHECK(data.move == move);
+    CHECK(data.score == -250);
+    CHECK(data.eval == 17);
+    CHECK(data.depth == 6);
+    CHECK(data.bound == TranspositionTable::kLower);
+
+    // A shallower bound of the same search does not replace a deeper one
+    table.store(0x1234, PackedMove(), 100, 17, 2, TranspositionTable::kUpper);
+    REQUIRE(table.probe(0x1234, &data));
+    CHECK(data.depth == 6);
+
+    // A key in the same cluster with other high bits is a miss
+    CHECK_FALSE(table.probe(0x1234 | (1ULL << 60), &data));
+
+    table.clear();
+    CHECK_FALSE(table.probe(0x1234, &data));
+}
+
+TEST_CASE( "Test search", "[Search]")
+{
+    ChessEngine::init();
+
+    TranspositionTable table(4);
+    Search             search(&table);
+    ChessEngine        engine;
+    SearchLimits       limits;
+
+    SECTION( "Mate in one" )
+    {
+        REQUIRE(engine.setFen("6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1"));
+        limits.depth = 4;
+
+        auto result = search.run(engine, limits);
+
+        CHECK(result.bestMove.toString() == "a1a8");
+        CHECK(result.score == Search::kMateScore - 1);
+    }
+
+    SECTION( "Mate in two" )
+    {
+        REQUIRE(engine.setFen("r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1"));
+        limits.depth = 6;
+
+        std::vector<SearchInfo> infos;
+        auto result = search.run(engine, limits, [&infos] (const SearchInfo & inInfo) {
+            infos.push_back(inInfo);
+        });
+
+        REQUIRE(!infos.empty());
+        CHECK(infos.back().isMate());
+        CHECK(infos.back().getMateInMoves() == 2);
+        CHECK(infos.back().pv.front() == result.bestMove);
+        CHECK(result.bestMove.toString() == "d5f6");
+    }
+
+    SECTION( "Win material" )
+    {
+        // The queen on d5 hangs to the knight
+        REQUIRE(engine.setFen("rnb1kbnr/ppp1pppp/8/3q4/8/2N5/PPPP1PPP/R1BQKBNR w KQkq - 0 3"));
+        limits.depth = 4;
+
+        auto result = search.run(engine, limits);
+
+        CHECK(result.bestMove.toString() == "c3d5");
+        CHECK(result.score > 500);
+        CHECK(result.stats.nodes > 0);
+        CHECK(result.stats.numIterations == limits.depth);
+
+        if (SearchStats::kIsDetailed)
+        {
+            CHECK(result.stats.ttHits > 0);
+            CHECK(result.stats.ttHits <= result.stats.ttProbes);
+            CHECK(result.stats.firstMoveCutoffs <= result.stats.betaCutoffs);
+        }
+    }
+
+    SECTION( "No legal moves" )
+    {
+        REQUIRE(engine.setFen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"));
+
+        auto result = search.run(engine, limits);
+
+        CHECK(result.bestMove.isNull());
+        CHECK(result.score == 0);
+    }
+
+    SECTION( "Node limit" )
+    {
+        limits.nodes = 20000;
+
+        auto result = search.run(engine, limits);
+
+        MoveList legalMoves;
+        engine.generateLegalMoves(&legalMoves);
+
+        CHECK(legalMoves.contains(result.bestMove));
+        CHECK(result.stats.nodes < limits.nodes + 1024);
+    }
+
+    SECTION( "Stop from another thread" )
+    {
+        SearchResult result;
+
+        std::thread worker([&] {
+            result = search.run(engine, limits);
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        search.stop();
+        worker.join();
+
+        CHECK(!result.bestMove.isNull());
+        CHECK_FALSE(search.isStopped());
+    }
+}
+
+TEST_CASE( "Test pondering and search reuse", "[Search]")
+{
+    ChessEngine::init();
+
+    TranspositionTable table(4);
+    Search             search(&table);
+    ChessEngine        engine;
+    SearchLimits       limits;
+
+    SECTION( "Ponder until the hit" )
+    {
+        limits.moveTimeMs = 50;
+        limits.ponder     = true;
+
+        std::atomic<bool> isDone(false);
+        SearchResult result;
+
+        std::thread worker([&] {
+            result = search.run(engine, limits);
+            isDone = true;
+        });
+
+        // The time limit does not apply while pondering
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        CHECK_FALSE(isDone);
+
+        auto hitTime = std::chrono::steady_clock::now();
+        search.ponderHit();
+        worker.join();
+
+        auto afterHitMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - hitTime).count();
+
+        CHECK(afterHitMs < 1000);
+        CHECK(!result.bestMove.isNull());
+    }
+
+    SECTION( "Seed from the previous principal variation" )
+    {
+        limits.depth = 6;
+
+        auto first = search.run(engine, limits);
+        CHECK(first.stats.seededPlies == 0);
+        REQUIRE(!first.ponderMove.isNull());
+
+        engine.makeMove(first.bestMove);
+        engine.makeMove(first.ponderMove);
+
+        auto second = search.run(engine, limits);
+        CHECK(second.stats.seededPlies > 0);
+
+        REQUIRE(engine.setFen("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3"));
+
+        auto unrelated = search.run(engine, limits);
+        CHECK(unrelated.stats.seededPlies == 0);
+    }
+}
+
+TEST_CASE( "Test multi-PV search", "[Search]")
+{
+    ChessEngine::init();
+
+    TranspositionTable table(4);
+    Search             search(&table);
+    ChessEngine        engine;
+    SearchLimits       limits;
+
+    limits.depth   = 5;
+    limits.multiPv = 3;
+
+    SECTION( "Distinct lines, best first" )
+    {
+        std::vector<SearchInfo> reported;
+
+        auto result = search.run(engine, limits, [&reported] (const SearchInfo & inInfo) {
+            reported.push_back(inInfo);
+        });
+
+        REQUIRE(result.lines.size() == 3);
+        CHECK(result.lines[0].pv[0] == result.bestMove);
+        CHECK(result.lines[0].score == result.score);
+
+        for (size_t i = 0; i < result.lines.size(); i++)
+        {
+            CHECK(result.lines[i].multiPv == static_cast<int>(i) + 1);
+            CHECK(result.lines[i].depth == limits.depth);
+
+            for (size_t j = i + 1; j < result.lines.size(); j++)
+            {
+                CHECK(result.lines[i].pv[0] != result.lines[j].pv[0]);
+                CHECK(result.lines[i].score >= result.lines[j].score);
+            }
+        }
+
+        // Every line of every iteration is reported
+        CHECK(reported.size() == static_cast<size_t>(limits.depth * limits.multiPv));
+    }
+
+    SECTION( "Exact scores" )
+    {
+        // Only one move wins the queen, the other lines are worse by far
+        REQUIRE(engine.setFen("q6k/8/8/8/8/8/8/R5K1 w - - 0 1"));
+
+        auto result = search.run(engine, limits);
+
+        REQUIRE(result.lines.size() == 3);
+        CHECK(result.lines[0].pv[0].toString() == "a1a8");
+        CHECK(result.lines[0].score - result.lines[1].score > 500);
+    }
+
+    SECTION( "Fewer moves than lines" )
+    {
+        REQUIRE(engine.setFen("7k/8/6QK/8/8/8/8/8 b - - 0 1"));
+
+        auto result = search.run(engine, limits);
+
+        MoveList legalMoves;
+        engine.generateLegalMoves(&legalMoves);
+
+        CHECK(result.lines.size() == legalMoves.size);
+    }
+}
+
+TEST_CASE( "Test Lazy SMP helpers", "[Search]")
+{
+    ChessEngine::init();
+
+    ChessEngine  engine;
+    SearchLimits limits;
+
+    limits.depth   = 8;
+    limits.multiPv = 2;
+
+    // Every helper skips its own iterations, and so searches another tree than the main search
+    std::vector<std::vector<int>> depths;
+    std::vector<uint64_t>         nodes;
+
+    for (int helper = 0; helper < 4; helper++)
+    {
+        TranspositionTable table(4);
+        Search             search(&table);
+        std::vector<int>   reported;
+
+        search.setHelperIndex(helper);
+
+        auto result = search.run(engine, limits, [&reported] (const SearchInfo & inInfo) {
+            if (inInfo.multiPv == 1)
+            {
+                reported.push_back(inInfo.depth);
+            }
+        });
+
+        REQUIRE(!reported.empty());
+        CHECK(reported.front() == 1);
+        CHECK(result.depth == reported.back());
+        REQUIRE(result.lines.size() == 2);
+        CHECK(result.lines[0].depth == result.depth);
+        CHECK(result.lines[1].depth == result.depth);
+
+        depths.push_back(reported);
+        nodes.push_back(result.stats.nodes);
+    }
+
+    CHECK(depths[0] == std::vector<int>({ 1, 2, 3, 4, 5, 6, 7, 8 }));
+    CHECK(depths[1] == std::vector<int>({ 1, 2, 4, 6, 8 }));
+    CHECK(depths[2] == std::vector<int>({ 1, 3, 5, 7 }));
+    CHECK(depths[3] == std::vector<int>({ 1, 4, 5, 8 }));
+
+    for (size_t i = 1; i < nodes.size(); i++)
+    {
+        CHECK(nodes[i] != nodes[0]);
+    }
+}
+
+TEST_CASE( "Test search statistics", "[Search]")
+{
+    ChessEngine::init();
+
+    TranspositionTable table(4);
+    Search             search(&table);
+    ChessEngine        engine;
+    SearchLimits       limits;
+
+    REQUIRE(engine.setFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"));
+    limits.depth = 6;
+
+    auto first  = search.run(engine, limits);
+    auto second = search.run(engine, limits);
+
+    REQUIRE(first.stats.numIterations == limits.depth);
+    CHECK(first.stats.qNodes > 0);
+    CHECK(first.stats.qNodes < first.stats.nodes);
+
+    // Threads add up their counters and the times of each depth
+    SearchStats total = first.stats;
+    total += second.stats;
+
+    CHECK(total.nodes == first.stats.nodes + second.stats.nodes);
+    CHECK(total.qNodes == first.stats.qNodes + second.stats.qNodes);
+    CHECK(total.betaCutoffs == first.stats.betaCutoffs + second.stats.betaCutoffs);
+    CHECK(total.numIterations == first.stats.numIterations);
+    CHECK(total.iterationUs[0] == first.stats.iterationUs[0] + second.stats.iterationUs[0]);
+
+    auto json = total.toJson();
+
+    CHECK(json.front() == '{');
+    CHECK(json.back() == '}');
+    CHECK(json.find("\"nodes\":" + std::to_string(total.nodes)) != std::string::npos);
+    CHECK(json.find("\"firstMoveCutoffRate\":") != std::string::npos);
+    CHECK(json.find("\"iterationUs\":[") != std::string::npos);
+    CHECK(json.find("\"pawnHitRate\":") != std::string::npos);
+
+    if (SearchStats::kIsDetailed)
+    {
+        CHECK(first.stats.ttProbes > 0);
+        CHECK(first.stats.betaCutoffs > 0);
+        CHECK(first.stats.nullMoveTries > 0);
+        CHECK(first.stats.lmrReductions > 0);
+        CHECK(first.stats.getFirstMoveCutoffRate() > 0.5);
+    }
+}
+
+TEST_CASE( "Test search allocations", "[Search]")
+{
+    ChessEngine::init();
+
+    TranspositionTable table(4);
+    Search             search(&table);
+    ChessEngine        engine;
+    SearchLimits       limits;
+
+    REQUIRE(engine.setFen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"));
+
+    limits.depth   = 8;
+    limits.multiPv = 3;
+
+    int                      numReported = 0;
+    Search::ProgressCallback onProgress  = [&numReported] (const SearchInfo &) { numReported++; };
+
+    sNumAllocations        = 0;
+    sIsCountingAllocations = true;
+
+    auto result = search.run(engine, limits, onProgress);
+
+    sIsCountingAllocations = false;
+
+    REQUIRE(result.lines.size() == 3);
+    CHECK(numReported == limits.depth * limits.multiPv);
+    CHECK(result.stats.nodes > 10000);
+
+    // Only the lines copied into a new result, their vector and the principal variation of each
+    CHECK(sNumAllocations == 1 + result.lines.size());
+
+    // A result searched into again keeps the memory of its lines
+    table.clear();
+    search.clearHistory();
+
+    sNumAllocations        = 0;
+    sIsCountingAllocations = true;
+
+    search.run(engine, limits, &result, onProgress);
+
+    sIsCountingAllocations = false;
+
+    REQUIRE(result.lines.size() == 3);
+    CHECK(result.stats.nodes > 10000);
+    CHECK(sNumAllocations == 0);
+
+    // As does a game longer than the moves reserved from the start, once its position was copied
+    engine = ChessEngine();
+
+    const PackedMove kShuffle[] = {
+        PackedMove(Square(0, 6), Square(2, 5), PackedMove::kQuiet),
+        PackedMove(Square(7, 6), Square(5, 5), PackedMove::kQuiet),
+        PackedMove(Square(2, 5), Square(0, 6), PackedMove::kQuiet),
+        PackedMove(Square(5, 5), Square(7, 6), PackedMove::kQuiet)
+    };
+
+    for (size_t ply = 0; ply < ChessEngine::kMaxGamePly + 100; ply++)
+    {
+        engine.makeMove(kShuffle[ply % 4]);
+    }
+
+    limits.depth = 6;
+    search.run(engine, limits, &result);
+
+    sNumAllocations        = 0;
+    sIsCountingAllocations = true;
+
+    search.run(engine, limits, &result);
+
+    sIsCountingAllocations = false;
+
+    CHECK(!result.bestMove.isNull());
+    CHECK(sNumAllocations == 0);
+}
+
+TEST_CASE( "Benchmark table prefetch", "[.][benchmark]")
+{
+    ChessEngine::init();
+
+    // Large enough that probes miss the cache
+    TranspositionTable table(512);
+    Search             search(&table);
+    ChessEngine        engine;
+
+    const char * fens[] = {
+        "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    uint64_t nodes[2] = { 0, 0 };
+
+    for (auto isEnabled : { false, true })
+    {
+        int64_t usedUs = 0;
+
+        search.setPrefetch(isEnabled);
+
+        for (auto fen : fens)
+        {
+            REQUIRE(engine.setFen(fen));
+
+            SearchLimits limits;
+            limits.depth = 11;
+
+            table.clear();
+            search.clearHistory();
+
+            auto start  = std::chrono::steady_clock::now();
+            auto result = search.run(engine, limits);
+            usedUs += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+            nodes[isEnabled] += result.stats.nodes;
+        }
+
+        auto nodesPerSecond = nodes[isEnabled] * 1000000 / std::max<int64_t>(usedUs, 1);
+
+        printf("Prefetch %s: %llu nodes, %llu nodes/s\n", isEnabled ? "on" : "off",
+               static_cast<unsigned long long>(nodes[isEnabled]),
+               static_cast<unsigned long long>(nodesPerSecond));
+    }
+
+    // Prefetching changes the speed, never the search
+    CHECK(nodes[0] == nodes[1]);
+}
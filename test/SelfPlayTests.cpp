@@ -0,0 +1,98 @@
+/***************************************************************************************************
+ *
+ *  @file       SelfPlayTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "SelfPlay.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace chessEngine;
+
+static std::vector<std::string>
+_readRecords(const char * inPath)
+{
+    std::ifstream            file(inPath, std::ios::binary);
+    std::ostringstream       data;
+    std::vector<std::string> records;
+
+    data << file.rdbuf();
+
+    auto text = data.str();
+
+    REQUIRE((text.size() % SelfPlay::kRecordSize) == 0);
+
+    for (size_t offset = 0; offset < text.size(); offset += SelfPlay::kRecordSize)
+    {
+        records.push_back(text.substr(offset, SelfPlay::kRecordSize));
+    }
+
+    std::sort(records.begin(), records.end());
+
+    return records;
+}
+
+TEST_CASE( "Test self-play", "[SelfPlay]")
+{
+    ChessEngine::init();
+
+    static const char * const kPath      = "SelfPlayTests.bin";
+    static const char * const kOtherPath = "SelfPlayTests.other.bin";
+
+    SelfPlayOptions options;
+    SelfPlayStats   stats;
+    uint64_t        numProgress = 0;
+
+    options.numGames       = 6;
+    options.numThreads     = 3;
+    options.limits.nodes   = 400;
+    options.maxPlies       = 60;
+    options.hashSizeMb     = 1;
+    options.flushInterval  = 2;
+
+    REQUIRE(SelfPlay::run(kPath, options, &stats, [&] (const SelfPlayStats & inStats) {
+        CHECK(inStats.numGames == ++numProgress);
+    }));
+
+    CHECK(stats.numGames == options.numGames);
+    CHECK(numProgress == options.numGames);
+    CHECK(stats.numWhiteWins + stats.numDraws + stats.numBlackWins == stats.numGames);
+    CHECK(stats.numRecords > options.numGames * 10);
+
+    auto records = _readRecords(kPath);
+    REQUIRE(records.size() == stats.numRecords);
+
+    // Every record is a position the engine can set up, with a score and result for its side
+    ChessEngine position;
+
+    for (auto & data : records)
+    {
+        auto record = SelfPlay::readRecord(reinterpret_cast<const uint8_t *>(data.data()));
+
+        REQUIRE(position.setPackedPosition(record.position));
+        CHECK(!position.isInCheck());
+        CHECK(std::abs(record.score) < 30000);
+        CHECK(((record.result >= -1) && (record.result <= 1)));
+        CHECK(position.getFullMoveNumber() > options.numRandomPlies / 2);
+    }
+
+    // The games do not depend on the number of threads
+    options.numThreads = 1;
+
+    REQUIRE(SelfPlay::run(kOtherPath, options));
+    CHECK(_readRecords(kOtherPath) == records);
+
+    remove(kPath);
+    remove(kOtherPath);
+}
@@ -0,0 +1,351 @@
+/***************************************************************************************************
+ *
+ *  @file       TablebaseTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "Search.h"
+#include "Tablebase.h"
+#include "TablebaseGenerator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+using namespace chessEngine;
+
+/**
+ @brief         Largest distance to zeroing of the kings and one white piece, white to move
+
+ @discussion    The white king only goes over the a1-d1-d4 triangle, which the other squares mirror
+ to.
+ */
+static int
+_getMaxDtz(const Tablebases & inTablebases, char inPiece)
+{
+    static const int kTriangle[] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+
+    ChessEngine engine;
+    int         maxDtz = -1;
+
+    for (auto whiteKing : kTriangle)
+    {
+        for (int piece = 0; piece < 64; piece++)
+        {
+            for (int blackKing = 0; blackKing < 64; blackKing++)
+            {
+                if ((piece == whiteKing) || (blackKing == whiteKing) || (blackKing == piece))
+                {
+                    continue;
+                }
+
+                std::string board(64, ' ');
+                board[whiteKing] = 'K';
+                board[piece]     = inPiece;
+                board[blackKing] = 'k';
+
+                std::string fen;
+
+                for (int row = 7; row >= 0; row--)
+                {
+                    for (int col = 0; col < 8; col++)
+                    {
+                        char c = board[row * 8 + col];
+                        fen += (c != ' ') ? c : '1';
+                    }
+
+                    fen += (row > 0) ? "/" : " w - - 0 1";
+                }
+
+                // The black king cannot be in check
+                int dtz;
+
+                if (!engine.setFen(fen) ||
+                    engine.isSquareAttacked(Square(static_cast<uint8_t>(blackKing)),
+                                            attributes::ChessColor::kWhite))
+                {
+                    continue;
+                }
+
+                if (!inTablebases.probeDtz(engine, &dtz))
+                {
+                    return -1;
+                }
+
+                maxDtz = std::max(maxDtz, dtz);
+            }
+        }
+    }
+
+    return maxDtz;
+}
+
+/**
+ @brief         Tables generated once into the working directory, removed at exit
+ */
+struct GeneratedTables
+{
+    static constexpr int        kNumTables = 5;
+    static const char * const   kNames[kNumTables];
+
+    Tablebases                  tablebases;
+    bool                        isGenerated;
+
+    GeneratedTables() :
+    isGenerated(true)
+    {
+        ChessEngine::init();
+
+        // Promotions lead into the tables before the pawn one
+        for (auto name : kNames)
+        {
+            isGenerated = isGenerated && TablebaseGenerator::generate(name, ".", tablebases);
+            tablebases.load(".");
+        }
+    }
+
+    ~GeneratedTables()
+    {
+        tablebases.clear();
+
+        for (auto name : kNames)
+        {
+            remove((std::string(name) + Tablebases::kWdlSuffix).c_str());
+            remove((std::string(name) + Tablebases::kDtzSuffix).c_str());
+        }
+    }
+
+    static GeneratedTables &    get()
+    {
+        static GeneratedTables sTables;
+        return sTables;
+    }
+};
+
+const char * const GeneratedTables::kNames[GeneratedTables::kNumTables] = {
+    "KQvK", "KRvK", "KBvK", "KNvK", "KPvK"
+};
+
+TEST_CASE( "Test tablebase material", "[Tablebase]")
+{
+    TablebaseMaterial material;
+
+    REQUIRE(TablebaseMaterial::fromName("KRPvKR", &material));
+    CHECK(material.getName() == "KRPvKR");
+    CHECK(material.getNumPieces() == 5);
+    CHECK(material.getFlipped().getName() == "KRvKRP");
+    CHECK(material.getFlipped().getKey() != material.getKey());
+
+    CHECK_FALSE(TablebaseMaterial::fromName("KRP", &material));
+    CHECK_FALSE(TablebaseMaterial::fromName("RvK", &material));
+    CHECK_FALSE(TablebaseMaterial::fromName("KXvK", &material));
+    CHECK_FALSE(TablebaseMaterial::fromName("KQQQQQvK", &material));
+
+    ChessEngine::init();
+
+    ChessEngine engine;
+    REQUIRE(engine.setFen("8/8/3k4/8/8/2K5/3R4/8 w - - 0 1"));
+    CHECK(TablebaseMaterial::fromPosition(engine).getName() == "KRvK");
+}
+
+TEST_CASE( "Test tablebases", "[Tablebase]")
+{
+    auto & generated  = GeneratedTables::get();
+    auto & tablebases = generated.tablebases;
+
+    REQUIRE(generated.isGenerated);
+    REQUIRE(tablebases.getNumTables() == 5);
+    CHECK(tablebases.getMaxPieces() == 3);
+
+    ChessEngine     engine;
+    Tablebases::Wdl wdl;
+    int             dtz;
+
+    SECTION( "Distances match the longest known mates" )
+    {
+        // Mate in 10 with the queen and in 16 with the rook
+        CHECK(_getMaxDtz(tablebases, 'Q') == 19);
+        CHECK(_getMaxDtz(tablebases, 'R') == 31);
+    }
+
+    SECTION( "Mate in one" )
+    {
+        REQUIRE(engine.setFen("7k/8/6K1/8/8/8/8/1Q6 w - - 0 1"));
+
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kWin);
+        REQUIRE(tablebases.probeDtz(engine, &dtz));
+        CHECK(dtz == 1);
+
+        // The same with the colors swapped
+        REQUIRE(engine.setFen("1q6/8/8/8/8/6k1/8/7K b - - 0 1"));
+
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kWin);
+        REQUIRE(tablebases.probeDtz(engine, &dtz));
+        CHECK(dtz == 1);
+    }
+
+    SECTION( "Draws" )
+    {
+        // The queen is lost
+        REQUIRE(engine.setFen("8/8/8/8/8/8/6kQ/K7 b - - 0 1"));
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kDraw);
+
+        // Stalemate
+        REQUIRE(engine.setFen("k7/2Q5/1K6/8/8/8/8/8 b - - 0 1"));
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kDraw);
+
+        // Bare kings
+        REQUIRE(engine.setFen("8/8/3k4/8/8/2K5/8/8 w - - 0 1"));
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kDraw);
+    }
+
+    SECTION( "Losses" )
+    {
+        REQUIRE(engine.setFen("8/8/3k4/8/8/2K5/3R4/8 b - - 0 1"));
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kLoss);
+        REQUIRE(tablebases.probeDtz(engine, &dtz));
+        CHECK(dtz < 0);
+    }
+
+    SECTION( "Pawns" )
+    {
+        // The king in front of the pawn on the sixth rank wins whoever moves, on any file
+        REQUIRE(engine.setFen("4k3/8/4K3/4P3/8/8/8/8 w - - 0 1"));
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kWin);
+        REQUIRE(tablebases.probeDtz(engine, &dtz));
+        CHECK(dtz > 0);
+
+        REQUIRE(engine.setFen("3k4/8/3K4/3P4/8/8/8/8 b - - 0 1"));
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kLoss);
+
+        // Except with a rook pawn
+        REQUIRE(engine.setFen("k7/8/K7/P7/8/8/8/8 w - - 0 1"));
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kDraw);
+
+        // Stalemate
+        REQUIRE(engine.setFen("4k3/4P3/4K3/8/8/8/8/8 b - - 0 1"));
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kDraw);
+
+        // The pawn promotes, with the colors swapped
+        REQUIRE(engine.setFen("4k3/8/8/8/8/8/K3p3/8 b - - 0 1"));
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kWin);
+        REQUIRE(tablebases.probeDtz(engine, &dtz));
+        CHECK(dtz == 1);
+    }
+
+    SECTION( "The 50 move rule" )
+    {
+        REQUIRE(engine.setFen("8/8/3k4/8/8/2K5/3R4/8 b - - 0 1"));
+        REQUIRE(tablebases.probeDtz(engine, &dtz));
+
+        // The loss holds as long as the clock lets the win be converted
+        auto clock = std::to_string(100 + dtz);
+
+        REQUIRE(engine.setFen("8/8/3k4/8/8/2K5/3R4/8 b - - " + clock + " 80"));
+        REQUIRE(tablebases.probeWdlWithClock(engine, &wdl));
+        CHECK(wdl == Tablebases::kLoss);
+
+        clock = std::to_string(101 + dtz);
+
+        REQUIRE(engine.setFen("8/8/3k4/8/8/2K5/3R4/8 b - - " + clock + " 80"));
+        REQUIRE(tablebases.probeWdlWithClock(engine, &wdl));
+        CHECK(wdl == Tablebases::kBlessedLoss);
+        REQUIRE(tablebases.probeWdl(engine, &wdl));
+        CHECK(wdl == Tablebases::kLoss);
+
+        // Draws do not need the DTZ
+        REQUIRE(engine.setFen("8/8/8/8/8/8/6kQ/K7 b - - 60 80"));
+        REQUIRE(tablebases.probeWdlWithClock(engine, &wdl));
+        CHECK(wdl == Tablebases::kDraw);
+    }
+
+    SECTION( "Not in the tables" )
+    {
+        REQUIRE(engine.setFen("8/8/3k4/8/8/2K5/3B4/3N4 w - - 0 1"));
+        CHECK_FALSE(tablebases.probeWdl(engine, &wdl));
+
+        // Files that are not Syzygy ones are left out
+        FILE * file = fopen("KBNvK.rtbw", "wb");
+        REQUIRE(file != nullptr);
+        fputs("Not a table", file);
+        fclose(file);
+
+        Tablebases others;
+        CHECK(others.load(".") == tablebases.getNumTables());
+        remove("KBNvK.rtbw");
+
+        REQUIRE(engine.setFen("r3k3/8/8/8/8/8/8/4K3 b q - 0 1"));
+        CHECK_FALSE(tablebases.canProbe(engine));
+    }
+
+    SECTION( "Root moves keep the win" )
+    {
+        // The queen can be taken after most of its moves
+        REQUIRE(engine.setFen("8/8/8/8/8/5k2/6Q1/K7 w - - 0 1"));
+
+        MoveList moves;
+        engine.generateLegalMoves(&moves);
+
+        auto numLegal = moves.size;
+
+        REQUIRE(tablebases.filterRootMoves(engine, &moves));
+        CHECK(moves.size > 0);
+        CHECK(moves.size < numLegal);
+
+        for (auto move : moves)
+        {
+            engine.makeMove(move);
+            REQUIRE(tablebases.probeWdl(engine, &wdl));
+            CHECK(wdl == Tablebases::kLoss);
+            engine.unmakeMove();
+        }
+    }
+
+    SECTION( "Search" )
+    {
+        TranspositionTable table(4);
+        Search             search(&table);
+        SearchLimits       limits;
+
+        search.setTablebases(&tablebases);
+        limits.depth = 4;
+
+        // Winning the rook leads into a won table
+        REQUIRE(engine.setFen("4k3/8/8/8/8/8/r7/R3K3 w - - 0 1"));
+
+        auto result = search.run(engine, limits);
+
+        CHECK(result.bestMove.toString() == "a1a2");
+        CHECK(result.score >= Search::kTBWinScore - Search::kMaxPly);
+        CHECK(result.stats.tbHits > 0);
+
+        // The tables are probed with a running clock too, which spoils a win too far from mate
+        REQUIRE(engine.setFen("8/8/3k4/8/8/2K5/3R4/8 w - - 0 80"));
+        result = search.run(engine, limits);
+        CHECK(result.score >= Search::kTBWinScore - Search::kMaxPly);
+
+        REQUIRE(engine.setFen("8/8/3k4/8/8/2K5/3R4/8 w - - 90 80"));
+        table.clear();
+        result = search.run(engine, limits);
+        CHECK(result.score < Search::kMateBound - Search::kMaxPly);
+        CHECK(result.stats.tbHits > 0);
+    }
+}
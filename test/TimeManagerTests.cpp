@@ -0,0 +1,171 @@
+/***************************************************************************************************
+ *
+ *  @file       TimeManagerTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "Search.h"
+#include "TimeManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace chessEngine;
+
+TEST_CASE( "Test time manager", "[TimeManager]")
+{
+    TimeManager  timeManager;
+    SearchLimits limits;
+
+    SECTION( "No limit" )
+    {
+        timeManager.start(limits);
+
+        CHECK_FALSE(timeManager.isLimited());
+        CHECK(timeManager.shouldStartIteration(1000000000));
+        CHECK_FALSE(timeManager.isHardLimitReached(1000000000));
+    }
+
+    SECTION( "Fixed move time" )
+    {
+        limits.moveTimeMs = 100;
+        timeManager.start(limits);
+
+        CHECK(timeManager.getHardLimitUs() == 100000);
+        CHECK(timeManager.shouldStartIteration(49000));
+        CHECK_FALSE(timeManager.shouldStartIteration(51000));
+        CHECK(timeManager.isHardLimitReached(100000));
+
+        // Stability does not matter when the time is fixed
+        for (int i = 0; i < 10; i++)
+        {
+            timeManager.onIteration(PackedMove(Square(12), Square(28), PackedMove::kQuiet), 20);
+        }
+
+        CHECK(timeManager.getSoftLimitUs() == 50000);
+    }
+
+    SECTION( "Clock" )
+    {
+        limits.timeLeftMs  = 60000;
+        limits.incrementMs = 1000;
+        timeManager.start(limits);
+
+        auto soft = timeManager.getSoftLimitUs();
+        auto hard = timeManager.getHardLimitUs();
+
+        CHECK(soft > 0);
+        CHECK(soft <= hard);
+        CHECK(hard <= (limits.timeLeftMs - TimeManager::kMoveOverheadMs) * 1000);
+
+        // A stable best move shrinks the soft limit
+        for (int i = 0; i < 8; i++)
+        {
+            timeManager.onIteration(PackedMove(Square(12), Square(28), PackedMove::kQuiet), 20);
+        }
+
+        auto stableSoft = timeManager.getSoftLimitUs();
+        CHECK(stableSoft < soft);
+
+        // A changing best move and a falling score stretch it
+        timeManager.onIteration(PackedMove(Square(11), Square(27), PackedMove::kQuiet), -80);
+        CHECK(timeManager.getSoftLimitUs() > soft);
+        CHECK(timeManager.getSoftLimitUs() <= hard);
+    }
+
+    SECTION( "Last move before the time control" )
+    {
+        limits.timeLeftMs = 1000;
+        limits.movesToGo  = 1;
+        timeManager.start(limits);
+
+        CHECK(timeManager.getHardLimitUs() == (1000 - TimeManager::kMoveOverheadMs) * 1000);
+    }
+
+    SECTION( "Almost no time left" )
+    {
+        limits.timeLeftMs = 5;
+        timeManager.start(limits);
+
+        CHECK(timeManager.isLimited());
+        CHECK(timeManager.getHardLimitUs() >= 1000);
+    }
+
+    SECTION( "Check interval follows the node rate" )
+    {
+        uint64_t minInterval = TimeManager::kMinCheckInterval;
+
+        timeManager.start(limits);
+        CHECK(timeManager.getCheckInterval() == minInterval);
+
+        // 4 million nodes a second
+        timeManager.updateNodeRate(40000, 10000);
+        CHECK(timeManager.getCheckInterval() == 4 * TimeManager::kCheckPeriodUs);
+
+        timeManager.updateNodeRate(100, 10000);
+        CHECK(timeManager.getCheckInterval() == minInterval);
+    }
+}
+
+TEST_CASE( "Benchmark time overrun", "[.][benchmark]")
+{
+    ChessEngine::init();
+
+    TranspositionTable table(16);
+    Search             search(&table);
+    ChessEngine        engine;
+
+    const char * fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+
+    const int64_t moveTimesMs[] = { 1, 5, 20, 100 };
+
+    // Overrun of the hard limit of each search, in microseconds
+    std::vector<int64_t> overrunsUs;
+
+    for (auto moveTimeMs : moveTimesMs)
+    {
+        for (auto fen : fens)
+        {
+            for (int i = 0; i < 5; i++)
+            {
+                REQUIRE(engine.setFen(fen));
+
+                SearchLimits limits;
+                limits.moveTimeMs = moveTimeMs;
+
+                auto start  = std::chrono::steady_clock::now();
+                search.run(engine, limits);
+                auto usedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+
+                overrunsUs.push_back(std::max<int64_t>(usedUs - moveTimeMs * 1000, 0));
+            }
+        }
+    }
+
+    std::sort(overrunsUs.begin(), overrunsUs.end());
+
+    auto percentile = [&overrunsUs] (size_t inPercent) {
+        return overrunsUs[std::min(overrunsUs.size() - 1, overrunsUs.size() * inPercent / 100)];
+    };
+
+    printf("Time overrun over %zu searches: p50 %lld us, p90 %lld us, p99 %lld us, max %lld us\n",
+           overrunsUs.size(), static_cast<long long>(percentile(50)),
+           static_cast<long long>(percentile(90)), static_cast<long long>(percentile(99)),
+           static_cast<long long>(overrunsUs.back()));
+
+    CHECK(percentile(99) < 1000);
+}
@@ -0,0 +1,210 @@
+/***************************************************************************************************
+ *
+ *  @file       UciEngineTests.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief
+ *
+ **************************************************************************************************/
+
+#include "Test.h"
+
+#include "ChessEngine.h"
+#include "Nnue.h"
+#include "UciEngine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace chessEngine;
+
+/**
+ @brief         Output of the engine that holds its own lock, as the worker writes to it
+ */
+class _SyncedBuffer : public std::stringbuf
+{
+public:
+    std::string                     getText()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return str();
+    }
+
+protected:
+    int                             sync() override
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return std::stringbuf::sync();
+    }
+
+    std::streamsize                 xsputn(const char * inData, std::streamsize inSize) override
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return std::stringbuf::xsputn(inData, inSize);
+    }
+
+    int_type                        overflow(int_type inChar) override
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        return std::stringbuf::overflow(inChar);
+    }
+
+private:
+    // The base class overflows from within xsputn
+    std::recursive_mutex            _mutex;
+};
+
+static bool
+_contains(const std::string & inText, const std::string & inPart)
+{
+    return inText.find(inPart) != std::string::npos;
+}
+
+TEST_CASE( "Test UCI engine", "[UciEngine]")
+{
+    ChessEngine::init();
+
+    _SyncedBuffer buffer;
+    std::ostream  out(&buffer);
+    UciEngine     engine(out);
+
+    SECTION( "Handshake" )
+    {
+        CHECK(engine.handleCommand("uci"));
+        CHECK(engine.handleCommand("isready"));
+        CHECK(engine.handleCommand("not a command"));
+
+        auto text = buffer.getText();
+
+        CHECK(_contains(text, "id name Chess\n"));
+        CHECK(_contains(text, "option name Hash type spin"));
+        CHECK(_contains(text, "option name Threads type spin"));
+        CHECK(_contains(text, "uciok\nreadyok\n"));
+
+        CHECK_FALSE(engine.handleCommand("quit"));
+    }
+
+    SECTION( "Network of the EvalFile option" )
+    {
+        static const char * const kPath = "UciEngineTests.nnue";
+
+        // Every position is worth 123 centipawns to the side to move
+        std::unique_ptr<nnue::Network> network(new nnue::Network());
+        memset(network.get(), 0, sizeof(nnue::Network));
+        network->outBias = 123 * nnue::kOutputScale;
+        REQUIRE(network->save(kPath));
+
+        engine.handleCommand("uci");
+        CHECK(_contains(buffer.getText(), "option name EvalFile type string default <empty>"));
+
+        engine.handleCommand(std::string("setoption name EvalFile value ") + kPath);
+        engine.handleCommand("position startpos");
+        engine.handleCommand("go depth 1");
+        engine.waitForSearch();
+
+        CHECK(_contains(buffer.getText(), "info depth 1 seldepth 1 multipv 1 score cp -123 "));
+
+        // A file that is not a network keeps the one in use
+        engine.handleCommand("setoption name EvalFile value UciEngineTests.missing.nnue");
+        CHECK(_contains(buffer.getText(), "info string Could not load the network"));
+
+        engine.handleCommand("position startpos moves e2e4");
+        engine.handleCommand("go depth 1");
+        engine.waitForSearch();
+
+        CHECK(_contains(buffer.getText(), "score cp -123 nodes"));
+
+        // Back to the handcrafted evaluation
+        auto numChars = buffer.getText().size();
+
+        engine.handleCommand("setoption name EvalFile value <empty>");
+        engine.handleCommand("position startpos");
+        engine.handleCommand("go depth 1");
+        engine.waitForSearch();
+
+        auto text = buffer.getText().substr(numChars);
+        CHECK(_contains(text, "info depth 1 "));
+        CHECK_FALSE(_contains(text, "score cp -123 "));
+
+        remove(kPath);
+    }
+
+    SECTION( "Search to a depth" )
+    {
+        engine.handleCommand("position startpos moves e2e4 e7e5 g1f3");
+        engine.handleCommand("go depth 4");
+        engine.waitForSearch();
+
+        auto text = buffer.getText();
+
+        CHECK(_contains(text, "info depth 4 "));
+        CHECK(_contains(text, "\nbestmove "));
+        CHECK_FALSE(_contains(text, "info depth 5 "));
+    }
+
+    SECTION( "Mate from a FEN" )
+    {
+        engine.handleCommand("setoption name MultiPV value 2");
+        engine.handleCommand("position fen 6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+        engine.handleCommand("go depth 3");
+        engine.waitForSearch();
+
+        auto text = buffer.getText();
+
+        CHECK(_contains(text, "multipv 1 score mate 1 "));
+        CHECK(_contains(text, "multipv 2 "));
+        CHECK(_contains(text, "bestmove d1d8\n"));
+    }
+
+    SECTION( "Invalid positions and moves" )
+    {
+        engine.handleCommand("position fen not a fen");
+        engine.handleCommand("position startpos moves e2e4 e2e4");
+
+        auto text = buffer.getText();
+
+        CHECK(_contains(text, "info string Invalid FEN"));
+        CHECK(_contains(text, "info string Illegal move e2e4"));
+
+        // No legal moves
+        engine.handleCommand("position fen 7k/5K2/6Q1/8/8/8/8/8 b - - 0 1");
+        engine.handleCommand("go depth 2");
+        engine.waitForSearch();
+
+        CHECK(_contains(buffer.getText(), "bestmove 0000\n"));
+    }
+
+    SECTION( "Infinite search until stopped" )
+    {
+        engine.handleCommand("setoption name Threads value 3");
+        engine.handleCommand("setoption name Hash value 8");
+        engine.handleCommand("position startpos");
+        engine.handleCommand("go infinite");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK_FALSE(_contains(buffer.getText(), "bestmove"));
+
+        engine.handleCommand("stop");
+        CHECK(_contains(buffer.getText(), "bestmove"));
+    }
+
+    SECTION( "Pondering until the hit" )
+    {
+        engine.handleCommand("position startpos moves d2d4");
+        engine.handleCommand("go ponder movetime 20");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK_FALSE(_contains(buffer.getText(), "bestmove"));
+
+        engine.handleCommand("ponderhit");
+        engine.waitForSearch();
+
+        CHECK(_contains(buffer.getText(), "bestmove"));
+    }
+}
@@ -0,0 +1,171 @@
+/***************************************************************************************************
+ *
+ *  @file       BenchMain.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Deterministic search benchmark
+ *
+ *  @discussion Searches a fixed set of positions to a fixed depth on one thread, and prints the
+ *  total number of nodes and the speed. The node count is a signature of the search: a change
+ *  that is not meant to change the search has to keep it, and a change meant to make it faster
+ *  is measured by the nodes per second. With --json the search statistics of all the positions
+ *  are printed at the end as one JSON object. With --nnue the positions are evaluated by the
+ *  network of a file rather than the handcrafted evaluation, to compare their nodes per second.
+ *
+ *  Usage: ChessBench [depth [hash in MB]] [--no-prefetch] [--json] [--nnue network]
+ *
+ **************************************************************************************************/
+
+#include "ChessEngine.h"
+#include "Nnue.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+using namespace chessEngine;
+
+static constexpr int        kDefaultDepth = 10;
+
+static const char * const   kBenchFens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "r2q1rk1/1b2bppp/p2ppn2/1p6/3NP3/1BN1B3/PPP2PPP/R2Q1RK1 w - - 0 12",
+    "2r2rk1/pp1bqppp/2n1pn2/3p4/3P4/2PBPN2/P1Q2PPP/R4RK1 b - - 5 15",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/8 b - - 0 1",
+    "8/3k4/8/8/3PK3/8/8/8 w - - 0 1",
+    "8/8/1p4k1/p1p2p2/P1P2P2/1P4K1/8/8 w - - 0 1",
+};
+
+int
+main(int argc, char ** argv)
+{
+    int    depth      = kDefaultDepth;
+    size_t hashSizeMb = TranspositionTable::kDefaultSizeMb;
+    bool   isPrefetch = true;
+    bool   isJson     = false;
+    int    numNumbers = 0;
+
+    const char * networkPath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--no-prefetch") == 0)
+        {
+            isPrefetch = false;
+        }
+        else if (strcmp(argv[i], "--json") == 0)
+        {
+            isJson = true;
+        }
+        else if ((strcmp(argv[i], "--nnue") == 0) && (i + 1 < argc))
+        {
+            networkPath = argv[++i];
+        }
+        else if (numNumbers == 0)
+        {
+            depth = atoi(argv[i]);
+            numNumbers++;
+        }
+        else if (numNumbers == 1)
+        {
+            hashSizeMb = static_cast<size_t>(atoi(argv[i]));
+            numNumbers++;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [depth [hash in MB]] [--no-prefetch] [--json] "
+                    "[--nnue network]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((depth <= 0) || (depth > Search::kMaxDepth) || (hashSizeMb == 0))
+    {
+        fprintf(stderr, "Invalid depth or hash size\n");
+        return 1;
+    }
+
+    ChessEngine::init();
+
+    TranspositionTable             table(hashSizeMb);
+    Search                         search(&table);
+    ChessEngine                    engine;
+    std::unique_ptr<nnue::Network> network;
+
+    search.setPrefetch(isPrefetch);
+
+    if (networkPath != nullptr)
+    {
+        network.reset(new nnue::Network());
+
+        if (!network->load(networkPath))
+        {
+            fprintf(stderr, "Could not load the network %s\n", networkPath);
+            return 1;
+        }
+
+        // Kept by the engine through every position it is set to
+        engine.setNetwork(network.get());
+        printf("Network kernels : %s\n", nnue::Network::getKernelName());
+    }
+
+    SearchLimits limits;
+    limits.depth = depth;
+
+    SearchStats totalStats;
+    int64_t     totalUs = 0;
+    int         index   = 0;
+
+    for (auto fen : kBenchFens)
+    {
+        if (!engine.setFen(fen))
+        {
+            fprintf(stderr, "Invalid bench position %s\n", fen);
+            return 1;
+        }
+
+        // Every position starts with an empty table and history, so that its count does not
+        // depend on the positions before it
+        table.clear();
+        search.clearHistory();
+
+        auto start  = std::chrono::steady_clock::now();
+        auto result = search.run(engine, limits);
+        auto usedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        totalStats += result.stats;
+        totalUs    += usedUs;
+
+        printf("Position %2d: %10llu nodes  best %s  score %d\n", ++index,
+               static_cast<unsigned long long>(result.stats.nodes),
+               result.bestMove.toString().c_str(), result.score);
+    }
+
+    auto totalNodes     = totalStats.nodes;
+    auto elapsedUs      = static_cast<uint64_t>(std::max<int64_t>(totalUs, 1));
+    auto nodesPerSecond = totalNodes * 1000000 / elapsedUs;
+
+    printf("===========================\n");
+    printf("Total time (ms) : %lld\n", static_cast<long long>(totalUs / 1000));
+    printf("Nodes searched  : %llu\n", static_cast<unsigned long long>(totalNodes));
+    printf("Nodes/second    : %llu\n", static_cast<unsigned long long>(nodesPerSecond));
+
+    if (isJson)
+    {
+        printf("%s\n", totalStats.toJson().c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+/***************************************************************************************************
+ *
+ *  @file       EpdMain.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Runner of EPD test suites
+ *
+ *  @discussion Searches the positions of EPD files with bm or am operations on all the cores,
+ *  one position per thread, each for a fixed time, number of nodes or depth. Prints whether every
+ *  position was solved and how soon, then the totals, and with --json writes the report of
+ *  EpdSuite::toJson() to a file.
+ *
+ *  Usage: ChessEpd file... [--time ms] [--nodes n] [--depth n] [--threads n] [--hash MB]
+ *                  [--json report]
+ *
+ **************************************************************************************************/
+
+#include "ChessEngine.h"
+#include "EpdSuite.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using namespace chessEngine;
+
+static void
+_printUsage(const char * inName)
+{
+    fprintf(stderr, "Usage: %s file... [--time ms] [--nodes n] [--depth n] [--threads n] "
+            "[--hash MB] [--json report]\n", inName);
+}
+
+int
+main(int argc, char ** argv)
+{
+    EpdOptions                options;
+    std::vector<const char *> paths;
+    const char *              jsonPath = nullptr;
+
+    options.numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+
+        if ((strcmp(argv[i], "--time") == 0) && hasValue)
+        {
+            options.limits.moveTimeMs = atoll(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--nodes") == 0) && hasValue)
+        {
+            options.limits.nodes      = strtoull(argv[++i], nullptr, 10);
+            options.limits.moveTimeMs = 0;
+        }
+        else if ((strcmp(argv[i], "--depth") == 0) && hasValue)
+        {
+            options.limits.depth      = atoi(argv[++i]);
+            options.limits.moveTimeMs = 0;
+        }
+        else if ((strcmp(argv[i], "--threads") == 0) && hasValue)
+        {
+            options.numThreads = std::max(atoi(argv[++i]), 1);
+        }
+        else if ((strcmp(argv[i], "--hash") == 0) && hasValue)
+        {
+            options.hashSizeMb = static_cast<size_t>(atoi(argv[++i]));
+        }
+        else if ((strcmp(argv[i], "--json") == 0) && hasValue)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            _printUsage(argv[0]);
+            return 1;
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    // A search without a limit would never end
+    if (paths.empty() || (options.hashSizeMb == 0) ||
+        ((options.limits.moveTimeMs <= 0) && (options.limits.nodes == 0) &&
+         (options.limits.depth <= 0)))
+    {
+        _printUsage(argv[0]);
+        return 1;
+    }
+
+    ChessEngine::init();
+
+    std::vector<EpdPosition> positions;
+
+    for (auto path : paths)
+    {
+        int errorLine;
+
+        if (!EpdSuite::load(path, &positions, &errorLine))
+        {
+            if (errorLine > 0)
+            {
+                fprintf(stderr, "%s:%d: not a valid EPD line\n", path, errorLine);
+            }
+            else
+            {
+                fprintf(stderr, "Could not read %s\n", path);
+            }
+
+            return 1;
+        }
+    }
+
+    auto start   = std::chrono::steady_clock::now();
+    auto results = EpdSuite::run(positions, options,
+                                 [&] (size_t inIndex, const EpdResult & inResult) {
+        auto & position = positions[inIndex];
+
+        printf("%-20s %-8s %6s", position.id.empty() ? "-" : position.id.c_str(),
+               inResult.move.toString().c_str(), inResult.isSolved ? "solved" : "failed");
+
+        if (inResult.isSolved)
+        {
+            printf("  %lld ms, %llu nodes", static_cast<long long>(inResult.solutionTimeMs),
+                   static_cast<unsigned long long>(inResult.solutionNodes));
+        }
+
+        printf("\n");
+        fflush(stdout);
+    });
+
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    uint64_t numSolved = 0, nodes = 0;
+
+    for (auto & result : results)
+    {
+        numSolved += result.isSolved ? 1 : 0;
+        nodes     += result.nodes;
+    }
+
+    printf("===========================\n");
+    printf("Solved          : %llu / %llu\n", static_cast<unsigned long long>(numSolved),
+           static_cast<unsigned long long>(results.size()));
+    printf("Nodes           : %llu\n", static_cast<unsigned long long>(nodes));
+    printf("Time (ms)       : %lld\n", static_cast<long long>(elapsedMs));
+    printf("Positions/s     : %.1f\n", results.size() * 1000.0 / std::max<int64_t>(elapsedMs, 1));
+
+    if (jsonPath != nullptr)
+    {
+        std::ofstream file(jsonPath);
+
+        file << EpdSuite::toJson(positions, results, options) << "\n";
+
+        if (!file)
+        {
+            fprintf(stderr, "Could not write %s\n", jsonPath);
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+/***************************************************************************************************
+ *
+ *  @file       MatchMain.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Match between two engines
+ *
+ *  @discussion Plays two engines against each other on all the cores, from the openings of an
+ *  EPD file if one is given, and prints the score and the state of the SPRT after every pair of
+ *  games. An engine is this build unless a command starting another one is given; its UCI options
+ *  are set with name=value. With --sprt the match stops once the test is decided, otherwise after
+ *  the number of games.
+ *
+ *  Usage: ChessMatch [games] [--engine1 command] [--engine2 command] [--option1 name=value]
+ *                    [--option2 name=value] [--concurrency n] [--tc seconds+increment]
+ *                    [--nodes n] [--openings file] [--sprt elo0 elo1] [--alpha a] [--beta b]
+ *
+ **************************************************************************************************/
+
+#include "ChessEngine.h"
+#include "Match.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace chessEngine;
+
+static void
+_printUsage(const char * inName)
+{
+    fprintf(stderr, "Usage: %s [games] [--engine1 command] [--engine2 command] "
+            "[--option1 name=value] [--option2 name=value] [--concurrency n] "
+            "[--tc seconds+increment] [--nodes n] [--openings file] [--sprt elo0 elo1] "
+            "[--alpha a] [--beta b]\n", inName);
+}
+
+static bool
+_addOption(const char * inOption, MatchEngine * inOutEngine)
+{
+    auto separator = strchr(inOption, '=');
+
+    if ((separator == nullptr) || (separator == inOption))
+    {
+        return false;
+    }
+
+    inOutEngine->options.emplace_back(std::string(inOption, separator), separator + 1);
+
+    return true;
+}
+
+static const char *
+_getStatusName(Sprt::Status inStatus)
+{
+    switch (inStatus)
+    {
+        case Sprt::Status::kAcceptH0:
+            return "H0 accepted";
+        case Sprt::Status::kAcceptH1:
+            return "H1 accepted";
+        default:
+            return "continue";
+    }
+}
+
+int
+main(int argc, char ** argv)
+{
+    MatchEngine     engines[2];
+    MatchOptions    options;
+    const char *    openingsPath = nullptr;
+    double          elo0 = 0.0, elo1 = 5.0, alpha = 0.05, beta = 0.05;
+    bool            hasGames = false;
+
+    engines[0].name     = "engine1";
+    engines[1].name     = "engine2";
+    options.concurrency = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+
+        if (((strcmp(argv[i], "--engine1") == 0) || (strcmp(argv[i], "--engine2") == 0)) &&
+            hasValue)
+        {
+            auto & engine = engines[argv[i][8] - '1'];
+
+            engine.command = argv[++i];
+            engine.name    = engine.command;
+        }
+        else if (((strcmp(argv[i], "--option1") == 0) || (strcmp(argv[i], "--option2") == 0)) &&
+                 hasValue)
+        {
+            auto & engine = engines[argv[i][8] - '1'];
+
+            if (!_addOption(argv[++i], &engine))
+            {
+                _printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if ((strcmp(argv[i], "--concurrency") == 0) && hasValue)
+        {
+            options.concurrency = std::max(atoi(argv[++i]), 1);
+        }
+        else if ((strcmp(argv[i], "--tc") == 0) && hasValue)
+        {
+            char * increment;
+
+            options.timeMs      = static_cast<int64_t>(strtod(argv[++i], &increment) * 1000.0);
+            options.incrementMs = (*increment == '+')
+                                  ? static_cast<int64_t>(strtod(increment + 1, nullptr) * 1000.0)
+                                  : 0;
+        }
+        else if ((strcmp(argv[i], "--nodes") == 0) && hasValue)
+        {
+            options.nodes = strtoull(argv[++i], nullptr, 10);
+        }
+        else if ((strcmp(argv[i], "--openings") == 0) && hasValue)
+        {
+            openingsPath = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--sprt") == 0) && (i + 2 < argc))
+        {
+            elo0            = atof(argv[++i]);
+            elo1            = atof(argv[++i]);
+            options.isSprt  = true;
+        }
+        else if ((strcmp(argv[i], "--alpha") == 0) && hasValue)
+        {
+            alpha = atof(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--beta") == 0) && hasValue)
+        {
+            beta = atof(argv[++i]);
+        }
+        else if ((strncmp(argv[i], "--", 2) != 0) && !hasGames)
+        {
+            options.numGames = strtoull(argv[i], nullptr, 10);
+            hasGames         = true;
+        }
+        else
+        {
+            _printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((options.numGames == 0) || (options.timeMs <= 0) || (elo0 >= elo1) ||
+        (alpha <= 0.0) || (alpha >= 1.0) || (beta <= 0.0) || (beta >= 1.0))
+    {
+        _printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.isSprt && !hasGames)
+    {
+        // The test decides when to stop, the number of games is only there to bound it
+        options.numGames = 100000;
+    }
+
+    ChessEngine::init();
+
+    if ((openingsPath != nullptr) && !Match::loadOpenings(openingsPath, &options.openings))
+    {
+        fprintf(stderr, "Could not read the openings of %s\n", openingsPath);
+        return 1;
+    }
+
+    options.sprt = Sprt(elo0, elo1, alpha, beta);
+
+    printf("%s vs %s, %d games at once", engines[0].name.c_str(), engines[1].name.c_str(),
+           options.concurrency);
+
+    if (options.nodes == 0)
+    {
+        printf(", time scaled by %.2f", Match::getTimeScale(options.concurrency));
+    }
+
+    printf("\n");
+
+    MatchStats stats;
+
+    bool isPlayed = Match::run(engines[0], engines[1], options, &stats,
+                               [] (const MatchStats & inStats) {
+        double error;
+        double elo = inStats.sprt.getElo(&error);
+
+        printf("%llu games: +%llu =%llu -%llu, Elo %.1f +/- %.1f, LLR %.2f (%.2f, %.2f)\n",
+               static_cast<unsigned long long>(inStats.numGames),
+               static_cast<unsigned long long>(inStats.numWins),
+               static_cast<unsigned long long>(inStats.numDraws),
+               static_cast<unsigned long long>(inStats.numLosses), elo, error,
+               inStats.sprt.getLlr(), inStats.sprt.getLowerBound(),
+               inStats.sprt.getUpperBound());
+        fflush(stdout);
+    });
+
+    if (!isPlayed)
+    {
+        fprintf(stderr, "Could not start the engines\n");
+        return 1;
+    }
+
+    double error;
+    double elo   = stats.sprt.getElo(&error);
+    auto & pairs = stats.sprt.getPairs();
+
+    printf("===========================\n");
+    printf("Games           : %llu\n", static_cast<unsigned long long>(stats.numGames));
+    printf("+ / = / -       : %llu / %llu / %llu\n",
+           static_cast<unsigned long long>(stats.numWins),
+           static_cast<unsigned long long>(stats.numDraws),
+           static_cast<unsigned long long>(stats.numLosses));
+    printf("Forfeits        : %llu\n", static_cast<unsigned long long>(stats.numForfeits));
+    printf("Pairs 0 - 2     : %llu %llu %llu %llu %llu\n",
+           static_cast<unsigned long long>(pairs[0]), static_cast<unsigned long long>(pairs[1]),
+           static_cast<unsigned long long>(pairs[2]), static_cast<unsigned long long>(pairs[3]),
+           static_cast<unsigned long long>(pairs[4]));
+    printf("Elo             : %.1f +/- %.1f\n", elo, error);
+    printf("SPRT            : %s\n", _getStatusName(stats.sprt.getStatus()));
+
+    return 0;
+}
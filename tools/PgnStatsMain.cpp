@@ -0,0 +1,168 @@
+/***************************************************************************************************
+ *
+ *  @file       PgnStatsMain.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Validation and statistics of a PGN archive
+ *
+ *  @discussion Parses every game of a file on all the cores, resolving every move, and prints the
+ *  number of games, moves and results, with the first games whose moves could not be resolved.
+ *  The counts are kept per chunk of the file and merged in order, so that the output is the same
+ *  for any number of threads.
+ *
+ *  Usage: ChessPgnStats file.pgn [threads]
+ *
+ **************************************************************************************************/
+
+#include "ChessEngine.h"
+#include "PgnReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chessEngine;
+
+static constexpr size_t     kChunksPerThread = 16;
+static constexpr size_t     kMaxErrors       = 10;
+
+/**
+ @brief         Counts of a chunk of the file
+ */
+struct PgnStats
+{
+    size_t                      numGames      = 0;
+    size_t                      numMoves      = 0;
+    size_t                      numWhiteWins  = 0;
+    size_t                      numBlackWins  = 0;
+    size_t                      numDraws      = 0;
+    size_t                      numNoResults  = 0;
+    size_t                      numInvalid    = 0;
+    std::vector<std::string>    errors;
+
+    void                        add(const PgnGame & inGame, size_t inOffset)
+    {
+        numGames++;
+        numMoves += inGame.moves.size();
+
+        if (inGame.result == "1-0")
+        {
+            numWhiteWins++;
+        }
+        else if (inGame.result == "0-1")
+        {
+            numBlackWins++;
+        }
+        else if (inGame.result == "1/2-1/2")
+        {
+            numDraws++;
+        }
+        else
+        {
+            numNoResults++;
+        }
+
+        if (!inGame.isValid())
+        {
+            numInvalid++;
+
+            if (errors.size() < kMaxErrors)
+            {
+                errors.push_back("offset " + std::to_string(inOffset) + ", move " +
+                                 std::to_string(inGame.moves.size() / 2 + 1) + ": " +
+                                 inGame.error.toString());
+            }
+        }
+    }
+
+    void                        operator+= (const PgnStats & inOther)
+    {
+        numGames     += inOther.numGames;
+        numMoves     += inOther.numMoves;
+        numWhiteWins += inOther.numWhiteWins;
+        numBlackWins += inOther.numBlackWins;
+        numDraws     += inOther.numDraws;
+        numNoResults += inOther.numNoResults;
+        numInvalid   += inOther.numInvalid;
+
+        for (auto & error : inOther.errors)
+        {
+            if (errors.size() < kMaxErrors)
+            {
+                errors.push_back(error);
+            }
+        }
+    }
+};
+
+int
+main(int argc, char ** argv)
+{
+    if ((argc < 2) || (argc > 3))
+    {
+        fprintf(stderr, "Usage: %s file.pgn [threads]\n", argv[0]);
+        return 1;
+    }
+
+    int numThreads = (argc == 3) ? atoi(argv[2])
+                                 : static_cast<int>(std::thread::hardware_concurrency());
+
+    numThreads = std::max(numThreads, 1);
+
+    ChessEngine::init();
+
+    PgnReader reader;
+
+    if (!reader.open(argv[1]))
+    {
+        fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    auto start  = std::chrono::steady_clock::now();
+    auto text   = reader.getText();
+    auto chunks = PgnParser::split(text, static_cast<size_t>(numThreads) * kChunksPerThread);
+
+    std::vector<PgnStats> chunkStats(chunks.size());
+
+    PgnParser::parseParallel(chunks, numThreads, [&] (size_t inChunk, const PgnGame & inGame) {
+        chunkStats[inChunk].add(inGame, static_cast<size_t>(inGame.text.begin() - text.begin()));
+        return true;
+    });
+
+    PgnStats stats;
+
+    for (auto & chunk : chunkStats)
+    {
+        stats += chunk;
+    }
+
+    auto usedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    printf("Games    : %zu\n", stats.numGames);
+    printf("Moves    : %zu\n", stats.numMoves);
+    printf("1-0      : %zu\n", stats.numWhiteWins);
+    printf("0-1      : %zu\n", stats.numBlackWins);
+    printf("1/2-1/2  : %zu\n", stats.numDraws);
+    printf("Other    : %zu\n", stats.numNoResults);
+    printf("Invalid  : %zu\n", stats.numInvalid);
+
+    for (auto & error : stats.errors)
+    {
+        printf("  %s\n", error.c_str());
+    }
+
+    printf("Threads  : %d\n", numThreads);
+    printf("Time     : %lld ms\n", static_cast<long long>(usedMs));
+    printf("Speed    : %.1f MB/s, %lld games/s\n",
+           text.size / 1048576.0 * 1000 / std::max<long long>(usedMs, 1),
+           static_cast<long long>(stats.numGames * 1000 / std::max<long long>(usedMs, 1)));
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/***************************************************************************************************
+ *
+ *  @file       SelfPlayMain.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Generation of training data by self-play
+ *
+ *  @discussion Plays games of the engine against itself on all the cores, each move searched to
+ *  a fixed number of nodes or depth, and writes their positions with the search scores and the
+ *  results to a file of SelfPlay records. Progress is printed every hundred games.
+ *
+ *  Usage: ChessSelfPlay file [games [threads]] [--nodes n] [--depth n] [--random plies]
+ *                       [--hash MB] [--seed n]
+ *
+ **************************************************************************************************/
+
+#include "ChessEngine.h"
+#include "SelfPlay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace chessEngine;
+
+static constexpr uint64_t   kProgressInterval = 100;
+
+static void
+_printUsage(const char * inName)
+{
+    fprintf(stderr, "Usage: %s file [games [threads]] [--nodes n] [--depth n] [--random plies] "
+            "[--hash MB] [--seed n]\n", inName);
+}
+
+int
+main(int argc, char ** argv)
+{
+    SelfPlayOptions options;
+    const char *    path       = nullptr;
+    int             numNumbers = 0;
+
+    options.numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+
+        if ((strcmp(argv[i], "--nodes") == 0) && hasValue)
+        {
+            options.limits.nodes = strtoull(argv[++i], nullptr, 10);
+            options.limits.depth = 0;
+        }
+        else if ((strcmp(argv[i], "--depth") == 0) && hasValue)
+        {
+            options.limits.depth = atoi(argv[++i]);
+            options.limits.nodes = 0;
+        }
+        else if ((strcmp(argv[i], "--random") == 0) && hasValue)
+        {
+            options.numRandomPlies = atoi(argv[++i]);
+        }
+        else if ((strcmp(argv[i], "--hash") == 0) && hasValue)
+        {
+            options.hashSizeMb = static_cast<size_t>(atoi(argv[++i]));
+        }
+        else if ((strcmp(argv[i], "--seed") == 0) && hasValue)
+        {
+            options.seed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            _printUsage(argv[0]);
+            return 1;
+        }
+        else if (path == nullptr)
+        {
+            path = argv[i];
+        }
+        else if (numNumbers == 0)
+        {
+            options.numGames = strtoull(argv[i], nullptr, 10);
+            numNumbers++;
+        }
+        else if (numNumbers == 1)
+        {
+            options.numThreads = std::max(atoi(argv[i]), 1);
+            numNumbers++;
+        }
+        else
+        {
+            _printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if ((path == nullptr) || ((options.limits.depth <= 0) && (options.limits.nodes == 0)) ||
+        (options.numRandomPlies < 0) || (options.hashSizeMb == 0))
+    {
+        _printUsage(argv[0]);
+        return 1;
+    }
+
+    ChessEngine::init();
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto elapsedMs = [&] {
+        return std::max<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count(), 1);
+    };
+
+    SelfPlayStats stats;
+
+    bool isWritten = SelfPlay::run(path, options, &stats, [&] (const SelfPlayStats & inStats) {
+        if ((inStats.numGames % kProgressInterval) == 0)
+        {
+            printf("%llu games, %llu positions, %.1f games/s\n",
+                   static_cast<unsigned long long>(inStats.numGames),
+                   static_cast<unsigned long long>(inStats.numRecords),
+                   inStats.numGames * 1000.0 / elapsedMs());
+            fflush(stdout);
+        }
+    });
+
+    if (!isWritten)
+    {
+        fprintf(stderr, "Could not write %s\n", path);
+        return 1;
+    }
+
+    printf("===========================\n");
+    printf("Games           : %llu\n", static_cast<unsigned long long>(stats.numGames));
+    printf("1-0 / = / 0-1   : %llu / %llu / %llu\n",
+           static_cast<unsigned long long>(stats.numWhiteWins),
+           static_cast<unsigned long long>(stats.numDraws),
+           static_cast<unsigned long long>(stats.numBlackWins));
+    printf("Positions       : %llu\n", static_cast<unsigned long long>(stats.numRecords));
+    printf("Time (ms)       : %lld\n", static_cast<long long>(elapsedMs()));
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+/***************************************************************************************************
+ *
+ *  @file       UciMain.cpp
+ *
+ *  @author     Virag Doshi
+ *
+ *  @brief      Headless engine speaking UCI on the standard input and output
+ *
+ *  @discussion Built from the engine sources only, for tournament managers and analysis tools.
+ *
+ *  Usage: ChessUCI
+ *
+ **************************************************************************************************/
+
+#include "ChessEngine.h"
+#include "UciEngine.h"
+
+#include <iostream>
+#include <string>
+
+using namespace chessEngine;
+
+int
+main()
+{
+    ChessEngine::init();
+
+    UciEngine   engine(std::cout);
+    std::string line;
+
+    while (std::getline(std::cin, line))
+    {
+        // Interfaces on Windows may end their lines with a carriage return
+        if (!line.empty() && (line.back() == '\r'))
+        {
+            line.pop_back();
+        }
+
+        if (!engine.handleCommand(line))
+        {
+            break;
+        }
+    }
+
+    return 0;
+}